@@ -643,6 +643,7 @@ void CGame::PreLoadSimulation(LuaParser* defsParser)
 	loadscreen->SetLoadMessage("Creating QuadField & CEGs");
 	moveDefHandler.Init(defsParser);
 	quadField.Init(int2(mapDims.mapx, mapDims.mapy), modInfo.quadFieldQuadSizeInElmos);
+	quadField.SetPackedUnitQueries(modInfo.quadFieldPackedUnitQueries);
 	damageArrayHandler.Init(defsParser);
 	explGenHandler.Init();
 }
@@ -1019,6 +1020,9 @@ void CGame::KillSimulation()
 	RECOIL_DETAILED_TRACY_ZONE;
 	LOG("[Game::%s][1]", __func__);
 
+	if (pathManager != nullptr)
+		pathManager->SyncQueuedSearches();
+
 	// Kill all teams that are still alive, in
 	// case the game did not do so through Lua.
 	//
@@ -1797,7 +1801,10 @@ void CGame::SimFrame() {
 			if (luaGCControl == 0)
 				eventHandler.CollectGarbage(false);
 
+			// deliver batched call-ins queued between frames first
+			FlushCallInBatches();
 			eventHandler.GameFrame(gs->frameNum);
+			FlushCallInBatches();
 		}
 
 		helper->Update();
@@ -1805,9 +1812,11 @@ void CGame::SimFrame() {
 		smoothGround.UpdateSmoothMesh();
 		mapDamage->Update();
 		unitHandler.Update();
+		FlushCallInBatches();
 		pathManager->Update();
 		projectileHandler.Update();
 		featureHandler.Update();
+		FlushCallInBatches();
 		{
 			/* The default GAME_SPEED is 30, which doesn't divide 1000 well,
 			 * so scripts will perceive 990ms per second. But this is fine,
@@ -1830,7 +1839,14 @@ void CGame::SimFrame() {
 
 		teamHandler.GameFrame(gs->frameNum);
 		playerHandler.GameFrame(gs->frameNum);
+		FlushCallInBatches();
 		eventHandler.GameFramePost(gs->frameNum);
+
+		// synced state is frozen from here until the next net message is
+		// processed, which is when the searches started now are published;
+		// being started here (rather than in pathManager->Update) they see
+		// the state at the end of the frame
+		pathManager->StartQueuedSearches();
 	}
 
 	lastSimFrameTime = spring_gettime();
@@ -1861,6 +1877,15 @@ void CGame::SimFrame() {
 	LEAVE_SYNCED_CODE();
 }
 
+void CGame::FlushCallInBatches() {
+	// explosions caused by the batch call-ins are left to the next flush,
+	// their deferred gfx are still waiting for a batch that has not run
+	const size_t numExplosionGfx = helper->GetNumExplosionGfx();
+
+	eventHandler.FlushCallInBatches();
+	helper->GenDeferredExplosionGfx(numExplosionGfx);
+}
+
 
 void CGame::GameEnd(const std::vector<unsigned char>& winningAllyTeams, bool timeout)
 {
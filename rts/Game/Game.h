@@ -142,6 +142,7 @@ private:
 	void UpdateNumQueuedSimFrames();
 	void UpdateNetMessageProcessingTimeLeft();
 	void SimFrame();
+	void FlushCallInBatches();
 	void StartPlaying();
 
 public:
@@ -40,6 +40,7 @@
 #include "System/EventHandler.h"
 #include "System/SpringMath.h"
 #include "System/Sound/ISoundChannels.h"
+#include "System/Threading/ThreadPool.h"
 
 #include "System/Misc/TracyDefs.h"
 
@@ -58,6 +59,11 @@ void CGameHelper::Init()
 
 void CGameHelper::Kill()
 {
+	weaponTargetCandidates.clear();
+	explosionGfx.clear();
+
+	explosionGfxBaseID = 0;
+	curExplosionGfx = -1;
 }
 
 void CGameHelper::Update()
@@ -248,6 +254,52 @@ void CGameHelper::DamageObjectsInExplosionRadius(
 	featureCache.resize(oldNumFeatures);
 }
 
+uint32_t CGameHelper::DeferExplosionGfx()
+{
+	assert(curExplosionGfx >= 0);
+	explosionGfx[curExplosionGfx].deferred = true;
+	return explosionGfxBaseID + curExplosionGfx;
+}
+
+void CGameHelper::SuppressExplosionGfx(uint32_t id)
+{
+	const uint32_t index = id - explosionGfxBaseID;
+
+	if (index >= explosionGfx.size())
+		return;
+
+	explosionGfx[index].suppressed = true;
+}
+
+void CGameHelper::GenDeferredExplosionGfx(size_t numExplosionGfx)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	assert(curExplosionGfx < 0);
+	assert(numExplosionGfx <= explosionGfx.size());
+
+	for (size_t i = 0; i < numExplosionGfx; i++) {
+		const ExplosionGfx& gfx = explosionGfx[i];
+
+		if (!gfx.deferred || gfx.suppressed)
+			continue;
+
+		// owner or hit unit may have died since
+		explGenHandler.GenExplosion(
+			gfx.expGenID,
+			gfx.pos,
+			gfx.dir,
+			gfx.damage,
+			gfx.radius,
+			gfx.gfxMod,
+			unitHandler.GetUnit(gfx.ownerID),
+			unitHandler.GetUnit(gfx.hitUnitID)
+		);
+	}
+
+	explosionGfx.erase(explosionGfx.begin(), explosionGfx.begin() + numExplosionGfx);
+	explosionGfxBaseID += numExplosionGfx;
+}
+
 void CGameHelper::Explosion(const CExplosionParams& params) {
 	RECOIL_DETAILED_TRACY_ZONE;
 	const DamageArray& damages = params.damages;
@@ -266,9 +318,31 @@ void CGameHelper::Explosion(const CExplosionParams& params) {
 	const float realHeight = CGround::GetHeightReal(params.pos);
 	const float altitude = (params.pos).y - realHeight;
 
+	// gfx are spawned below, or after the call-in batches are flushed if a
+	// batched Explosion call-in deferred them; track by index since this
+	// can recurse
+	const int prevExplosionGfx = curExplosionGfx;
+	const int thisExplosionGfx = curExplosionGfx = explosionGfx.size();
+
+	explosionGfx.push_back({
+		params.pos,
+		params.dir,
+		damages.GetDefault(),
+		damageAOE,
+		params.gfxMod,
+		static_cast<unsigned int>(explosionID),
+		(params.owner != nullptr)? params.owner->id: -1,
+		(params.hitUnit != nullptr)? params.hitUnit->id: -1,
+		false,
+		false,
+	});
+
 	// NOTE: event triggers before damage is applied to objects
 	const bool noGfx = eventHandler.Explosion(weaponDefID, params.projectileID, params.pos, params.owner);
 
+	curExplosionGfx = prevExplosionGfx;
+	explosionGfx[thisExplosionGfx].suppressed |= noGfx;
+
 	if (luaUI != nullptr && weaponDef != nullptr)
 		luaUI->ShockFront(params.pos, weaponDef->cameraShake, damageAOE);
 
@@ -318,17 +392,25 @@ void CGameHelper::Explosion(const CExplosionParams& params) {
 		}
 	}
 
-	if (!noGfx) {
-		explGenHandler.GenExplosion(
-			explosionID,
-			params.pos,
-			params.dir,
-			damages.GetDefault(),
-			damageAOE,
-			params.gfxMod,
-			params.owner,
-			params.hitUnit
-		);
+	if (!explosionGfx[thisExplosionGfx].deferred) {
+		// handled here, GenDeferredExplosionGfx skips it
+		explosionGfx[thisExplosionGfx].suppressed = true;
+
+		if (thisExplosionGfx == int(explosionGfx.size()) - 1)
+			explosionGfx.pop_back();
+
+		if (!noGfx) {
+			explGenHandler.GenExplosion(
+				explosionID,
+				params.pos,
+				params.dir,
+				damages.GetDefault(),
+				damageAOE,
+				params.gfxMod,
+				params.owner,
+				params.hitUnit
+			);
+		}
 	}
 
 	CExplosionCreator::FireExplosionEvent(params);
@@ -655,6 +737,149 @@ namespace {
 
 
 
+float CGameHelper::GetWeaponTargetScanRadius(const CWeapon* weapon)
+{
+	const float aimPosHeight = weapon->aimFromPos.y;
+	const float minMapHeight = std::max(0.0f, readMap->GetCurrMinHeight());
+
+	// find theoretical maximum range based on height above lowest point on map
+	// return (weapon->GetRange2D(weapon->autoTargetRangeBoost, (minMapHeight - aimPosHeight) * weapon->weaponDef->heightmod));
+	return (weapon->range + weapon->autoTargetRangeBoost + (aimPosHeight - minMapHeight) * weapon->weaponDef->heightmod);
+}
+
+void CGameHelper::BuildWeaponTargetCandidates(const CUnit* unit, int threadOwner)
+{
+	// weapon aim-positions are refreshed during SlowUpdate, leave some room
+	// so the list still covers the radius a weapon asks for after that
+	constexpr float SCAN_RADIUS_SLACK = SQUARE_SIZE * 4.0f;
+
+	WeaponTargetCandidates& candidates = weaponTargetCandidates[unit->id];
+
+	candidates.quads.clear();
+	candidates.units.clear();
+	candidates.unitOffsets.clear();
+	candidates.enemyAllyTeams.clear();
+
+	candidates.pos = unit->pos;
+	candidates.radius = 0.0f;
+
+	for (const CWeapon* weapon: unit->weapons) {
+		candidates.radius = std::max(candidates.radius, GetWeaponTargetScanRadius(weapon) + SCAN_RADIUS_SLACK);
+	}
+
+	{
+		QuadFieldQuery qfQuery;
+		qfQuery.threadOwner = threadOwner;
+		quadField.GetQuads(qfQuery, candidates.pos, candidates.radius);
+
+		candidates.quads.assign(qfQuery.quads->begin(), qfQuery.quads->end());
+	}
+
+	candidates.unitOffsets.push_back(0);
+
+	for (int t = 0; t < teamHandler.ActiveAllyTeams(); ++t) {
+		const bool isEnemy = !teamHandler.Ally(unit->allyteam, t);
+
+		candidates.enemyAllyTeams.push_back(isEnemy);
+
+		for (const int qi: candidates.quads) {
+			if (isEnemy) {
+				const std::vector<CUnit*>& allyTeamUnits = quadField.GetQuad(qi).teamUnits[t];
+				candidates.units.insert(candidates.units.end(), allyTeamUnits.begin(), allyTeamUnits.end());
+			}
+
+			candidates.unitOffsets.push_back(candidates.units.size());
+		}
+	}
+
+	candidates.allyTeam = unit->allyteam;
+	candidates.frameNum = gs->frameNum;
+	candidates.quadFieldUpdateCount = quadField.GetObjectUpdateCount();
+}
+
+void CGameHelper::GenerateWeaponTargetCandidates(const std::vector<CUnit*>& units, size_t idxBeg, size_t idxEnd, bool mt)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	weaponTargetCandidates.resize(std::max(weaponTargetCandidates.size(), size_t(unitHandler.MaxUnits())));
+
+	// skip units whose weapons will not look for new targets this round
+	// (see CWeapon::AllowWeaponAutoTarget); if the guess is wrong either
+	// way GenerateWeaponTargets simply falls back to its own query
+	const auto WantsCandidates = [](const CUnit* unit) {
+		if (unit->weapons.size() < 2)
+			return false;
+
+		for (const CWeapon* weapon: unit->weapons) {
+			if (!weapon->HaveTarget() || weapon->avoidTarget || gs->frameNum > (weapon->lastTargetRetry + 65))
+				return true;
+		}
+
+		return false;
+	};
+
+	// small batches are not worth waking the workers for
+	constexpr size_t MIN_BATCH_SIZE = 64;
+
+	if (!mt || (idxEnd - idxBeg) < MIN_BATCH_SIZE) {
+		for (size_t i = idxBeg; i < idxEnd; ++i) {
+			if (WantsCandidates(units[i]))
+				BuildWeaponTargetCandidates(units[i], 0);
+		}
+
+		return;
+	}
+
+	// every list only reads the QuadField and is written by one thread
+	for_mt(idxBeg, idxEnd, [&](const int i) {
+		if (WantsCandidates(units[i]))
+			BuildWeaponTargetCandidates(units[i], ThreadPool::GetThreadNum());
+	});
+}
+
+const CGameHelper::WeaponTargetCandidates* CGameHelper::GetWeaponTargetCandidates(const CUnit* unit, float scanRadius)
+{
+	// a single weapon does not gain anything from a shared list
+	if (unit->weapons.size() < 2)
+		return nullptr;
+
+	if (size_t(unit->id) >= weaponTargetCandidates.size())
+		weaponTargetCandidates.resize(std::max(size_t(unit->id) + 1, size_t(unitHandler.MaxUnits())));
+
+	const auto IsValid = [&](const WeaponTargetCandidates& candidates) {
+		if (candidates.frameNum != gs->frameNum)
+			return false;
+		if (candidates.quadFieldUpdateCount != quadField.GetObjectUpdateCount())
+			return false;
+		if (candidates.allyTeam != unit->allyteam)
+			return false;
+		// float3::operator!= has a tolerance, the quads must match exactly
+		if (candidates.pos.x != unit->pos.x || candidates.pos.z != unit->pos.z)
+			return false;
+		if (candidates.radius < scanRadius)
+			return false;
+
+		// alliances can be changed by Lua at any time
+		for (int t = 0; t < teamHandler.ActiveAllyTeams(); ++t) {
+			if (candidates.enemyAllyTeams[t] == teamHandler.Ally(unit->allyteam, t))
+				return false;
+		}
+
+		return true;
+	};
+
+	WeaponTargetCandidates& candidates = weaponTargetCandidates[unit->id];
+
+	if (IsValid(candidates))
+		return &candidates;
+
+	BuildWeaponTargetCandidates(unit, 0);
+
+	if (!IsValid(candidates))
+		return nullptr;
+
+	return &candidates;
+}
+
 size_t CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* avoidUnit, std::vector<std::pair<float, CUnit*>>& targets)
 {
 	const CUnit*  weaponOwner = weapon->owner;
@@ -667,7 +892,6 @@ size_t CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* av
 	const float3 testPos;
 
 	const float aimPosHeight = weapon->aimFromPos.y;
-	const float minMapHeight = std::max(0.0f, readMap->GetCurrMinHeight());
 
 	// how much damage the weapon deals over 1 second
 	const float secDamage = weaponDmg->GetDefault() * weapon->salvoSize / weapon->reloadTime * GAME_SPEED;
@@ -678,9 +902,7 @@ size_t CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* av
 
 	const float  baseRange = weapon->range;
 	const float rangeBoost = weapon->autoTargetRangeBoost;
-	// find theoretical maximum range based on height above lowest point on map
-	// const float scanRadius = weapon->GetRange2D(rangeBoost, (minMapHeight - aimPosHeight) * heightMod);
-	const float scanRadius = baseRange + rangeBoost + (aimPosHeight - minMapHeight) * heightMod;
+	const float scanRadius = GetWeaponTargetScanRadius(weapon);
 
 	// [0] := default, [1,2,3,4,5,6] := target is {avoidee, in bad category, crashing, last attacker, paralyzed, outside unboosted range}
 	constexpr float tgtPriorityMults[] = {1.0f, 10.0f, 100.0f, 1000.0f, 0.5f, 4.0f, 100000.0f};
@@ -691,93 +913,119 @@ size_t CGameHelper::GenerateWeaponTargets(const CWeapon* weapon, const CUnit* av
 	QuadFieldQuery qfQuery;
 	quadField.GetQuads(qfQuery, ownerPos, scanRadius);
 
+	// enemies gathered once for all weapons of the owner, if still valid
+	const WeaponTargetCandidates* candidates = helper->GetWeaponTargetCandidates(weaponOwner, scanRadius);
+
 	targets.clear();
 	targets.reserve(32);
 
 	const int tempNum = gs->GetTempNum();
 
-	for (int t = 0; t < teamHandler.ActiveAllyTeams(); ++t) {
-		if (teamHandler.Ally(weaponOwner->allyteam, t))
-			continue;
+	const auto AddTarget = [&](CUnit* targetUnit) {
+		if (targetUnit->tempNum == tempNum)
+			return;
 
-		for (const int qi: *qfQuery.quads) {
-			const std::vector<CUnit*>& allyTeamUnits = quadField.GetQuad(qi).teamUnits[t];
+		targetUnit->tempNum = tempNum;
 
-			for (CUnit* targetUnit: allyTeamUnits) {
-				if (targetUnit->tempNum == tempNum)
-					continue;
+		if (!weapon->TestTarget(testPos, SWeaponTarget(targetUnit)))
+			return;
 
-				targetUnit->tempNum = tempNum;
+		const unsigned short targetLOSState = targetUnit->losStatus[weaponOwner->allyteam];
 
-				if (!weapon->TestTarget(testPos, SWeaponTarget(targetUnit)))
-					continue;
+		float targetPriority = tgtPriorityMults[(targetUnit == avoidUnit) * 1];
+		float3 targetPos;
 
-				const unsigned short targetLOSState = targetUnit->losStatus[weaponOwner->allyteam];
+		if (targetLOSState & LOS_INLOS) {
+			targetPos = targetUnit->aimPos;
+		} else if (targetLOSState & LOS_INRADAR) {
+			targetPos = weapon->GetUnitPositionWithError(targetUnit);
+			targetPriority *= tgtPriorityMults[1];
+		} else {
+			return;
+		}
 
-				float targetPriority = tgtPriorityMults[(targetUnit == avoidUnit) * 1];
-				float3 targetPos;
+		const float modRange = weapon->GetRange2D(rangeBoost, (targetPos.y - aimPosHeight) * heightMod);
+		const float sqDist2D = ownerPos.SqDistance2D(targetPos);
 
-				if (targetLOSState & LOS_INLOS) {
-					targetPos = targetUnit->aimPos;
-				} else if (targetLOSState & LOS_INRADAR) {
-					targetPos = weapon->GetUnitPositionWithError(targetUnit);
-					targetPriority *= tgtPriorityMults[1];
-				} else {
-					continue;
-				}
+		if (sqDist2D > Square(modRange))
+			return;
 
-				const float modRange = weapon->GetRange2D(rangeBoost, (targetPos.y - aimPosHeight) * heightMod);
-				const float sqDist2D = ownerPos.SqDistance2D(targetPos);
+		const float3 worldTargetDir = (targetPos - ownerPos).SafeNormalize();
+		const float angleOffset =  (1.f - worldMainDir.dot(worldTargetDir));
+		const float angleMod = angleOffset * weaponAimAdjustPriority + 1.f;
 
-				if (sqDist2D > Square(modRange))
-					continue;
+		// Strengthen focus towards the front, desire should weaken quadratically rather
+		// than linearly otherwise target distance can too easily cause units to choose a
+		// target that requires turning around to fire at.
+		const float angleMul = angleMod*angleMod;
 
-				const float3 worldTargetDir = (targetPos - ownerPos).SafeNormalize();
-				const float angleOffset =  (1.f - worldMainDir.dot(worldTargetDir));
-				const float angleMod = angleOffset * weaponAimAdjustPriority + 1.f;
+		const float dist2D = math::sqrt(sqDist2D);
+		const float rangeMul = (dist2D * weaponDef->proximityPriority + modRange * 0.4f + 100.0f);
+		const float damageMul = std::max(0.0001f, weaponDmg->Get(targetUnit->armorType) * targetUnit->curArmorMultiple);
 
-				// Strengthen focus towards the front, desire should weaken quadratically rather
-				// than linearly otherwise target distance can too easily cause units to choose a
-				// target that requires turning around to fire at.
-				const float angleMul = angleMod*angleMod;
+		targetPriority *= angleMul;
+		targetPriority *= rangeMul;
+		targetPriority *= tgtPriorityMults[(dist2D > baseRange) * 6];
 
-				const float dist2D = math::sqrt(sqDist2D);
-				const float rangeMul = (dist2D * weaponDef->proximityPriority + modRange * 0.4f + 100.0f);
-				const float damageMul = std::max(0.0001f, weaponDmg->Get(targetUnit->armorType) * targetUnit->curArmorMultiple);
+		if (targetLOSState & LOS_INLOS) {
+			targetPriority *= (secDamage + targetUnit->health);
 
-				targetPriority *= angleMul;
-				targetPriority *= rangeMul;
-				targetPriority *= tgtPriorityMults[(dist2D > baseRange) * 6];
+			if (paralyzer && targetUnit->paralyzeDamage > (modInfo.paralyzeOnMaxHealth? targetUnit->maxHealth: targetUnit->health))
+				targetPriority *= tgtPriorityMults[5];
 
-				if (targetLOSState & LOS_INLOS) {
-					targetPriority *= (secDamage + targetUnit->health);
+			if (weapon->hasTargetWeight)
+				targetPriority *= weapon->TargetWeight(targetUnit);
 
-					if (paralyzer && targetUnit->paralyzeDamage > (modInfo.paralyzeOnMaxHealth? targetUnit->maxHealth: targetUnit->health))
-						targetPriority *= tgtPriorityMults[5];
+		} else {
+			targetPriority *= (secDamage + 10000.0f);
+		}
 
-					if (weapon->hasTargetWeight)
-						targetPriority *= weapon->TargetWeight(targetUnit);
+		if (targetLOSState & LOS_PREVLOS) {
+			targetPriority /= (damageMul * targetUnit->power);
+			targetPriority *= tgtPriorityMults[((targetUnit->category & weapon->badTargetCategory) != 0) * 2];
+			targetPriority *= tgtPriorityMults[(targetUnit->IsCrashing()) * 3];
+			targetPriority *= tgtPriorityMults[(targetUnit == lastAttacker) * 4];
+		}
 
-				} else {
-					targetPriority *= (secDamage + 10000.0f);
-				}
+		const bool allowTarget = eventHandler.AllowWeaponTarget(weaponOwner->id, targetUnit->id, weapon->weaponNum, weaponDef->id, &targetPriority);
 
-				if (targetLOSState & LOS_PREVLOS) {
-					targetPriority /= (damageMul * targetUnit->power);
-					targetPriority *= tgtPriorityMults[((targetUnit->category & weapon->badTargetCategory) != 0) * 2];
-					targetPriority *= tgtPriorityMults[(targetUnit->IsCrashing()) * 3];
-					targetPriority *= tgtPriorityMults[(targetUnit == lastAttacker) * 4];
+		// Lua call may have changed tempNum, so needs to be set again
+		targetUnit->tempNum = tempNum;
+
+		if (!allowTarget)
+			return;
+
+		targets.emplace_back(targetPriority, targetUnit);
+	};
+
+	for (int t = 0; t < teamHandler.ActiveAllyTeams(); ++t) {
+		if (teamHandler.Ally(weaponOwner->allyteam, t))
+			continue;
+
+		if (candidates == nullptr) {
+			for (const int qi: *qfQuery.quads) {
+				const std::vector<CUnit*>& allyTeamUnits = quadField.GetQuad(qi).teamUnits[t];
+
+				for (CUnit* targetUnit: allyTeamUnits) {
+					AddTarget(targetUnit);
 				}
+			}
+
+			continue;
+		}
 
-				const bool allowTarget = eventHandler.AllowWeaponTarget(weaponOwner->id, targetUnit->id, weapon->weaponNum, weaponDef->id, &targetPriority);
+		// the candidate quads are a sorted superset of ours, so this visits
+		// the same units in the same order as the loop above
+		const size_t numQuads = candidates->quads.size();
 
-				// Lua call may have changed tempNum, so needs to be set again
-				targetUnit->tempNum = tempNum;
+		for (const int qi: *qfQuery.quads) {
+			const auto quadIt = std::lower_bound(candidates->quads.begin(), candidates->quads.end(), qi);
+			const size_t k = t * numQuads + (quadIt - candidates->quads.begin());
 
-				if (!allowTarget)
-					continue;
+			assert(quadIt != candidates->quads.end() && *quadIt == qi);
 
-				targets.emplace_back(targetPriority, targetUnit);
+			for (size_t i = candidates->unitOffsets[k], n = candidates->unitOffsets[k + 1]; i < n; ++i) {
+				AddTarget(candidates->units[i]);
 			}
 		}
 	}
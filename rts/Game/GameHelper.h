@@ -13,6 +13,7 @@
 
 #include <array>
 #include <bit>
+#include <cstdint>
 #include <vector>
 #include <memory>
 
@@ -149,6 +150,14 @@ public:
 	);
 
 	static size_t GenerateWeaponTargets(const CWeapon* weapon, const CUnit* avoidUnit, std::vector<std::pair<float, CUnit*>>& targets);
+	static float GetWeaponTargetScanRadius(const CWeapon* weapon);
+
+	/**
+	 * Gathers the enemy units around each of <units>[idxBeg, idxEnd) once,
+	 * so all weapons of a unit can auto-target from the same list during
+	 * this frame's SlowUpdate. Lists are built concurrently when <mt> is set.
+	 */
+	void GenerateWeaponTargetCandidates(const std::vector<CUnit*>& units, size_t idxBeg, size_t idxEnd, bool mt);
 
 	void Init();
 	void Kill();
@@ -182,7 +191,43 @@ public:
 	void DamageObjectsInExplosionRadius(const CExplosionParams& params, const float expRad, const int weaponDefID);
 	void Explosion(const CExplosionParams& params);
 
+	/**
+	 * Called from a batched Explosion call-in: holds back the gfx of the
+	 * current explosion until GenDeferredExplosionGfx, so the batch can
+	 * still suppress them. Returns the id to pass to SuppressExplosionGfx.
+	 */
+	uint32_t DeferExplosionGfx();
+	void SuppressExplosionGfx(uint32_t id);
+
+	size_t GetNumExplosionGfx() const { return explosionGfx.size(); }
+	/**
+	 * Spawns the deferred gfx among the first <numExplosionGfx> explosions
+	 * that were not suppressed. Pass GetNumExplosionGfx() from before the
+	 * call-in batches were flushed; later explosions wait for the next flush.
+	 */
+	void GenDeferredExplosionGfx(size_t numExplosionGfx);
+
 private:
+	struct WeaponTargetCandidates {
+		// quads covered by <radius> around <pos>, in GetQuads order
+		std::vector<int> quads;
+		// enemy units of allyteam t in quads[k] are units[unitOffsets[i]] up
+		// to units[unitOffsets[i + 1]] with i = t * quads.size() + k
+		std::vector<CUnit*> units;
+		std::vector<unsigned int> unitOffsets;
+		std::vector<std::uint8_t> enemyAllyTeams;
+
+		float3 pos;
+		float radius = 0.0f;
+
+		int allyTeam = -1;
+		int frameNum = -1;
+		unsigned int quadFieldUpdateCount = 0;
+	};
+
+	void BuildWeaponTargetCandidates(const CUnit* unit, int threadOwner);
+	const WeaponTargetCandidates* GetWeaponTargetCandidates(const CUnit* unit, float scanRadius);
+
 	struct WaitingDamage {
 		WaitingDamage(const DamageArray& _damage, const float3& _impulse, int _attackerID, int _targetID, int _weaponID, int _projectileID)
 		: attackerID(_attackerID)
@@ -202,7 +247,28 @@ private:
 		float3 impulse;
 	};
 	
+	struct ExplosionGfx {
+		float3 pos;
+		float3 dir;
+
+		float damage;
+		float radius;
+		float gfxMod;
+
+		unsigned int expGenID;
+
+		int ownerID;
+		int hitUnitID;
+
+		bool deferred;
+		bool suppressed;
+	};
+
 	std::array<std::vector<WaitingDamage>, 128> waitingDamages;
+	std::vector<ExplosionGfx> explosionGfx; // pending entries, explosionGfx[i] has id explosionGfxBaseID + i
+	uint32_t explosionGfxBaseID = 0;
+	int curExplosionGfx = -1;
+	std::vector<WeaponTargetCandidates> weaponTargetCandidates; // indexed by unit id
 	static_assert (std::has_single_bit(std::tuple_size_v <decltype(waitingDamages)>), "Size is used in bit hax and must be 2^N");
 
 public:
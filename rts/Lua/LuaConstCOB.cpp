@@ -171,7 +171,7 @@ bool LuaConstCOB::PushEntries(lua_State* L)
 	PUSH_COB(SONAR_STEALTH);
 	PUSH_COB(REVERSING);
 
-	// NOTE: [LUA0 - LUA9] are defined in CobThread.cpp as [110 - 119]
+	// NOTE: [LUA0 - LUA9] are defined in CobInterpreter.h as [110 - 119]
 
 	PUSH_COB(FLANK_B_MODE);
 	PUSH_COB(FLANK_B_DIR);
@@ -15,6 +15,7 @@
 #include "LuaUtils.h"
 #include "LuaZip.h"
 #include "Game/Game.h"
+#include "Game/GameHelper.h"
 #include "Game/Action.h"
 #include "Game/GlobalUnsynced.h"
 #include "Game/Players/Player.h"
@@ -31,6 +32,7 @@
 #include "Sim/Features/FeatureDef.h"
 #include "Sim/Units/Unit.h"
 #include "Sim/Units/UnitDef.h"
+#include "Sim/Units/UnitHandler.h"
 #include "Sim/Weapons/Weapon.h"
 #include "Sim/Weapons/WeaponDef.h"
 #include "System/creg/SerializeLuaState.h"
@@ -121,11 +123,10 @@ CLuaHandle::CLuaHandle(const string& _name, int _order, bool _userMode, bool _sy
 	: CEventClient(_name, _order, _synced)
 	, userMode(_userMode)
 	, killMe(false)
-	// no shared pool for LuaIntro to protect against LoadingMT=1
-	// do not use it for LuaMenu either; too many blocks allocated
-	// by *other* states end up not being recycled which presently
-	// forces clearing the shared pool on reload
-	, D(_name != "LuaIntro" && name != "LuaMenu", true)
+	// every handle gets its own pool, used as an arena: closing the
+	// state releases all of its pages at once instead of recycling
+	// blocks into a pool shared with other (possibly MT) states
+	, D(false, true)
 {
 	D.owner = this;
 	D.synced = _synced;
@@ -185,6 +186,7 @@ void CLuaHandle::KillLua(bool inFreeHandler)
 	// state to become non-valid so that LoadHandler returns
 	// false and FreeHandler runs next
 	LUA_ERASE_CONTEXT(&D, LUAHANDLE_CONTEXTS[D.synced]);
+	D.memPool->BeginArenaTeardown();
 	LUA_CLOSE(&L);
 }
 
@@ -599,7 +601,15 @@ bool CLuaHandle::HasCallIn(lua_State* L, const string& name) const
 	if (!IsValid())
 		return false;
 
-	if (name == "CollectGarbage")
+	if (name == "CollectGarbage" || name == "FlushCallInBatches")
+		return true;
+
+	// batched variants are delivered through the event of the plain name
+	if (name == "UnitDamaged" && WantsBatchedCallIn(BATCHED_UNIT_DAMAGED))
+		return true;
+	if (name == "ProjectileCreated" && WantsBatchedCallIn(BATCHED_PROJECTILE_CREATED))
+		return true;
+	if (name == "Explosion" && WantsBatchedCallIn(BATCHED_EXPLOSION))
 		return true;
 
 	//FIXME should be equal to below, but somehow it isn't and doesn't work as expected!?
@@ -620,6 +630,12 @@ bool CLuaHandle::HasCallIn(lua_State* L, const string& name) const
 bool CLuaHandle::UpdateCallIn(lua_State* L, const string& name)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
+	// (un)defining e.g. UnitDamagedBatch toggles the UnitDamaged event
+	if (name.size() > 5 && StringEndsWith(name, "Batch"))
+		return UpdateCallIn(L, name.substr(0, name.size() - 5));
+
+	UpdateBatchedCallIn(L, name);
+
 	if (HasCallIn(L, name)) {
 		eventHandler.InsertEvent(this, name);
 	} else {
@@ -1282,6 +1298,19 @@ void CLuaHandle::UnitDamaged(
 	LUA_CALL_IN_CHECK(L);
 	luaL_checkstack(L, 11, __func__);
 
+	if (WantsBatchedCallIn(BATCHED_UNIT_DAMAGED)) {
+		// synced handles have full read access, attacker info is never hidden
+		QueueBatchedCallIn(BATCHED_UNIT_DAMAGED).args = {
+			float(unit->id), float(unit->unitDef->id), float(unit->team),
+			damage, float(paralyzer),
+			float(weaponDefID), float(projectileID),
+			float((attacker != nullptr)? attacker->id: -1),
+			float((attacker != nullptr)? attacker->unitDef->id: -1),
+			float((attacker != nullptr)? attacker->team: -1),
+		};
+		return;
+	}
+
 	static const LuaHashString cmdStr(__func__);
 	const LuaUtils::ScopedDebugTraceBack traceBack(L);
 
@@ -2048,6 +2077,15 @@ void CLuaHandle::ProjectileCreated(const CProjectile* p)
 	LUA_CALL_IN_CHECK(L);
 	luaL_checkstack(L, 5, __func__);
 
+	if (WantsBatchedCallIn(BATCHED_PROJECTILE_CREATED)) {
+		QueueBatchedCallIn(BATCHED_PROJECTILE_CREATED).args = {
+			float(p->id),
+			float((owner != nullptr)? owner->id: -1),
+			float((wd != nullptr)? wd->id: -1),
+		};
+		return;
+	}
+
 	static const LuaHashString cmdStr(__func__);
 
 	if (!cmdStr.GetGlobalFunc(L))
@@ -2144,6 +2182,19 @@ bool CLuaHandle::Explosion(int weaponDefID, int projectileID, const float3& pos,
 	LUA_CALL_IN_CHECK(L, false);
 	luaL_checkstack(L, 7, __func__);
 
+	if (WantsBatchedCallIn(BATCHED_EXPLOSION)) {
+		// the gfx wait for ExplosionBatch, which may still suppress them
+		BatchedCallIn& event = QueueBatchedCallIn(BATCHED_EXPLOSION);
+		event.gfxID = helper->DeferExplosionGfx();
+		event.args = {
+			float(weaponDefID),
+			pos.x, pos.y, pos.z,
+			float((owner != nullptr)? owner->id: -1),
+			float(projectileID),
+		};
+		return false;
+	}
+
 	static const LuaHashString cmdStr(__func__);
 	if (!cmdStr.GetGlobalFunc(L))
 		return false;
@@ -3781,6 +3832,219 @@ void CLuaHandle::CollectGarbage(bool forced)
 	eventHandler.DbgTimingInfo(TIMING_GC, startTime, finishTime);
 }
 
+
+/*** Batched call-ins
+ *
+ * Synced handles that define one of these receive the matching event
+ * (UnitDamaged, ProjectileCreated, Explosion) once per sim-frame phase
+ * instead of once per occurrence. Events of different types keep their
+ * relative order; consecutive events of one type are passed as a flat
+ * array of `numEvents * stride` values. The array is reused between
+ * calls and entries past `numEvents * stride` are stale.
+ *
+ * Damage already dealt can not be replaced from here (UnitPreDamaged
+ * stays synchronous and is the only damage override), but
+ * UnitDamagedBatch may return an array with additional damage per
+ * event, and ExplosionBatch may return an array with a noGfx flag per
+ * event. The engine holds back the graphics of
+ * batched explosions until ExplosionBatch has run.
+ *
+ * @section batched
+ */
+
+/*** @function UnitDamagedBatch
+ * @number numEvents
+ * @tparam table events unitID, unitDefID, unitTeam, damage, paralyzer, weaponDefID, projectileID, attackerID, attackerDefID, attackerTeam (attacker fields are nil if there is none)
+ * @treturn[opt] table additionalDamage per event (nil or 0 for none), dealt on top of the applied damage like Spring.AddUnitDamage(unitID, additionalDamage, 0, attackerID, weaponDefID); negative values heal, paralyzer events are ignored
+ */
+
+/*** @function ProjectileCreatedBatch
+ * @number numEvents
+ * @tparam table events proID, proOwnerID, weaponDefID
+ */
+
+/*** @function ExplosionBatch
+ * @number numEvents
+ * @tparam table events weaponDefID, px, py, pz, attackerID, projectileID (attackerID is nil if there is none)
+ * @treturn[opt] table noGfx per event, as returned by Explosion
+ */
+
+static const LuaHashString batchedCallInStrs[] = {
+	LuaHashString("UnitDamagedBatch"),
+	LuaHashString("ProjectileCreatedBatch"),
+	LuaHashString("ExplosionBatch"),
+};
+
+// number of values per event, and which of them are booleans or nil when negative
+static constexpr size_t batchedCallInStrides[] = {10, 3, 6};
+static constexpr uint32_t batchedCallInBoolArgs[] = {1 << 4, 0, 0};
+static constexpr uint32_t batchedCallInNilArgs[] = {(1 << 7) | (1 << 8) | (1 << 9), 0, 1 << 4};
+// 1 if the call-in may return a table with one value per event
+static constexpr int batchedCallInResults[] = {1, 0, 1};
+
+
+void CLuaHandle::UpdateBatchedCallIn(lua_State* L, const string& name)
+{
+	for (int type = BATCHED_UNIT_DAMAGED; type < BATCHED_CALLIN_COUNT; type++) {
+		const LuaHashString& batchStr = batchedCallInStrs[type];
+
+		if ((name.size() + 5) != strlen(batchStr.GetString()) || !StringStartsWith(batchStr.GetString(), name))
+			continue;
+
+		batchedCallInFuncs[type] = false;
+
+		// unsynced handles would need per-event visibility checks
+		if (!IsValid() || !GetLuaContextData(L)->synced)
+			return;
+
+		batchStr.GetGlobal(L);
+		batchedCallInFuncs[type] = lua_isfunction(L, -1);
+		lua_pop(L, 1);
+		return;
+	}
+}
+
+CLuaHandle::BatchedCallIn& CLuaHandle::QueueBatchedCallIn(BatchedCallInType type)
+{
+	BatchedCallIn& event = batchedCallIns.emplace_back();
+	event.type = type;
+	event.gfxID = 0;
+	return event;
+}
+
+void CLuaHandle::FlushCallInBatches()
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	if (batchedCallIns.empty())
+		return;
+
+	// events raised by the batch call-ins themselves go into the next flush
+	flushedCallIns.clear();
+	std::swap(batchedCallIns, flushedCallIns);
+
+	for (size_t i = 0, j = 0; i < flushedCallIns.size(); i = j) {
+		for (j = i + 1; j < flushedCallIns.size() && flushedCallIns[j].type == flushedCallIns[i].type; j++) {}
+
+		RunBatchedCallIn(&flushedCallIns[i], j - i);
+
+		// handle was killed by an error in the call-in
+		if (!IsValid())
+			return;
+	}
+}
+
+void CLuaHandle::RunBatchedCallIn(const BatchedCallIn* events, size_t numEvents)
+{
+	const BatchedCallInType type = events[0].type;
+	const size_t stride = batchedCallInStrides[type];
+	const size_t numValues = numEvents * stride;
+
+	LUA_CALL_IN_CHECK(L);
+	luaL_checkstack(L, 6, __func__);
+
+	const LuaHashString& cmdStr = batchedCallInStrs[type];
+	const LuaUtils::ScopedDebugTraceBack traceBack(L);
+
+	// may have been undefined after the events were queued
+	if (!cmdStr.GetGlobalFunc(L))
+		return;
+
+	lua_pushnumber(L, numEvents);
+
+	if (batchTableRefs[type] == LUA_NOREF || batchTableSizes[type] < numValues) {
+		luaL_unref(L, LUA_REGISTRYINDEX, batchTableRefs[type]);
+
+		batchTableSizes[type] = std::max(numValues, batchTableSizes[type] * 2);
+
+		lua_createtable(L, batchTableSizes[type], 0);
+		lua_pushvalue(L, -1);
+		batchTableRefs[type] = luaL_ref(L, LUA_REGISTRYINDEX);
+	} else {
+		lua_rawgeti(L, LUA_REGISTRYINDEX, batchTableRefs[type]);
+	}
+
+	for (size_t i = 0, n = 0; i < numEvents; i++) {
+		for (size_t k = 0; k < stride; k++) {
+			const float arg = events[i].args[k];
+
+			if ((batchedCallInBoolArgs[type] >> k) & 1) {
+				lua_pushboolean(L, arg != 0.0f);
+			} else if (((batchedCallInNilArgs[type] >> k) & 1) && arg < 0.0f) {
+				lua_pushnil(L);
+			} else {
+				lua_pushnumber(L, arg);
+			}
+
+			lua_rawseti(L, -2, ++n);
+		}
+	}
+
+	const int numResults = batchedCallInResults[type];
+
+	if (!RunCallInTraceback(L, cmdStr, 2, numResults, traceBack.GetErrFuncIdx(), false))
+		return;
+	if (numResults == 0)
+		return;
+
+	if (!lua_istable(L, -1)) {
+		lua_pop(L, 1);
+		return;
+	}
+
+	// copy the results first, dealing damage runs further call-ins; for
+	// UnitDamaged they are additive, the damage of the event already applied
+	batchResults.clear();
+	batchResults.resize(numEvents, 0.0f);
+
+	for (size_t i = 0; i < numEvents; i++) {
+		lua_rawgeti(L, -1, i + 1);
+
+		if (type == BATCHED_EXPLOSION) {
+			batchResults[i] = lua_toboolean(L, -1);
+		} else {
+			// no luaL_opt*, errors can not be raised outside the call-in
+			batchResults[i] = lua_isnumber(L, -1)? lua_tofloat(L, -1): 0.0f;
+		}
+
+		lua_pop(L, 1);
+	}
+
+	lua_pop(L, 1);
+
+	for (size_t i = 0; i < numEvents; i++) {
+		if (batchResults[i] == 0.0f)
+			continue;
+
+		const auto& args = events[i].args;
+
+		switch (type) {
+			case BATCHED_UNIT_DAMAGED: {
+				// paralyzer events do not carry the paralyzeDamageTime
+				if (args[4] != 0.0f)
+					break;
+
+				CUnit* unit = unitHandler.GetUnit(int(args[0]));
+				CUnit* attacker = (args[7] >= 0.0f)? unitHandler.GetUnit(int(args[7])): nullptr;
+
+				if (unit == nullptr)
+					break;
+
+				// additional damage, the original hit is not undone
+				DamageArray damages;
+				damages.Set(unit->armorType, batchResults[i]);
+
+				unit->DoDamage(damages, ZeroVector, attacker, int(args[5]), -1);
+			} break;
+			case BATCHED_EXPLOSION: {
+				helper->SuppressExplosionGfx(events[i].gfxID);
+			} break;
+			default: {
+				assert(false);
+			} break;
+		}
+	}
+}
+
 /******************************************************************************/
 /******************************************************************************/
 
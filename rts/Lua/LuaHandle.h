@@ -10,6 +10,7 @@
 #include "LuaHashString.h"
 #include "lib/lua/include/LuaInclude.h" //FIXME needed for GetLuaContextData
 
+#include <array>
 #include <map>
 #include <string>
 #include <tuple>
@@ -102,7 +103,7 @@ class CLuaHandle : public CEventClient
 		CLuaDisplayLists& GetDisplayLists(const lua_State* L = NULL) { return GetLuaContextData(L)->displayLists; }
 #endif
 	public: // call-ins
-		bool WantsEvent(const std::string& name) override { return HasCallIn(L, name); }
+		bool WantsEvent(const std::string& name) override { UpdateBatchedCallIn(L, name); return HasCallIn(L, name); }
 		virtual bool HasCallIn(lua_State* L, const std::string& name) const;
 		virtual bool UpdateCallIn(lua_State* L, const std::string& name);
 
@@ -275,6 +276,7 @@ class CLuaHandle : public CEventClient
 		//FIXME void MetalMapChanged(const int x, const int z);
 
 		void CollectGarbage(bool forced) override;
+		void FlushCallInBatches() override;
 
 		void DownloadQueued(int ID, const std::string& archiveName, const std::string& archiveType) override;
 		void DownloadStarted(int ID) override;
@@ -319,6 +321,26 @@ class CLuaHandle : public CEventClient
 
 		void DrawObjectsLua(std::initializer_list<bool> bools, const char* func);
 		void InitializeRmlUi();
+
+	protected:
+		/// synced handles defining e.g. UnitDamagedBatch receive these events once per sim-frame phase
+		enum BatchedCallInType {
+			BATCHED_UNIT_DAMAGED       = 0,
+			BATCHED_PROJECTILE_CREATED = 1,
+			BATCHED_EXPLOSION          = 2,
+			BATCHED_CALLIN_COUNT       = 3,
+		};
+
+		struct BatchedCallIn {
+			BatchedCallInType type;
+			uint32_t gfxID; // CGameHelper id of the explosion gfx ExplosionBatch may suppress
+			std::array<float, 10> args; // lua_Number is float
+		};
+
+		void UpdateBatchedCallIn(lua_State* L, const std::string& name);
+		bool WantsBatchedCallIn(BatchedCallInType type) const { return batchedCallInFuncs[type]; }
+		BatchedCallIn& QueueBatchedCallIn(BatchedCallInType type);
+		void RunBatchedCallIn(const BatchedCallIn* events, size_t numEvents);
 	protected:
 		bool rmlui = false;
 		bool userMode = false;
@@ -341,6 +363,17 @@ class CLuaHandle : public CEventClient
 		std::vector<bool> watchExplosionDefs;   // callin masks for Explosion
 		std::vector<bool> watchAllowTargetDefs; // callin masks for AllowWeapon*Target*
 
+		std::vector<BatchedCallIn> batchedCallIns; // queued in event order, flushed by FlushCallInBatches
+		std::vector<BatchedCallIn> flushedCallIns;
+
+		// whether the *Batch function was defined when its event was last (re)registered
+		std::array<bool, BATCHED_CALLIN_COUNT> batchedCallInFuncs = {};
+
+		// registry refs to the argument tables reused by each *Batch call-in
+		std::array<int, BATCHED_CALLIN_COUNT> batchTableRefs = {LUA_NOREF, LUA_NOREF, LUA_NOREF};
+		std::array<size_t, BATCHED_CALLIN_COUNT> batchTableSizes = {};
+		std::vector<float> batchResults; // per-event values returned by a *Batch call-in
+
 	private: // call-outs
 		static int KillActiveHandle(lua_State* L);
 		static int CallOutGetName(lua_State* L);
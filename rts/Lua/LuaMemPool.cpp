@@ -68,6 +68,9 @@ void LuaMemPool::ReleasePtr(LuaMemPool* p, const CLuaHandle* o)
 		return;
 	}
 
+	// release the whole arena now rather than when p is reacquired
+	p->Clear();
+
 	gMutex.lock();
 	gIndcs.push_back(p->GetGlobalIndex());
 	gMutex.unlock();
@@ -91,25 +94,94 @@ void LuaMemPool::KillStatic()
 
 
 LuaMemPool::LuaMemPool(bool isEnabled): LuaMemPool(size_t(-1)) { assert(isEnabled == LuaMemPool::enabled); }
-LuaMemPool::LuaMemPool(size_t lmpIndex): globalIndex(lmpIndex)
+LuaMemPool::LuaMemPool(size_t lmpIndex): globalIndex(lmpIndex) {}
+
+
+size_t LuaMemPool::GetSizeClass(size_t size)
 {
-	RECOIL_DETAILED_TRACY_ZONE;
-	if (!LuaMemPool::enabled)
+	// maps (size - 1) / 16 to the smallest class that fits
+	static constexpr auto SIZE_CLASS_TABLE = []() {
+		std::array<uint8_t, MAX_SLAB_SIZE / 16> table = {};
+
+		for (size_t i = 0, c = 0; i < table.size(); i++) {
+			while (SIZE_CLASSES[c] < (i + 1) * 16)
+				c++;
+
+			table[i] = c;
+		}
+
+		return table;
+	}();
+
+	if (size == 0 || size > MAX_SLAB_SIZE)
+		return NUM_SIZE_CLASSES;
+
+	return SIZE_CLASS_TABLE[(size - 1) / 16];
+}
+
+void* LuaMemPool::AllocSlab(size_t sizeClass)
+{
+	SizeClass& sc = sizeClasses[sizeClass];
+
+	if (sc.freeList != nullptr) {
+		void* ptr = sc.freeList;
+
+		sc.freeList = *static_cast<void**>(ptr);
+		sizeClassStats[sizeClass].hits += 1;
+		return ptr;
+	}
+
+	sizeClassStats[sizeClass].misses += 1;
+
+	if ((sc.pageCurr + SIZE_CLASSES[sizeClass]) > sc.pageEnd) {
+		// the page remainder too small for another block is wasted
+		uint8_t* page = static_cast<uint8_t*>(::operator new(SLAB_PAGE_SIZE));
+
+		slabPages.push_back(page);
+
+		sc.pageCurr = page;
+		sc.pageEnd = page + SLAB_PAGE_SIZE;
+	}
+
+	void* ptr = sc.pageCurr;
+
+	sc.pageCurr += SIZE_CLASSES[sizeClass];
+	return ptr;
+}
+
+void LuaMemPool::FreeSlab(void* ptr, size_t sizeClass)
+{
+	// the whole arena is about to be released
+	if (arenaTeardown)
 		return;
 
-	luaMemPoolImpl = std::make_unique<LuaMemPool::LuaMemPoolImpl>();
+	SizeClass& sc = sizeClasses[sizeClass];
+
+	*static_cast<void**>(ptr) = sc.freeList;
+	sc.freeList = ptr;
 }
 
+
 void LuaMemPool::Clear()
 {
 	RECOIL_DETAILED_TRACY_ZONE;
-	//allocStats = {};
+	// releases every block of the arena at once
+	for (uint8_t* page: slabPages) {
+		::operator delete(page);
+	}
+
+	slabPages.clear();
+
+	sizeClasses = {};
+	arenaTeardown = false;
 }
 
 void* LuaMemPool::Alloc(size_t size)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
-	if (!LuaMemPool::enabled) {
+	const size_t sizeClass = GetSizeClass(size);
+
+	if (!LuaMemPool::enabled || sizeClass == NUM_SIZE_CLASSES) {
 		allocStats[STAT_NAE] += 1 * (size > 0);
 		allocStats[STAT_NBE] += size;
 		auto t0 = spring_now();
@@ -119,22 +191,11 @@ void* LuaMemPool::Alloc(size_t size)
 	}
 
 	auto t0 = spring_now();
-	auto* ptr = luaMemPoolImpl->allocMem(size);
-	
-	if (size > NUM_BUCKETS * BUCKET_STEP) {
-		allocStats[STAT_NAE] += 1 * (size > 0);
-		allocStats[STAT_NBE] += size;
-		allocStats[STAT_NTE] += (spring_now() - t0).toMicroSecsi();
-	} else if (luaMemPoolImpl->isAllocInternal(ptr)) {
-		allocStats[STAT_NAI] += 1 * (size > 0);
-		allocStats[STAT_NBI] += size;
-		allocStats[STAT_NTI] += (spring_now() - t0).toMicroSecsi();
-	} else {
-		allocStats[STAT_NAF] += 1 * (size > 0);
-		allocStats[STAT_NBF] += size;
-		allocStats[STAT_NTF] += (spring_now() - t0).toMicroSecsi();
-	}
+	void* ptr = AllocSlab(sizeClass);
 
+	allocStats[STAT_NAI] += 1;
+	allocStats[STAT_NBI] += size;
+	allocStats[STAT_NTI] += (spring_now() - t0).toMicroSecsi();
 	return ptr;
 }
 
@@ -144,80 +205,75 @@ void* LuaMemPool::Realloc(void* ptr, size_t nsize, size_t osize)
 	if (ptr == nullptr || osize == 0)
 		return Alloc(nsize);
 
-	if (!LuaMemPool::enabled) {
-		void* newPtr = ::operator new(nsize);
+	// shrinking or growing within the same class keeps the block
+	if (LuaMemPool::enabled && GetSizeClass(nsize) == GetSizeClass(osize) && GetSizeClass(nsize) != NUM_SIZE_CLASSES)
+		return ptr;
 
-		if (newPtr == nullptr)
-			return nullptr;
+	void* newPtr = Alloc(nsize);
 
-		allocStats[STAT_NBE] -= osize;
-		allocStats[STAT_NBE] += nsize;
+	if (newPtr == nullptr)
+		return nullptr;
 
-		auto t0 = spring_now();
-		std::memcpy(newPtr, ptr, std::min(nsize, osize));
-		std::memset(ptr, 0, osize);
-		::operator delete(ptr);
-		allocStats[STAT_NTE] += (spring_now() - t0).toMicroSecsi();
+	std::memcpy(newPtr, ptr, std::min(nsize, osize));
+	Free(ptr, osize);
 
-		return newPtr;
-	}
-
-	auto t0 = spring_now();
-	auto* ret = luaMemPoolImpl->reAllocMem(ptr, nsize);
-	if (nsize > NUM_BUCKETS * BUCKET_STEP) {
-		allocStats[STAT_NAE] += 1 * (nsize > 0);
-		allocStats[STAT_NBE] += nsize;
-		allocStats[STAT_NTE] += (spring_now() - t0).toMicroSecsi();
-	}
-	else if (luaMemPoolImpl->isAllocInternal(ret)) {
-		allocStats[STAT_NAI] += 1 * (nsize > 0);
-		allocStats[STAT_NBI] += nsize;
-		allocStats[STAT_NTI] += (spring_now() - t0).toMicroSecsi();
-	}
-	else {
-		allocStats[STAT_NAF] += 1 * (nsize > 0);
-		allocStats[STAT_NBF] += nsize;
-		allocStats[STAT_NTF] += (spring_now() - t0).toMicroSecsi();
-	}
-	return ret;
+	return newPtr;
 }
 
 void LuaMemPool::Free(void* ptr, size_t size)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
-	if (!LuaMemPool::enabled) {
+	if (ptr == nullptr)
+		return;
+
+	const size_t sizeClass = GetSizeClass(size);
+
+	if (!LuaMemPool::enabled || sizeClass == NUM_SIZE_CLASSES) {
 		::operator delete(ptr);
 		return;
 	}
 
-	luaMemPoolImpl->freeMem(ptr);
+	FreeSlab(ptr, sizeClass);
 }
 
 void LuaMemPool::LogStats(const char* handle, const char* lctype)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
 	static constexpr auto one = uint64_t(1);
-	const float intPerc = 100.0f * static_cast<float>(allocStats[STAT_NAI]) / static_cast<float>(std::max(allocStats[STAT_NAI] + allocStats[STAT_NAF] + allocStats[STAT_NAE], one));
+	const float intPerc = 100.0f * static_cast<float>(allocStats[STAT_NAI]) / static_cast<float>(std::max(allocStats[STAT_NAI] + allocStats[STAT_NAE], one));
 	const float avgAllocTimeI = static_cast<float>(allocStats[STAT_NTI]) / static_cast<float>(std::max(allocStats[STAT_NAI], one));
-	const float avgAllocTimeF = static_cast<float>(allocStats[STAT_NTF]) / static_cast<float>(std::max(allocStats[STAT_NAF], one));
 	const float avgAllocTimeE = static_cast<float>(allocStats[STAT_NTE]) / static_cast<float>(std::max(allocStats[STAT_NAE], one));
 	std::string msg = fmt::sprintf(
-		"[LuaMemPool::%s][handle=%s (%s)] index=%u numAllocs{int+, int-, ext, int_p}={%u, %u, %u, %.1f} allocedSize{int+, int-, ext}={%u, %u, %u}, avgAllocTime{int+, int-, ext}={%.4f, %.4f, %.4f}",
+		"[LuaMemPool::%s][handle=%s (%s)] index=%u numAllocs{int, ext, int_p}={%u, %u, %.1f} allocedSize{int, ext}={%u, %u}, avgAllocTime{int, ext}={%.4f, %.4f} numPages=%u",
 		__func__,
 		handle,
 		lctype,
 		globalIndex,
 		allocStats[STAT_NAI],
-		allocStats[STAT_NAF],
 		allocStats[STAT_NAE],
 		intPerc,
 		allocStats[STAT_NBI],
-		allocStats[STAT_NBF],
 		allocStats[STAT_NBE],
 		avgAllocTimeI,
-		avgAllocTimeF,
-		avgAllocTimeE
+		avgAllocTimeE,
+		slabPages.size()
 	);
+
+	// hits are free-list reuses, misses are blocks carved from pages
+	msg += " sizeClasses{size:hits/misses}={";
+
+	for (size_t i = 0; i < NUM_SIZE_CLASSES; i++) {
+		const SizeClassStats& scs = sizeClassStats[i];
+
+		if ((scs.hits + scs.misses) == 0)
+			continue;
+
+		msg += fmt::sprintf(" %u:%u/%u", SIZE_CLASSES[i], scs.hits, scs.misses);
+	}
+
+	msg += " }";
+
 	LOG("%s", msg.c_str());
 	allocStats = {};
+	sizeClassStats = {};
 }
@@ -2,15 +2,10 @@
 
 #pragma once
 
+#include <array>
 #include <cstddef>
+#include <cstdint>
 #include <vector>
-#include <memory>
-
-#include "System/bitops.h"
-#include "System/MemPoolTypes.h"
-#include "System/UnorderedMap.hpp"
-
-#define LMP_USE_CHUNK_TABLE 0
 
 class CLuaHandle;
 class LuaMemPool {
@@ -18,14 +13,7 @@ public:
 	explicit LuaMemPool(bool isEnabled);
 	explicit LuaMemPool(size_t lmpIndex);
 
-	~LuaMemPool() {
-		Clear();
-
-		if (!LuaMemPool::enabled)
-			return;
-
-		luaMemPoolImpl = nullptr;
-	}
+	~LuaMemPool() { Clear(); }
 
 	LuaMemPool(const LuaMemPool& p) = delete;
 	LuaMemPool(LuaMemPool&& p) = delete;
@@ -50,6 +38,10 @@ public:
 	void* Realloc(void* ptr, size_t nsize, size_t osize);
 	void Free(void* ptr, size_t size);
 
+	// called right before the owning state is closed; its small blocks
+	// are then not freed one by one but released with all pages by Clear
+	void BeginArenaTeardown() { arenaTeardown = (this != GetSharedPtr()); }
+
 	void LogStats(const char* handle, const char* lctype);
 
 	size_t  GetGlobalIndex() const { return globalIndex; }
@@ -58,26 +50,60 @@ public:
 
 public:
 	static bool enabled;
+
+	// tuned to common Lua object sizes on 64-bit targets: strings (24 + len),
+	// tables (64), closures (40 + 8 * nups), upvalues (40), userdata (40 + n),
+	// array parts (16 * n) and hash parts (40 * 2^n)
+	static constexpr size_t NUM_SIZE_CLASSES = 20;
+	static constexpr std::array<uint32_t, NUM_SIZE_CLASSES> SIZE_CLASSES = {
+		  16,   32,   48,   64,   80,   96,  112,  128,
+		 160,  192,  224,  256,  320,  384,  448,  512,
+		 768, 1024, 1536, 2048,
+	};
+
+	static constexpr size_t MAX_SLAB_SIZE = SIZE_CLASSES[NUM_SIZE_CLASSES - 1];
+	static constexpr size_t SLAB_PAGE_SIZE = 64 * 1024;
+
+	struct SizeClassStats {
+		uint64_t hits = 0;   // allocations served from the free-list
+		uint64_t misses = 0; // allocations carved from a page
+	};
+
+	const std::array<SizeClassStats, NUM_SIZE_CLASSES>& GetSizeClassStats() const { return sizeClassStats; }
+
+private:
+	struct SizeClass {
+		void* freeList = nullptr;
+
+		uint8_t* pageCurr = nullptr;
+		uint8_t* pageEnd = nullptr;
+	};
+
+	static size_t GetSizeClass(size_t size);
+
+	void* AllocSlab(size_t sizeClass);
+	void FreeSlab(void* ptr, size_t sizeClass);
+
 private:
-	static constexpr uint32_t NUM_BUCKETS = 32;
-	static constexpr uint32_t BUCKET_STEP = 16;
-	using LuaMemPoolImpl = PassThroughPool<NUM_BUCKETS, 4 * (1024 * 1024)>;
-	std::unique_ptr<LuaMemPoolImpl> luaMemPoolImpl;
+	// pools are never shared between threads, so the free-lists need no locks
+	std::array<SizeClass, NUM_SIZE_CLASSES> sizeClasses;
+	std::array<SizeClassStats, NUM_SIZE_CLASSES> sizeClassStats;
+
+	std::vector<uint8_t*> slabPages;
 
 	enum {
 		STAT_NAI = 0, // number of internal allocs
-		STAT_NAF = 1, // number of int fail allocs
-		STAT_NAE = 2, // number of external allocs
-		STAT_NBI = 3, // number of bytes alloced (internal)
-		STAT_NBF = 4, // number of bytes alloced (int fail)
-		STAT_NBE = 5, // number of bytes alloced (external)
-		STAT_NTI = 6, // cumulative time spent on internal allocs
-		STAT_NTF = 7, // cumulative time spent on int fail allocs
-		STAT_NTE = 8, // cumulative time spent on external allocs
+		STAT_NAE = 1, // number of external allocs
+		STAT_NBI = 2, // number of bytes alloced (internal)
+		STAT_NBE = 3, // number of bytes alloced (external)
+		STAT_NTI = 4, // cumulative time spent on internal allocs
+		STAT_NTE = 5, // cumulative time spent on external allocs
 	};
 
-	std::array<uint64_t, 9> allocStats = { 0, 0, 0, 0, 0 };
+	std::array<uint64_t, 6> allocStats = {0, 0, 0, 0, 0, 0};
 
 	size_t globalIndex = 0;
 	size_t sharedCount = 0;
-};
\ No newline at end of file
+
+	bool arenaTeardown = false;
+};
@@ -78,6 +78,8 @@
 #include "System/StringUtil.h"
 
 #include <cctype>
+#include <cmath>
+#include <limits>
 #include <type_traits>
 
 
@@ -86,6 +88,8 @@ using std::max;
 
 static const LuaHashString hs_n("n");
 
+static void CreateUnitArrayBufferMetatable(lua_State* L);
+
 
 /******************************************************************************
  * Synced Read
@@ -189,6 +193,11 @@ bool LuaSyncedRead::PushEntries(lua_State* L)
 	REGISTER_LUA_CFUNC(GetUnitArrayCentroid);
 	REGISTER_LUA_CFUNC(GetUnitMapCentroid);
 
+	CreateUnitArrayBufferMetatable(L);
+	REGISTER_LUA_CFUNC(GetUnitArrayPositions);
+	REGISTER_LUA_CFUNC(GetUnitArrayVelocities);
+	REGISTER_LUA_CFUNC(GetUnitArrayHealths);
+
 	REGISTER_LUA_CFUNC(GetFeaturesInRectangle);
 	REGISTER_LUA_CFUNC(GetFeaturesInSphere);
 	REGISTER_LUA_CFUNC(GetFeaturesInCylinder);
@@ -548,6 +557,50 @@ static int GetSolidObjectRotation(lua_State* L, const CSolidObject* o)
 	return 3;
 }
 
+// NaN marks values hidden from the reader
+static void GetUnitHealthValues(lua_State* L, const CUnit* unit, float* values)
+{
+	const UnitDef* ud = unit->unitDef;
+	const bool enemyUnit = LuaUtils::IsEnemyUnit(L, unit);
+
+	if (ud->hideDamage && enemyUnit) {
+		values[0] = std::numeric_limits<float>::quiet_NaN();
+		values[1] = std::numeric_limits<float>::quiet_NaN();
+		values[2] = std::numeric_limits<float>::quiet_NaN();
+	} else if (!enemyUnit || (ud->decoyDef == nullptr)) {
+		values[0] = unit->health;
+		values[1] = unit->maxHealth;
+		values[2] = unit->paralyzeDamage;
+	} else {
+		const float scale = (ud->decoyDef->health / ud->health);
+		values[0] = scale * unit->health;
+		values[1] = scale * unit->maxHealth;
+		values[2] = scale * unit->paralyzeDamage;
+	}
+	values[3] = unit->captureProgress;
+	values[4] = unit->buildProgress;
+}
+
+static void GetUnitPositionValues(lua_State* L, const CUnit* unit, float* values)
+{
+	float3 errorVec;
+
+	if (!LuaUtils::IsAllyUnit(L, unit))
+		errorVec = unit->GetLuaErrorVector(CLuaHandle::GetHandleReadAllyTeam(L), CLuaHandle::GetHandleFullRead(L));
+
+	values[0] = unit->pos.x + errorVec.x;
+	values[1] = unit->pos.y + errorVec.y;
+	values[2] = unit->pos.z + errorVec.z;
+}
+
+static void GetUnitVelocityValues(lua_State* L, const CUnit* unit, float* values)
+{
+	values[0] = unit->speed.x;
+	values[1] = unit->speed.y;
+	values[2] = unit->speed.z;
+	values[3] = unit->speed.w;
+}
+
 static int GetSolidObjectBlocking(lua_State* L, const CSolidObject* o)
 {
 	if (o == nullptr)
@@ -3355,6 +3408,170 @@ int LuaSyncedRead::GetUnitMapCentroid(lua_State* L)
 }
 
 
+/******************************************************************************/
+//
+//  Bulk unit-state readers
+//
+//  These fill a reusable flat float buffer for a whole array of units in one
+//  call; Lua reads it through a read-only userdata view, so no per-unit call
+//  or intermediate table is needed. Values the reader may not see are nil.
+//
+
+struct UnitArrayBuffer {
+	std::vector<float> values;
+	size_t stride = 0;
+};
+
+static int unitarraybuffer_gc(lua_State* L)
+{
+	static_cast<UnitArrayBuffer*>(luaL_checkudata(L, 1, "UnitArrayBuffer"))->~UnitArrayBuffer();
+	return 0;
+}
+
+static int unitarraybuffer_index(lua_State* L)
+{
+	const UnitArrayBuffer* buffer = static_cast<const UnitArrayBuffer*>(lua_touserdata(L, 1));
+
+	if (lua_israwnumber(L, 2)) {
+		// 1-based, negative indices wrap to out of range
+		const size_t index = static_cast<size_t>(lua_toint(L, 2)) - 1;
+
+		if (index >= buffer->values.size() || std::isnan(buffer->values[index]))
+			return 0;
+
+		lua_pushnumber(L, buffer->values[index]);
+		return 1;
+	}
+
+	if (!lua_israwstring(L, 2))
+		return 0;
+
+	const char* key = lua_tostring(L, 2);
+
+	if (strcmp(key, "stride") == 0) {
+		lua_pushnumber(L, buffer->stride);
+		return 1;
+	}
+	if (strcmp(key, "count") == 0) {
+		lua_pushnumber(L, buffer->values.size() / std::max(buffer->stride, size_t(1)));
+		return 1;
+	}
+
+	return 0;
+}
+
+static int unitarraybuffer_newindex(lua_State* L)
+{
+	luaL_error(L, "UnitArrayBuffer is read-only");
+	return 0;
+}
+
+static int unitarraybuffer_len(lua_State* L)
+{
+	lua_pushnumber(L, static_cast<const UnitArrayBuffer*>(lua_touserdata(L, 1))->values.size());
+	return 1;
+}
+
+static void CreateUnitArrayBufferMetatable(lua_State* L)
+{
+	luaL_newmetatable(L, "UnitArrayBuffer");
+	HSTR_PUSH_CFUNC(L, "__gc",       unitarraybuffer_gc);
+	HSTR_PUSH_CFUNC(L, "__index",    unitarraybuffer_index);
+	HSTR_PUSH_CFUNC(L, "__newindex", unitarraybuffer_newindex);
+	HSTR_PUSH_CFUNC(L, "__len",      unitarraybuffer_len);
+	lua_pop(L, 1);
+}
+
+static int FillUnitArrayBuffer(
+	lua_State* L,
+	const char* caller,
+	size_t stride,
+	const CUnit* (*parseUnit)(lua_State*, const char*, int),
+	void (*getValues)(lua_State*, const CUnit*, float*)
+) {
+	luaL_checktype(L, 1, LUA_TTABLE);
+
+	const size_t numUnits = lua_objlen(L, 1);
+
+	UnitArrayBuffer* buffer = nullptr;
+
+	if (lua_isnoneornil(L, 2)) {
+		buffer = new (lua_newuserdata(L, sizeof(UnitArrayBuffer))) UnitArrayBuffer();
+		luaL_getmetatable(L, "UnitArrayBuffer");
+		lua_setmetatable(L, -2);
+	} else {
+		buffer = static_cast<UnitArrayBuffer*>(luaL_checkudata(L, 2, "UnitArrayBuffer"));
+		lua_pushvalue(L, 2);
+	}
+
+	buffer->stride = stride;
+	buffer->values.resize(numUnits * stride);
+
+	for (size_t i = 0; i < numUnits; i++) {
+		float* values = &buffer->values[i * stride];
+
+		lua_rawgeti(L, 1, i + 1);
+
+		if (const CUnit* unit = parseUnit(L, caller, -1); unit != nullptr) {
+			getValues(L, unit, values);
+		} else {
+			std::fill(values, values + stride, std::numeric_limits<float>::quiet_NaN());
+		}
+
+		lua_pop(L, 1);
+	}
+
+	return 1;
+}
+
+
+/*** Fills a buffer with the positions of an array of units
+ *
+ * Same visibility rules and radar position error as Spring.GetUnitPosition.
+ * The buffer is a read-only userdata: `buffer[3 * (i - 1) + 1]` is the x
+ * coordinate of the i-th unit, `#buffer` the number of values, and
+ * `buffer.count` / `buffer.stride` the number of units and values per unit.
+ * Passing the buffer returned by a previous call reuses its storage.
+ *
+ * @function Spring.GetUnitArrayPositions
+ * @tparam table units { unitID, unitID, ... }
+ * @tparam[opt] UnitArrayBuffer buffer
+ * @treturn UnitArrayBuffer buffer 3 values per unit: posX, posY, posZ
+ */
+int LuaSyncedRead::GetUnitArrayPositions(lua_State* L)
+{
+	return FillUnitArrayBuffer(L, __func__, 3, ParseUnit, GetUnitPositionValues);
+}
+
+/*** Fills a buffer with the velocities of an array of units
+ *
+ * See Spring.GetUnitArrayPositions for the buffer layout.
+ *
+ * @function Spring.GetUnitArrayVelocities
+ * @tparam table units { unitID, unitID, ... }
+ * @tparam[opt] UnitArrayBuffer buffer
+ * @treturn UnitArrayBuffer buffer 4 values per unit: velX, velY, velZ, velLength
+ */
+int LuaSyncedRead::GetUnitArrayVelocities(lua_State* L)
+{
+	return FillUnitArrayBuffer(L, __func__, 4, ParseInLosUnit, GetUnitVelocityValues);
+}
+
+/*** Fills a buffer with the health of an array of units
+ *
+ * See Spring.GetUnitArrayPositions for the buffer layout.
+ *
+ * @function Spring.GetUnitArrayHealths
+ * @tparam table units { unitID, unitID, ... }
+ * @tparam[opt] UnitArrayBuffer buffer
+ * @treturn UnitArrayBuffer buffer 5 values per unit: health, maxHealth, paralyzeDamage, captureProgress, buildProgress
+ */
+int LuaSyncedRead::GetUnitArrayHealths(lua_State* L)
+{
+	return FillUnitArrayBuffer(L, __func__, 5, ParseInLosUnit, GetUnitHealthValues);
+}
+
+
 /***
  *
  * @function Spring.GetUnitNearestAlly
@@ -4054,25 +4271,17 @@ int LuaSyncedRead::GetUnitHealth(lua_State* L)
 	if (unit == nullptr)
 		return 0;
 
-	const UnitDef* ud = unit->unitDef;
-	const bool enemyUnit = LuaUtils::IsEnemyUnit(L, unit);
+	float values[5];
+	GetUnitHealthValues(L, unit, values);
 
-	if (ud->hideDamage && enemyUnit) {
-		lua_pushnil(L);
-		lua_pushnil(L);
-		lua_pushnil(L);
-	} else if (!enemyUnit || (ud->decoyDef == nullptr)) {
-		lua_pushnumber(L, unit->health);
-		lua_pushnumber(L, unit->maxHealth);
-		lua_pushnumber(L, unit->paralyzeDamage);
-	} else {
-		const float scale = (ud->decoyDef->health / ud->health);
-		lua_pushnumber(L, scale * unit->health);
-		lua_pushnumber(L, scale * unit->maxHealth);
-		lua_pushnumber(L, scale * unit->paralyzeDamage);
+	for (const float value: values) {
+		if (std::isnan(value)) {
+			lua_pushnil(L);
+		} else {
+			lua_pushnumber(L, value);
+		}
 	}
-	lua_pushnumber(L, unit->captureProgress);
-	lua_pushnumber(L, unit->buildProgress);
+
 	return 5;
 }
 
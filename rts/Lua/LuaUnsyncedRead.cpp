@@ -6,6 +6,7 @@
 #include "LuaInclude.h"
 #include "LuaHandle.h"
 #include "LuaHashString.h"
+#include "LuaMemPool.h"
 #include "LuaUtils.h"
 #include "LuaRules.h"
 #include "Game/Camera.h"
@@ -106,6 +107,7 @@ bool LuaUnsyncedRead::PushEntries(lua_State* L)
 	REGISTER_LUA_CFUNC(GetProfilerRecordNames);
 
 	REGISTER_LUA_CFUNC(GetLuaMemUsage);
+	REGISTER_LUA_CFUNC(GetLuaMemPoolStats);
 	REGISTER_LUA_CFUNC(GetVidMemUsage);
 
 	REGISTER_LUA_CFUNC(GetDrawFrame);
@@ -633,6 +635,36 @@ int LuaUnsyncedRead::GetLuaMemUsage(lua_State* L)
 }
 
 
+/***
+ *
+ * @function Spring.GetLuaMemPoolStats
+ *
+ * Hits are allocations served from a size class free-list, misses are
+ * blocks newly carved from a page of the calling handle's memory pool.
+ *
+ * @treturn table sizeClasses { { size, hits, misses }, ... } hits and misses divided by 1000
+ */
+int LuaUnsyncedRead::GetLuaMemPoolStats(lua_State* L)
+{
+	const auto& sizeClassStats = GetLuaContextData(L)->memPool->GetSizeClassStats();
+
+	lua_createtable(L, LuaMemPool::NUM_SIZE_CLASSES, 0);
+
+	for (size_t i = 0; i < LuaMemPool::NUM_SIZE_CLASSES; i++) {
+		lua_createtable(L, 3, 0);
+		lua_pushnumber(L, LuaMemPool::SIZE_CLASSES[i]);
+		lua_rawseti(L, -2, 1);
+		lua_pushnumber(L, sizeClassStats[i].hits / 1000.0f);
+		lua_rawseti(L, -2, 2);
+		lua_pushnumber(L, sizeClassStats[i].misses / 1000.0f);
+		lua_rawseti(L, -2, 3);
+		lua_rawseti(L, -2, i + 1);
+	}
+
+	return 1;
+}
+
+
 /***
  *
  * @function Spring.GetVidMemUsage
@@ -2,6 +2,7 @@
 
 
 #include "Ground.h"
+#include "GroundSampling.h"
 #include "ReadMap.h"
 #include "Sim/Misc/GlobalConstants.h"
 #include "Sim/Misc/GlobalSynced.h"
@@ -15,62 +16,6 @@
 #undef far // avoid collision with windef.h
 #undef near
 
-static inline float InterpolateCornerHeight(float x, float z, const float* cornerHeightMap)
-{
-	// NOTE:
-	// This isn't a bilinear interpolation. Instead it interpolates
-	// on the 2 triangles that form the ground quad:
-	//
-	// TL __________ TR
-	//    |        /|
-	//    | dx+dz / |
-	//    | \<1  /  |
-	//    |     /   |
-	//    |    /    |
-	//    |   /     |
-	//    |  / dx+dz|
-	//    | /  \>=1 |
-	//    |/        |
-	// BL ---------- BR
-	//
-	x = std::clamp(x, 0.0f, float3::maxxpos) / SQUARE_SIZE;
-	z = std::clamp(z, 0.0f, float3::maxzpos) / SQUARE_SIZE;
-
-	const int ix = x;
-	const int iz = z;
-	const int hs = ix + iz * mapDims.mapxp1;
-
-	const float dx = x - ix;
-	const float dz = z - iz;
-
-	float h = 0.0f;
-
-	if (dx + dz < 1.0f) {
-		// top-left triangle
-		const float h00 = cornerHeightMap[hs + 0                 ];
-		const float h10 = cornerHeightMap[hs + 1                 ];
-		const float h01 = cornerHeightMap[hs + 0 + mapDims.mapxp1];
-
-		const float xdif = dx * (h10 - h00);
-		const float zdif = dz * (h01 - h00);
-
-		h = h00 + xdif + zdif;
-	} else {
-		// bottom-right triangle
-		const float h10 = cornerHeightMap[hs + 1                 ];
-		const float h01 = cornerHeightMap[hs + 0 + mapDims.mapxp1];
-		const float h11 = cornerHeightMap[hs + 1 + mapDims.mapxp1];
-
-		const float xdif = (1.0f - dx) * (h01 - h11);
-		const float zdif = (1.0f - dz) * (h10 - h11);
-
-		h = h11 + xdif + zdif;
-	}
-
-	return h;
-}
-
-
 static inline float LineGroundSquareCol(
 	const float* heightmap,
 	const float3* normalmap,
@@ -470,6 +415,34 @@ float CGround::GetHeightReal(float x, float z, bool synced)
 	return InterpolateCornerHeight(x, z, readMap->GetSharedCornerHeightMap(synced));
 }
 
+void CGround::GetApproximateHeight(const float* xs, const float* zs, float* heights, size_t count, bool synced)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	const float* heightMap = readMap->GetSharedCenterHeightMap(synced);
+
+	for (size_t i = 0; i < count; ++i) {
+		const int xsquare = std::clamp(int(xs[i]) / SQUARE_SIZE, 0, mapDims.mapxm1);
+		const int zsquare = std::clamp(int(zs[i]) / SQUARE_SIZE, 0, mapDims.mapym1);
+		heights[i] = heightMap[zsquare * mapDims.mapx + xsquare];
+	}
+}
+
+void CGround::GetHeightAboveWater(const float* xs, const float* zs, float* heights, size_t count, bool synced)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	GetHeightReal(xs, zs, heights, count, synced);
+
+	for (size_t i = 0; i < count; ++i) {
+		heights[i] = std::max(0.0f, heights[i]);
+	}
+}
+
+void CGround::GetHeightReal(const float* xs, const float* zs, float* heights, size_t count, bool synced)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	InterpolateCornerHeights(xs, zs, heights, count, readMap->GetSharedCornerHeightMap(synced));
+}
+
 float CGround::GetOrigHeight(float x, float z)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
@@ -480,11 +453,13 @@ float CGround::GetOrigHeight(float x, float z)
 const float3& CGround::GetNormal(float x, float z, bool synced)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
-	const int xsquare = std::clamp(int(x) / SQUARE_SIZE, 0, mapDims.mapxm1);
-	const int zsquare = std::clamp(int(z) / SQUARE_SIZE, 0, mapDims.mapym1);
+	return SampleCenterNormal(x, z, readMap->GetSharedCenterNormals(synced));
+}
 
-	const float3* normalMap = readMap->GetSharedCenterNormals(synced);
-	return normalMap[xsquare + zsquare * mapDims.mapx];
+void CGround::GetNormal(const float* xs, const float* zs, float3* normals, size_t count, bool synced)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	SampleCenterNormals(xs, zs, normals, count, readMap->GetSharedCenterNormals(synced));
 }
 
 const float3& CGround::GetNormalAboveWater(float x, float z, bool synced)
@@ -507,6 +482,18 @@ float CGround::GetSlope(float x, float z, bool synced)
 	return slopeMap[xhsquare + zhsquare * mapDims.hmapx];
 }
 
+void CGround::GetSlope(const float* xs, const float* zs, float* slopes, size_t count, bool synced)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	const float* slopeMap = readMap->GetSharedSlopeMap(synced);
+
+	for (size_t i = 0; i < count; ++i) {
+		const int xhsquare = std::clamp(int(xs[i]) / (2 * SQUARE_SIZE), 0, mapDims.hmapx - 1);
+		const int zhsquare = std::clamp(int(zs[i]) / (2 * SQUARE_SIZE), 0, mapDims.hmapy - 1);
+		slopes[i] = slopeMap[xhsquare + zhsquare * mapDims.hmapx];
+	}
+}
+
 
 float3 CGround::GetSmoothNormal(float x, float z, bool synced)
 {
@@ -576,9 +563,36 @@ float CGround::SimTrajectoryGroundColDist(const float3& trajStartPos, const floa
 		vel += acc;
 		pos += vel;
 	}
-	while (pos.y >= GetHeightReal(pos)) {
-		vel += acc;
-		pos += vel;
+
+	// the positions do not depend on the ground, so step ahead in batches
+	// and stop at the first one that is below it
+	constexpr size_t NUM_SAMPLES = 32;
+
+	float xs[NUM_SAMPLES];
+	float ys[NUM_SAMPLES];
+	float zs[NUM_SAMPLES];
+	float hs[NUM_SAMPLES];
+
+	for (bool belowGround = false; !belowGround; ) {
+		for (size_t n = 0; n < NUM_SAMPLES; ++n) {
+			xs[n] = pos.x;
+			ys[n] = pos.y;
+			zs[n] = pos.z;
+
+			vel += acc;
+			pos += vel;
+		}
+
+		GetHeightReal(xs, zs, hs, NUM_SAMPLES);
+
+		for (size_t n = 0; n < NUM_SAMPLES; ++n) {
+			if (ys[n] >= hs[n])
+				continue;
+
+			pos = {xs[n], ys[n], zs[n]};
+			belowGround = true;
+			break;
+		}
 	}
 
 	if (pos.SqDistance2D(trajStartPos) >= Square(maxDist))
@@ -604,16 +618,37 @@ float CGround::TrajectoryGroundCol(const float3& trajStartPos, const float3& tra
 	const float minDist = length * std::max(0.0f, ips.x);
 	const float maxDist = length * std::min(1.0f, ips.y);
 
-	for (float dist = minDist; dist < maxDist; dist += SQUARE_SIZE) {
-		const float3 pos = (trajStartPos + dir * dist) + (alt * dist * dist);
+	constexpr size_t NUM_SAMPLES = 64;
+
+	float xs[NUM_SAMPLES];
+	float ys[NUM_SAMPLES];
+	float zs[NUM_SAMPLES];
+	float hs[NUM_SAMPLES];
+	float ds[NUM_SAMPLES];
+
+	for (float dist = minDist; dist < maxDist; ) {
+		size_t numSamples = 0;
+
+		for (; numSamples < NUM_SAMPLES && dist < maxDist; dist += SQUARE_SIZE) {
+			const float3 pos = (trajStartPos + dir * dist) + (alt * dist * dist);
+
+			xs[numSamples] = pos.x;
+			ys[numSamples] = pos.y;
+			zs[numSamples] = pos.z;
+			ds[numSamples] = dist;
+			numSamples++;
+		}
 
 		#if 1
-		if (GetApproximateHeight(pos) > pos.y)
-			return dist;
+		GetApproximateHeight(xs, zs, hs, numSamples);
 		#else
-		if (GetHeightReal(pos) > pos.y)
-			return dist;
+		GetHeightReal(xs, zs, hs, numSamples);
 		#endif
+
+		for (size_t n = 0; n < numSamples; ++n) {
+			if (hs[n] > ys[n])
+				return ds[n];
+		}
 	}
 
 	return -1.0f;
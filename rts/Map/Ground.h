@@ -3,6 +3,8 @@
 #ifndef GROUND_H
 #define GROUND_H
 
+#include <cstddef>
+
 #include "System/float3.h"
 #include "System/type2.h"
 
@@ -52,6 +54,13 @@ public:
 	static const float3& GetNormalAboveWater(const float3& p, bool synced = true) { return (GetNormalAboveWater(p.x, p.z, synced)); }
 	static float3 GetSmoothNormal(const float3& p, bool synced = true) { return (GetSmoothNormal(p.x, p.z, synced)); }
 
+	/// batch variants of the above; element i is identical to the scalar result for (xs[i], zs[i])
+	static void GetApproximateHeight(const float* xs, const float* zs, float* heights, size_t count, bool synced = true);
+	static void GetHeightAboveWater(const float* xs, const float* zs, float* heights, size_t count, bool synced = true);
+	static void GetHeightReal(const float* xs, const float* zs, float* heights, size_t count, bool synced = true);
+	static void GetSlope(const float* xs, const float* zs, float* slopes, size_t count, bool synced = true);
+	static void GetNormal(const float* xs, const float* zs, float3* normals, size_t count, bool synced = true);
+
 
 	static float LineGroundCol(float3 from, float3 to, bool synced = true);
 	static float LineGroundCol(const float3 pos, const float3 dir, float len, bool synced = true);
@@ -0,0 +1,159 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef GROUND_SAMPLING_H
+#define GROUND_SAMPLING_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+
+#include "Map/ReadMap.h"
+#include "Sim/Misc/GlobalConstants.h"
+#include "System/float3.h"
+
+#include "xsimd/xsimd.hpp"
+
+// heightmap sampling kernels behind CGround's scalar and batch queries
+
+static inline float InterpolateCornerHeight(float x, float z, const float* cornerHeightMap)
+{
+	// NOTE:
+	// This isn't a bilinear interpolation. Instead it interpolates
+	// on the 2 triangles that form the ground quad:
+	//
+	// TL __________ TR
+	//    |        /|
+	//    | dx+dz / |
+	//    | \<1  /  |
+	//    |     /   |
+	//    |    /    |
+	//    |   /     |
+	//    |  / dx+dz|
+	//    | /  \>=1 |
+	//    |/        |
+	// BL ---------- BR
+	//
+	x = std::clamp(x, 0.0f, float3::maxxpos) / SQUARE_SIZE;
+	z = std::clamp(z, 0.0f, float3::maxzpos) / SQUARE_SIZE;
+
+	const int ix = x;
+	const int iz = z;
+	const int hs = ix + iz * mapDims.mapxp1;
+
+	const float dx = x - ix;
+	const float dz = z - iz;
+
+	float h = 0.0f;
+
+	if (dx + dz < 1.0f) {
+		// top-left triangle
+		const float h00 = cornerHeightMap[hs + 0                 ];
+		const float h10 = cornerHeightMap[hs + 1                 ];
+		const float h01 = cornerHeightMap[hs + 0 + mapDims.mapxp1];
+
+		const float xdif = dx * (h10 - h00);
+		const float zdif = dz * (h01 - h00);
+
+		h = h00 + xdif + zdif;
+	} else {
+		// bottom-right triangle
+		const float h10 = cornerHeightMap[hs + 1                 ];
+		const float h01 = cornerHeightMap[hs + 0 + mapDims.mapxp1];
+		const float h11 = cornerHeightMap[hs + 1 + mapDims.mapxp1];
+
+		const float xdif = (1.0f - dx) * (h01 - h11);
+		const float zdif = (1.0f - dz) * (h10 - h11);
+
+		h = h11 + xdif + zdif;
+	}
+
+	return h;
+}
+
+using GroundBatchType = xsimd::simd_type<float>;
+static constexpr size_t GROUND_BATCH_SIZE = GroundBatchType::size;
+
+// same as InterpolateCornerHeight for xs[i], zs[i] (including the choice of
+// triangle and the evaluation order) but for GROUND_BATCH_SIZE positions at once
+static inline void InterpolateCornerHeights(const float* xs, const float* zs, float* hs, const float* cornerHeightMap)
+{
+	alignas(XSIMD_DEFAULT_ALIGNMENT) int32_t ixs[GROUND_BATCH_SIZE];
+	alignas(XSIMD_DEFAULT_ALIGNMENT) int32_t izs[GROUND_BATCH_SIZE];
+	alignas(XSIMD_DEFAULT_ALIGNMENT) float tls[GROUND_BATCH_SIZE];
+	alignas(XSIMD_DEFAULT_ALIGNMENT) float h10s[GROUND_BATCH_SIZE];
+	alignas(XSIMD_DEFAULT_ALIGNMENT) float h01s[GROUND_BATCH_SIZE];
+	alignas(XSIMD_DEFAULT_ALIGNMENT) float hcs[GROUND_BATCH_SIZE];
+
+	const GroundBatchType zero(0.0f);
+	const GroundBatchType one(1.0f);
+	const GroundBatchType maxx(float3::maxxpos);
+	const GroundBatchType maxz(float3::maxzpos);
+	const GroundBatchType sqrSize(SQUARE_SIZE);
+
+	GroundBatchType x = xsimd::load_unaligned(xs);
+	GroundBatchType z = xsimd::load_unaligned(zs);
+
+	// std::clamp semantics, {min,max} can differ in the sign of zero
+	x = xsimd::select(x < zero, zero, xsimd::select(maxx < x, maxx, x)) / sqrSize;
+	z = xsimd::select(z < zero, zero, xsimd::select(maxz < z, maxz, z)) / sqrSize;
+
+	// both are non-negative, so truncation equals the scalar int-cast
+	const auto ix = xsimd::to_int(x);
+	const auto iz = xsimd::to_int(z);
+
+	const GroundBatchType dx = x - xsimd::to_float(ix);
+	const GroundBatchType dz = z - xsimd::to_float(iz);
+	const auto tl = ((dx + dz) < one);
+
+	ix.store_aligned(ixs);
+	iz.store_aligned(izs);
+	xsimd::select(tl, one, zero).store_aligned(tls);
+
+	// read the same three corners as the scalar path; h00 (top-left) or h11 (bottom-right) is the shared vertex
+	for (size_t j = 0; j < GROUND_BATCH_SIZE; ++j) {
+		const int hs = ixs[j] + izs[j] * mapDims.mapxp1;
+
+		h10s[j] = cornerHeightMap[hs + 1                 ];
+		h01s[j] = cornerHeightMap[hs + 0 + mapDims.mapxp1];
+		hcs[j] = (tls[j] != 0.0f)? cornerHeightMap[hs]: cornerHeightMap[hs + 1 + mapDims.mapxp1];
+	}
+
+	const GroundBatchType h10 = xsimd::load_aligned(h10s);
+	const GroundBatchType h01 = xsimd::load_aligned(h01s);
+	const GroundBatchType hc = xsimd::load_aligned(hcs);
+
+	const GroundBatchType htl = (hc + dx * (h10 - hc)) + dz * (h01 - hc);
+	const GroundBatchType hbr = (hc + (one - dx) * (h01 - hc)) + (one - dz) * (h10 - hc);
+
+	xsimd::select(tl, htl, hbr).store_unaligned(hs);
+}
+
+static inline void InterpolateCornerHeights(const float* xs, const float* zs, float* hs, size_t count, const float* cornerHeightMap)
+{
+	const size_t numBatched = count - (count % GROUND_BATCH_SIZE);
+
+	for (size_t i = 0; i < numBatched; i += GROUND_BATCH_SIZE) {
+		InterpolateCornerHeights(&xs[i], &zs[i], &hs[i], cornerHeightMap);
+	}
+	for (size_t i = numBatched; i < count; ++i) {
+		hs[i] = InterpolateCornerHeight(xs[i], zs[i], cornerHeightMap);
+	}
+}
+
+
+static inline const float3& SampleCenterNormal(float x, float z, const float3* centerNormalMap)
+{
+	const int xsquare = std::clamp(int(x) / SQUARE_SIZE, 0, mapDims.mapxm1);
+	const int zsquare = std::clamp(int(z) / SQUARE_SIZE, 0, mapDims.mapym1);
+
+	return centerNormalMap[xsquare + zsquare * mapDims.mapx];
+}
+
+static inline void SampleCenterNormals(const float* xs, const float* zs, float3* normals, size_t count, const float3* centerNormalMap)
+{
+	for (size_t i = 0; i < count; ++i) {
+		normals[i] = SampleCenterNormal(xs[i], zs[i], centerNormalMap);
+	}
+}
+
+#endif // GROUND_SAMPLING_H
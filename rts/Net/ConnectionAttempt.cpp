@@ -0,0 +1,49 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "ConnectionAttempt.h"
+
+#include "Net/Protocol/BaseNetProtocol.h"
+#include "System/SpringFormat.h"
+#include "System/Net/UDPListener.h"
+#include "System/Net/UDPConnection.h"
+#include "System/Net/UnpackPacket.h"
+
+
+void UnpackConnectionAttempt(std::shared_ptr<const netcode::RawPacket> packet, ConnectionAttempt& attempt)
+{
+	if (packet->length < 3) {
+		std::string pkts;
+		for (int i = 0; i < packet->length; ++i) {
+			pkts += spring::format(" 0x%x", (int)packet->data[i]);
+		}
+		throw netcode::UnpackPacketException("Packet too short (data: " + pkts + ")");
+	}
+
+	if (packet->data[0] != NETMSG_ATTEMPTCONNECT)
+		throw netcode::UnpackPacketException("Invalid message ID");
+
+	netcode::UnpackPacket msg(packet, 3);
+	uint16_t netversion;
+	msg >> netversion;
+	msg >> attempt.name;
+	msg >> attempt.passwd;
+	msg >> attempt.version;
+	msg >> attempt.platform;
+	msg >> attempt.reconnect;
+	msg >> attempt.netloss;
+
+	if (netversion != NETWORK_VERSION)
+		throw netcode::UnpackPacketException(spring::format("Wrong network version: received %d, required %d", (int)netversion, (int)NETWORK_VERSION));
+}
+
+bool PeekConnectionAttempt(netcode::UDPListener& listener, ConnectionAttempt& attempt)
+{
+	std::shared_ptr<netcode::UDPConnection> prev = listener.PreviewConnection().lock();
+	std::shared_ptr<const netcode::RawPacket> packet = prev->Peek(0);
+
+	if (packet == nullptr)
+		return false;
+
+	UnpackConnectionAttempt(packet, attempt);
+	return true;
+}
@@ -0,0 +1,37 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef _CONNECTION_ATTEMPT_H
+#define _CONNECTION_ATTEMPT_H
+
+#include <cinttypes>
+#include <memory>
+#include <string>
+
+namespace netcode
+{
+	class RawPacket;
+	class UDPListener;
+}
+
+/// contents of a NETMSG_ATTEMPTCONNECT packet
+struct ConnectionAttempt {
+	std::string name;
+	std::string passwd;
+	std::string version;
+	std::string platform;
+
+	uint8_t reconnect = 0;
+	uint8_t netloss = 0;
+};
+
+/// throws netcode::UnpackPacketException if the packet is malformed
+void UnpackConnectionAttempt(std::shared_ptr<const netcode::RawPacket> packet, ConnectionAttempt& attempt);
+
+/**
+ * @brief unpack the attempt of the connection at the front of the listener's queue
+ * Leaves the packet with the connection, so whoever accepts it can read it again.
+ * Returns false if the connection has no data, throws like UnpackConnectionAttempt.
+ */
+bool PeekConnectionAttempt(netcode::UDPListener& listener, ConnectionAttempt& attempt);
+
+#endif // _CONNECTION_ATTEMPT_H
@@ -6,6 +6,11 @@
 #include "Sim/Misc/GlobalConstants.h"
 #include "System/Log/ILog.h"
 #include "System/Net/Connection.h"
+#include "System/Net/ProtocolDef.h"
+#include "System/Net/RawPacket.h"
+
+/// flush gathered messages once they reach this size (NETMSG_PACKED holds up to 64K)
+static constexpr size_t MAX_PACKED_SIZE = 16384;
 
 GameParticipant::GameParticipant()
 {
@@ -22,14 +27,90 @@ GameParticipant::~GameParticipant()
 
 void GameParticipant::SendData(std::shared_ptr<const netcode::RawPacket> packet)
 {
-	if (clientLink != nullptr && myState != GameParticipant::State::DISCONNECTING)
+	if (clientLink == nullptr || myState == GameParticipant::State::DISCONNECTING)
+		return;
+
+	if (packedFrames == 0 || packet->length > MAX_PACKED_SIZE) {
+		FlushPackedMessages(true);
 		clientLink->SendData(packet);
+		return;
+	}
+
+	switch (packet->data[0]) {
+		case NETMSG_GAME_FRAME_PROGRESS: {
+			// skips the queue anyway
+			clientLink->SendData(packet);
+			return;
+		} break;
+		case NETMSG_QUIT: {
+			FlushPackedMessages(true);
+			clientLink->SendData(packet);
+			return;
+		} break;
+		case NETMSG_NEWFRAME:
+		case NETMSG_KEYFRAME: {
+			numPackedFrames += 1;
+		} break;
+		default: {
+		} break;
+	}
+
+	packedMessages.insert(packedMessages.end(), packet->data, packet->data + packet->length);
+
+	if (packedMessages.size() >= MAX_PACKED_SIZE)
+		FlushPackedMessages(true);
+}
+
+void GameParticipant::FlushPackedMessages(bool forced, PackedMessageCache* cache)
+{
+	if (packedMessages.empty())
+		return;
+	if (!forced && packedFrames > 0 && numPackedFrames < packedFrames)
+		return;
+
+	if (clientLink != nullptr) {
+		std::shared_ptr<const netcode::RawPacket> packet;
+
+		// spectators usually gather exactly the same messages, compress those only once
+		if (cache != nullptr && cache->packet != nullptr && cache->data == packedMessages) {
+			packet = cache->packet;
+		} else {
+			packet = CBaseNetProtocol::Get().SendPackedMessages(packedMessages);
+		}
+
+		if (packet != nullptr) {
+			clientLink->SendData(packet);
+
+			if (cache != nullptr && cache->packet != packet) {
+				cache->data.assign(packedMessages.begin(), packedMessages.end());
+				cache->packet = packet;
+			}
+		} else {
+			// can not happen below MAX_PACKED_SIZE, but do not lose anything
+			for (unsigned int pos = 0; pos < packedMessages.size(); ) {
+				const int length = netcode::ProtocolDef::GetInstance()->PacketLength(&packedMessages[pos], packedMessages.size() - pos);
+
+				if (length <= 0)
+					break;
+
+				clientLink->SendData(netcode::MakeSharedPacket(new netcode::RawPacket(&packedMessages[pos], length)));
+				pos += length;
+			}
+		}
+	}
+
+	packedMessages.clear();
+	numPackedFrames = 0;
 }
 
 void GameParticipant::Connected(std::shared_ptr<netcode::CConnection> _link, bool local)
 {
 	CloseConnection(false);
 
+	// anything gathered was meant for the previous link
+	packedMessages.clear();
+	numPackedFrames = 0;
+
 	clientLink = _link;
 	aiClientLinks[MAX_AIS].link.reset(new netcode::CLoopbackConnection());
 
@@ -44,6 +125,7 @@ void GameParticipant::Kill(const std::string& reason, const bool flush)
 
 	if (clientLink != nullptr) {
 		if (myState != GameParticipant::State::DISCONNECTING) {
+			FlushPackedMessages(true);
 			clientLink->SendData(CBaseNetProtocol::Get().SendQuit(reason));
 
 			if (flush) {
@@ -4,6 +4,7 @@
 #define _GAME_PARTICIPANT_H
 
 #include <memory>
+#include <vector>
 
 #include "Game/Players/PlayerBase.h"
 #include "Game/Players/PlayerStatistics.h"
@@ -19,11 +20,25 @@ namespace netcode
 
 class GameParticipant : public PlayerBase
 {
+public:
+	/// lets participants gathering identical messages share one packed packet
+	struct PackedMessageCache {
+		std::vector<uint8_t> data;
+		std::shared_ptr<const netcode::RawPacket> packet;
+	};
+
 public:
 	GameParticipant();
 	~GameParticipant();
 
 	void SendData(std::shared_ptr<const netcode::RawPacket> packet);
+	/**
+	 * @brief gather the messages of this many frames into one NETMSG_PACKED
+	 * Zero (the default) sends every message right away.
+	 */
+	void SetPackedFrames(unsigned int numFrames) { packedFrames = numFrames; }
+	/// send the gathered messages if enough frames are in (or if forced)
+	void FlushPackedMessages(bool forced, PackedMessageCache* cache = nullptr);
 	void Connected(std::shared_ptr<netcode::CConnection> link, bool local);
 	void Kill(const std::string& reason, const bool flush = false);
 
@@ -73,6 +88,12 @@ public:
 
 private:
 	void CloseConnection(bool flush);
+
+private:
+	std::vector<uint8_t> packedMessages;
+
+	unsigned int packedFrames = 0;
+	unsigned int numPackedFrames = 0;
 };
 
 #endif // _GAME_PARTICIPANT_H
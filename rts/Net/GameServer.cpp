@@ -10,6 +10,7 @@
 #endif
 
 #include "GameServer.h"
+#include "ConnectionAttempt.h"
 
 #include "GameParticipant.h"
 #include "GameSkirmishAI.h"
@@ -76,6 +77,7 @@ CONFIG(bool, ServerRecordDemos).defaultValue(false).dedicatedValue(true);
 CONFIG(bool, ServerLogInfoMessages).defaultValue(false);
 CONFIG(bool, ServerLogDebugMessages).defaultValue(false);
 CONFIG(std::string, AutohostIP).defaultValue("127.0.0.1");
+CONFIG(int, SpectatorFrameBatch).defaultValue(0).minimumValue(0).maximumValue(GAME_SPEED).description("Number of sim-frames whose messages are sent to remote spectators as one compressed packet, trading their latency for bandwidth. 0 disables, players are never batched.");
 
 
 // use the specific section for all LOG*() calls in this source file
@@ -130,7 +132,8 @@ CGameServer* gameServer = nullptr;
 CGameServer::CGameServer(
 	const std::shared_ptr<const ClientSetup> newClientSetup,
 	const std::shared_ptr<const    GameData> newGameData,
-	const std::shared_ptr<const  CGameSetup> newGameSetup
+	const std::shared_ptr<const  CGameSetup> newGameSetup,
+	const std::shared_ptr<netcode::UDPListener> sharedListener
 ) {
 	lastPlayerInfo = serverStartTime;
 	lastUpdate = serverStartTime;
@@ -139,6 +142,9 @@ CGameServer::CGameServer(
 	myGameData = newGameData;
 	myGameSetup = newGameSetup;
 
+	udpListener = sharedListener;
+	hostedServer = (sharedListener != nullptr);
+
 	Initialize();
 }
 
@@ -147,7 +153,8 @@ CGameServer::~CGameServer()
 	quitServer = true;
 
 	LOG_L(L_INFO, "[%s][1]", __func__);
-	thread.join();
+	if (thread.joinable())
+		thread.join();
 	LOG_L(L_INFO, "[%s][2]", __func__);
 
 	// after this, demoRecorder goes out of scope and its dtor is called
@@ -163,14 +170,16 @@ void CGameServer::Initialize()
 	whiteListAdditionalPlayers = configHandler->GetBool("WhiteListAdditionalPlayers");
 	logInfoMessages = configHandler->GetBool("ServerLogInfoMessages");
 	logDebugMessages = configHandler->GetBool("ServerLogDebugMessages");
+	spectatorFrameBatch = configHandler->GetInt("SpectatorFrameBatch");
 
 	rng.Seed((myGameData->GetSetupText()).length());
 
-	// start network
-	if (!myGameSetup->onlyLocal)
+	// start network; hosted servers get theirs (and their autohost port) from the host
+	if (!myGameSetup->onlyLocal && !hostedServer)
 		udpListener.reset(new netcode::UDPListener(myClientSetup->hostPort, myClientSetup->hostIP));
 
-	AddAutohostInterface(StringToLower(configHandler->GetString("AutohostIP")), configHandler->GetInt("AutohostPort"));
+	if (!hostedServer)
+		AddAutohostInterface(StringToLower(configHandler->GetString("AutohostIP")), configHandler->GetInt("AutohostPort"));
 	Message(spring::format(ServerStart, myClientSetup->hostPort), false);
 
 	// start script
@@ -260,7 +269,8 @@ void CGameServer::Initialize()
 	lastNewFrameTick = spring_gettime();
 	lastBandwidthUpdate = spring_gettime();
 
-	thread = spring::thread(std::bind(&CGameServer::UpdateLoop, this));
+	if (!hostedServer)
+		thread = spring::thread(std::bind(&CGameServer::UpdateLoop, this));
 
 	LOG("%s: thread affinity %x", __func__, Threading::GetAffinity());
 
@@ -410,7 +420,7 @@ void CGameServer::SkipTo(int targetFrameNum)
 
 	CommandMessage startMsg(spring::format("skip start %d", targetFrameNum), SERVER_PLAYER);
 	CommandMessage endMsg("skip end", SERVER_PLAYER);
-	Broadcast(std::shared_ptr<const netcode::RawPacket>(startMsg.Pack()));
+	Broadcast(netcode::MakeSharedPacket(startMsg.Pack()));
 
 	// fast-read and send demo data
 	//
@@ -427,7 +437,7 @@ void CGameServer::SkipTo(int targetFrameNum)
 		udpListener->Update();
 	}
 
-	Broadcast(std::shared_ptr<const netcode::RawPacket>(endMsg.Pack()));
+	Broadcast(netcode::MakeSharedPacket(endMsg.Pack()));
 
 	if (udpListener != nullptr)
 		udpListener->Update();
@@ -459,7 +469,7 @@ bool CGameServer::SendDemoData(int targetFrameNum)
 
 	// get all packets from the stream up to <modGameTime>
 	while ((buf = demoReader->GetData(modGameTime))) {
-		std::shared_ptr<const RawPacket> rpkt(buf);
+		std::shared_ptr<const RawPacket> rpkt = netcode::MakeSharedPacket(buf);
 
 		if (buf->length <= 0) {
 			Message("Warning: Discarding zero size packet in demo");
@@ -844,6 +854,19 @@ void CGameServer::Update()
 	else if (!PreSimFrame() || demoReader != nullptr)
 		CreateNewFrame(true, false);
 
+	if (spectatorFrameBatch > 0) {
+		// messages to remote spectators go out every few frames as one packet;
+		// nothing is held back for players, or for anyone while paused
+		GameParticipant::PackedMessageCache packedCache;
+
+		for (GameParticipant& p: players) {
+			const bool packFrames = (gameHasStarted && !isPaused && p.spectator && !p.isLocal);
+
+			p.SetPackedFrames(packFrames? spectatorFrameBatch: 0);
+			p.FlushPackedMessages(false, &packedCache);
+		}
+	}
+
 	if (hostif != nullptr) {
 		const std::string msg = hostif->GetChatMessage();
 
@@ -1865,77 +1888,70 @@ void CGameServer::ProcessPacket(const unsigned playerNum, std::shared_ptr<const
 
 void CGameServer::HandleConnectionAttempts()
 {
+	// attempts arriving on a shared listener are routed by CGameServerHost
+	if (hostedServer)
+		return;
+
 	while (udpListener != nullptr && udpListener->HasIncomingConnections()) {
-		std::shared_ptr<netcode::UDPConnection> prev = udpListener->PreviewConnection().lock();
-		std::shared_ptr<const RawPacket> packet = prev->GetData();
+		HandleConnectionAttempt();
+	}
+}
 
-		if (packet == nullptr) {
-			udpListener->RejectConnection();
-			continue;
-		}
+bool CGameServer::ExpectsPlayer(const std::string& name, const std::string& passwd) const
+{
+	std::lock_guard<spring::recursive_mutex> scoped_lock(gameServerMutex);
 
-		try {
-			if (packet->length < 3) {
-				std::string pkts;
-				for (int i = 0; i < packet->length; ++i) {
-					pkts += spring::format(" 0x%x", (int)packet->data[i]);
-				}
-				throw netcode::UnpackPacketException("Packet too short (data: " + pkts + ")");
-			}
+	const auto pred = [&name](const GameParticipant& gp) { return (!gp.isFromDemo && gp.name == name); };
+	const auto iter = std::find_if(players.begin(), players.end(), pred);
 
-			if (packet->data[0] != NETMSG_ATTEMPTCONNECT)
-				throw netcode::UnpackPacketException("Invalid message ID");
+	return (iter != players.end() && CheckPlayerPassword(iter->id, passwd));
+}
 
-			netcode::UnpackPacket msg(packet, 3);
-			std::string name;
-			std::string passwd;
-			std::string version;
-			std::string platform;
-			uint8_t reconnect;
-			uint8_t netloss;
-			uint16_t netversion;
-			msg >> netversion;
-			msg >> name;
-			msg >> passwd;
-			msg >> version;
-			msg >> platform;
-			msg >> reconnect;
-			msg >> netloss;
+void CGameServer::HandleConnectionAttempt()
+{
+	std::shared_ptr<netcode::UDPConnection> prev = udpListener->PreviewConnection().lock();
+	std::shared_ptr<const RawPacket> packet = prev->GetData();
 
-			if (netversion != NETWORK_VERSION)
-				throw netcode::UnpackPacketException(spring::format("Wrong network version: received %d, required %d", (int)netversion, (int)NETWORK_VERSION));
+	if (packet == nullptr) {
+		udpListener->RejectConnection();
+		return;
+	}
 
-			BindConnection(udpListener->AcceptConnection(), name, passwd, version, platform, false, reconnect, netloss);
-		} catch (const netcode::UnpackPacketException& ex) {
-			const asio::ip::udp::endpoint endp = prev->GetEndpoint();
-			const asio::ip::address addr = endp.address();
+	try {
+		ConnectionAttempt attempt;
+		UnpackConnectionAttempt(packet, attempt);
 
-			const std::string str = addr.to_string();
-			const std::string msg = spring::format(ConnectionReject, str.c_str(), ex.what());
+		std::lock_guard<spring::recursive_mutex> scoped_lock(gameServerMutex);
+		BindConnection(udpListener->AcceptConnection(), attempt.name, attempt.passwd, attempt.version, attempt.platform, false, attempt.reconnect, attempt.netloss);
+	} catch (const netcode::UnpackPacketException& ex) {
+		const asio::ip::udp::endpoint endp = prev->GetEndpoint();
+		const asio::ip::address addr = endp.address();
 
-			auto  pair = std::make_pair(rejectedConnections.find(str), false);
-			auto& iter = pair.first;
+		const std::string str = addr.to_string();
+		const std::string msg = spring::format(ConnectionReject, str.c_str(), ex.what());
 
-			if (iter == rejectedConnections.end()) {
-				pair = rejectedConnections.insert(std::make_pair(str, 0));
-				iter = pair.first;
-			}
+		auto  pair = std::make_pair(rejectedConnections.find(str), false);
+		auto& iter = pair.first;
 
-			if (iter->second < 5) {
-				rejectedConnections.insert(std::make_pair(str, iter->second + 1));
+		if (iter == rejectedConnections.end()) {
+			pair = rejectedConnections.insert(std::make_pair(str, 0));
+			iter = pair.first;
+		}
 
-				prev->Unmute();
-				prev->SendData(CBaseNetProtocol::Get().SendRejectConnect(msg));
-				prev->Flush(true);
+		if (iter->second < 5) {
+			rejectedConnections.insert(std::make_pair(str, iter->second + 1));
 
-				Message(msg);
-			} else {
-				// silently drop
-				Message(msg, false, true);
-			}
+			prev->Unmute();
+			prev->SendData(CBaseNetProtocol::Get().SendRejectConnect(msg));
+			prev->Flush(true);
 
-			udpListener->RejectConnection();
+			Message(msg);
+		} else {
+			// silently drop
+			Message(msg, false, true);
 		}
+
+		udpListener->RejectConnection();
 	}
 }
 
@@ -2180,7 +2196,8 @@ void CGameServer::StartGame(bool forced)
 	if (!canReconnect && !allowSpecJoin)
 		packetCache.clear(); // free memory
 
-	if (udpListener && !canReconnect && !allowSpecJoin)
+	// a shared listener still has to accept connections for the other games
+	if (udpListener && !canReconnect && !allowSpecJoin && !hostedServer)
 		udpListener->SetAcceptingConnections(false); // do not accept new connections
 
 	// make sure initial game speed is within allowed range and send a new speed if not
@@ -2408,13 +2425,13 @@ void CGameServer::PushAction(const Action& action, bool fromAutoHost)
 			InverseOrSetBool(noHelperAIs, action.extra);
 			// sent it because clients have to do stuff when this changes
 			CommandMessage msg(action, SERVER_PLAYER);
-			Broadcast(std::shared_ptr<const RawPacket>(msg.Pack()));
+			Broadcast(netcode::MakeSharedPacket(msg.Pack()));
 		} break;
 		case hashString("nospecdraw"): {
 			InverseOrSetBool(allowSpecDraw, action.extra, true);
 			// sent it because clients have to do stuff when this changes
 			CommandMessage msg(action, SERVER_PLAYER);
-			Broadcast(std::shared_ptr<const RawPacket>(msg.Pack()));
+			Broadcast(netcode::MakeSharedPacket(msg.Pack()));
 		} break;
 
 		case hashString("setmaxspeed"): {
@@ -2471,7 +2488,7 @@ void CGameServer::PushAction(const Action& action, bool fromAutoHost)
 		case hashString("cheat"): {
 			InverseOrSetBool(cheating, action.extra);
 			CommandMessage msg(action, SERVER_PLAYER);
-			Broadcast(std::shared_ptr<const RawPacket>(msg.Pack()));
+			Broadcast(netcode::MakeSharedPacket(msg.Pack()));
 		} break;
 
 		case hashString("singlestep"): {
@@ -2559,7 +2576,7 @@ void CGameServer::PushAction(const Action& action, bool fromAutoHost)
 		default: {
 			// only forward to players (send over network)
 			CommandMessage msg(action, SERVER_PLAYER);
-			Broadcast(std::shared_ptr<const RawPacket>(msg.Pack()));
+			Broadcast(netcode::MakeSharedPacket(msg.Pack()));
 		} break;
 	}
 }
@@ -2747,6 +2764,33 @@ void CGameServer::UpdateLoop()
 	} CATCH_SPRING_ERRORS
 }
 
+void CGameServer::UpdateHosted()
+{
+	assert(hostedServer);
+
+	// the host updates the shared listener (and thereby our connections)
+	std::lock_guard<spring::recursive_mutex> scoped_lock(gameServerMutex);
+	ServerReadNet();
+	Update();
+}
+
+void CGameServer::QuitHosted()
+{
+	assert(hostedServer);
+
+	if (hostif != nullptr)
+		hostif->SendQuit();
+
+	Broadcast(CBaseNetProtocol::Get().SendQuit("Server shutdown"));
+
+	// no sleeping here, the host keeps updating the listener for a while
+	// before deleting us so the quit messages get flushed normally
+	for (GameParticipant& p: players) {
+		if (p.clientLink != nullptr)
+			p.clientLink->Flush();
+	}
+}
+
 
 void CGameServer::KickPlayer(int playerNum)
 {
@@ -3016,7 +3060,7 @@ unsigned CGameServer::BindConnection(
 	}
 
 	newPlayer.Connected(clientLink, isLocal);
-	newPlayer.SendData(std::shared_ptr<const RawPacket>(myGameData->Pack()));
+	newPlayer.SendData(netcode::MakeSharedPacket(myGameData->Pack()));
 	newPlayer.SendData(CBaseNetProtocol::Get().SendSetPlayerNum((unsigned char)newPlayerNumber));
 
 	// after gamedata and playerNum, the player can start loading
@@ -3053,7 +3097,7 @@ void CGameServer::GotChatMessage(const ChatMessage& msg)
 	if (msg.msg.empty())
 		return;
 
-	Broadcast(std::shared_ptr<const RawPacket>(msg.Pack()));
+	Broadcast(netcode::MakeSharedPacket(msg.Pack()));
 
 	if (hostif == nullptr)
 		return;
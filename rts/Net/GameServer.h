@@ -69,7 +69,8 @@ public:
 	CGameServer(
 		const std::shared_ptr<const ClientSetup> newClientSetup,
 		const std::shared_ptr<const    GameData> newGameData,
-		const std::shared_ptr<const  CGameSetup> newGameSetup
+		const std::shared_ptr<const  CGameSetup> newGameSetup,
+		const std::shared_ptr<netcode::UDPListener> sharedListener = nullptr
 	);
 
 	CGameServer(const CGameServer&) = delete; // no-copy
@@ -98,6 +99,26 @@ public:
 	bool HasLocalClient() const { return (localClientNumber != -1u); }
 	/// Is the server still running?
 	bool HasFinished() const;
+	/// Does the server share its listener and update thread with others?
+	bool IsHosted() const { return hostedServer; }
+
+	/**
+	 * @brief run one server tick
+	 * Only for hosted servers, see CGameServerHost; standalone
+	 * servers tick in UpdateLoop on their own thread instead.
+	 */
+	void UpdateHosted();
+	/// tell clients and autohost that a (finished) hosted server shuts down
+	void QuitHosted();
+
+	/**
+	 * @brief whether a connection attempt by this player belongs to this game
+	 * Used to route attempts arriving on a shared listener; only players
+	 * listed in the start-script (with matching password) are recognized.
+	 */
+	bool ExpectsPlayer(const std::string& name, const std::string& passwd) const;
+	/// accept or reject the connection at the front of the listener's queue
+	void HandleConnectionAttempt();
 
 	void UpdateSpeedControl(int speedCtrl);
 	static std::string SpeedControlToString(int speedCtrl);
@@ -249,6 +270,8 @@ private:
 	int medianPing = 0;
 	int curSpeedCtrl = 0;
 	int loopSleepTime = 0;
+	/// frames per NETMSG_PACKED sent to spectators, 0 if disabled
+	int spectatorFrameBatch = 0;
 
 
 	int serverFrameNum = -1;
@@ -281,11 +304,14 @@ private:
 	bool logInfoMessages = false;
 	bool logDebugMessages = false;
 
+	/// true if udpListener is shared and CGameServerHost ticks us
+	bool hostedServer = false;
+
 
 	/// If the server receives a command, it will forward it to clients if it is not in this set
 	static std::array<std::string, 26> commandBlacklist;
 
-	std::unique_ptr<netcode::UDPListener> udpListener;
+	std::shared_ptr<netcode::UDPListener> udpListener;
 	std::unique_ptr<CDemoReader> demoReader;
 	std::unique_ptr<CDemoRecorder> demoRecorder;
 	std::unique_ptr<AutohostInterface> hostif;
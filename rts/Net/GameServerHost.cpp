@@ -0,0 +1,230 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/Net/UDPListener.h"
+#include "System/Net/UDPConnection.h"
+
+#include <algorithm>
+#include <functional>
+
+#include "GameServerHost.h"
+#include "GameServer.h"
+#include "ConnectionAttempt.h"
+
+#include "Game/GameSetup.h"
+#include "Net/Protocol/BaseNetProtocol.h"
+#include "System/MsgStrings.h"
+#include "System/SpringFormat.h"
+#include "System/StringUtil.h"
+#include "System/Config/ConfigHandler.h"
+#include "System/Net/UnpackPacket.h"
+#include "System/LoadSave/DemoRecorder.h"
+#include "System/Log/ILog.h"
+#include "System/Platform/errorhandler.h"
+#include "System/Platform/Threading.h"
+
+/// how long finished games keep their connections, so quit messages get through
+static const spring_time gameQuitDelay = spring_secs(2);
+
+
+CGameServerHost::CGameServerHost(int hostPort, const std::string& hostIP)
+	: udpListener(new netcode::UDPListener(hostPort, hostIP))
+{
+	autohostIP = StringToLower(configHandler->GetString("AutohostIP"));
+	autohostPort = configHandler->GetInt("AutohostPort");
+	loopSleepTime = configHandler->GetInt("ServerSleepTime");
+
+	LOG("[GameServerHost::%s] %s", __func__, spring::format(ServerStart, hostPort).c_str());
+
+	thread = spring::thread(std::bind(&CGameServerHost::UpdateLoop, this));
+}
+
+CGameServerHost::~CGameServerHost()
+{
+	quitHost = true;
+	thread.join();
+
+	for (HostedGame& g: games) {
+		if (!spring_istime(g.quitTime))
+			g.server->QuitHosted();
+	}
+
+	// demos of the remaining games are written here
+	games.clear();
+}
+
+
+void CGameServerHost::AddGame(
+	const std::shared_ptr<const ClientSetup> clientSetup,
+	const std::shared_ptr<const    GameData> gameData,
+	const std::shared_ptr<const  CGameSetup> gameSetup
+) {
+	// not ticked until it is added, so this can run concurrently with UpdateLoop
+	std::unique_ptr<CGameServer> server(new CGameServer(clientSetup, gameData, gameSetup, udpListener));
+
+	std::lock_guard<spring::mutex> scoped_lock(gamesMutex);
+
+	const unsigned int gameNum = numAddedGames++;
+
+	if (autohostPort > 0)
+		server->AddAutohostInterface(autohostIP, autohostPort + gameNum);
+
+	LOG("[GameServerHost::%s] game %u: map %s, mod %s", __func__, gameNum, gameSetup->mapName.c_str(), gameSetup->modName.c_str());
+	games.push_back({std::move(server), gameNum, spring_notime, false});
+}
+
+bool CGameServerHost::HasFinished() const
+{
+	std::lock_guard<spring::mutex> scoped_lock(gamesMutex);
+	return (numAddedGames > 0 && games.empty());
+}
+
+size_t CGameServerHost::GetNumGames() const
+{
+	std::lock_guard<spring::mutex> scoped_lock(gamesMutex);
+	return games.size();
+}
+
+
+void CGameServerHost::UpdateLoop()
+{
+	try {
+		Threading::SetThreadName("netcode");
+		Threading::SetAffinity(~0);
+
+		while (!quitHost) {
+			spring_msecs(loopSleepTime).sleep(true);
+
+			// receives for and flushes the connections of all games at once
+			udpListener->Update();
+
+			std::lock_guard<spring::mutex> scoped_lock(gamesMutex);
+			HandleConnectionAttempts();
+
+			const spring_time now = spring_gettime();
+
+			for (HostedGame& g: games) {
+				if (spring_istime(g.quitTime))
+					continue;
+
+				try {
+					UpdateGame(g, now);
+				} catch (const std::exception& e) {
+					// only the failing game is retired, the others keep running
+					LOG_L(L_ERROR, "[GameServerHost::%s] game %u failed: %s", __func__, g.gameNum, e.what());
+					QuitGame(g, now);
+				}
+			}
+
+			const auto pred = [&](const HostedGame& g) { return (spring_istime(g.quitTime) && (now - g.quitTime) > gameQuitDelay); };
+			const auto iter = std::remove_if(games.begin(), games.end(), pred);
+
+			for (auto it = iter; it != games.end(); ++it) {
+				LOG("[GameServerHost::%s] game %u finished", __func__, it->gameNum);
+			}
+
+			// deleting a server writes its demo
+			games.erase(iter, games.end());
+		}
+	} CATCH_SPRING_ERRORS
+}
+
+void CGameServerHost::UpdateGame(HostedGame& game, spring_time now)
+{
+	if (game.server->HasFinished()) {
+		QuitGame(game, now);
+		return;
+	}
+
+	game.server->UpdateHosted();
+
+	if (!game.announced && game.server->HasGameID())
+		AnnounceGame(game);
+}
+
+void CGameServerHost::QuitGame(HostedGame& game, spring_time now)
+{
+	// removed after gameQuitDelay even if telling its clients fails
+	game.quitTime = now;
+
+	try {
+		game.server->QuitHosted();
+	} catch (const std::exception& e) {
+		LOG_L(L_ERROR, "[GameServerHost::%s] game %u: %s", __func__, game.gameNum, e.what());
+	}
+}
+
+
+void CGameServerHost::HandleConnectionAttempts()
+{
+	while (udpListener->HasIncomingConnections()) {
+		ConnectionAttempt attempt;
+
+		try {
+			// the packet stays with the connection for the game to read
+			if (!PeekConnectionAttempt(*udpListener, attempt)) {
+				udpListener->RejectConnection();
+				continue;
+			}
+		} catch (const netcode::UnpackPacketException& ex) {
+			RejectConnectionAttempt(ex.what());
+			continue;
+		}
+
+		const auto pred = [&](const HostedGame& g) { return (!spring_istime(g.quitTime) && g.server->ExpectsPlayer(attempt.name, attempt.passwd)); };
+		const auto iter = std::find_if(games.begin(), games.end(), pred);
+
+		if (iter == games.end()) {
+			RejectConnectionAttempt("no game for player " + attempt.name);
+			continue;
+		}
+
+		const std::shared_ptr<netcode::UDPConnection> prev = udpListener->PreviewConnection().lock();
+
+		try {
+			// the game unpacks the attempt again and binds (or rejects) the connection
+			iter->server->HandleConnectionAttempt();
+		} catch (const std::exception& e) {
+			LOG_L(L_ERROR, "[GameServerHost::%s] game %u failed: %s", __func__, iter->gameNum, e.what());
+			QuitGame(*iter, spring_gettime());
+
+			// drop the attempt if the game did not get to it
+			if (udpListener->HasIncomingConnections() && udpListener->PreviewConnection().lock() == prev)
+				udpListener->RejectConnection();
+		}
+	}
+}
+
+void CGameServerHost::RejectConnectionAttempt(const std::string& reason)
+{
+	std::shared_ptr<netcode::UDPConnection> prev = udpListener->PreviewConnection().lock();
+
+	const std::string str = prev->GetEndpoint().address().to_string();
+	const std::string msg = spring::format(ConnectionReject, str.c_str(), reason.c_str());
+
+	// only answer the first few attempts per address, drop the rest silently
+	if ((rejectedConnections[str] += 1) <= 5) {
+		prev->Unmute();
+		prev->SendData(CBaseNetProtocol::Get().SendRejectConnect(msg));
+		prev->Flush(true);
+
+		LOG("[GameServerHost::%s] %s", __func__, msg.c_str());
+	}
+
+	udpListener->RejectConnection();
+}
+
+
+void CGameServerHost::AnnounceGame(HostedGame& game) const
+{
+	game.announced = true;
+
+	const std::unique_ptr<CDemoRecorder>& demoRec = game.server->GetDemoRecorder();
+
+	if (demoRec == nullptr)
+		return;
+
+	const std::uint8_t* gameID = (demoRec->GetFileHeader()).gameID;
+
+	LOG("[GameServerHost::%s] game %u: recording demo %s", __func__, game.gameNum, (demoRec->GetName()).c_str());
+	LOG("[GameServerHost::%s] game %u: GameID %02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x", __func__, game.gameNum, gameID[0], gameID[1], gameID[2], gameID[3], gameID[4], gameID[5], gameID[6], gameID[7], gameID[8], gameID[9], gameID[10], gameID[11], gameID[12], gameID[13], gameID[14], gameID[15]);
+}
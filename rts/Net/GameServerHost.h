@@ -0,0 +1,90 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef _GAME_SERVER_HOST_H
+#define _GAME_SERVER_HOST_H
+
+#include <atomic>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "System/Misc/SpringTime.h"
+#include "System/Threading/SpringThreading.h"
+
+namespace netcode
+{
+	class UDPListener;
+}
+class ClientSetup;
+class CGameServer;
+class CGameSetup;
+class GameData;
+
+/**
+ * @brief Runs several independent games in one process
+ * All hosted CGameServer's share one UDPListener (port) and are ticked
+ * by a single thread. Connection attempts are routed to the game whose
+ * start-script lists the connecting player (with matching password), so
+ * unlisted spectators can not join a hosted game.
+ */
+class CGameServerHost
+{
+public:
+	CGameServerHost(int hostPort, const std::string& hostIP);
+	CGameServerHost(const CGameServerHost&) = delete; // no-copy
+	~CGameServerHost();
+
+	/**
+	 * @brief start hosting a game
+	 * The n-th added game reports to the autohost on AutohostPort + n.
+	 */
+	void AddGame(
+		const std::shared_ptr<const ClientSetup> clientSetup,
+		const std::shared_ptr<const    GameData> gameData,
+		const std::shared_ptr<const  CGameSetup> gameSetup
+	);
+
+	/// have all added games finished (and been cleaned up)?
+	bool HasFinished() const;
+	size_t GetNumGames() const;
+
+private:
+	struct HostedGame {
+		std::unique_ptr<CGameServer> server;
+
+		unsigned int gameNum;
+		/// when the game finished and told its clients to quit
+		spring_time quitTime;
+
+		bool announced;
+	};
+
+	void UpdateLoop();
+	/// throws whatever the game's server throws, see UpdateLoop
+	void UpdateGame(HostedGame& game, spring_time now);
+	void QuitGame(HostedGame& game, spring_time now);
+	void HandleConnectionAttempts();
+	void RejectConnectionAttempt(const std::string& reason);
+	void AnnounceGame(HostedGame& game) const;
+
+private:
+	std::shared_ptr<netcode::UDPListener> udpListener;
+
+	std::vector<HostedGame> games;
+	std::map<std::string, int> rejectedConnections;
+
+	std::string autohostIP;
+
+	int autohostPort = 0;
+	int loopSleepTime = 0;
+
+	unsigned int numAddedGames = 0;
+
+	spring::thread thread;
+	mutable spring::mutex gamesMutex;
+
+	std::atomic<bool> quitHost{false};
+};
+
+#endif // _GAME_SERVER_HOST_H
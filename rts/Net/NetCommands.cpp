@@ -307,6 +307,10 @@ void CGame::ClientReadNet()
 		if (packet == nullptr)
 			break;
 
+		// path searches started at the end of the last SimFrame must not
+		// overlap with anything this message might change in synced state
+		pathManager->SyncQueuedSearches();
+
 		lastReceivedNetPacketTime = spring_gettime();
 
 		const uint8_t* inbuf = packet->data;
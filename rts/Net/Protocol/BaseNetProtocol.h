@@ -120,6 +120,12 @@ public:
 
 	PacketType SendGameStateDump();
 
+	/**
+	 * Packs consecutive messages (raw, as sent) into one compressed message;
+	 * see NETMSG_PACKED. Returns nullptr if they do not fit into one.
+	 */
+	PacketType SendPackedMessages(const std::vector<uint8_t>& messages);
+
 private:
 	CBaseNetProtocol();
 
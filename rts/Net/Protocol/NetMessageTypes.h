@@ -95,6 +95,8 @@ enum NETMSG {
 
 	NETMSG_PING = 78, // uint8_t playerNum, uint8_t pingTag, float localTime
 
+	NETMSG_PACKED = 79, // uint16_t messageSize, uint16_t rawSize, deflated rawSize bytes of consecutive messages # server -> spectators, the receiving connection unpacks it #
+
 	NETMSG_LAST //max types of netmessages, internal only
 };
 
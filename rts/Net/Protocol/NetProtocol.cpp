@@ -143,7 +143,7 @@ std::shared_ptr<const netcode::RawPacket> CNetProtocol::GetData(int frameNum)
 }
 
 
-void CNetProtocol::Send(const netcode::RawPacket* pkt) { Send(std::shared_ptr<const netcode::RawPacket>(pkt)); }
+void CNetProtocol::Send(const netcode::RawPacket* pkt) { Send(netcode::MakeSharedPacket(pkt)); }
 void CNetProtocol::Send(std::shared_ptr<const netcode::RawPacket> pkt)
 {
 	std::lock_guard<spring::spinlock> lock(serverConnMutex);
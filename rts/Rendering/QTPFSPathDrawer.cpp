@@ -62,6 +62,9 @@ void QTPFSPathDrawer::DrawAll() const {
 	if (!gs->cheatEnabled && !gu->spectating)
 		return;
 
+	// paths and nodes are read directly below
+	pm->SyncQueuedSearches();
+
 	glPushAttrib(GL_ENABLE_BIT | GL_POLYGON_BIT);
 	glDisable(GL_DEPTH_TEST);
 	glEnable(GL_BLEND);
@@ -64,6 +64,7 @@ inline void SLosInstance::Init(int radius, int allyteam, int2 basePos, float bas
 	this->isCached = false;
 	this->isQueuedForUpdate = false;
 	this->isQueuedForTerraform = false;
+	this->damagedRects.clear();
 }
 
 
@@ -304,6 +305,45 @@ inline void ILosType::LosRemove(SLosInstance* li)
 }
 
 
+void ILosType::UpdateLosMaps(const std::vector<SLosInstance*>& lis, int amount)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	const auto UpdateLosMap = [&](SLosInstance* li) {
+		if (amount > 0) {
+			assert(li->refCount > 0);
+			LosAdd(li);
+		} else {
+			LosRemove(li);
+		}
+	};
+	// squares entering LoS are reported to the ReadMap, keep those losmaps on this thread
+	const auto IsThreadSafe = [&](int allyTeam) {
+		return (amount < 0 || algoType != LOS_ALGO_RAYCAST || !losMaps[allyTeam].SendsReadMapEvents(allyTeam));
+	};
+
+	if (lis.size() < 64 || losMaps.size() == 1) {
+		std::for_each(lis.begin(), lis.end(), UpdateLosMap);
+		return;
+	}
+
+	// every allyteam has its own losmap, each of them is still updated in instance order
+	for_mt(0, losMaps.size(), [&](const int allyTeam) {
+		if (!IsThreadSafe(allyTeam))
+			return;
+
+		for (SLosInstance* li: lis) {
+			if (li->allyteam == allyTeam)
+				UpdateLosMap(li);
+		}
+	});
+
+	for (SLosInstance* li: lis) {
+		if (!IsThreadSafe(li->allyteam))
+			UpdateLosMap(li);
+	}
+}
+
+
 inline void ILosType::RefInstance(SLosInstance* li)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
@@ -402,6 +442,7 @@ inline void ILosType::DeleteInstance(SLosInstance* li)
 	}
 
 	li->squares.clear();
+	li->damagedRects.clear();
 	freeIDs.push_back(li->id);
 }
 
@@ -569,26 +610,28 @@ void ILosType::Update()
 	}
 
 	// remove sight
-	//FIXME multithread?
-	for (SLosInstance* li: losRemove) {
-		LosRemove(li);
-	}
+	UpdateLosMaps(losRemove, -1);
 
 	// raycast terrain
 	if (algoType == LOS_ALGO_RAYCAST)  {
 		for_mt(0, losRecalc.size(), [&](const int idx) {
-			auto li = losRecalc[idx];
+			SLosInstance* li = losRecalc[idx];
+			const CLosMap& losMap = losMaps[li->allyteam];
+
 			assert(li->refCount > 0);
-			li->squares.clear();
-			losMaps[li->allyteam].PrepareRaycast(li);
+
+			// after terraforming only the rays crossing the changed area need to be recast
+			if (!losMap.UpdateRaycast(li)) {
+				li->squares.clear();
+				losMap.PrepareRaycast(li);
+			}
+
+			li->damagedRects.clear();
 		});
 	}
 
 	// add sight
-	for (SLosInstance* li: losAdd) {
-		assert(li->refCount > 0);
-		LosAdd(li);
-	}
+	UpdateLosMaps(losAdd, 1);
 
 	// delete / move to cache unused instances
 	if (algoType == LOS_ALGO_RAYCAST) {
@@ -620,29 +663,28 @@ void ILosType::UpdateHeightMapSynced(SRectangle rect)
 	if (algoType == LOS_ALGO_CIRCLE)
 		return;
 
-	auto CheckOverlap = [&](SLosInstance* li, SRectangle rect) -> bool {
-		int2 pos = li->basePos * mipDiv;
-		const int radius = li->radius * mipDiv;
-
-		const int hw = rect.GetWidth() * (SQUARE_SIZE / 2);
-		const int hh = rect.GetHeight() * (SQUARE_SIZE / 2);
-
-		int2 circleDistance;
-		circleDistance.x = std::abs(pos.x - rect.x1 * SQUARE_SIZE) - hw;
-		circleDistance.y = std::abs(pos.y - rect.y1 * SQUARE_SIZE) - hh;
+	// convert to LOS-map space; padded because the center and mip heightmaps
+	// are updated slightly beyond the given rectangle (see CReadMap)
+	const SRectangle losRect = {
+		std::max(((std::max(rect.x1 - 2, 0)) >> mipLevel) - 1, 0),
+		std::max(((std::max(rect.z1 - 2, 0)) >> mipLevel) - 1, 0),
+		std::min(((rect.x2 + 2) >> mipLevel) + 2, size.x),
+		std::min(((rect.z2 + 2) >> mipLevel) + 2, size.y),
+	};
 
-		if (circleDistance.x > radius) { return false; }
-		if (circleDistance.y > radius) { return false; }
-		if (circleDistance.x <= 0) { return true; }
-		if (circleDistance.y <= 0) { return true; }
+	auto CheckOverlap = [&](const SLosInstance* li) -> bool {
+		// distance from the base square to the closest square inside losRect
+		const int dx = li->basePos.x - std::clamp(li->basePos.x, losRect.x1, losRect.x2 - 1);
+		const int dy = li->basePos.y - std::clamp(li->basePos.y, losRect.z1, losRect.z2 - 1);
 
-		return (Square(circleDistance.x) + Square(circleDistance.y)) <= Square(radius);
+		// raycast squares can lie slightly outside of the exact radius
+		return ((Square(dx) + Square(dy)) <= Square(li->radius + 1));
 	};
 
 	// delete unused instances that overlap with the changed rectangle
 	for (auto it = losCache.begin(); it != losCache.end();) {
 		SLosInstance* li = *it;
-		if (li->refCount > 0 || !CheckOverlap(li, rect)) {
+		if (li->refCount > 0 || !CheckOverlap(li)) {
 			++it;
 			continue;
 		}
@@ -655,9 +697,29 @@ void ILosType::UpdateHeightMapSynced(SRectangle rect)
 	// relos used instances
 	for (auto& p: instanceHashes) {
 		for (SLosInstance* li: p.second) {
-			if (li->status & SLosInstance::TLosStatus::RECALC)
+			if (!CheckOverlap(li))
 				continue;
-			if (!CheckOverlap(li, rect))
+
+			// remember every damaged area until the instance gets recast, not only the first
+			auto& damagedRects = li->damagedRects;
+
+			if (damagedRects.size() < MAX_DAMAGED_RECTS) {
+				damagedRects.push_back(losRect);
+			} else {
+				SRectangle bounds = losRect;
+
+				for (const SRectangle& r: damagedRects) {
+					bounds.x1 = std::min(bounds.x1, r.x1);
+					bounds.z1 = std::min(bounds.z1, r.z1);
+					bounds.x2 = std::max(bounds.x2, r.x2);
+					bounds.z2 = std::max(bounds.z2, r.z2);
+				}
+
+				damagedRects.clear();
+				damagedRects.push_back(bounds);
+			}
+
+			if (li->status & SLosInstance::TLosStatus::RECALC)
 				continue;
 
 			UpdateInstanceStatus(li, SLosInstance::TLosStatus::RECALC);
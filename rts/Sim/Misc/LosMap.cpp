@@ -2,15 +2,18 @@
 
 #include <algorithm>
 #include <array>
+#include <limits>
 
 #include "LosMap.h"
-#include "LosHandler.h"
+#include "LosInstance.h"
 #include "Map/ReadMap.h"
 #include "System/SpringMath.h"
 #include "System/float3.h"
 #include "System/Log/ILog.h"
 #include "System/StringUtil.h"
+#include "System/Misc/TracyDefs.h"
 #include "System/Threading/ThreadPool.h"
+#include "System/UnorderedMap.hpp"
 #include "Game/GlobalUnsynced.h" // for myAllyTeam
 
 constexpr float LOS_BONUS_HEIGHT = 5.0f;
@@ -20,6 +23,13 @@ static std::array<std::vector<float>, ThreadPool::MAX_THREADS> RADIUS_ISQRT_TABL
 static std::array<std::vector<float>, ThreadPool::MAX_THREADS> RAYCAST_ANGLE_TABLES;
 static std::array<std::vector< char>, ThreadPool::MAX_THREADS> LOSRAY_SQUARE_TABLES; // visible squares per instance
 
+// UpdateRaycast helpers
+static std::array<std::vector< char>, ThreadPool::MAX_THREADS> RAYCAST_STATE_TABLES; // per square
+static std::array<std::vector<  int>, ThreadPool::MAX_THREADS> RAYCAST_DIRTY_TABLES; // per ray and orientation
+static std::array<std::vector<  int>, ThreadPool::MAX_THREADS> LINE_WIDTH_TABLES;
+static std::array<std::vector< int2>, ThreadPool::MAX_THREADS> DIRTY_SQUARE_LISTS;
+static std::array<std::vector<  int>, ThreadPool::MAX_THREADS> DIRTY_RAY_LISTS;
+
 
 static float isqrtTableLookup(unsigned r, int threadNum)
 {
@@ -132,6 +142,20 @@ public:
 		return losTables[losSize].size();
 	}
 
+	// inverse of a LosTable, {rayIndex, squareIdx} pairs per square
+	struct SquareRays {
+		std::pair<const int2*, const int2*> Get(int2 p, size_t losSize) const {
+			const size_t idx = p.y * (losSize + 1) + p.x;
+			return {rays.data() + offsets[idx], rays.data() + offsets[idx + 1]};
+		}
+
+		std::vector<int> offsets;
+		std::vector<int2> rays;
+	};
+
+	// only generates the index if not in cache, requires GenerateForLosSize
+	const SquareRays& GenerateSquareRaysForLosSize(size_t losSize);
+
 private:
 	// [0] is the zero-radius table
 	// NOTE:
@@ -139,6 +163,9 @@ private:
 	//   why not precalculate only the largest and subsample?
 	std::array<LosTable, MAX_UNIT_SENSOR_RADIUS + 1> losTables;
 
+	// only built for radii that were recast after terraforming
+	spring::unordered_map<size_t, SquareRays> squareRayTables;
+
 private:
 	static LosLine GetRay(int x, int y);
 	static LosTable GetLosRays(int radius);
@@ -170,6 +197,50 @@ void CLosTableHelper::GenerateForLosSize(size_t losSize)
 
 
 
+/**
+ * @brief Indexes the rays of a LoS table per square they pass, as CSR.
+ * Only the upper right sector is covered, like the table itself.
+ */
+const CLosTableHelper::SquareRays& CLosTableHelper::GenerateSquareRaysForLosSize(size_t losSize)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	assert(losSize < losTables.size());
+
+	SquareRays& squareRays = squareRayTables[losSize];
+
+	if (!squareRays.offsets.empty())
+		return squareRays;
+
+	const LosTable& table = losTables[losSize];
+	const size_t width = losSize + 1;
+
+	squareRays.offsets.resize(width * width + 1, 0);
+
+	for (const LosLine& line: table) {
+		for (const int2& p: line) {
+			squareRays.offsets[p.y * width + p.x + 1]++;
+		}
+	}
+
+	for (size_t i = 1; i < squareRays.offsets.size(); i++) {
+		squareRays.offsets[i] += squareRays.offsets[i - 1];
+	}
+
+	std::vector<int> fillIndices(squareRays.offsets.begin(), squareRays.offsets.end() - 1);
+
+	squareRays.rays.resize(squareRays.offsets.back());
+
+	for (size_t i = 0; i < table.size(); i++) {
+		for (size_t n = 0; n < table[i].size(); n++) {
+			const int2& p = table[i][n];
+			squareRays.rays[fillIndices[p.y * width + p.x]++] = int2(i, n);
+		}
+	}
+
+	return squareRays;
+}
+
+
 /**
  * @brief Precalcs the rays for LineOfSight raytracing.
  * In LoS we raytrace all squares in a radius if they are in view
@@ -436,10 +507,7 @@ void CLosMap::AddRaycast(SLosInstance* instance, int amount)
 		return;
 
 	// inform ReadMap when squares enter LoS
-	const bool visibleInstanceSquares = (instance->allyteam >= 0 && (instance->allyteam == gu->myAllyTeam || gu->spectatingFullView));
-	const bool updateUnsyncedHeightMap = sendReadmapEvents && visibleInstanceSquares;
-
-	if ((amount > 0) && updateUnsyncedHeightMap) {
+	if ((amount > 0) && SendsReadMapEvents(instance->allyteam)) {
 		for (const SLosInstance::RLE rle: losSquares) {
 			for (int idx = rle.start, len = rle.length; len > 0; --len, ++idx) {
 				losmap[idx] += amount;
@@ -468,6 +536,13 @@ void CLosMap::AddRaycast(SLosInstance* instance, int amount)
 }
 
 
+bool CLosMap::SendsReadMapEvents(int allyTeam) const
+{
+	const bool visibleInstanceSquares = (allyTeam >= 0 && (allyTeam == gu->myAllyTeam || gu->spectatingFullView));
+	return (sendReadmapEvents && visibleInstanceSquares);
+}
+
+
 void CLosMap::PrepareRaycast(SLosInstance* instance) const
 {
 	RECOIL_DETAILED_TRACY_ZONE;
@@ -821,3 +896,233 @@ void CLosMap::SafeLosAdd(SLosInstance* li) const
 	// translate visible square indices to map square idx + RLE
 	AddSquaresToInstance(li, losRaySquares);
 }
+
+
+bool CLosMap::UpdateRaycast(SLosInstance* li) const
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	// Re-raycasts only what terrain changes inside li->damagedRects can affect:
+	// every ray (per orientation) crossing a damaged square is recast from that
+	// square on, all squares it reaches from there are "dirty". Dirty squares are
+	// reset and ANDed again over *all* rays passing them, the remaining squares
+	// keep their old visibility. The result is identical to a full LosAdd().
+	const auto& damagedRects = li->damagedRects;
+	const auto& losSquares = li->squares;
+
+	if (damagedRects.empty())
+		return false;
+	// instance was never raycast or has no sight at all (base square underground)
+	if (losSquares.empty() || losSquares[0].length == SLosInstance::EMPTY_RLE.length)
+		return false;
+
+	const int threadNum = ThreadPool::GetThreadNum();
+
+	const int2 pos   = li->basePos;
+	const int radius = li->radius;
+	const int diameter = (2 * radius) + 1;
+	const float losHeight = li->baseHeight;
+
+	const SRectangle fullRect(0, 0, size.x, size.y);
+	const SRectangle instRect(pos.x - radius, pos.y - radius, pos.x + radius + 1, pos.y + radius + 1);
+
+	size_t damagedArea = 0;
+
+	for (SRectangle rect: damagedRects) {
+		// base height check in LosAdd could flip
+		if (rect.Inside(pos))
+			return false;
+
+		rect.ClampIn(instRect);
+		damagedArea += std::max(rect.GetArea(), 0);
+	}
+
+	// recasting a large part of the rays is slower than starting over
+	if ((damagedArea * 4) > size_t(diameter * diameter))
+		return false;
+
+	if (damagedArea == 0)
+		return true;
+
+
+	CLosTableHelper& helper = losTableHelpers[threadNum];
+
+	std::vector< char>& losRaySquares = LOSRAY_SQUARE_TABLES[threadNum];
+	std::vector<float>& raycastAngles = RAYCAST_ANGLE_TABLES[threadNum];
+	std::vector< char>& squareStates  = RAYCAST_STATE_TABLES[threadNum];
+	std::vector<  int>& rayDirtyIdcs  = RAYCAST_DIRTY_TABLES[threadNum];
+	std::vector<  int>& lineWidths    = LINE_WIDTH_TABLES[threadNum];
+	std::vector< int2>& dirtySquares  = DIRTY_SQUARE_LISTS[threadNum];
+	std::vector<  int>& dirtyRays     = DIRTY_RAY_LISTS[threadNum];
+
+	helper.GenerateForLosSize(radius);
+
+	const CLosTableHelper::SquareRays& squareRays = helper.GenerateSquareRaysForLosSize(radius);
+
+	isqrtTableExpand((radius + 1) * (radius + 1), threadNum);
+
+	const size_t numRays = helper.GetLosTableSize(radius);
+
+	constexpr char SQUARE_DIRTY = 1;
+	constexpr char SQUARE_ANGLE = 2;
+	constexpr int RAY_CLEAN = std::numeric_limits<int>::max();
+	constexpr int RAY_RECAST = -1;
+
+	losRaySquares.clear();
+	losRaySquares.resize(Square(diameter), false);
+	raycastAngles.resize(Square(diameter));
+	squareStates.clear();
+	squareStates.resize(Square(diameter), 0);
+	rayDirtyIdcs.clear();
+	rayDirtyIdcs.resize(numRays * 4, RAY_CLEAN);
+	lineWidths.clear();
+	lineWidths.resize(diameter, -1);
+	dirtySquares.clear();
+	dirtyRays.clear();
+
+	MidpointCircleAlgoPerLine(radius, [&](int width, int y) {
+		lineWidths[y + radius] = std::max(lineWidths[y + radius], width);
+	});
+
+	// decode the previous result
+	for (const SLosInstance::RLE rle: losSquares) {
+		const int2 off = IdxToCoord(rle.start, size.x) - pos;
+		std::fill_n(&losRaySquares[ToAngleMapIdx(off, radius)], rle.length, true);
+	}
+
+	// the four mirrored orientations rays are cast in, and their inverse
+	const auto RotateSquare = [](int2 p, int o) -> int2 {
+		switch (o) {
+			case  0: return p;
+			case  1: return -p;
+			case  2: return int2( p.y, -p.x);
+			default: return int2(-p.y,  p.x);
+		}
+	};
+	const auto UnrotateSquare = [](int2 q, int o) -> int2 {
+		switch (o) {
+			case  0: return q;
+			case  1: return -q;
+			case  2: return int2(-q.y,  q.x);
+			default: return int2( q.y, -q.x);
+		}
+	};
+	const auto ForEachRayThrough = [&](int2 q, const auto& func) {
+		for (int o = 0; o < 4; ++o) {
+			const int2 p = UnrotateSquare(q, o);
+
+			if (p.x < 0 || p.y < 0 || p.x > radius || p.y > radius)
+				continue;
+
+			const auto rays = squareRays.Get(p, radius);
+
+			for (const int2* ray = rays.first; ray != rays.second; ++ray) {
+				func(ray->x * 4 + o, ray->y);
+			}
+		}
+	};
+
+	// same conditions as the angle precalculation in {Uns,S}afeLosAdd
+	const auto IsSquareInRange = [&](int2 q) {
+		return (q != int2(0, 0) && std::abs(q.x) <= lineWidths[q.y + radius] && fullRect.Inside(pos + q));
+	};
+	const auto CacheSquareAngle = [&](int2 q) {
+		const size_t oidx = ToAngleMapIdx(q, radius);
+
+		if (squareStates[oidx] & SQUARE_ANGLE)
+			return;
+
+		squareStates[oidx] |= SQUARE_ANGLE;
+		raycastAngles[oidx] = -1e8;
+
+		if (!IsSquareInRange(q))
+			return;
+
+		const float invR = isqrtTableLookup(q.x*q.x + q.y*q.y, threadNum);
+		const float dh = std::max(0.0f, mipHeightMap[MAP_SQUARE(pos + q)]) - losHeight;
+
+		raycastAngles[oidx] = (dh + LOS_BONUS_HEIGHT) * invR;
+	};
+
+
+	// 1. find the first damaged square of every ray
+	for (SRectangle rect: damagedRects) {
+		rect.ClampIn(instRect);
+
+		for (int y = rect.y1; y < rect.y2; ++y) {
+			for (int x = rect.x1; x < rect.x2; ++x) {
+				ForEachRayThrough(int2(x, y) - pos, [&](int rayKey, int squareIdx) {
+					if (rayDirtyIdcs[rayKey] == RAY_CLEAN)
+						dirtyRays.push_back(rayKey);
+
+					rayDirtyIdcs[rayKey] = std::min(rayDirtyIdcs[rayKey], squareIdx);
+				});
+			}
+		}
+	}
+
+	// 2. everything behind those squares can change
+	for (const int rayKey: dirtyRays) {
+		const size_t rayIndex = rayKey / 4;
+		const size_t numSquares = helper.GetLosTableRaySize(radius, rayIndex);
+
+		for (size_t n = rayDirtyIdcs[rayKey]; n < numSquares; n++) {
+			const int2 q = RotateSquare(helper.GetLosTableRaySquare(radius, rayIndex, n), rayKey % 4);
+			const size_t oidx = ToAngleMapIdx(q, radius);
+
+			if (squareStates[oidx] & SQUARE_DIRTY)
+				continue;
+
+			squareStates[oidx] |= SQUARE_DIRTY;
+			dirtySquares.push_back(q);
+		}
+
+		rayDirtyIdcs[rayKey] = RAY_RECAST;
+	}
+
+	// 3. all rays passing a dirty square contribute to its visibility
+	for (const int2 q: dirtySquares) {
+		ForEachRayThrough(q, [&](int rayKey, int) {
+			if (rayDirtyIdcs[rayKey] == RAY_RECAST)
+				return;
+
+			rayDirtyIdcs[rayKey] = RAY_RECAST;
+			dirtyRays.push_back(rayKey);
+		});
+
+		losRaySquares[ToAngleMapIdx(q, radius)] = IsSquareInRange(q);
+	}
+
+	// 4. recast them, rays only ever clear squares so their order does not matter
+	const bool emitInsideMap = fullRect.Inside(pos);
+
+	for (const int rayKey: dirtyRays) {
+		const size_t rayIndex = rayKey / 4;
+		const size_t numSquares = helper.GetLosTableRaySize(radius, rayIndex);
+
+		float maxAngle = -1e7;
+		float prvAngle = -1e7;
+
+		for (size_t n = 0; n < numSquares; n++) {
+			const int2 q = RotateSquare(helper.GetLosTableRaySquare(radius, rayIndex, n), rayKey % 4);
+
+			if (!fullRect.Inside(pos + q)) {
+				if (emitInsideMap)
+					break;
+
+				continue;
+			}
+
+			CacheSquareAngle(q);
+			CastLos(&prvAngle, &maxAngle, q, losRaySquares, raycastAngles, radius, threadNum);
+		}
+	}
+
+	li->squares.clear();
+
+	AddSquaresToInstance(li, losRaySquares);
+
+	if (li->squares.empty())
+		li->squares.push_back(SLosInstance::EMPTY_RLE);
+
+	return true;
+}
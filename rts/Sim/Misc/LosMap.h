@@ -43,6 +43,12 @@ public:
 	/// arbitrary area, for losMap, non-circular radar maps, ...
 	void PrepareRaycast(SLosInstance* instance) const;
 
+	/// re-raycasts only the rays crossing instance->damagedRects, returns false if a full PrepareRaycast is needed
+	bool UpdateRaycast(SLosInstance* instance) const;
+
+	/// true if AddRaycast informs the ReadMap about squares entering LoS, which is not thread-safe
+	bool SendsReadMapEvents(int allyTeam) const;
+
 public:
 	int At(int2 p) const {
 		p.x = std::clamp(p.x, 0, size.x - 1);
@@ -50,6 +50,7 @@ public:
 	bool allowSepAxisCollisionTest;  //< determines if (ground-)units perform collision-testing via the SAT
 	bool allowGroundUnitGravity;     //< determines if (ground-)units experience gravity during regular movement
 	bool allowHoverUnitStrafing;     //< determines if (hover-)units carry their momentum sideways when turning
+	bool allowAirCollisionPlanningMT; //< determines if aircraft look for collidees in parallel, against positions from before any of them moved
 
 	// relative to a unit's maxspeed (default: inf)
 	float maxCollisionPushMultiplier;
@@ -229,6 +230,14 @@ public:
 	int smoothMeshSmoothRadius;
 
 	int quadFieldQuadSizeInElmos;
+	/// exact unit queries (weapon targeting, explosions, area searches) test
+	/// against positions cached in each quad instead of live unit positions,
+	/// which is much faster in crowded quads. The cache of a unit is refreshed
+	/// when its quad position is (every unitQuadPositionUpdateRate frames, or
+	/// by Spring.ForceUnitCollisionUpdate), so with a rate above 1 a moving
+	/// unit can be found or missed based on where it was up to that many
+	/// frames ago. Default is false.
+	bool quadFieldPackedUnitQueries;
 
 	bool allowTake;
 	bool allowEnginePlayerlist;
@@ -33,7 +33,11 @@ CR_REG_METADATA(CQuadField, (
 	CR_IGNORED(tempFeatures),
 	CR_IGNORED(tempProjectiles),
 	CR_IGNORED(tempSolids),
-	CR_IGNORED(tempQuads)
+	CR_IGNORED(tempQuads),
+	CR_IGNORED(tempPackedHits),
+
+	CR_IGNORED(objectUpdateCount),
+	CR_IGNORED(usePackedUnitQueries)
 ))
 
 CR_BIND(CQuadField::Quad, )
@@ -43,6 +47,7 @@ CR_REG_METADATA_SUB(CQuadField, Quad, (
 	CR_MEMBER(features),
 	CR_MEMBER(projectiles),
 	CR_MEMBER(repulsers),
+	CR_IGNORED(packedUnits),
 
 	CR_POSTLOAD(PostLoad)
 ))
@@ -107,9 +112,29 @@ void CQuadField::Quad::PostLoad()
 	for (CUnit* unit: units) {
 		spring::VectorInsertUnique(teamUnits[unit->allyteam], unit, false);
 	}
+
+	RebuildPackedUnits(quadField.UsePackedUnitQueries());
 #endif
 }
 
+#ifndef UNIT_TEST
+void CQuadField::Quad::AddUnit(CUnit* unit, bool packed) { AddQuadUnit(*this, unit, packed); }
+void CQuadField::Quad::RemoveUnit(CUnit* unit, bool packed) { RemoveQuadUnit(*this, unit, packed); }
+void CQuadField::Quad::UpdatePackedUnit(const CUnit* unit) { UpdateQuadPackedUnit(*this, unit); }
+
+void CQuadField::Quad::RebuildPackedUnits(bool packed)
+{
+	packedUnits.Clear();
+
+	if (!packed)
+		return;
+
+	for (const CUnit* unit: units) {
+		packedUnits.Append(unit->pos, unit->radius);
+	}
+}
+#endif
+
 void CQuadField::Init(int2 mapDims, int quadSize)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
@@ -142,6 +167,17 @@ void CQuadField::Init(int2 mapDims, int quadSize)
 #endif
 }
 
+#ifndef UNIT_TEST
+void CQuadField::SetPackedUnitQueries(bool b)
+{
+	usePackedUnitQueries = b;
+
+	for (Quad& quad: baseQuads) {
+		quad.RebuildPackedUnits(b);
+	}
+}
+#endif
+
 void CQuadField::Kill()
 {
 	RECOIL_DETAILED_TRACY_ZONE;
@@ -183,7 +219,6 @@ int CQuadField::WorldPosToQuadFieldIdx(const float3 p) const
 }
 
 
-#ifndef UNIT_TEST
 void CQuadField::GetQuads(QuadFieldQuery& qfq, float3 pos, float radius)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
@@ -238,7 +273,6 @@ void CQuadField::GetQuadsRectangle(QuadFieldQuery& qfq, const float3& mins, cons
 
 	return;
 }
-#endif // UNIT_TEST
 
 
 /// note: this function got an UnitTest, check the tests/ folder!
@@ -347,8 +381,16 @@ bool CQuadField::InsertUnitIf(CUnit* unit, const float3& wpos)
 	if (!spring::VectorInsertUnique(unit->quads, wposQuadIdx, true))
 		return false;
 
-	spring::VectorInsertUnique(baseQuads[wposQuadIdx].units, unit, false);
-	spring::VectorInsertUnique(baseQuads[wposQuadIdx].teamUnits[unit->allyteam], unit, false);
+	objectUpdateCount++;
+	baseQuads[wposQuadIdx].AddUnit(unit, usePackedUnitQueries);
+
+	// keep the packed entries of all quads touched by <unit> identical
+	if (usePackedUnitQueries) {
+		for (const int qi: unit->quads) {
+			baseQuads[qi].UpdatePackedUnit(unit);
+		}
+	}
+
 	return true;
 }
 
@@ -378,8 +420,8 @@ bool CQuadField::RemoveUnitIf(CUnit* unit, const float3& wpos)
 	if (!spring::VectorErase(unit->quads, wposQuadIdx))
 		return false;
 
-	spring::VectorErase(baseQuads[wposQuadIdx].units, unit);
-	spring::VectorErase(baseQuads[wposQuadIdx].teamUnits[unit->allyteam], unit);
+	objectUpdateCount++;
+	baseQuads[wposQuadIdx].RemoveUnit(unit, usePackedUnitQueries);
 	return true;
 }
 #endif
@@ -390,37 +432,20 @@ bool CQuadField::RemoveUnitIf(CUnit* unit, const float3& wpos)
 void CQuadField::MovedUnit(CUnit* unit)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
+	objectUpdateCount++;
+
 	QuadFieldQuery qfQuery;
 	GetQuads(qfQuery, unit->pos, unit->radius);
 
-	// compare if the quads have changed, if not stop here
-	if (qfQuery.quads->size() == unit->quads.size()) {
-		if (std::equal(qfQuery.quads->begin(), qfQuery.quads->end(), unit->quads.begin()))
-			return;
-	}
-
-	for (const int qi: unit->quads) {
-		spring::VectorErase(baseQuads[qi].units, unit);
-		spring::VectorErase(baseQuads[qi].teamUnits[unit->allyteam], unit);
-	}
-
-	for (const int qi: *qfQuery.quads) {
-		spring::VectorInsertUnique(baseQuads[qi].units, unit, false);
-		spring::VectorInsertUnique(baseQuads[qi].teamUnits[unit->allyteam], unit, false);
-	}
-
-	unit->quads = std::move(*qfQuery.quads);
+	MoveQuadsUnit(baseQuads, unit, *qfQuery.quads, usePackedUnitQueries);
 }
 
 void CQuadField::RemoveUnit(CUnit* unit)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
-	for (const int qi: unit->quads) {
-		spring::VectorErase(baseQuads[qi].units, unit);
-		spring::VectorErase(baseQuads[qi].teamUnits[unit->allyteam], unit);
-	}
+	objectUpdateCount++;
 
-	unit->quads.clear();
+	RemoveQuadsUnit(baseQuads, unit, usePackedUnitQueries);
 
 	#ifdef DEBUG_QUADFIELD
 	for (const Quad& q: baseQuads) {
@@ -437,6 +462,8 @@ void CQuadField::RemoveUnit(CUnit* unit)
 void CQuadField::MovedRepulser(CPlasmaRepulser* repulser)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
+	objectUpdateCount++;
+
 	QuadFieldQuery qfQuery;
 	GetQuads(qfQuery, repulser->weaponMuzzlePos, repulser->GetRadius());
 
@@ -462,6 +489,8 @@ void CQuadField::MovedRepulser(CPlasmaRepulser* repulser)
 void CQuadField::RemoveRepulser(CPlasmaRepulser* repulser)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
+	objectUpdateCount++;
+
 	for (const int qi: repulser->GetQuads()) {
 		spring::VectorErase(baseQuads[qi].repulsers, repulser);
 	}
@@ -481,6 +510,8 @@ void CQuadField::RemoveRepulser(CPlasmaRepulser* repulser)
 void CQuadField::AddFeature(CFeature* feature)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
+	objectUpdateCount++;
+
 	QuadFieldQuery qfQuery;
 	GetQuads(qfQuery, feature->pos, feature->radius);
 
@@ -492,6 +523,8 @@ void CQuadField::AddFeature(CFeature* feature)
 void CQuadField::RemoveFeature(CFeature* feature)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
+	objectUpdateCount++;
+
 	QuadFieldQuery qfQuery;
 	GetQuads(qfQuery, feature->pos, feature->radius);
 
@@ -598,23 +631,10 @@ void CQuadField::GetUnitsExact(QuadFieldQuery& qfq, const float3& pos, float rad
 	qfq.units = tempUnits[curThread].ReserveVector();
 
 	for (const int qi: *qfQuery.quads) {
-		for (CUnit* u: baseQuads[qi].units) {
-			if (u->mtTempNum[curThread] == tempNum)
-				continue;
-
-			u->mtTempNum[curThread] = tempNum;
-
-			const float totRad       = radius + u->radius;
-			const float totRadSq     = totRad * totRad;
-			const float posUnitDstSq = spherical?
-				pos.SqDistance(u->pos):
-				pos.SqDistance2D(u->pos);
-
-			if (posUnitDstSq >= totRadSq)
-				continue;
+		const Quad& quad = baseQuads[qi];
+		const QuadFieldPacked* packed = usePackedUnitQueries? &quad.packedUnits: nullptr;
 
-			qfq.units->push_back(u);
-		}
+		GetQuadUnitsExact(*qfq.units, quad.units, packed, tempPackedHits[curThread], curThread, tempNum, pos, radius, spherical);
 	}
 
 	return;
@@ -631,21 +651,10 @@ void CQuadField::GetUnitsExact(QuadFieldQuery& qfq, const float3& mins, const fl
 	qfq.units = tempUnits[curThread].ReserveVector();
 
 	for (const int qi: *qfQuery.quads) {
-		for (CUnit* unit: baseQuads[qi].units) {
-
-			if (unit->mtTempNum[curThread] == tempNum)
-				continue;
-
-			unit->mtTempNum[curThread] = tempNum;
-
-			const float3& pos = unit->pos;
-			if (pos.x < mins.x || pos.x > maxs.x)
-				continue;
-			if (pos.z < mins.z || pos.z > maxs.z)
-				continue;
+		const Quad& quad = baseQuads[qi];
+		const QuadFieldPacked* packed = usePackedUnitQueries? &quad.packedUnits: nullptr;
 
-			qfq.units->push_back(unit);
-		}
+		GetQuadUnitsExact(*qfq.units, quad.units, packed, tempPackedHits[curThread], curThread, tempNum, mins, maxs);
 	}
 
 	return;
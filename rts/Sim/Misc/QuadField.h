@@ -5,8 +5,11 @@
 
 #include <algorithm>
 #include <array>
+#include <cstdint>
 #include <vector>
 
+#include "Sim/Misc/QuadFieldPacked.h"
+#include "System/ContainerUtil.h"
 #include "System/Misc/NonCopyable.h"
 #include "System/Threading/ThreadPool.h"
 #include "System/creg/creg_cond.h"
@@ -191,10 +194,15 @@ public:
 			features = std::move(q.features);
 			projectiles = std::move(q.projectiles);
 			repulsers = std::move(q.repulsers);
+			packedUnits = std::move(q.packedUnits);
 			return *this;
 		}
 
 		void PostLoad();
+		void AddUnit(CUnit* unit, bool packed);
+		void RemoveUnit(CUnit* unit, bool packed);
+		void UpdatePackedUnit(const CUnit* unit);
+		void RebuildPackedUnits(bool packed);
 		void Resize(int numAllyTeams) { teamUnits.resize(numAllyTeams); }
 		void Clear() {
 			units.clear();
@@ -206,6 +214,7 @@ public:
 			features.clear();
 			projectiles.clear();
 			repulsers.clear();
+			packedUnits.Clear();
 		}
 
 	public:
@@ -214,6 +223,10 @@ public:
 		std::vector<CFeature*> features;
 		std::vector<CProjectile*> projectiles;
 		std::vector<CPlasmaRepulser*> repulsers;
+
+		///< pos, radius and allyteam of each entry in <units>, same order;
+		///< only maintained while packed unit queries are enabled
+		QuadFieldPacked packedUnits;
 	};
 
 	const Quad& GetQuad(unsigned i) const {
@@ -232,6 +245,71 @@ public:
 	int GetQuadSizeX() const { return quadSizeX; }
 	int GetQuadSizeZ() const { return quadSizeZ; }
 
+	/**
+	 * When enabled, GetUnitsExact tests against the per-quad packed copies
+	 * of unit positions instead of reading CUnit::pos, which allows the tests
+	 * to be vectorized. The copies are only refreshed when MovedUnit is called
+	 * (every unitQuadPositionUpdateRate frames per unit), so results can lag
+	 * behind the live positions; hence this is a modrule.
+	 */
+	bool UsePackedUnitQueries() const { return usePackedUnitQueries; }
+	void SetPackedUnitQueries(bool b);
+
+	/**
+	 * The exact tests of GetUnitsExact for the units of a single quad, against
+	 * their live positions or, if @c packed is given, against its copies of
+	 * them. Units already marked with @c tempNum are skipped. Templated on the
+	 * unit type so tests can run them on stand-ins.
+	 */
+	template<typename U>
+	static void GetQuadUnitsExact(
+		std::vector<U*>& result,
+		const std::vector<U*>& units,
+		const QuadFieldPacked* packed,
+		std::vector<uint32_t>& hits,
+		int curThread,
+		int tempNum,
+		const float3& pos,
+		float radius,
+		bool spherical
+	);
+	template<typename U>
+	static void GetQuadUnitsExact(
+		std::vector<U*>& result,
+		const std::vector<U*>& units,
+		const QuadFieldPacked* packed,
+		std::vector<uint32_t>& hits,
+		int curThread,
+		int tempNum,
+		const float3& mins,
+		const float3& maxs
+	);
+
+	/**
+	 * The quad maintenance of MovedUnit, RemoveUnit and Quad, templated on the
+	 * unit and quad types like GetQuadUnitsExact so tests can run them on
+	 * stand-ins. MoveQuadsUnit moves @c unit from the quads it is in to
+	 * @c newQuads, or only refreshes its packed entries if those are the same.
+	 * @c packed tells whether the quads' packed copies are maintained.
+	 */
+	template<typename Q, typename U>
+	static void MoveQuadsUnit(std::vector<Q>& quads, U* unit, std::vector<int>& newQuads, bool packed);
+	template<typename Q, typename U>
+	static void RemoveQuadsUnit(std::vector<Q>& quads, U* unit, bool packed);
+
+	template<typename Q, typename U>
+	static void AddQuadUnit(Q& quad, U* unit, bool packed);
+	template<typename Q, typename U>
+	static void RemoveQuadUnit(Q& quad, U* unit, bool packed);
+	template<typename Q, typename U>
+	static void UpdateQuadPackedUnit(Q& quad, const U* unit);
+
+	/**
+	 * Incremented whenever a unit, feature or repulser is added, moved or
+	 * removed, so callers can tell if a snapshot of quad contents went stale.
+	 */
+	unsigned int GetObjectUpdateCount() const { return objectUpdateCount; }
+
 	constexpr static unsigned int BASE_QUAD_SIZE = 128;
 
 private:
@@ -247,6 +325,7 @@ private:
 	QueryVectorCache<CProjectile*> tempProjectiles;
 	std::array< QueryVectorCache<CSolidObject*>, ThreadPool::MAX_THREADS > tempSolids;
 	std::array< QueryVectorCache<int>, ThreadPool::MAX_THREADS > tempQuads;
+	std::array< std::vector<uint32_t>, ThreadPool::MAX_THREADS > tempPackedHits;
 
 	float2 invQuadSize;
 
@@ -255,11 +334,189 @@ private:
 
 	int quadSizeX;
 	int quadSizeZ;
+
+	unsigned int objectUpdateCount = 0;
+
+	bool usePackedUnitQueries = false;
 };
 
 extern CQuadField quadField;
 
 
+template<typename U>
+void CQuadField::GetQuadUnitsExact(
+	std::vector<U*>& result,
+	const std::vector<U*>& units,
+	const QuadFieldPacked* packed,
+	std::vector<uint32_t>& hits,
+	int curThread,
+	int tempNum,
+	const float3& pos,
+	float radius,
+	bool spherical
+) {
+	if (packed != nullptr) {
+		hits.clear();
+		packed->GetIndicesExact(hits, pos, radius, spherical);
+
+		// a unit spanning several quads has identical packed entries
+		// in each of them, so it either hits in all or in none
+		for (const uint32_t hi: hits) {
+			U* u = units[hi];
+
+			if (u->mtTempNum[curThread] == tempNum)
+				continue;
+
+			u->mtTempNum[curThread] = tempNum;
+			result.push_back(u);
+		}
+
+		return;
+	}
+
+	for (U* u: units) {
+		if (u->mtTempNum[curThread] == tempNum)
+			continue;
+
+		u->mtTempNum[curThread] = tempNum;
+
+		const float totRad       = radius + u->radius;
+		const float totRadSq     = totRad * totRad;
+		const float posUnitDstSq = spherical?
+			pos.SqDistance(u->pos):
+			pos.SqDistance2D(u->pos);
+
+		if (posUnitDstSq >= totRadSq)
+			continue;
+
+		result.push_back(u);
+	}
+}
+
+template<typename U>
+void CQuadField::GetQuadUnitsExact(
+	std::vector<U*>& result,
+	const std::vector<U*>& units,
+	const QuadFieldPacked* packed,
+	std::vector<uint32_t>& hits,
+	int curThread,
+	int tempNum,
+	const float3& mins,
+	const float3& maxs
+) {
+	if (packed != nullptr) {
+		hits.clear();
+		packed->GetIndicesExact(hits, mins, maxs);
+
+		for (const uint32_t hi: hits) {
+			U* unit = units[hi];
+
+			if (unit->mtTempNum[curThread] == tempNum)
+				continue;
+
+			unit->mtTempNum[curThread] = tempNum;
+			result.push_back(unit);
+		}
+
+		return;
+	}
+
+	for (U* unit: units) {
+		if (unit->mtTempNum[curThread] == tempNum)
+			continue;
+
+		unit->mtTempNum[curThread] = tempNum;
+
+		const float3& pos = unit->pos;
+		if (pos.x < mins.x || pos.x > maxs.x)
+			continue;
+		if (pos.z < mins.z || pos.z > maxs.z)
+			continue;
+
+		result.push_back(unit);
+	}
+}
+
+template<typename Q, typename U>
+void CQuadField::MoveQuadsUnit(std::vector<Q>& quads, U* unit, std::vector<int>& newQuads, bool packed)
+{
+	// compare if the quads have changed, if not stop here
+	if (newQuads.size() == unit->quads.size()) {
+		if (std::equal(newQuads.begin(), newQuads.end(), unit->quads.begin())) {
+			if (!packed)
+				return;
+
+			for (const int qi: unit->quads) {
+				UpdateQuadPackedUnit(quads[qi], unit);
+			}
+
+			return;
+		}
+	}
+
+	for (const int qi: unit->quads) {
+		RemoveQuadUnit(quads[qi], unit, packed);
+	}
+
+	for (const int qi: newQuads) {
+		AddQuadUnit(quads[qi], unit, packed);
+	}
+
+	unit->quads = std::move(newQuads);
+}
+
+template<typename Q, typename U>
+void CQuadField::RemoveQuadsUnit(std::vector<Q>& quads, U* unit, bool packed)
+{
+	for (const int qi: unit->quads) {
+		RemoveQuadUnit(quads[qi], unit, packed);
+	}
+
+	unit->quads.clear();
+}
+
+template<typename Q, typename U>
+void CQuadField::AddQuadUnit(Q& quad, U* unit, bool packed)
+{
+	spring::VectorInsertUnique(quad.units, unit, false);
+	spring::VectorInsertUnique(quad.teamUnits[unit->allyteam], unit, false);
+
+	if (!packed)
+		return;
+
+	quad.packedUnits.Append(unit->pos, unit->radius);
+}
+
+template<typename Q, typename U>
+void CQuadField::RemoveQuadUnit(Q& quad, U* unit, bool packed)
+{
+	// mirror spring::VectorErase so <packedUnits> stays index-aligned
+	const auto iter = std::find(quad.units.begin(), quad.units.end(), unit);
+
+	if (iter == quad.units.end())
+		return;
+
+	if (packed)
+		quad.packedUnits.EraseSwap(iter - quad.units.begin());
+
+	*iter = quad.units.back();
+	quad.units.pop_back();
+
+	spring::VectorErase(quad.teamUnits[unit->allyteam], unit);
+}
+
+template<typename Q, typename U>
+void CQuadField::UpdateQuadPackedUnit(Q& quad, const U* unit)
+{
+	const auto iter = std::find(quad.units.begin(), quad.units.end(), unit);
+
+	if (iter == quad.units.end())
+		return;
+
+	quad.packedUnits.Assign(iter - quad.units.begin(), unit->pos, unit->radius);
+}
+
+
 struct QuadFieldQuery {
 	~QuadFieldQuery() {
 		quadField.ReleaseVector(units, threadOwner);
@@ -0,0 +1,103 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include <bit>
+
+#include "QuadFieldPacked.h"
+
+#include "xsimd/xsimd.hpp"
+
+#include "System/Misc/TracyDefs.h"
+
+using BatchType = xsimd::simd_type<float>;
+static constexpr size_t BATCH_SIZE = BatchType::size;
+
+
+template<typename MaskType>
+static inline void AppendBatchHits(std::vector<uint32_t>& hits, const MaskType& mask, size_t base)
+{
+#if defined(XSIMD_X86_INSTR_SET) && (XSIMD_X86_INSTR_SET >= XSIMD_X86_AVX_VERSION)
+	uint32_t bits = _mm256_movemask_ps(mask);
+#elif defined(XSIMD_X86_INSTR_SET) && (XSIMD_X86_INSTR_SET >= XSIMD_X86_SSE2_VERSION)
+	uint32_t bits = _mm_movemask_ps(mask);
+#else
+	alignas(32) float lanes[BATCH_SIZE];
+	xsimd::store_aligned(lanes, xsimd::select(mask, BatchType(1.0f), BatchType(0.0f)));
+
+	uint32_t bits = 0;
+
+	for (size_t j = 0; j < BATCH_SIZE; ++j) {
+		bits |= (uint32_t(lanes[j] != 0.0f) << j);
+	}
+#endif
+
+	for (; bits != 0; bits &= (bits - 1)) {
+		hits.push_back(base + std::countr_zero(bits));
+	}
+}
+
+
+void QuadFieldPacked::GetIndicesExact(std::vector<uint32_t>& hits, const float3& pos, float radius, bool spherical) const
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	const size_t numEntries = Size();
+	const size_t numBatched = numEntries - (numEntries % BATCH_SIZE);
+
+	const BatchType qx(pos.x);
+	const BatchType qy(pos.y);
+	const BatchType qz(pos.z);
+	const BatchType qr(radius);
+
+	for (size_t i = 0; i < numBatched; i += BATCH_SIZE) {
+		const BatchType dx = qx - xsimd::load_unaligned(&posX[i]);
+		const BatchType dy = qy - xsimd::load_unaligned(&posY[i]);
+		const BatchType dz = qz - xsimd::load_unaligned(&posZ[i]);
+		const BatchType tr = qr + xsimd::load_unaligned(&radii[i]);
+
+		// same evaluation order as float3::SqDistance{2D}; the negated test
+		// keeps NaN distances in, exactly like the scalar early-continue
+		const BatchType dstSq = spherical? ((dx * dx + dy * dy) + dz * dz): (dx * dx + dz * dz);
+
+		AppendBatchHits(hits, !(dstSq >= (tr * tr)), i);
+	}
+
+	for (size_t i = numBatched; i < numEntries; ++i) {
+		const float dx = pos.x - posX[i];
+		const float dy = pos.y - posY[i];
+		const float dz = pos.z - posZ[i];
+		const float totRad = radius + radii[i];
+		const float dstSq = spherical? (dx * dx + dy * dy + dz * dz): (dx * dx + dz * dz);
+
+		if (dstSq >= (totRad * totRad))
+			continue;
+
+		hits.push_back(i);
+	}
+}
+
+void QuadFieldPacked::GetIndicesExact(std::vector<uint32_t>& hits, const float3& mins, const float3& maxs) const
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	const size_t numEntries = Size();
+	const size_t numBatched = numEntries - (numEntries % BATCH_SIZE);
+
+	const BatchType minX(mins.x);
+	const BatchType minZ(mins.z);
+	const BatchType maxX(maxs.x);
+	const BatchType maxZ(maxs.z);
+
+	for (size_t i = 0; i < numBatched; i += BATCH_SIZE) {
+		const BatchType px = xsimd::load_unaligned(&posX[i]);
+		const BatchType pz = xsimd::load_unaligned(&posZ[i]);
+
+		AppendBatchHits(hits, !((px < minX) || (px > maxX) || (pz < minZ) || (pz > maxZ)), i);
+	}
+
+	for (size_t i = numBatched; i < numEntries; ++i) {
+		if (posX[i] < mins.x || posX[i] > maxs.x)
+			continue;
+		if (posZ[i] < mins.z || posZ[i] > maxs.z)
+			continue;
+
+		hits.push_back(i);
+	}
+}
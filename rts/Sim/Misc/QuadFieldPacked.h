@@ -0,0 +1,69 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef QUAD_FIELD_PACKED_H
+#define QUAD_FIELD_PACKED_H
+
+#include <cstdint>
+#include <vector>
+
+#include "System/float3.h"
+
+/**
+ * Dense (structure-of-arrays) copy of the position and radius of every object in a single QuadField cell. Entries are kept in the same order
+ * as the cell's object vector (including spring::VectorErase's swap-with-last
+ * semantics), so a kernel hit at index i refers to the i-th object there and
+ * the objects themselves need not be touched to reject them.
+ */
+class QuadFieldPacked {
+public:
+	void Clear() {
+		posX.clear();
+		posY.clear();
+		posZ.clear();
+		radii.clear();
+	}
+
+	void Append(const float3& pos, float radius) {
+		posX.push_back(pos.x);
+		posY.push_back(pos.y);
+		posZ.push_back(pos.z);
+		radii.push_back(radius);
+	}
+
+	void Assign(size_t idx, const float3& pos, float radius) {
+		posX[idx] = pos.x;
+		posY[idx] = pos.y;
+		posZ[idx] = pos.z;
+		radii[idx] = radius;
+	}
+
+	void EraseSwap(size_t idx) {
+		posX[idx] = posX.back(); posX.pop_back();
+		posY[idx] = posY.back(); posY.pop_back();
+		posZ[idx] = posZ.back(); posZ.pop_back();
+		radii[idx] = radii.back(); radii.pop_back();
+	}
+
+	size_t Size() const { return posX.size(); }
+
+	/**
+	 * Appends (in ascending order) the index of every entry whose sphere
+	 * overlaps the query sphere, or the infinite vertical cylinder through
+	 * it if @c spherical is false. Matches CQuadField::GetUnitsExact bit for
+	 * bit when fed the same positions.
+	 */
+	void GetIndicesExact(std::vector<uint32_t>& hits, const float3& pos, float radius, bool spherical) const;
+	/**
+	 * Appends (in ascending order) the index of every entry whose center
+	 * lies within the rectangle defined by mins and maxs on the xz-plane
+	 */
+	void GetIndicesExact(std::vector<uint32_t>& hits, const float3& mins, const float3& maxs) const;
+
+private:
+	std::vector<float> posX;
+	std::vector<float> posY;
+	std::vector<float> posZ;
+	std::vector<float> radii;
+};
+
+#endif /* QUAD_FIELD_PACKED_H */
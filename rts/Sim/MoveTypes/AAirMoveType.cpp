@@ -8,6 +8,7 @@
 #include "Map/MapInfo.h"
 #include "Rendering/Env/Particles/Classes/SmokeProjectile.h"
 #include "Sim/Ecs/Registry.h"
+#include "Sim/Misc/GlobalSynced.h"
 #include "Sim/Misc/QuadField.h"
 #include "Sim/Misc/SmoothHeightMesh.h"
 #include "Sim/Projectiles/ExplosionGenerator.h"
@@ -16,6 +17,7 @@
 #include "Sim/Units/UnitDef.h"
 #include "Sim/Units/CommandAI/CommandAI.h"
 #include "System/SpringMath.h"
+#include "System/Threading/ThreadPool.h"
 
 #include "System/Misc/TracyDefs.h"
 
@@ -46,6 +48,9 @@ CR_REG_METADATA(AAirMoveType, (
 	CR_MEMBER(floatOnWater),
 
 	CR_MEMBER(lastCollidee),
+	CR_IGNORED(plannedCollidee),
+	CR_IGNORED(plannedCollisionState),
+	CR_IGNORED(plannedCollisionFrame),
 
 	CR_MEMBER(crashExpGenID)
 ))
@@ -113,7 +118,19 @@ AAirMoveType::AAirMoveType(CUnit* unit): AMoveType(unit)
 		crashExpGenID = ud->GetCrashExpGenID(crashExpGenID);
 	}
 
-	Sim::registry.emplace_or_replace<GeneralMoveType>(owner->entityReference, owner->id);
+	Connect();
+}
+
+void AAirMoveType::Connect() {
+	RECOIL_DETAILED_TRACY_ZONE;
+	AMoveType::Connect();
+	Sim::registry.emplace_or_replace<AirMoveType>(owner->entityReference, owner->id);
+}
+
+void AAirMoveType::Disconnect() {
+	RECOIL_DETAILED_TRACY_ZONE;
+	AMoveType::Disconnect();
+	Sim::registry.remove<AirMoveType>(owner->entityReference);
 }
 
 
@@ -236,19 +253,32 @@ void AAirMoveType::UpdateLanding()
 }
 
 
+void AAirMoveType::PlanCollisionCheck()
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	// same condition the {Hover,Strafe}AirMoveType's check under
+	if (!collide || ((gs->frameNum + owner->id) & 3) != 0)
+		return;
+
+	plannedCollisionState = FindCollidee(owner->midPos, owner->frontdir, ThreadPool::GetThreadNum(), plannedCollidee);
+	plannedCollisionFrame = gs->frameNum;
+}
+
 void AAirMoveType::CheckForCollision()
 {
 	RECOIL_DETAILED_TRACY_ZONE;
 	if (!collide)
 		return;
 
-	const SyncedFloat3& pos = owner->midPos;
-	const SyncedFloat3& forward = owner->frontdir;
+	CUnit* collidee = nullptr;
+	CollisionState state = COLLISION_NOUNIT;
 
-	float dist = 200.0f;
-
-	QuadFieldQuery qfQuery;
-	quadField.GetUnitsExact(qfQuery, pos + forward * 121.0f, dist);
+	if (plannedCollisionFrame == gs->frameNum) {
+		collidee = plannedCollidee;
+		state = plannedCollisionState;
+	} else {
+		state = FindCollidee(owner->midPos, owner->frontdir, 0, collidee);
+	}
 
 	if (lastCollidee != nullptr) {
 		DeleteDeathDependence(lastCollidee, DEPENDENCE_LASTCOLWARN);
@@ -257,6 +287,25 @@ void AAirMoveType::CheckForCollision()
 		collisionState = COLLISION_NOUNIT;
 	}
 
+	if (collidee == nullptr)
+		return;
+
+	lastCollidee = collidee;
+	collisionState = state;
+	AddDeathDependence(lastCollidee, DEPENDENCE_LASTCOLWARN);
+}
+
+AAirMoveType::CollisionState AAirMoveType::FindCollidee(const float3& pos, const float3& forward, int threadOwner, CUnit*& collidee) const
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	float dist = 200.0f;
+
+	QuadFieldQuery qfQuery;
+	qfQuery.threadOwner = threadOwner;
+	quadField.GetUnitsExact(qfQuery, pos + forward * 121.0f, dist);
+
+	collidee = nullptr;
+
 	// find closest potential collidee
 	for (CUnit* unit: *qfQuery.units) {
 		if (unit == owner || !unit->unitDef->canfly)
@@ -276,15 +325,12 @@ void AAirMoveType::CheckForCollision()
 
 		if (ortoDif.SqLength() < (minOrtoDif * minOrtoDif)) {
 			dist = frontLength;
-			lastCollidee = const_cast<CUnit*>(unit);
+			collidee = unit;
 		}
 	}
 
-	if (lastCollidee != nullptr) {
-		collisionState = COLLISION_DIRECT;
-		AddDeathDependence(lastCollidee, DEPENDENCE_LASTCOLWARN);
-		return;
-	}
+	if (collidee != nullptr)
+		return COLLISION_DIRECT;
 
 	for (CUnit* u: *qfQuery.units) {
 		if (u == owner)
@@ -293,12 +339,11 @@ void AAirMoveType::CheckForCollision()
 		if ((u->midPos - pos).SqLength() > Square((owner->radius + u->radius) * 2.0f))
 			continue;
 
-		lastCollidee = u;
+		collidee = u;
 	}
 
-	if (lastCollidee != nullptr) {
-		collisionState = COLLISION_NEARBY;
-		AddDeathDependence(lastCollidee, DEPENDENCE_LASTCOLWARN);
-		return;
-	}
+	if (collidee != nullptr)
+		return COLLISION_NEARBY;
+
+	return COLLISION_NOUNIT;
 }
@@ -60,8 +60,19 @@ public:
 
 	void DependentDied(CObject* o);
 
+	void Connect() override;
+	void Disconnect() override;
+
+	/**
+	 * Look for the unit CheckForCollision will warn about this frame, if it
+	 * runs this frame. Only reads shared state, so it can be called from
+	 * any thread, before the (single-threaded) Update.
+	 */
+	void PlanCollisionCheck();
+
 protected:
 	void CheckForCollision();
+	CollisionState FindCollidee(const float3& pos, const float3& forward, int threadOwner, CUnit*& collidee) const;
 
 public:
 	AircraftState aircraftState = AIRCRAFT_LANDED;
@@ -92,6 +103,10 @@ public:
 protected:
 	/// unit found to be dangerously close to our path
 	CUnit* lastCollidee = nullptr;
+	/// result of PlanCollisionCheck, only valid during plannedCollisionFrame
+	CUnit* plannedCollidee = nullptr;
+	CollisionState plannedCollisionState = COLLISION_NOUNIT;
+	int plannedCollisionFrame = -1;
 
 	unsigned int crashExpGenID = -1u;
 };
@@ -5,6 +5,8 @@
 #include "GeneralMoveSystem.h"
 
 #include "Sim/Ecs/Registry.h"
+#include "Sim/Misc/ModInfo.h"
+#include "Sim/MoveTypes/AAirMoveType.h"
 #include "Sim/MoveTypes/Components/MoveTypesComponents.h"
 #include "Sim/MoveTypes/MoveMath/MoveMath.h"
 #include "Sim/Units/Unit.h"
@@ -26,6 +28,25 @@ void GeneralMoveSystem::Init() {
 
 void GeneralMoveSystem::Update() {
     RECOIL_DETAILED_TRACY_ZONE;
+	if (modInfo.allowAirCollisionPlanningMT) {
+        // The neighbour queries for the aircraft collision warnings only read
+        // positions, so they all run up front; Update (below) applies them.
+        // Aircraft updated earlier in the loop have moved by then, which is why
+        // results differ from the serial queries and this is opt-in.
+        SCOPED_TIMER("Sim::Unit::MoveType::5::PlanAirCollisions");
+        auto view = Sim::registry.view<AirMoveType>();
+        for_mt(0, view.size(), [&view](const int i){
+            auto entity = view.storage<AirMoveType>()[i];
+            auto unitId = view.get<AirMoveType>(entity);
+
+            CUnit* unit = unitHandler.GetUnit(unitId.value);
+            AAirMoveType* moveType = static_cast<AAirMoveType*>(unit->moveType);
+            assert(moveType != nullptr);
+
+            moveType->PlanCollisionCheck();
+        });
+	}
+
     auto view = Sim::registry.view<GeneralMoveType>();
 	{
         SCOPED_TIMER("Sim::Unit::MoveType::5::Update");
@@ -13,6 +13,7 @@
 
 #include "System/EventHandler.h"
 #include "System/TimeProfiler.h"
+#include "System/Sync/SyncedPrimitiveBase.h"
 #include "System/Threading/ThreadPool.h"
 
 using namespace MoveTypes;
@@ -31,6 +32,22 @@ void issue_events(F func)
     });
 }
 
+// for_mt over code that writes synced vars; each job has to call Sync::SetMTKey
+// before its first write. The sync debugger needs all writes in sequence, so
+// that build stays single-threaded.
+template<typename F>
+void for_mt_synced(int start, int end, F&& func)
+{
+#ifdef SYNCDEBUG
+    for (int i = start; i < end; ++i) {
+        func(i);
+    }
+#else
+    Sync::ScopedMTSection mtSection;
+    for_mt(start, end, func);
+#endif
+}
+
 void GroundMoveSystem::Update() {
     auto& comp = Sim::systemGlobals.GetSystemComponent<GroundMoveSystemComponent>();
 
@@ -58,9 +75,26 @@ void GroundMoveSystem::Update() {
 	{
 		SCOPED_TIMER("Sim::Unit::MoveType::2::UpdatePreCollisions");
 
-        // These two sections are ST due to the numerous synced vars being changed.
+        // Units with a Lua ChangeHeading callin are left for the ST pass, in
+        // the same order as before; everyone else only changes its own state.
         {
             auto view = Sim::registry.view<ChangeHeadingEvent>();
+            for_mt_synced(0, view.size(), [&view](const int i){
+                auto entity = view.storage<ChangeHeadingEvent>()[i];
+                auto& event = view.get<ChangeHeadingEvent>(entity);
+
+                if (!event.changed)
+                    return;
+
+                CUnit* unit = unitHandler.GetUnit(event.unitId);
+                if (unit->script->HasChangeHeading())
+                    return;
+
+                Sync::SetMTKey(event.unitId);
+                CGroundMoveType* moveType = static_cast<CGroundMoveType*>(unit->moveType);
+                moveType->ChangeHeading(event.deltaHeading);
+                event.changed = false;
+            });
             view.each([](ChangeHeadingEvent& event){
                 if (event.changed) {
                     CUnit* unit = unitHandler.GetUnit(event.unitId);
@@ -72,6 +106,22 @@ void GroundMoveSystem::Update() {
         }
         {
             auto view = Sim::registry.view<ChangeMainHeadingEvent>();
+            for_mt_synced(0, view.size(), [&view](const int i){
+                auto entity = view.storage<ChangeMainHeadingEvent>()[i];
+                auto& event = view.get<ChangeMainHeadingEvent>(entity);
+
+                if (!event.changed)
+                    return;
+
+                CUnit* unit = unitHandler.GetUnit(event.unitId);
+                if (unit->script->HasChangeHeading())
+                    return;
+
+                Sync::SetMTKey(event.unitId);
+                CGroundMoveType* moveType = static_cast<CGroundMoveType*>(unit->moveType);
+                moveType->SetMainHeading();
+                event.changed = false;
+            });
             view.each([](ChangeMainHeadingEvent& event){
                 if (event.changed) {
                     CUnit* unit = unitHandler.GetUnit(event.unitId);
@@ -150,16 +200,37 @@ void GroundMoveSystem::Update() {
         });
 	}
 	{
-        // TODO: the vars are synced and that's what is stoping this being MT'ed.
-        // Need an alternative method to support sync values that doesn't stop MT.
-        // Same for change heading above as well.
         SCOPED_TIMER("Sim::Unit::MoveType::5::Update");
         auto view = Sim::registry.view<GroundMoveType>();
-        view.each([&view](GroundMoveType& unitId){
+
+        // Update only moves the unit itself; the result is kept in its UnitMovedEvent.
+        // (SyncWaypoints would call Fail() and so Lua if moveFailed were set, nothing sets it)
+        for_mt_synced(0, view.size(), [&view](const int i){
+            auto entity = view.storage<GroundMoveType>()[i];
+            auto unitId = view.get<GroundMoveType>(entity);
+
             CUnit* unit = unitHandler.GetUnit(unitId.value);
             CGroundMoveType* moveType = static_cast<CGroundMoveType*>(unit->moveType);
             assert(moveType != nullptr);
-            if (moveType->Update()) 
+
+            Sync::SetMTKey(unitId.value);
+
+            auto& event = Sim::registry.get<UnitMovedEvent>(entity);
+            event.unit = unit;
+            event.moved = moveType->Update();
+        });
+
+        // Commit in unit order.
+        view.each([](entt::entity entity, GroundMoveType& unitId){
+            CUnit* unit = unitHandler.GetUnit(unitId.value);
+
+            auto& event = Sim::registry.get<UnitMovedEvent>(entity);
+            const bool moved = event.moved;
+
+            event.unit = nullptr;
+            event.moved = false;
+
+            if (moved)
                 eventHandler.UnitMoved(unit);
 
             #ifndef NDEBUG
@@ -39,6 +39,15 @@ public:
 
 	virtual void RemoveCacheFiles() {}
 	virtual void Update() {}
+
+	/**
+	 * Called at the end of a sim-frame, when no more synced state will change
+	 * until the next one. Path searches queued so far may then be executed in
+	 * the background; their results are published by SyncQueuedSearches, which
+	 * must be called before synced state is modified again.
+	 */
+	virtual void StartQueuedSearches() {}
+	virtual void SyncQueuedSearches() {}
 	virtual void UpdatePath(const CSolidObject* owner, unsigned int pathID) {}
 
 	/**
@@ -30,6 +30,7 @@ namespace QTPFS {
 
 	struct INode {
 			friend SearchNode;
+			friend NodeLayer;
 	public:
 		struct NeighbourPoints {
 			int nodeId;
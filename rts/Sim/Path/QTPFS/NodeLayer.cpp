@@ -2,7 +2,10 @@
 
 // #undef NDEBUG
 
+#include <cstring>
+#include <iterator>
 #include <limits>
+#include <type_traits>
 
 #if defined(_MSC_VER)
 #include <intrin.h>
@@ -58,6 +61,9 @@ void QTPFS::NodeLayer::Init(unsigned int layerNum) {
 
 	// pre-count the root
 	numLeafNodes = 1;
+	numOpenNodes = 0;
+	numClosedNodes = 0;
+	maxNodesAlloced = 0;
 	layerNumber = layerNum;
 
 	xsize = mapDims.mapx;
@@ -420,3 +426,131 @@ QTPFS::INode* QTPFS::NodeLayer::GetNodeThatEncasesPowerOfTwoArea(const SRectangl
 	assert(selectedNode != nullptr);
 	return selectedNode;
 }
+
+
+namespace {
+	template<typename T> void WriteBuffer(std::vector<std::uint8_t>& buffer, const T* data, size_t count) {
+		static_assert(std::is_trivially_copyable_v<T>);
+
+		const size_t pos = buffer.size();
+		buffer.resize(pos + sizeof(T) * count);
+		std::memcpy(buffer.data() + pos, data, sizeof(T) * count);
+	}
+
+	template<typename T> bool ReadBuffer(const std::vector<std::uint8_t>& buffer, size_t& pos, T* data, size_t count) {
+		static_assert(std::is_trivially_copyable_v<T>);
+
+		if (count > ((buffer.size() - pos) / sizeof(T)))
+			return false;
+
+		std::memcpy(data, buffer.data() + pos, sizeof(T) * count);
+		pos += sizeof(T) * count;
+		return true;
+	}
+}
+
+void QTPFS::NodeLayer::Serialize(std::vector<std::uint8_t>& buffer) const {
+	RECOIL_DETAILED_TRACY_ZONE;
+	const std::uint32_t counters[] = {
+		layerNumber, numLeafNodes, updateCounter, numOpenNodes, numClosedNodes,
+		std::uint32_t(maxNodesAlloced), std::uint32_t(numRootNodes), std::uint32_t(xRootNodes), std::uint32_t(zRootNodes), std::uint32_t(rootNodeSize), rootMask,
+		xsize, zsize,
+		std::uint32_t(nodeIndcs.size()),
+	};
+
+	WriteBuffer(buffer, &counters[0], std::size(counters));
+	WriteBuffer(buffer, nodeIndcs.data(), nodeIndcs.size());
+	WriteBuffer(buffer, curSpeedMods.data(), curSpeedMods.size());
+	WriteBuffer(buffer, curSpeedBins.data(), curSpeedBins.size());
+
+	// slots past maxNodesAlloced have never been handed out, so are not needed
+	for (int32_t i = 0; i < maxNodesAlloced; ++i) {
+		const QTNode* node = GetPoolNode(i);
+		const std::uint32_t numNeighbours = node->neighbours.size();
+
+		WriteBuffer(buffer, &node->nodeNumber, 1);
+		WriteBuffer(buffer, &node->index, 1);
+		WriteBuffer(buffer, node->points.data(), node->points.size());
+		WriteBuffer(buffer, &node->moveCostAvg, 1);
+		WriteBuffer(buffer, &node->childBaseIndex, 1);
+		WriteBuffer(buffer, &numNeighbours, 1);
+		WriteBuffer(buffer, node->neighbours.data(), numNeighbours);
+	}
+}
+
+bool QTPFS::NodeLayer::Deserialize(const std::vector<std::uint8_t>& buffer) {
+	RECOIL_DETAILED_TRACY_ZONE;
+	std::uint32_t counters[14];
+	size_t pos = 0;
+
+	if (!ReadBuffer(buffer, pos, &counters[0], std::size(counters)))
+		return false;
+
+	const std::uint32_t numNodes = counters[5];
+	const std::uint32_t numSquares = counters[11] * counters[12];
+	const std::uint32_t numFreeIndcs = counters[13];
+
+	// the layer must have been created for this map and layer
+	if (counters[0] != layerNumber || counters[11] != unsigned(mapDims.mapx) || counters[12] != unsigned(mapDims.mapy))
+		return false;
+	if (numNodes > POOL_TOTAL_SIZE || numFreeIndcs > POOL_TOTAL_SIZE)
+		return false;
+
+	nodeIndcs.resize(numFreeIndcs);
+	curSpeedMods.resize(numSquares);
+	curSpeedBins.resize(numSquares);
+
+	if (!ReadBuffer(buffer, pos, nodeIndcs.data(), nodeIndcs.size()))
+		return false;
+	if (!ReadBuffer(buffer, pos, curSpeedMods.data(), curSpeedMods.size()))
+		return false;
+	if (!ReadBuffer(buffer, pos, curSpeedBins.data(), curSpeedBins.size()))
+		return false;
+
+	for (std::uint32_t i = 0; i < numNodes; ++i) {
+		if (poolNodes[i / POOL_CHUNK_SIZE].empty())
+			poolNodes[i / POOL_CHUNK_SIZE].resize(POOL_CHUNK_SIZE);
+
+		QTNode* node = GetPoolNode(i);
+		std::uint32_t numNeighbours = 0;
+
+		if (!ReadBuffer(buffer, pos, &node->nodeNumber, 1))
+			return false;
+		if (!ReadBuffer(buffer, pos, &node->index, 1))
+			return false;
+		if (!ReadBuffer(buffer, pos, node->points.data(), node->points.size()))
+			return false;
+		if (!ReadBuffer(buffer, pos, &node->moveCostAvg, 1))
+			return false;
+		if (!ReadBuffer(buffer, pos, &node->childBaseIndex, 1))
+			return false;
+		if (!ReadBuffer(buffer, pos, &numNeighbours, 1))
+			return false;
+		if (numNeighbours > ((buffer.size() - pos) / sizeof(QTNode::NeighbourPoints)))
+			return false;
+
+		node->neighbours.resize(numNeighbours);
+
+		if (!ReadBuffer(buffer, pos, node->neighbours.data(), numNeighbours))
+			return false;
+	}
+
+	if (pos != buffer.size())
+		return false;
+
+	// only commit the counters once everything else was read
+	layerNumber     = counters[ 0];
+	numLeafNodes    = counters[ 1];
+	updateCounter   = counters[ 2];
+	numOpenNodes    = counters[ 3];
+	numClosedNodes  = counters[ 4];
+	maxNodesAlloced = counters[ 5];
+	numRootNodes    = counters[ 6];
+	xRootNodes      = counters[ 7];
+	zRootNodes      = counters[ 8];
+	rootNodeSize    = counters[ 9];
+	rootMask        = counters[10];
+	xsize           = counters[11];
+	zsize           = counters[12];
+	return true;
+}
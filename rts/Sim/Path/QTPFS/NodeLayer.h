@@ -44,6 +44,11 @@ namespace QTPFS {
 
 		bool Update(UpdateThreadData& threadData);
 
+		// (de)serialize the tesselated node tree, its free-list and speed-mod
+		// grids into a flat buffer; used by the on-disk node-layer cache
+		void Serialize(std::vector<std::uint8_t>& buffer) const;
+		bool Deserialize(const std::vector<std::uint8_t>& buffer);
+
 		void ExecNodeNeighborCacheUpdates(const SRectangle& ur, UpdateThreadData& threadData);
 		float GetNodeRatio() const { return (numLeafNodes / std::max(1.0f, float(xsize * zsize))); }
 
@@ -7,8 +7,13 @@
 #include <algorithm>
 #include <chrono>
 #include <cinttypes>
+#include <cstring>
 #include <deque>
 #include <functional>
+#include <memory>
+
+#include "zlib.h"
+#include "minizip/zip.h"
 
 #include "System/Threading/ThreadPool.h"
 #include "System/Threading/SpringThreading.h"
@@ -19,21 +24,29 @@
 #include "Utils/PathSpeedModInfoSystemUtils.h"
 
 #include "Game/GameSetup.h"
+#include "Game/GameVersion.h"
 #include "Game/LoadScreen.h"
 #include "Map/MapInfo.h"
+#include "Map/ReadMap.h"
 
 #include "Sim/Misc/GlobalSynced.h"
+#include "Sim/Misc/GroundBlockingObjectMap.h"
 #include "Sim/Misc/ModInfo.h"
 #include "Sim/Misc/TeamHandler.h"
 #include "Sim/MoveTypes/MoveDefHandler.h"
 #include "Sim/MoveTypes/MoveMath/MoveMath.h"
 #include "Sim/Objects/SolidObject.h"
 #include "System/Config/ConfigHandler.h"
+#include "System/FileSystem/Archives/IArchive.h"
+#include "System/FileSystem/ArchiveLoader.h"
 #include "System/FileSystem/ArchiveScanner.h"
+#include "System/FileSystem/DataDirsAccess.h"
+#include "System/FileSystem/FileQueryFlags.h"
 #include "System/FileSystem/FileSystem.h"
 #include "System/Log/ILog.h"
 #include "System/Platform/Threading.h"
 #include "System/Rectangle.h"
+#include "System/SpringHash.h"
 #include "System/TimeProfiler.h"
 #include "System/StringUtil.h"
 
@@ -57,6 +70,8 @@
 #define MAP_RECTANGLE SRectangle(0, 0,  mapDims.mapx, mapDims.mapy)
 
 CONFIG(int, PathingThreadCount).defaultValue(0).safemodeValue(1).minimumValue(0);
+CONFIG(bool, QTPFSAsyncPathSearches).defaultValue(true).safemodeValue(false).description("Execute queued QTPFS path searches on worker threads between sim-frames instead of inside the next frame. Results are the same either way.");
+CONFIG(bool, QTPFSNodeLayerCache).defaultValue(true).safemodeValue(false).description("Store tesselated QTPFS node layers in the cache directory and reuse them when map, movedefs and engine version match.");
 
 namespace QTPFS {
 	struct PMLoadScreen {
@@ -121,6 +136,14 @@ namespace QTPFS {
 
 	static PMLoadScreen pmLoadScreen;
 
+	static const std::string GetNodeLayerCacheDir() {
+		return (FileSystem::GetCacheDir() + FileSystemAbstraction::GetNativePathSeparator() + "paths" + FileSystemAbstraction::GetNativePathSeparator());
+	}
+
+	static const std::string GetNodeLayerCacheFileName(std::uint32_t cacheHash) {
+		return (GetNodeLayerCacheDir() + mapInfo->map.name + ".qtpfs-" + IntToString(cacheHash, "%x") + ".zip");
+	}
+
 	static size_t GetNumThreads() {
 		const size_t numThreads = std::max(0, configHandler->GetInt("PathingThreadCount"));
 		const size_t numCores = Threading::GetLogicalCpuCores();
@@ -148,6 +171,10 @@ QTPFS::PathManager::PathManager() {
 
 QTPFS::PathManager::~PathManager() {
 	RECOIL_DETAILED_TRACY_ZONE;
+	WaitForQueuedSearches();
+	asyncSearchTasks.clear();
+	queuedSearches.clear();
+
 	isFinalized = false;
 
 	PathSpeedModInfoSystem::Shutdown();
@@ -261,6 +288,7 @@ void QTPFS::PathManager::Load() {
 	// NOTE: offset *must* start at a non-zero value
 	searchStateOffset = NODE_STATE_OFFSET;
 	numPathRequests   = 0;
+	asyncSearches     = configHandler->GetBool("QTPFSAsyncPathSearches");
 	int maxAllocedNodes   = 0;
 
 	deadPathsToUpdatePerFrame = 1;
@@ -322,7 +350,13 @@ void QTPFS::PathManager::Load() {
 		sha512::dump_digest(mapCheckSum, mapCheckSumHex);
 		sha512::dump_digest(modCheckSum, modCheckSumHex);
 
-		InitNodeLayersThreaded(MAP_RECTANGLE);
+		const std::uint32_t cacheHash = CalcNodeLayerCacheHash();
+
+		if (!ReadNodeLayerCache(cacheHash)) {
+			InitNodeLayersThreaded(MAP_RECTANGLE);
+			WriteNodeLayerCache(cacheHash);
+		}
+
 		PathSpeedModInfoSystem::Init();
 		RemoveDeadPathsSystem::Init();
 		RequeuePathsSystem::Init();
@@ -557,6 +591,145 @@ void QTPFS::PathManager::InitNodeLayer(unsigned int layerNum, const SRectangle&
 	assert((numRootCount/zRootNodes)*zRootNodes == numRootCount);
 }
 
+std::uint32_t QTPFS::PathManager::CalcNodeLayerCacheHash() const {
+	RECOIL_DETAILED_TRACY_ZONE;
+	const std::string& syncVersion = SpringVersion::GetSync();
+
+	const unsigned int hmChecksum = readMap->CalcHeightmapChecksum();
+	const unsigned int tmChecksum = readMap->CalcTypemapChecksum();
+	const unsigned int mdChecksum = moveDefHandler.GetCheckSum();
+	const unsigned int bmChecksum = groundBlockingObjectMap.CalcChecksum();
+	const unsigned int evChecksum = spring::LiteHash(syncVersion.data(), syncVersion.size(), 0);
+	const unsigned int qcChecksum = spring::LiteHash(mapInfo->pfs.qtpfs_constants, rootSize);
+	const unsigned int nlHashCode = (hmChecksum + tmChecksum + mdChecksum + bmChecksum + evChecksum + qcChecksum + QTPFS_NODELAYER_CACHE_VERSION);
+
+	LOG("[QTPFS::%s] QTPFS_NODELAYER_CACHE_VERSION=%u", __func__, QTPFS_NODELAYER_CACHE_VERSION);
+	LOG("[QTPFS::%s] heightMapChecksum=%x", __func__, hmChecksum);
+	LOG("[QTPFS::%s] typeMapChecksum=%x", __func__, tmChecksum);
+	LOG("[QTPFS::%s] moveDefChecksum=%x", __func__, mdChecksum);
+	LOG("[QTPFS::%s] blockMapChecksum=%x", __func__, bmChecksum);
+	LOG("[QTPFS::%s] engineVersionChecksum=%x", __func__, evChecksum);
+	LOG("[QTPFS::%s] constantsChecksum=%x", __func__, qcChecksum);
+	LOG("[QTPFS::%s] nodeLayerHashCode=%x", __func__, nlHashCode);
+
+	return nlHashCode;
+}
+
+/**
+ * Try to restore all node-layers from a previously written cache-file,
+ * return false (and leave the layers to be tesselated) on any mismatch
+ */
+bool QTPFS::PathManager::ReadNodeLayerCache(std::uint32_t cacheHash) {
+	RECOIL_DETAILED_TRACY_ZONE;
+	if (!configHandler->GetBool("QTPFSNodeLayerCache"))
+		return false;
+
+	const std::string cacheFileName = GetNodeLayerCacheFileName(cacheHash);
+
+	LOG("[QTPFS::%s] hash=%x file=\"%s\" (exists=%d)", __func__, cacheHash, cacheFileName.c_str(), FileSystem::FileExists(cacheFileName));
+
+	if (!FileSystem::FileExists(cacheFileName))
+		return false;
+
+	std::unique_ptr<IArchive> upfile(archiveLoader.OpenArchive(dataDirsAccess.LocateFile(cacheFileName), "sdz"));
+
+	const auto RemoveCacheFile = [&]() {
+		upfile.reset();
+		FileSystem::Remove(cacheFileName);
+		return false;
+	};
+
+	if (upfile == nullptr || !upfile->IsOpen())
+		return (RemoveCacheFile());
+
+	pmLoadScreen.AddMessage("[PathManager::" + std::string(__func__) + "] reading node-layer cache");
+
+	std::vector<std::uint8_t> buffer;
+	std::uint32_t header[5] = {0};
+
+	{
+		const unsigned int fid = upfile->FindFile("header");
+
+		if (fid >= upfile->NumFiles() || !upfile->GetFile(fid, buffer) || buffer.size() != sizeof(header))
+			return (RemoveCacheFile());
+
+		std::memcpy(&header[0], buffer.data(), sizeof(header));
+
+		if (header[0] != QTPFS_NODELAYER_CACHE_VERSION || header[1] != cacheHash || header[2] != nodeLayers.size() || header[3] != unsigned(rootSize))
+			return (RemoveCacheFile());
+	}
+
+	for (unsigned int layerNum = 0; layerNum < nodeLayers.size(); layerNum++) {
+		const unsigned int fid = upfile->FindFile("layer" + IntToString(layerNum));
+
+		if (fid >= upfile->NumFiles() || !upfile->GetFile(fid, buffer))
+			return (RemoveCacheFile());
+
+		nodeLayers[layerNum].Init(layerNum);
+
+		if (!nodeLayers[layerNum].Deserialize(buffer))
+			return (RemoveCacheFile());
+	}
+
+	// normally set by InitNodeLayer
+	QTNode::MAX_DEPTH = header[4];
+	return true;
+}
+
+/**
+ * Write all freshly tesselated node-layers to a cache-file, one zip entry per layer
+ */
+bool QTPFS::PathManager::WriteNodeLayerCache(std::uint32_t cacheHash) const {
+	RECOIL_DETAILED_TRACY_ZONE;
+	if (!configHandler->GetBool("QTPFSNodeLayerCache"))
+		return false;
+
+	// we need this directory to exist
+	if (!FileSystem::CreateDirectory(GetNodeLayerCacheDir()))
+		return false;
+
+	const std::string cacheFileName = GetNodeLayerCacheFileName(cacheHash);
+
+	LOG("[QTPFS::%s] hash=%x file=\"%s\" (exists=%d)", __func__, cacheHash, cacheFileName.c_str(), FileSystem::FileExists(cacheFileName));
+
+	zipFile file = zipOpen(dataDirsAccess.LocateFile(cacheFileName, FileQueryFlags::WRITE).c_str(), APPEND_STATUS_CREATE);
+
+	if (file == nullptr)
+		return false;
+
+	pmLoadScreen.AddMessage("[PathManager::" + std::string(__func__) + "] writing node-layer cache");
+
+	const std::uint32_t header[5] = {QTPFS_NODELAYER_CACHE_VERSION, cacheHash, std::uint32_t(nodeLayers.size()), std::uint32_t(rootSize), QTNode::MAX_DEPTH};
+
+	zipOpenNewFileInZip(file, "header", nullptr, nullptr, 0, nullptr, 0, nullptr, Z_DEFLATED, Z_BEST_SPEED);
+	zipWriteInFileInZip(file, &header[0], sizeof(header));
+	zipCloseFileInZip(file);
+
+	std::vector<std::uint8_t> buffer;
+
+	// layers can be hundreds of MB in total, favour speed over size
+	for (unsigned int layerNum = 0; layerNum < nodeLayers.size(); layerNum++) {
+		buffer.clear();
+		nodeLayers[layerNum].Serialize(buffer);
+
+		zipOpenNewFileInZip(file, ("layer" + IntToString(layerNum)).c_str(), nullptr, nullptr, 0, nullptr, 0, nullptr, Z_DEFLATED, Z_BEST_SPEED);
+		zipWriteInFileInZip(file, buffer.data(), buffer.size());
+		zipCloseFileInZip(file);
+	}
+
+	zipClose(file, nullptr);
+
+	std::unique_ptr<IArchive> upfile(archiveLoader.OpenArchive(dataDirsAccess.LocateFile(cacheFileName), "sdz"));
+
+	if (upfile == nullptr || !upfile->IsOpen()) {
+		upfile.reset();
+		FileSystem::Remove(cacheFileName);
+		return false;
+	}
+
+	return true;
+}
+
 
 
 // __FORCE_ALIGN_STACK__
@@ -564,8 +737,6 @@ void QTPFS::PathManager::InitNodeLayer(unsigned int layerNum, const SRectangle&
 // called in the non-staggered (#ifndef QTPFS_STAGGERED_LAYER_UPDATES)
 // layer update scheme and during initialization; see ::TerrainChange
 void QTPFS::PathManager::UpdateNodeLayer(unsigned int layerNum, const SRectangle& rect, int currentThread) {
-	const MoveDef* md = moveDefHandler.GetMoveDefByPathType(layerNum);
-
 	if (!IsFinalized())
 		return;
 
@@ -574,27 +745,51 @@ void QTPFS::PathManager::UpdateNodeLayer(unsigned int layerNum, const SRectangle
 
 	SRectangle r(rect);
 	if (rect.x1 == 0 && rect.x2 == 0) {
-		auto& nlMapDmgTracker = nodeLayersMapDamageTrack.mapChangeTrackers[layerNum];
-
 		// No more damaged areas. Finish up.
-		if (nlMapDmgTracker.damageQueue.size() == 0) { return; }
-
-		const int sectorId = nodeLayersMapDamageTrack.mapChangeTrackers[layerNum].damageQueue.front();
-		const int blockIdxX = (sectorId % nodeLayersMapDamageTrack.width) * nodeLayersMapDamageTrack.cellSize;
-		const int blockIdxY = (sectorId / nodeLayersMapDamageTrack.width) * nodeLayersMapDamageTrack.cellSize;
-
-		assert(sectorId < nlMapDmgTracker.damageMap.size());
-		nlMapDmgTracker.damageMap[sectorId] = false;
-		nlMapDmgTracker.damageQueue.pop_front();
-
-		r = SRectangle
-			( blockIdxX
-			, blockIdxY
-			, blockIdxX + DAMAGE_MAP_BLOCK_SIZE
-			, blockIdxY + DAMAGE_MAP_BLOCK_SIZE
-			);
+		if (!PopDamagedArea(layerNum, r)) { return; }
 	}
 
+	if (UpdateNodeLayerSpeedMods(layerNum, r, currentThread))
+		TesselateNodeLayer(layerNum, r, currentThread);
+}
+
+bool QTPFS::PathManager::PopDamagedArea(unsigned int layerNum, SRectangle& r) {
+	auto& nlMapDmgTracker = nodeLayersMapDamageTrack.mapChangeTrackers[layerNum];
+
+	if (nlMapDmgTracker.damageQueue.size() == 0)
+		return false;
+
+	const int sectorId = nlMapDmgTracker.damageQueue.front();
+	const int blockIdxX = (sectorId % nodeLayersMapDamageTrack.width) * nodeLayersMapDamageTrack.cellSize;
+	const int blockIdxY = (sectorId / nodeLayersMapDamageTrack.width) * nodeLayersMapDamageTrack.cellSize;
+
+	assert(sectorId < nlMapDmgTracker.damageMap.size());
+	nlMapDmgTracker.damageMap[sectorId] = false;
+	nlMapDmgTracker.damageQueue.pop_front();
+
+	r = SRectangle
+		( blockIdxX
+		, blockIdxY
+		, blockIdxX + DAMAGE_MAP_BLOCK_SIZE
+		, blockIdxY + DAMAGE_MAP_BLOCK_SIZE
+		);
+
+	return true;
+}
+
+// only writes the layer's speed-mods and speed-bins inside <r>, so different
+// areas (of the same or different layers) can be updated concurrently
+bool QTPFS::PathManager::UpdateNodeLayerSpeedMods(unsigned int layerNum, const SRectangle& r, int currentThread) {
+	const MoveDef* md = moveDefHandler.GetMoveDefByPathType(layerNum);
+	const INode* containingNode = nodeLayers[layerNum].GetNodeThatEncasesPowerOfTwoArea(r);
+
+	updateThreadData[currentThread].InitUpdate(r, *containingNode, *md, currentThread);
+	return nodeLayers[layerNum].Update(updateThreadData[currentThread]);
+}
+
+void QTPFS::PathManager::TesselateNodeLayer(unsigned int layerNum, const SRectangle& r, int currentThread) {
+	const MoveDef* md = moveDefHandler.GetMoveDefByPathType(layerNum);
+
 	INode* containingNode = nodeLayers[layerNum].GetNodeThatEncasesPowerOfTwoArea(r);
 	SRectangle re(containingNode->xmin(), containingNode->zmin(), containingNode->xmax(), containingNode->zmax());
 
@@ -614,13 +809,9 @@ void QTPFS::PathManager::UpdateNodeLayer(unsigned int layerNum, const SRectangle
 	// 		}}}
 
 	updateThreadData[currentThread].InitUpdate(r, *containingNode, *md, currentThread);
-	const bool needTesselation = nodeLayers[layerNum].Update(updateThreadData[currentThread]);
 
 	// process the affected root nodes.
-
-	// LOG("%s: [%d] needTesselation=%d, wantTesselation=%d", __func__, layerNum, (int)needTesselation, (int)wantTesselation);
-
-	if (needTesselation) {
+	{
 		SRectangle ur(re.x1, re.z1, re.x2, re.z2);
 		auto& nodeLayer = nodeLayers[layerNum];
 
@@ -645,6 +836,8 @@ void QTPFS::PathManager::UpdateNodeLayer(unsigned int layerNum, const SRectangle
 // height-map changes, then blocking-map does
 void QTPFS::PathManager::TerrainChange(unsigned int x1, unsigned int z1,  unsigned int x2, unsigned int z2, unsigned int type) {
 	RECOIL_DETAILED_TRACY_ZONE;
+	SyncQueuedSearches();
+
 	if (!IsFinalized())
 		return;
 
@@ -683,13 +876,10 @@ void QTPFS::PathManager::MapChanged(int x1, int y1, int x2, int y2) {
 
 void QTPFS::PathManager::Update() {
 	SCOPED_TIMER("Sim::Path");
+	SyncQueuedSearches();
 	{
 		systemUtils.NotifyUpdate();
 	}
-	{
-		SCOPED_TIMER("Sim::Path::Requests");
-		ThreadUpdate();
-	}
 	{
 		SCOPED_TIMER("Sim::Path::MapUpdates");
 
@@ -712,12 +902,42 @@ void QTPFS::PathManager::Update() {
 			return blocksToUpdate;
 		};
 
-		SRectangle rect(0,0,0,0);
-		for_mt(0, nodeLayers.size(), [this, &rect, &numBlocksToUpdate](const int index) {
-			int curThread = ThreadPool::GetThreadNum();
-			int layerNum = nodeLayerUpdatePriorityOrder[index];
-			int blocksToUpdate = numBlocksToUpdate(layerNum);
-			for (int i = 0; i < blocksToUpdate; ++i) { UpdateNodeLayer(layerNum, rect, curThread); }
+		// collect this frame's damaged areas, grouped by layer in priority order
+		nodeLayerUpdates.clear();
+		nodeLayerUpdateOffsets.clear();
+		nodeLayerUpdateOffsets.push_back(0);
+
+		for (size_t index = 0; index < nodeLayers.size(); ++index) {
+			const int layerNum = nodeLayerUpdatePriorityOrder[index];
+			const int blocksToUpdate = numBlocksToUpdate(layerNum);
+
+			SRectangle area(0, 0, 0, 0);
+			for (int i = 0; i < blocksToUpdate && PopDamagedArea(layerNum, area); ++i) {
+				nodeLayerUpdates.push_back({area, static_cast<unsigned int>(layerNum), false});
+			}
+
+			nodeLayerUpdateOffsets.push_back(nodeLayerUpdates.size());
+		}
+
+		// recomputing speed-mods is the bulk of the work and independent per
+		// (layer, area) pair, so these are spread over all workers; with few
+		// movedefs a per-layer split leaves most of them idle
+		for_mt(0, nodeLayerUpdates.size(), [this](const int i) {
+			NodeLayerUpdate& update = nodeLayerUpdates[i];
+			update.needTesselation = UpdateNodeLayerSpeedMods(update.layerNum, update.area, ThreadPool::GetThreadNum());
+		});
+
+		// tesselation restructures the layer's tree, so each layer's areas are
+		// still processed in order by a single thread
+		for_mt(0, nodeLayers.size(), [this](const int index) {
+			const int curThread = ThreadPool::GetThreadNum();
+
+			for (size_t i = nodeLayerUpdateOffsets[index]; i < nodeLayerUpdateOffsets[index + 1]; ++i) {
+				const NodeLayerUpdate& update = nodeLayerUpdates[i];
+
+				if (update.needTesselation)
+					TesselateNodeLayer(update.layerNum, update.area, curThread);
+			}
 		});
 
 		// Mark all dirty paths so that they can be recalculated
@@ -785,10 +1005,93 @@ void QTPFS::PathManager::Update() {
 	}
 }
 
-__FORCE_ALIGN_STACK__
-void QTPFS::PathManager::ThreadUpdate() {
+// NOTE:
+//   this runs at the end of the sim-frame (after GameFramePost), not in
+//   Update as the searches used to; they see this frame's node-layer updates
+//   and everything changed after unitHandler.Update, which alters results
+//   compared to older engines (but not between clients or settings)
+void QTPFS::PathManager::StartQueuedSearches() {
+	SCOPED_TIMER("Sim::Path::Requests");
+	SyncQueuedSearches();
+
+	if (!IsFinalized())
+		return;
+
 	QueueDeadPathSearches();
-	ExecuteQueuedSearches();
+	ReadyQueuedSearches();
+
+	// execute pending searches collected via
+	// RequestPath and QueueDeadPathSearches
+	auto pathView = registry.group<PathSearch, ProcessPath>();
+	queuedSearches.assign(pathView.begin(), pathView.end());
+
+	if (queuedSearches.empty())
+		return;
+
+	// nothing touches synced state until the next SyncQueuedSearches call, so
+	// the searches see the same world whether they run now or in the background
+	if (!asyncSearches || ThreadPool::GetNumThreads() <= 1) {
+		for_mt(0, queuedSearches.size(), [this](int i) {
+			ExecuteQueuedSearch(queuedSearches[i]);
+		});
+
+		SyncQueuedSearches();
+		return;
+	}
+
+	// the main thread does not take part, each worker pulls searches until none are left
+	const size_t numTasks = std::min(queuedSearches.size(), size_t(ThreadPool::GetNumThreads() - 1));
+
+	nextAsyncSearch.store(0);
+	asyncSearchTasks.reserve(numTasks);
+
+	for (size_t i = 0; i < numTasks; ++i) {
+		asyncSearchTasks.emplace_back(ThreadPool::Enqueue([this]() { ExecuteAsyncSearches(); }));
+	}
+}
+
+void QTPFS::PathManager::SyncQueuedSearches() {
+	if (queuedSearches.empty())
+		return;
+
+	ZoneScoped;
+	assert(!ThreadPool::inMultiThreadedSection);
+
+	WaitForQueuedSearches();
+
+	// rethrow anything a worker may have thrown
+	for (auto& task: asyncSearchTasks) {
+		task->get();
+	}
+
+	asyncSearchTasks.clear();
+
+	PublishQueuedSearches();
+	queuedSearches.clear();
+}
+
+void QTPFS::PathManager::WaitForQueuedSearches() const {
+	for (const auto& task: asyncSearchTasks) {
+		task->wait();
+	}
+}
+
+__FORCE_ALIGN_STACK__
+void QTPFS::PathManager::ExecuteAsyncSearches() {
+	ZoneScoped;
+	for (size_t i = nextAsyncSearch.fetch_add(1); i < queuedSearches.size(); i = nextAsyncSearch.fetch_add(1)) {
+		ExecuteQueuedSearch(queuedSearches[i]);
+	}
+}
+
+void QTPFS::PathManager::ExecuteQueuedSearch(entt::entity pathSearchEntity) {
+	assert(registry.valid(pathSearchEntity));
+	assert(registry.all_of<PathSearch>(pathSearchEntity));
+
+	PathSearch* search = &registry.get<PathSearch>(pathSearchEntity);
+	int pathType = search->GetPathType();
+	NodeLayer& nodeLayer = nodeLayers[pathType];
+	ExecuteSearch(search, nodeLayer, pathType);
 }
 
 
@@ -875,28 +1178,9 @@ void QTPFS::PathManager::ReadyQueuedSearches() {
 	}
 }
 
-void QTPFS::PathManager::ExecuteQueuedSearches() {
+void QTPFS::PathManager::PublishQueuedSearches() {
 	ZoneScoped;
 
-	ReadyQueuedSearches();
-
-	auto pathView = registry.group<PathSearch, ProcessPath>();
-
-	// execute pending searches collected via
-	// RequestPath and QueueDeadPathSearches
-	for_mt(0, pathView.size(), [this, &pathView](int i){
-		entt::entity pathSearchEntity = pathView.begin()[i];
-        // entt::entity pathSearchEntity = pathView.storage<PathSearch>()[i];
-
-		assert(registry.valid(pathSearchEntity));
-		assert(registry.all_of<PathSearch>(pathSearchEntity));
-
-		PathSearch* search = &pathView.get<PathSearch>(pathSearchEntity);
-		int pathType = search->GetPathType();
-		NodeLayer& nodeLayer = nodeLayers[pathType];
-		ExecuteSearch(search, nodeLayer, pathType);
-	});
-
 	auto completePath = [this](entt::entity pathEntity, IPath* path){
 		// inform the movement system that the path has been changed.
 		if (registry.all_of<PathUpdatedCounterIncrease>(pathEntity)) {
@@ -916,11 +1200,11 @@ void QTPFS::PathManager::ExecuteQueuedSearches() {
 	};
 
 	// TODO: make a function?
-	for (auto pathSearchEntity : pathView) {
+	for (auto pathSearchEntity : queuedSearches) {
 		assert(registry.valid(pathSearchEntity));
 		assert(registry.all_of<PathSearch>(pathSearchEntity));
 
-		PathSearch* search = &pathView.get<PathSearch>(pathSearchEntity);
+		PathSearch* search = &registry.get<PathSearch>(pathSearchEntity);
 		entt::entity pathEntity = (entt::entity)search->GetID();
 		if (registry.valid(pathEntity)) {
 			IPath* path = registry.try_get<IPath>(pathEntity);
@@ -933,8 +1217,8 @@ void QTPFS::PathManager::ExecuteQueuedSearches() {
 						registry.remove<PathSearchRef>(pathEntity);
 						registry.remove<PathIsDirty>(pathEntity);
 
-						// adding a new search doesn't break this loop because new paths do not
-						// have the tag ProcessPath and so don't impact this group view.
+						// adding a new search doesn't break this loop because it only walks
+						// the searches that were started together.
 						RequeueSearch(path, false, true, search->tryPathRepair);
 						// LOG("%s: %x - raw path check failed", __func__, entt::to_integral(pathEntity));
 					} else if (search->pathRequestWaiting) {
@@ -1333,6 +1617,7 @@ void QTPFS::PathManager::UpdatePath(const CSolidObject* owner, unsigned int path
 void QTPFS::PathManager::DeletePath(unsigned int pathID, bool force) {
 	RECOIL_DETAILED_TRACY_ZONE;
 	assert(!ThreadPool::inMultiThreadedSection);
+	SyncQueuedSearches();
 
 	entt::entity pathEntity = entt::entity(pathID);
 
@@ -1437,6 +1722,8 @@ unsigned int QTPFS::PathManager::RequestPath(
 	bool synced
 ) {
 	RECOIL_DETAILED_TRACY_ZONE;
+	SyncQueuedSearches();
+
 	unsigned int returnPathId = 0;
 
 	if (!IsFinalized())
@@ -1492,6 +1779,8 @@ unsigned int QTPFS::PathManager::ExecuteUnsyncedSearch(unsigned int pathId){
 
 bool QTPFS::PathManager::PathUpdated(unsigned int pathID) {
 	RECOIL_DETAILED_TRACY_ZONE;
+	SyncQueuedSearches();
+
 	entt::entity pathEntity = (entt::entity)pathID;
 	if (!registry.valid(pathEntity)) { return false; }
 	IPath* livePath = registry.try_get<IPath>(pathEntity);
@@ -1504,6 +1793,8 @@ bool QTPFS::PathManager::PathUpdated(unsigned int pathID) {
 
 void QTPFS::PathManager::ClearPathUpdated(unsigned int pathID) {
 	RECOIL_DETAILED_TRACY_ZONE;
+	SyncQueuedSearches();
+
 	entt::entity pathEntity = (entt::entity)pathID;
 	if (!registry.valid(pathEntity)) { return; }
 	IPath* livePath = registry.try_get<IPath>(pathEntity);
@@ -1524,6 +1815,8 @@ float3 QTPFS::PathManager::NextWayPoint(
 	bool synced
 ) {
 	ZoneScoped;
+	SyncQueuedSearches();
+
 	const float3 noPathPoint = -XZVector;
 
 	if (!IsFinalized())
@@ -1612,6 +1905,8 @@ float3 QTPFS::PathManager::NextWayPoint(
 
 bool QTPFS::PathManager::CurrentWaypointIsUnreachable(unsigned int pathID) {
 	RECOIL_DETAILED_TRACY_ZONE;
+	SyncQueuedSearches();
+
 	entt::entity pathEntity = entt::entity(pathID);
 	if (!registry.valid(pathEntity))
 		return true;
@@ -1630,6 +1925,8 @@ bool QTPFS::PathManager::CurrentWaypointIsUnreachable(unsigned int pathID) {
 
 bool QTPFS::PathManager::NextWayPointIsUnreachable(unsigned int pathID) {
 	RECOIL_DETAILED_TRACY_ZONE;
+	SyncQueuedSearches();
+
 	entt::entity pathEntity = entt::entity(pathID);
 	if (!registry.valid(pathEntity))
 		return true;
@@ -1651,6 +1948,10 @@ void QTPFS::PathManager::GetPathWayPoints(
 	std::vector<int>& starts
 ) const {
 	RECOIL_DETAILED_TRACY_ZONE;
+	// unsynced callers may get here between frames; the path is complete
+	// once its search has finished even if it has not been published yet
+	WaitForQueuedSearches();
+
 	if (!IsFinalized())
 		return;
 
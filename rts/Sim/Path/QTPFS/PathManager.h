@@ -3,6 +3,9 @@
 #ifndef QTPFS_PATHMANAGER_HDR
 #define QTPFS_PATHMANAGER_HDR
 
+#include <atomic>
+#include <future>
+#include <memory>
 #include <vector>
 
 #include "Sim/Misc/ModInfo.h"
@@ -10,6 +13,7 @@
 #include "NodeLayer.h"
 #include "PathCache.h"
 #include "PathSearch.h"
+#include "System/Rectangle.h"
 #include "System/UnorderedMap.hpp"
 
 struct MoveDef;
@@ -52,6 +56,8 @@ namespace QTPFS {
 
 		void TerrainChange(unsigned int x1, unsigned int z1,  unsigned int x2, unsigned int z2, unsigned int type) override;
 		void Update() override;
+		void StartQueuedSearches() override;
+		void SyncQueuedSearches() override;
 		void UpdatePath(const CSolidObject* owner, unsigned int pathID) override;
 		void DeletePath(unsigned int pathID, bool force = false) override;
 		void DeletePathEntity(entt::entity pathEntity);
@@ -94,7 +100,6 @@ namespace QTPFS {
 	private:
 		void MapChanged(int x1, int z1, int x2, int z2);
 
-		void ThreadUpdate();
 		void Load();
 
 		std::uint64_t GetMemFootPrint() const;
@@ -119,7 +124,14 @@ namespace QTPFS {
 		void InitNodeLayersThreaded(const SRectangle& rect);
 		void InitNodeLayer(unsigned int layerNum, const SRectangle& r);
 		void InitRootSize(const SRectangle& r);
+
+		std::uint32_t CalcNodeLayerCacheHash() const;
+		bool ReadNodeLayerCache(std::uint32_t cacheHash);
+		bool WriteNodeLayerCache(std::uint32_t cacheHash) const;
 		void UpdateNodeLayer(unsigned int layerNum, const SRectangle& r, int currentThread);
+		bool PopDamagedArea(unsigned int layerNum, SRectangle& r);
+		bool UpdateNodeLayerSpeedMods(unsigned int layerNum, const SRectangle& r, int currentThread);
+		void TesselateNodeLayer(unsigned int layerNum, const SRectangle& r, int currentThread);
 
 		bool InitializeSearch(entt::entity searchEntity);
 		void RemovePathFromShared(entt::entity entity);
@@ -127,7 +139,10 @@ namespace QTPFS {
 		void RemovePathSearch(entt::entity pathEntity);
 
 		void ReadyQueuedSearches();
-		void ExecuteQueuedSearches();
+		void ExecuteQueuedSearch(entt::entity pathSearchEntity);
+		void ExecuteAsyncSearches();
+		void WaitForQueuedSearches() const;
+		void PublishQueuedSearches();
 		void QueueDeadPathSearches();
 
 		unsigned int QueueSearch(
@@ -179,6 +194,23 @@ namespace QTPFS {
 
 		NodeLayersChangeTrack nodeLayersMapDamageTrack;
 
+		struct NodeLayerUpdate {
+			SRectangle area;
+			unsigned int layerNum;
+			bool needTesselation;
+		};
+
+		// damaged areas handled in the current frame; the updates of the
+		// layer at priority index i are [offsets[i], offsets[i + 1])
+		std::vector<NodeLayerUpdate> nodeLayerUpdates;
+		std::vector<size_t> nodeLayerUpdateOffsets;
+
+		// searches started by StartQueuedSearches (in execution order) and the
+		// worker tasks running them; both are cleared by SyncQueuedSearches
+		std::vector<entt::entity> queuedSearches;
+		std::vector<std::shared_ptr<std::future<void>>> asyncSearchTasks;
+		std::atomic<size_t> nextAsyncSearch = {0};
+
 		int deadPathsToUpdatePerFrame = 1;
 		int recalcDeadPathUpdateRateOnFrame = 0;
 		int rootSize = 0;
@@ -198,6 +230,7 @@ namespace QTPFS {
 		entt::entity systemEntity = entt::null;
 
 		bool isFinalized = false;
+		bool asyncSearches = true;
 
 		static constexpr size_t INITIAL_PATH_RESERVE = 256;
 	};
@@ -12,6 +12,7 @@
 #include "Rendering/GroundFlash.h"
 #include "Sim/Features/Feature.h"
 #include "Sim/Features/FeatureDef.h"
+#include "Sim/Features/FeatureHandler.h"
 #include "Sim/Misc/CollisionHandler.h"
 #include "Sim/Misc/CollisionVolume.h"
 #include "Sim/Misc/GlobalSynced.h"
@@ -63,6 +64,10 @@ CR_REG_METADATA(CProjectileHandler, (
 // note: stores all ExpGenSpawnable types, not just projectiles
 ProjMemPool projMemPool;
 
+// broad phase state for CheckUnitFeatureCollisions, indexed like projectiles[synced]
+static std::vector<std::pair<float, int>> sweepProjectiles;
+static std::vector<char> collisionCandidates;
+
 CProjectileHandler projectileHandler;
 
 
@@ -419,7 +424,7 @@ static bool CheckProjectileCollisionFlags(const CProjectile* p, const CUnit* u)
 }
 
 
-void CProjectileHandler::CheckUnitCollisions(
+bool CProjectileHandler::CheckUnitCollisions(
 	CProjectile* p,
 	std::vector<CUnit*>& tempUnits,
 	const float3 ppos0,
@@ -427,7 +432,7 @@ void CProjectileHandler::CheckUnitCollisions(
 ) {
 	RECOIL_DETAILED_TRACY_ZONE;
 	if (!p->checkCol)
-		return;
+		return false;
 
 	CollisionQuery cq;
 
@@ -455,12 +460,14 @@ void CProjectileHandler::CheckUnitCollisions(
 				p->Collision(unit);
 			}
 
-			break;
+			return true;
 		}
 	}
+
+	return false;
 }
 
-void CProjectileHandler::CheckFeatureCollisions(
+bool CProjectileHandler::CheckFeatureCollisions(
 	CProjectile* p,
 	std::vector<CFeature*>& tempFeatures,
 	const float3 ppos0,
@@ -469,10 +476,10 @@ void CProjectileHandler::CheckFeatureCollisions(
 	RECOIL_DETAILED_TRACY_ZONE;
 	// already collided with unit?
 	if (!p->checkCol)
-		return;
+		return false;
 
 	if ((p->GetCollisionFlags() & Collision::NOFEATURES) != 0)
-		return;
+		return false;
 
 	CollisionQuery cq;
 
@@ -494,13 +501,15 @@ void CProjectileHandler::CheckFeatureCollisions(
 				p->Collision(feature);
 			}
 
-			break;
+			return true;
 		}
 	}
+
+	return false;
 }
 
 
-void CProjectileHandler::CheckShieldCollisions(
+bool CProjectileHandler::CheckShieldCollisions(
 	CProjectile* p,
 	std::vector<CPlasmaRepulser*>& tempRepulsers,
 	const float3 ppos0,
@@ -508,10 +517,10 @@ void CProjectileHandler::CheckShieldCollisions(
 ) {
 	RECOIL_DETAILED_TRACY_ZONE;
 	if (!p->checkCol)
-		return;
+		return false;
 	// skip unsynced and non-weapon projectiles
 	if (!p->weapon)
-		return;
+		return false;
 
 	CWeaponProjectile* wpro = static_cast<CWeaponProjectile*>(p);
 	const WeaponDef* wdef = wpro->GetWeaponDef();
@@ -521,10 +530,13 @@ void CProjectileHandler::CheckShieldCollisions(
 
 	// bail early
 	if (interceptType == 0)
-		return;
+		return false;
 
 	CollisionQuery cq;
 
+	// IncomingProjectile runs the ShieldPreDamaged callin even if not absorbed
+	bool hit = false;
+
 	for (CPlasmaRepulser* repulser: tempRepulsers) {
 		assert(repulser != nullptr);
 
@@ -549,8 +561,92 @@ void CProjectileHandler::CheckShieldCollisions(
 		if (cq.InsideHit() && repulser->IgnoreInteriorHit(wpro))
 			continue;
 
+		hit = true;
+
 		if (repulser->IncomingProjectile(wpro, cq.GetHitPos()))
-			return;
+			break;
+	}
+
+	return hit;
+}
+
+void CProjectileHandler::MarkCollisionCandidates(bool synced)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	// below this (or when there are many more objects than projectiles)
+	// querying the QuadField per projectile is cheaper than the sweep
+	constexpr size_t MIN_SWEEP_PROJECTILES = 64;
+	constexpr size_t MAX_OBJECTS_PER_PROJECTILE = 32;
+
+	const auto& projs = projectiles[synced];
+
+	const auto& activeUnits = unitHandler.GetActiveUnits();
+	const auto& activeFeatureIDs = featureHandler.GetActiveFeatureIDs();
+
+	collisionCandidates.clear();
+	collisionCandidates.resize(projs.size(), true);
+
+	if (projs.size() < MIN_SWEEP_PROJECTILES)
+		return;
+	if ((activeUnits.size() + activeFeatureIDs.size()) > (projs.size() * MAX_OBJECTS_PER_PROJECTILE))
+		return;
+
+	sweepProjectiles.clear();
+	sweepProjectiles.reserve(projs.size());
+
+	float maxQueryRadius = 0.0f;
+
+	for (size_t i = 0; i < projs.size(); ++i) {
+		const CProjectile* p = projs[i];
+
+		collisionCandidates[i] = false;
+
+		if (!p->checkCol) continue;
+		if ( p->deleteMe) continue;
+
+		sweepProjectiles.emplace_back(p->pos.x, i);
+		maxQueryRadius = std::max(maxQueryRadius, p->speed.w + p->radius);
+	}
+
+	std::sort(sweepProjectiles.begin(), sweepProjectiles.end());
+
+	// same sphere test as GetUnitsAndFeaturesColVol, so the marked set is a
+	// superset of the projectiles for which the QuadField returns anything
+	const auto MarkOverlaps = [&](const float3& pos, const float radius) {
+		// pad the x-range slightly, the exact test below decides
+		const float minX = pos.x - (radius + maxQueryRadius + 1.0f);
+		const float maxX = pos.x + (radius + maxQueryRadius + 1.0f);
+
+		const auto pred = [](const std::pair<float, int>& sp, float x) { return (sp.first < x); };
+
+		for (auto it = std::lower_bound(sweepProjectiles.begin(), sweepProjectiles.end(), minX, pred); it != sweepProjectiles.end() && it->first <= maxX; ++it) {
+			const CProjectile* p = projs[it->second];
+			const float totRad = (p->speed.w + p->radius) + radius;
+
+			if (p->pos.SqDistance(pos) >= (totRad * totRad))
+				continue;
+
+			collisionCandidates[it->second] = true;
+		}
+	};
+
+	for (const CUnit* u: activeUnits) {
+		MarkOverlaps(u->collisionVolume.GetWorldSpacePos(u), u->collisionVolume.GetBoundingRadius());
+
+		for (const CWeapon* w: u->weapons) {
+			// nulled shields are CNoWeapon's, all others CPlasmaRepulser's (see CWeaponLoader)
+			if (!w->weaponDef->isShield || w->weaponDef->isNulled)
+				continue;
+
+			const CPlasmaRepulser* r = static_cast<const CPlasmaRepulser*>(w);
+
+			MarkOverlaps(r->weaponMuzzlePos, r->collisionVolume.GetBoundingRadius());
+		}
+	}
+
+	for (const int featureID: activeFeatureIDs) {
+		const CFeature* f = featureHandler.GetFeature(featureID);
+		MarkOverlaps(f->collisionVolume.GetWorldSpacePos(f), f->collisionVolume.GetBoundingRadius());
 	}
 }
 
@@ -561,6 +657,13 @@ void CProjectileHandler::CheckUnitFeatureCollisions(bool synced)
 	static std::vector<CFeature*> tempFeatures;
 	static std::vector<CPlasmaRepulser*> tempRepulsers;
 
+	MarkCollisionCandidates(synced);
+
+	// collision handling can run Lua callins which move objects around without
+	// going through the QuadField (e.g. MoveCtrl), so the candidate marks from
+	// the broad phase only hold until the first hit
+	bool useCandidates = true;
+
 	//can't use iterators here, because instructions inside the loop modify projectiles[synced]
 	for (size_t i = 0; i < projectiles[synced].size(); ++i) {
 		CProjectile* p = projectiles[synced][i];
@@ -568,15 +671,20 @@ void CProjectileHandler::CheckUnitFeatureCollisions(bool synced)
 		if (!p->checkCol) continue;
 		if ( p->deleteMe) continue;
 
+		// nothing in range according to the broad phase; only valid for projectiles
+		// that existed before it ran
+		if (useCandidates && i < collisionCandidates.size() && !collisionCandidates[i])
+			continue;
+
 		const float3 ppos0 = p->pos;
 		const float3 ppos1 = p->pos + p->speed;
 		// const float3 ppos1 = p->pos + p->dir * (p->speed.w + p->radius);
 
 		quadField.GetUnitsAndFeaturesColVol(p->pos, p->speed.w + p->radius, tempUnits, tempFeatures, &tempRepulsers);
 
-		CheckShieldCollisions (p, tempRepulsers, ppos0, ppos1); tempRepulsers.clear();
-		CheckUnitCollisions   (p, tempUnits    , ppos0, ppos1); tempUnits.clear();
-		CheckFeatureCollisions(p, tempFeatures , ppos0, ppos1); tempFeatures.clear();
+		useCandidates &= !CheckShieldCollisions (p, tempRepulsers, ppos0, ppos1); tempRepulsers.clear();
+		useCandidates &= !CheckUnitCollisions   (p, tempUnits    , ppos0, ppos1); tempUnits.clear();
+		useCandidates &= !CheckFeatureCollisions(p, tempFeatures , ppos0, ppos1); tempFeatures.clear();
 	}
 }
 
@@ -43,11 +43,12 @@ public:
 		return projectiles[synced];
 	}
 
-	void CheckUnitCollisions(CProjectile*, std::vector<CUnit*>&, const float3, const float3);
-	void CheckFeatureCollisions(CProjectile*, std::vector<CFeature*>&, const float3, const float3);
-	void CheckShieldCollisions(CProjectile*, std::vector<CPlasmaRepulser*>&, const float3, const float3);
+	bool CheckUnitCollisions(CProjectile*, std::vector<CUnit*>&, const float3, const float3);
+	bool CheckFeatureCollisions(CProjectile*, std::vector<CFeature*>&, const float3, const float3);
+	bool CheckShieldCollisions(CProjectile*, std::vector<CPlasmaRepulser*>&, const float3, const float3);
 	void CheckUnitFeatureCollisions(bool synced);
 	void CheckGroundCollisions(bool synced);
+	void MarkCollisionCandidates(bool synced);
 	void CheckCollisions();
 
 	void SetMaxParticles(int value) { maxParticles = std::max(0, value); }
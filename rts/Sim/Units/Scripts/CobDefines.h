@@ -93,7 +93,7 @@ static constexpr int SET_WEAPON_GROUND_TARGET = 107; // get (fake set)
 static constexpr int SONAR_STEALTH            = 108; // set or get
 static constexpr int REVERSING                = 109; // get
 
-// NOTE: [LUA0 - LUA9] are defined in CobThread.cpp as [110 - 119]
+// NOTE: [LUA0 - LUA9] are defined in CobInterpreter.h as [110 - 119]
 
 static constexpr int FLANK_B_MODE            = 120; // set or get
 static constexpr int FLANK_B_DIR             = 121; // set or get, set is through get for multiple args
@@ -4,6 +4,7 @@
 #include "CobEngine.h"
 #include "CobThread.h"
 #include "CobFile.h"
+#include "System/Threading/ThreadPool.h"
 
 #include <cstdint>
 #include "System/Misc/TracyDefs.h"
@@ -18,6 +19,11 @@ CR_REG_METADATA(CCobEngine, (
 	CR_MEMBER(sleepingThreadIDs),
 	// always null/empty when saving
 	CR_IGNORED(waitingThreadIDs),
+	CR_IGNORED(wokenThreadIDs),
+	CR_IGNORED(speculations),
+	CR_IGNORED(speculatingThreads),
+	CR_IGNORED(numSpeculations),
+	CR_IGNORED(speculate),
 
 	CR_IGNORED(curThread),
 
@@ -33,6 +39,13 @@ CR_REG_METADATA(CCobEngine::SleepingThread, (
 
 static const char* const numCobThreadsPlot = "CobThreads";
 
+// running a thread ahead has to save (and maybe restore) its stacks and
+// its instance's static vars, so it is only done for threads that get at
+// least this far, and only when there are enough of them to spread over
+// the workers
+static constexpr int MIN_SPECULATIVE_INSTRS = 16;
+static constexpr size_t MIN_SPECULATIONS = 64;
+
 int CCobEngine::AddThread(CCobThread&& thread)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
@@ -129,13 +142,13 @@ void CCobEngine::TickThread(CCobThread* thread)
 	curThread = nullptr;
 }
 
-void CCobEngine::WakeSleepingThreads()
+bool CCobEngine::PopSleepingThread(SleepingThread& st, const SleepingThread* before)
 {
-	ZoneScoped;
-	// check on the sleeping threads, remove any whose owner died
 	while (!sleepingThreadIDs.empty()) {
-		CCobThread* zzzThread = GetThread((sleepingThreadIDs.top()).id);
+		const SleepingThread& top = sleepingThreadIDs.top();
+		const CCobThread* zzzThread = GetThread(top.id);
 
+		// remove any whose owner died
 		if (zzzThread == nullptr) {
 			sleepingThreadIDs.pop();
 			continue;
@@ -143,37 +156,107 @@ void CCobEngine::WakeSleepingThreads()
 
 		// not yet time to execute this thread or any subsequent sleepers
 		if (zzzThread->GetWakeTime() >= currentTime)
-			break;
+			return false;
+
+		if (before != nullptr && !CCobThreadComp()(*before, top))
+			return false;
 
-		// remove executing thread from the queue
+		st = top;
 		sleepingThreadIDs.pop();
+		return true;
+	}
+
+	return false;
+}
+
+void CCobEngine::WakeThread(CCobThread* zzzThread)
+{
+	// wake up the thread and tick it (if not dead)
+	// this can quite possibly re-add the thread to <sleepingThreadIDs>
+	// again, but any thread is guaranteed to sleep for at least 1 tick
+	switch (zzzThread->GetState()) {
+		case CCobThread::Sleep: {
+			zzzThread->SetState(CCobThread::Run);
+			TickThread(zzzThread);
+		} break;
+		case CCobThread::Dead: {
+			RemoveThread(zzzThread->GetID());
+		} break;
+		default: {
+			LOG_L(L_ERROR, "[COBEngine::%s] unknown state %d for thread %d", __func__, zzzThread->GetState(), zzzThread->GetID());
+		} break;
+	}
+}
+
+void CCobEngine::WakeSleepingThreads()
+{
+	ZoneScoped;
 
-		// wake up the thread and tick it (if not dead)
-		// this can quite possibly re-add the thread to <sleepingThreadIDs>
-		// again, but any thread is guaranteed to sleep for at least 1 tick
-		switch (zzzThread->GetState()) {
-			case CCobThread::Sleep: {
-				zzzThread->SetState(CCobThread::Run);
-				TickThread(zzzThread);
-			} break;
-			case CCobThread::Dead: {
-				RemoveThread(zzzThread->GetID());
-			} break;
-			default: {
-				LOG_L(L_ERROR, "[COBEngine::%s] unknown state %d for thread %d", __func__, zzzThread->GetState(), zzzThread->GetID());
-			} break;
+	if (speculate) {
+		WakeSleepingThreadsSpeculative();
+		return;
+	}
+
+	// check on the sleeping threads, remove any whose owner died
+	for (SleepingThread st; PopSleepingThread(st, nullptr); ) {
+		WakeThread(GetThread(st.id));
+	}
+}
+
+void CCobEngine::WakeSleepingThreadsSpeculative()
+{
+	wokenThreadIDs.clear();
+
+	// all threads due now can run ahead before any of them is woken
+	for (SleepingThread st; PopSleepingThread(st, nullptr); ) {
+		wokenThreadIDs.push_back(st);
+		AddSpeculation(st.id);
+	}
+
+	RunSpeculations();
+
+	for (size_t i = 0; ; ) {
+		SleepingThread st;
+
+		// threads that went back to sleep for a negative time while ticking
+		// are due again right away, possibly before the remaining ones
+		if (!PopSleepingThread(st, (i < wokenThreadIDs.size())? &wokenThreadIDs[i]: nullptr)) {
+			if (i == wokenThreadIDs.size())
+				break;
+
+			st = wokenThreadIDs[i++];
 		}
+
+		CCobThread* zzzThread = GetThread(st.id);
+
+		if (zzzThread == nullptr)
+			continue;
+
+		WakeThread(zzzThread);
 	}
+
+	RevertSpeculations();
 }
 
 void CCobEngine::TickRunningThreads()
 {
 	ZoneScoped;
+	if (speculate) {
+		for (const int threadID: runningThreadIDs) {
+			AddSpeculation(threadID);
+		}
+
+		RunSpeculations();
+	}
+
 	// advance all currently running threads
 	for (const int threadID: runningThreadIDs) {
 		TickThread(GetThread(threadID));
 	}
 
+	if (speculate)
+		RevertSpeculations();
+
 	// a thread can never go from running->running, so clear the list
 	// note: if preemption was to be added, this would no longer hold
 	// however, TA scripts can not run preemptively anyway since there
@@ -184,6 +267,103 @@ void CCobEngine::TickRunningThreads()
 	std::swap(runningThreadIDs, waitingThreadIDs);
 }
 
+
+void CCobEngine::AddSpeculation(int threadID)
+{
+	CCobThread* thread = GetThread(threadID);
+
+	if (thread == nullptr || thread->IsGarbage())
+		return;
+	if (thread->GetState() != CCobThread::Run && thread->GetState() != CCobThread::Sleep)
+		return;
+
+	// only the first thread of each instance; later ones could depend on
+	// what it does after the speculated part
+	if (thread->cobInst->speculationIndex != -1)
+		return;
+	// not worth it if the thread calls into the unit (almost) right away
+	if (CobInterpreter::CountSpeculative(*thread->cobFile, thread->GetPC(), MIN_SPECULATIVE_INSTRS) < MIN_SPECULATIVE_INSTRS)
+		return;
+
+	if (numSpeculations == speculations.size())
+		speculations.emplace_back();
+
+	speculations[numSpeculations].threadID = threadID;
+	speculatingThreads.push_back(thread);
+
+	thread->cobInst->speculationIndex = numSpeculations++;
+}
+
+/*
+ * The part of each thread up to its first instruction with outside effects
+ * (calls into the unit or engine, Lua, RAND, START, sleeping, ...) only reads
+ * and writes the thread's own stacks and its instance's static vars, so this
+ * can run ahead concurrently for threads of different instances.
+ *
+ * Threads then tick in their usual order and continue from where they were
+ * stopped. Any other code that runs on the instance first (one of its other
+ * threads, a callin, a signal) reverts the speculation beforehand through
+ * ResolveSpeculation, so the outcome is exactly that of running serially.
+ */
+void CCobEngine::RunSpeculations()
+{
+	ZoneScoped;
+
+	if (numSpeculations < MIN_SPECULATIONS) {
+		for (const CCobThread* thread: speculatingThreads) {
+			thread->cobInst->speculationIndex = -1;
+		}
+
+		speculatingThreads.clear();
+		numSpeculations = 0;
+		return;
+	}
+
+	for_mt(0, speculatingThreads.size(), [&](const int i) {
+		speculatingThreads[i]->Speculate(speculations[i]);
+	});
+
+	// threads may move around in the registry from here on
+	speculatingThreads.clear();
+}
+
+void CCobEngine::ResolveSpeculation(CCobInstance* inst, int threadID)
+{
+	assert(static_cast<size_t>(inst->speculationIndex) < numSpeculations);
+
+	const CCobThread::Speculation& s = speculations[inst->speculationIndex];
+
+	inst->speculationIndex = -1;
+
+	// the speculating thread itself continues where it stopped
+	if (s.threadID == threadID)
+		return;
+
+	CCobThread* thread = GetThread(s.threadID);
+
+	if (thread == nullptr || thread->cobInst != inst)
+		return;
+
+	thread->RevertSpeculation(s);
+}
+
+void CCobEngine::RevertSpeculations()
+{
+	// threads that did not get their turn, with nothing else run on their instance
+	for (size_t i = 0; i < numSpeculations; i++) {
+		const CCobThread* thread = GetThread(speculations[i].threadID);
+
+		if (thread == nullptr || thread->IsGarbage())
+			continue;
+		if (thread->cobInst->speculationIndex != static_cast<int>(i))
+			continue;
+
+		ResolveSpeculation(thread->cobInst, -1);
+	}
+
+	numSpeculations = 0;
+}
+
 void CCobEngine::Tick(int deltaTime)
 {
 	ZoneScoped;
@@ -41,12 +41,13 @@ public:
 	};
 
 public:
-	void Init() {
+	void Init(bool speculative) {
 		threadInstances.reserve(2048);
 		tickAddedThreads.reserve(128);
 
 		runningThreadIDs.reserve(512);
 		waitingThreadIDs.reserve(512);
+		wokenThreadIDs.reserve(512);
 
 		sleepingThreadIDs = {};
 
@@ -54,6 +55,8 @@ public:
 
 		currentTime = 0;
 		threadCounter = 0;
+
+		speculate = speculative;
 	}
 	void Kill() {
 		// threadInstances is never explicitly iterated in the actual code,
@@ -63,6 +66,12 @@ public:
 
 		runningThreadIDs.clear();
 		waitingThreadIDs.clear();
+		wokenThreadIDs.clear();
+
+		speculations.clear();
+		speculatingThreads.clear();
+
+		numSpeculations = 0;
 
 		while (!sleepingThreadIDs.empty()) {
 			sleepingThreadIDs.pop();
@@ -93,6 +102,14 @@ public:
 	void ScheduleThread(const CCobThread* thread);
 	void SanityCheckThreads(const CCobInstance* owner);
 
+	/**
+	 * Called before other code of inst runs (threadID of the thread about
+	 * to be ticked or -1) while one of its threads was run speculatively.
+	 */
+	void ResolveSpeculation(CCobInstance* inst, int threadID);
+	/// true while threads run ahead this tick wait for their turn
+	bool HasSpeculations() const { return (numSpeculations != 0); }
+
 	const auto& GetThreadInstances() const { return threadInstances; }
 //	const auto& GetTickAddedThreads() const { return tickAddedThreads; }
 //	const auto& GetTickRemovedThreads() const { return tickRemovedThreads; }
@@ -105,9 +122,17 @@ public:
 private:
 	void TickThread(CCobThread* thread);
 
+	bool PopSleepingThread(SleepingThread& st, const SleepingThread* before);
+
+	void WakeThread(CCobThread* thread);
 	void WakeSleepingThreads();
+	void WakeSleepingThreadsSpeculative();
 	void TickRunningThreads();
 
+	void AddSpeculation(int threadID);
+	void RunSpeculations();
+	void RevertSpeculations();
+
 private:
 	// registry of every thread across all script instances
 	spring::unordered_map<int, CCobThread> threadInstances;
@@ -122,6 +147,18 @@ private:
 	// stores <id, waketime> pairs s.t. after waking up the ID can be checked
 	// for validity; thread owner might get removed while a thread is sleeping
 	std::priority_queue<SleepingThread, std::vector<SleepingThread>, CCobThreadComp> sleepingThreadIDs;
+	// threads due to wake up this tick, in wake-up order
+	std::vector<SleepingThread> wokenThreadIDs;
+
+	// threads run ahead concurrently this tick (at most one per instance), and
+	// their state before; only valid during TickRunningThreads and WakeSleepingThreads
+	std::vector<CCobThread::Speculation> speculations;
+	std::vector<CCobThread*> speculatingThreads;
+
+	size_t numSpeculations = 0;
+
+	// CobSpeculativeThreads, fixed for the game
+	bool speculate = false;
 
 	CCobThread* curThread = nullptr;
 
@@ -199,6 +199,8 @@ CCobFile::CCobFile(CFileHandler& in, const std::string& scriptName)
 
 		scriptIndex[pair.second] = fn;
 	}
+
+	CobInterpreter::Decode(*this, instrs);
 }
 
 
@@ -8,6 +8,7 @@
 #include <string>
 
 #include "Lua/LuaHashString.h"
+#include "CobInterpreter.h"
 #include "CobScriptNames.h"
 #include "System/UnorderedMap.hpp"
 
@@ -16,6 +17,7 @@ class CFileHandler;
 class CCobFile
 {
 public:
+	CCobFile() = default;
 	CCobFile(CFileHandler& in, const std::string& scriptName);
 	CCobFile(CCobFile&& f) { *this = std::move(f); }
 
@@ -23,6 +25,7 @@ public:
 		numStaticVars = f.numStaticVars;
 
 		code = std::move(f.code);
+		instrs = std::move(f.instrs);
 		scriptNames = std::move(f.scriptNames);
 		scriptOffsets = std::move(f.scriptOffsets);
 
@@ -43,6 +46,8 @@ public:
 	int numStaticVars = 0;
 
 	std::vector<int> code;
+	/// code decoded by CobInterpreter::Decode, indexed by the same offsets
+	std::vector<CobInterpreter::Instr> instrs;
 	std::vector<std::string> scriptNames;
 	std::vector<int> scriptOffsets;
 	/// Assumes that the scripts are sorted by offset in the file
@@ -47,6 +47,7 @@ CR_REG_METADATA(CCobInstance, (
 
 	CR_MEMBER(staticVars),
 	CR_MEMBER(threadIDs),
+	CR_IGNORED(speculationIndex),
 
 	CR_POSTLOAD(PostLoad),
 	CR_PREALLOC(GetUnit)
@@ -723,6 +724,10 @@ void CCobInstance::ThreadCallback(ThreadCallbackType type, int retCode, int cbPa
 void CCobInstance::Signal(int signal)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
+	// signalled before a speculatively run thread got its turn
+	if (cobEngine->HasSpeculations() && speculationIndex != -1)
+		cobEngine->ResolveSpeculation(this, -1);
+
 	for (int threadID: threadIDs) {
 		CCobThread* t = cobEngine->GetThread(threadID);
 
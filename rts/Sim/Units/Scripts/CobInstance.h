@@ -50,6 +50,9 @@ public:
 	std::vector<int> staticVars;
 	std::vector<int> threadIDs;
 
+	/// index of the speculative run of one of our threads this tick, see CCobEngine::RunSpeculations
+	int speculationIndex = -1;
+
 public:
 	// creg only
 	CCobInstance(): CUnitScript(nullptr), cobFile(nullptr) {}
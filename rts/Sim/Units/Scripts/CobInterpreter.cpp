@@ -0,0 +1,244 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+
+#include "CobInterpreter.h"
+#include "CobFile.h"
+#include "CobOpcodes.h"
+
+#include "System/Misc/TracyDefs.h"
+
+#include <algorithm>
+
+
+static int NumOperands(int opcode)
+{
+	switch (opcode) {
+		case MOVE:
+		case TURN:
+		case SPIN:
+		case STOP_SPIN:
+		case MOVE_NOW:
+		case TURN_NOW:
+		case WAIT_TURN:
+		case WAIT_MOVE:
+		case START:
+		case CALL:
+		case REAL_CALL:
+		case LUA_CALL:
+			return 2;
+
+		case SHOW:
+		case HIDE:
+		case CACHE:
+		case DONT_CACHE:
+		case SHADE:
+		case DONT_SHADE:
+		case EMIT_SFX:
+		case PUSH_CONSTANT:
+		case PUSH_LOCAL_VAR:
+		case PUSH_STATIC:
+		case POP_LOCAL_VAR:
+		case POP_STATIC:
+		case JUMP:
+		case JUMP_NOT_EQUAL:
+		case EXPLODE:
+		case PLAY_SOUND:
+			return 1;
+
+		default:
+			break;
+	}
+
+	return 0;
+}
+
+
+void CobInterpreter::Decode(const CCobFile& file, std::vector<Instr>& instrs)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+
+	const std::vector<int>& code = file.code;
+
+	const int codeSize = static_cast<int>(code.size());
+	const int numScripts = static_cast<int>(std::min(file.scriptNames.size(), std::min(file.scriptOffsets.size(), file.scriptLengths.size())));
+
+	// anything outside the code ends up at the trailing OP_BAD_ACCESS
+	const auto JumpTarget = [&](int ofs) { return (ofs >= 0 && ofs < codeSize)? ofs: codeSize; };
+	const auto IsScript = [&](int fn) { return (fn >= 0 && fn < numScripts); };
+
+	instrs.clear();
+	instrs.resize(codeSize + 1);
+
+	for (int pc = 0; pc < codeSize; pc++) {
+		Instr& ins = instrs[pc];
+
+		const int opcode = code[pc];
+		const int numOperands = NumOperands(opcode);
+
+		if ((pc + numOperands) >= codeSize)
+			continue;
+
+		ins.len = 1 + numOperands;
+		ins.a = (numOperands > 0)? code[pc + 1]: 0;
+		ins.b = (numOperands > 1)? code[pc + 2]: 0;
+
+		switch (opcode) {
+			case MOVE      : { ins.op = OP_MOVE     ; } break;
+			case TURN      : { ins.op = OP_TURN     ; } break;
+			case SPIN      : { ins.op = OP_SPIN     ; } break;
+			case STOP_SPIN : { ins.op = OP_STOP_SPIN; } break;
+			case SHOW      : { ins.op = OP_SHOW     ; } break;
+			case HIDE      : { ins.op = OP_HIDE     ; } break;
+			case MOVE_NOW  : { ins.op = OP_MOVE_NOW ; } break;
+			case TURN_NOW  : { ins.op = OP_TURN_NOW ; } break;
+			case EMIT_SFX  : { ins.op = OP_EMIT_SFX ; } break;
+
+			// no-ops, operand is skipped
+			case CACHE     :
+			case DONT_CACHE:
+			case SHADE     :
+			case DONT_SHADE: { ins.op = OP_NOP; } break;
+
+			case WAIT_TURN: { ins.op = OP_WAIT_TURN; } break;
+			case WAIT_MOVE: { ins.op = OP_WAIT_MOVE; } break;
+			case SLEEP    : { ins.op = OP_SLEEP    ; } break;
+
+			case PUSH_CONSTANT   : { ins.op = OP_PUSH_CONSTANT   ; } break;
+			case PUSH_LOCAL_VAR  : { ins.op = OP_PUSH_LOCAL_VAR  ; } break;
+			case CREATE_LOCAL_VAR: { ins.op = OP_CREATE_LOCAL_VAR; } break;
+			case POP_LOCAL_VAR   : { ins.op = OP_POP_LOCAL_VAR   ; } break;
+			case POP_STACK       : { ins.op = OP_POP_STACK       ; } break;
+
+			// accesses to non-existent static vars push nothing, or only pop
+			case PUSH_STATIC: {
+				ins.op = (static_cast<unsigned int>(ins.a) < static_cast<unsigned int>(file.numStaticVars))? OP_PUSH_STATIC: OP_NOP;
+			} break;
+			case POP_STATIC: {
+				ins.op = (static_cast<unsigned int>(ins.a) < static_cast<unsigned int>(file.numStaticVars))? OP_POP_STATIC: OP_POP_STACK;
+			} break;
+
+			case ADD        : { ins.op = OP_ADD        ; } break;
+			case SUB        : { ins.op = OP_SUB        ; } break;
+			case MUL        : { ins.op = OP_MUL        ; } break;
+			case DIV        : { ins.op = OP_DIV        ; } break;
+			case MOD        : { ins.op = OP_MOD        ; } break;
+			case BITWISE_AND: { ins.op = OP_BITWISE_AND; } break;
+			case BITWISE_OR : { ins.op = OP_BITWISE_OR ; } break;
+			case BITWISE_XOR: { ins.op = OP_BITWISE_XOR; } break;
+			case BITWISE_NOT: { ins.op = OP_BITWISE_NOT; } break;
+
+			case RAND          : { ins.op = OP_RAND          ; } break;
+			case GET_UNIT_VALUE: { ins.op = OP_GET_UNIT_VALUE; } break;
+			case GET           : { ins.op = OP_GET           ; } break;
+
+			case SET_LESS            : { ins.op = OP_SET_LESS            ; } break;
+			case SET_LESS_OR_EQUAL   : { ins.op = OP_SET_LESS_OR_EQUAL   ; } break;
+			case SET_GREATER         : { ins.op = OP_SET_GREATER         ; } break;
+			case SET_GREATER_OR_EQUAL: { ins.op = OP_SET_GREATER_OR_EQUAL; } break;
+			case SET_EQUAL           : { ins.op = OP_SET_EQUAL           ; } break;
+			case SET_NOT_EQUAL       : { ins.op = OP_SET_NOT_EQUAL       ; } break;
+			case LOGICAL_AND         : { ins.op = OP_LOGICAL_AND         ; } break;
+			case LOGICAL_OR          : { ins.op = OP_LOGICAL_OR          ; } break;
+			case LOGICAL_XOR         : { ins.op = OP_LOGICAL_XOR         ; } break;
+			case LOGICAL_NOT         : { ins.op = OP_LOGICAL_NOT         ; } break;
+
+			case START: {
+				if (!IsScript(ins.a)) {
+					ins.op = OP_INVALID;
+					ins.a = opcode;
+					break;
+				}
+
+				// do not start zero-length functions
+				ins.op = (file.scriptLengths[ins.a] != 0)? OP_START: OP_NOP;
+			} break;
+			case CALL: {
+				if (IsScript(ins.a) && file.scriptNames[ins.a].find("lua_") == 0) {
+					ins.op = OP_LUA_CALL;
+					break;
+				}
+			} [[fallthrough]];
+			case REAL_CALL: {
+				if (!IsScript(ins.a)) {
+					ins.op = OP_INVALID;
+					ins.a = opcode;
+					break;
+				}
+
+				// do not call zero-length functions
+				ins.op = (file.scriptLengths[ins.a] != 0)? OP_REAL_CALL: OP_NOP;
+				ins.c = JumpTarget(file.scriptOffsets[ins.a]);
+			} break;
+			case LUA_CALL: {
+				// script index is checked by CCobThread::LuaCall
+				ins.op = OP_LUA_CALL;
+			} break;
+
+			case JUMP: {
+				ins.op = OP_JUMP;
+				ins.a = JumpTarget(ins.a);
+			} break;
+			case RETURN: {
+				ins.op = OP_RETURN;
+			} break;
+			case JUMP_NOT_EQUAL: {
+				ins.op = OP_JUMP_NOT_EQUAL;
+				ins.a = JumpTarget(ins.a);
+			} break;
+			case SIGNAL         : { ins.op = OP_SIGNAL         ; } break;
+			case SET_SIGNAL_MASK: { ins.op = OP_SET_SIGNAL_MASK; } break;
+
+			case EXPLODE   : { ins.op = OP_EXPLODE   ; } break;
+			case PLAY_SOUND: { ins.op = OP_PLAY_SOUND; } break;
+
+			case SET   : { ins.op = OP_SET   ; } break;
+			case ATTACH: { ins.op = OP_ATTACH; } break;
+			case DROP  : { ins.op = OP_DROP  ; } break;
+
+			default: {
+				ins.op = OP_INVALID;
+				ins.a = opcode;
+			} break;
+		}
+	}
+}
+
+int CobInterpreter::CountSpeculative(const CCobFile& file, int pc, int maxInstrs)
+{
+	const std::vector<Instr>& instrs = file.instrs;
+
+	for (int n = 0; n < maxInstrs; n++) {
+		const Instr& ins = instrs[pc];
+
+		switch (ins.op) {
+			case OP_NOP:
+			case OP_PUSH_CONSTANT: case OP_PUSH_LOCAL_VAR: case OP_PUSH_STATIC:
+			case OP_CREATE_LOCAL_VAR: case OP_POP_LOCAL_VAR: case OP_POP_STATIC: case OP_POP_STACK:
+			case OP_ADD: case OP_SUB: case OP_MUL:
+			case OP_BITWISE_AND: case OP_BITWISE_OR: case OP_BITWISE_XOR: case OP_BITWISE_NOT:
+			case OP_SET_LESS: case OP_SET_LESS_OR_EQUAL: case OP_SET_GREATER: case OP_SET_GREATER_OR_EQUAL: case OP_SET_EQUAL: case OP_SET_NOT_EQUAL:
+			case OP_LOGICAL_AND: case OP_LOGICAL_OR: case OP_LOGICAL_XOR: case OP_LOGICAL_NOT:
+			case OP_SET_SIGNAL_MASK: {
+				pc += ins.len;
+			} break;
+
+			case OP_JUMP: {
+				pc = ins.a;
+			} break;
+			case OP_REAL_CALL: {
+				pc = ins.c;
+			} break;
+			// where this goes depends on the data stack
+			case OP_JUMP_NOT_EQUAL: {
+				return (n + 1);
+			} break;
+
+			// impure, or depending on the thread's state (DIV, MOD, RETURN)
+			default: {
+				return n;
+			} break;
+		}
+	}
+
+	return maxInstrs;
+}
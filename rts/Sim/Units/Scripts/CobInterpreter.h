@@ -0,0 +1,622 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef COB_INTERPRETER_H
+#define COB_INTERPRETER_H
+
+#include <cassert>
+#include <cstdint>
+#include <stdexcept>
+#include <vector>
+
+#include "Sim/Misc/GlobalConstants.h"
+#include "System/Log/ILog.h"
+#include "CobScriptNames.h"
+
+class CCobFile;
+
+
+// Indices for SET, GET, and GET_UNIT_VALUE for LUA return values
+static constexpr int LUA0 = 110; // (LUA0 returns the lua call status, 0 or 1)
+static constexpr int LUA1 = 111;
+static constexpr int LUA2 = 112;
+static constexpr int LUA3 = 113;
+static constexpr int LUA4 = 114;
+static constexpr int LUA5 = 115;
+static constexpr int LUA6 = 116;
+static constexpr int LUA7 = 117;
+static constexpr int LUA8 = 118;
+static constexpr int LUA9 = 119;
+
+
+#if defined(__GNUC__)
+// dispatch through a table of label addresses (GCC/Clang "labels as values")
+#define COB_DIRECT_THREADED 1
+#endif
+
+
+/**
+ * Pre-decoded COB bytecode and the interpreter loop running it.
+ *
+ * Decode translates the instruction starting at every offset of a script's
+ * code (so program counters, jump targets and call offsets keep meaning the
+ * same as in the raw code, also in savegames) with its operands already read,
+ * CALL's resolved to REAL_CALL or LUA_CALL, calls to empty functions and
+ * out-of-range static variables turned into no-ops and jump targets checked.
+ */
+namespace CobInterpreter {
+	enum Op: std::uint8_t {
+		OP_NOP,
+		OP_BAD_ACCESS, ///< reads past the end of the code
+		OP_INVALID,    ///< unknown opcode or function, a holds the opcode
+
+		OP_MOVE,
+		OP_TURN,
+		OP_SPIN,
+		OP_STOP_SPIN,
+		OP_SHOW,
+		OP_HIDE,
+		OP_MOVE_NOW,
+		OP_TURN_NOW,
+		OP_EMIT_SFX,
+
+		OP_WAIT_TURN,
+		OP_WAIT_MOVE,
+		OP_SLEEP,
+
+		OP_PUSH_CONSTANT,
+		OP_PUSH_LOCAL_VAR,
+		OP_PUSH_STATIC,
+		OP_CREATE_LOCAL_VAR,
+		OP_POP_LOCAL_VAR,
+		OP_POP_STATIC,
+		OP_POP_STACK,
+
+		OP_ADD,
+		OP_SUB,
+		OP_MUL,
+		OP_DIV,
+		OP_MOD,
+		OP_BITWISE_AND,
+		OP_BITWISE_OR,
+		OP_BITWISE_XOR,
+		OP_BITWISE_NOT,
+
+		OP_RAND,
+		OP_GET_UNIT_VALUE,
+		OP_GET,
+
+		OP_SET_LESS,
+		OP_SET_LESS_OR_EQUAL,
+		OP_SET_GREATER,
+		OP_SET_GREATER_OR_EQUAL,
+		OP_SET_EQUAL,
+		OP_SET_NOT_EQUAL,
+		OP_LOGICAL_AND,
+		OP_LOGICAL_OR,
+		OP_LOGICAL_XOR,
+		OP_LOGICAL_NOT,
+
+		OP_START,
+		OP_REAL_CALL,
+		OP_LUA_CALL,
+		OP_JUMP,
+		OP_RETURN,
+		OP_JUMP_NOT_EQUAL,
+		OP_SIGNAL,
+		OP_SET_SIGNAL_MASK,
+
+		OP_EXPLODE,
+		OP_PLAY_SOUND,
+
+		OP_SET,
+		OP_ATTACH,
+		OP_DROP,
+
+		OP_COUNT
+	};
+
+	struct Instr {
+		std::uint8_t op = OP_BAD_ACCESS;
+		/// in code words, including the opcode
+		std::uint8_t len = 1;
+
+		std::int32_t a = 0;
+		std::int32_t b = 0;
+		std::int32_t c = 0;
+	};
+
+	/**
+	 * Fills instrs with the decoded instruction at each offset of file.code,
+	 * plus one trailing OP_BAD_ACCESS that out-of-range jumps are sent to.
+	 */
+	void Decode(const CCobFile& file, std::vector<Instr>& instrs);
+
+	/**
+	 * Counts the instructions (up to maxInstrs) that a speculative Run of a
+	 * thread at pc is sure to get through, following jumps and calls; less
+	 * than that is not worth saving and maybe reverting the thread's state.
+	 */
+	int CountSpeculative(const CCobFile& file, int pc, int maxInstrs);
+
+
+	/**
+	 * Runs thread t until it blocks, dies or stops running.
+	 * Returns false if the thread is dead; see CCobThread::Tick.
+	 *
+	 * If Speculative, it instead stops in front of the first instruction
+	 * that has effects outside of the thread and its script's static vars
+	 * (or could raise an error), leaving pc pointing at it; this part can
+	 * run concurrently with the threads of other script instances, see
+	 * CCobEngine::RunSpeculations.
+	 *
+	 * T is CCobThread (or a stand-in for it in tests), which provides the
+	 * thread state and the calls into its script instance and the engine.
+	 */
+	template<bool Speculative = false, typename T>
+	bool Run(T& t)
+	{
+		const Instr* instrs = t.cobFile->instrs.data();
+		const Instr* ins = nullptr;
+
+		int r1, r2, r3, r4, r5, r6;
+
+		#define COB_FETCH() (ins = &instrs[t.pc], t.pc += ins->len)
+		#define COB_IMPURE_IF(cond) do { if constexpr (Speculative) { if (cond) { t.pc -= ins->len; goto done; } } } while (false)
+		#define COB_IMPURE() COB_IMPURE_IF(true)
+
+		#ifdef COB_DIRECT_THREADED
+		// must be in the same order as Op
+		static const void* const labels[] = {
+			&&L_OP_NOP, &&L_OP_BAD_ACCESS, &&L_OP_INVALID,
+			&&L_OP_MOVE, &&L_OP_TURN, &&L_OP_SPIN, &&L_OP_STOP_SPIN, &&L_OP_SHOW, &&L_OP_HIDE, &&L_OP_MOVE_NOW, &&L_OP_TURN_NOW, &&L_OP_EMIT_SFX,
+			&&L_OP_WAIT_TURN, &&L_OP_WAIT_MOVE, &&L_OP_SLEEP,
+			&&L_OP_PUSH_CONSTANT, &&L_OP_PUSH_LOCAL_VAR, &&L_OP_PUSH_STATIC, &&L_OP_CREATE_LOCAL_VAR, &&L_OP_POP_LOCAL_VAR, &&L_OP_POP_STATIC, &&L_OP_POP_STACK,
+			&&L_OP_ADD, &&L_OP_SUB, &&L_OP_MUL, &&L_OP_DIV, &&L_OP_MOD, &&L_OP_BITWISE_AND, &&L_OP_BITWISE_OR, &&L_OP_BITWISE_XOR, &&L_OP_BITWISE_NOT,
+			&&L_OP_RAND, &&L_OP_GET_UNIT_VALUE, &&L_OP_GET,
+			&&L_OP_SET_LESS, &&L_OP_SET_LESS_OR_EQUAL, &&L_OP_SET_GREATER, &&L_OP_SET_GREATER_OR_EQUAL, &&L_OP_SET_EQUAL, &&L_OP_SET_NOT_EQUAL,
+			&&L_OP_LOGICAL_AND, &&L_OP_LOGICAL_OR, &&L_OP_LOGICAL_XOR, &&L_OP_LOGICAL_NOT,
+			&&L_OP_START, &&L_OP_REAL_CALL, &&L_OP_LUA_CALL, &&L_OP_JUMP, &&L_OP_RETURN, &&L_OP_JUMP_NOT_EQUAL, &&L_OP_SIGNAL, &&L_OP_SET_SIGNAL_MASK,
+			&&L_OP_EXPLODE, &&L_OP_PLAY_SOUND,
+			&&L_OP_SET, &&L_OP_ATTACH, &&L_OP_DROP,
+		};
+		static_assert((sizeof(labels) / sizeof(labels[0])) == OP_COUNT, "");
+
+		#define COB_OP(name) L_##name
+		#define COB_NEXT() do { COB_FETCH(); goto *labels[ins->op]; } while (false)
+		// ops calling into the script instance or engine can get us signalled or killed
+		#define COB_NEXT_CHECKED() do { if (t.state != T::Run) goto done; COB_NEXT(); } while (false)
+
+		COB_NEXT();
+		{
+		#else
+		#define COB_OP(name) case name
+		#define COB_NEXT() continue
+		#define COB_NEXT_CHECKED() if (t.state != T::Run) goto done; else continue
+
+		while (t.state == T::Run) {
+			COB_FETCH();
+
+			switch (ins->op) {
+		#endif
+
+			COB_OP(OP_NOP): {
+			} COB_NEXT();
+
+			COB_OP(OP_BAD_ACCESS): {
+				COB_IMPURE();
+				// mantis #5981
+				throw std::out_of_range("[CobInterpreter] program counter out of range");
+			} COB_NEXT();
+
+			COB_OP(OP_PUSH_CONSTANT): {
+				t.PushDataStack(ins->a);
+			} COB_NEXT();
+			COB_OP(OP_SLEEP): {
+				COB_IMPURE();
+				t.ScheduleWakeUp(t.PopDataStack());
+				return true;
+			} COB_NEXT();
+			COB_OP(OP_SPIN): {
+				COB_IMPURE();
+				r3 = t.PopDataStack();         // speed
+				r4 = t.PopDataStack();         // accel
+				t.cobInst->Spin(ins->a, ins->b, r3, r4);
+			} COB_NEXT_CHECKED();
+			COB_OP(OP_STOP_SPIN): {
+				COB_IMPURE();
+				r3 = t.PopDataStack();         // decel
+				t.cobInst->StopSpin(ins->a, ins->b, r3);
+			} COB_NEXT_CHECKED();
+			COB_OP(OP_RETURN): {
+				COB_IMPURE_IF(t.LocalReturnAddr() == -1);
+
+				t.retCode = t.PopDataStack();
+
+				if (t.LocalReturnAddr() == -1) {
+					t.state = T::Dead;
+
+					// leave values intact on stack in case caller wants to check them
+					return false;
+				}
+
+				// return to caller
+				t.pc = t.LocalReturnAddr();
+				if (t.dataStack.size() > t.LocalStackFrame())
+					t.dataStack.resize(t.LocalStackFrame());
+
+				t.callStack.pop_back();
+			} COB_NEXT();
+
+
+			COB_OP(OP_REAL_CALL): {
+				auto& ci = t.PushCallStackRef();
+				ci.functionId = ins->a;
+				ci.returnAddr = t.pc;
+				ci.stackTop = t.dataStack.size() - ins->b;
+
+				t.paramCount = ins->b;
+
+				// call cobFile->scriptNames[a]
+				t.pc = ins->c;
+			} COB_NEXT();
+			COB_OP(OP_LUA_CALL): {
+				COB_IMPURE();
+				t.LuaCall(ins->a, ins->b);
+			} COB_NEXT_CHECKED();
+
+
+			COB_OP(OP_POP_STATIC): {
+				t.cobInst->staticVars[ins->a] = t.PopDataStack();
+			} COB_NEXT();
+			COB_OP(OP_POP_STACK): {
+				t.PopDataStack();
+			} COB_NEXT();
+
+
+			COB_OP(OP_START): {
+				COB_IMPURE();
+				t.StartChildThread(ins->a, ins->b);
+			} COB_NEXT();
+
+			COB_OP(OP_CREATE_LOCAL_VAR): {
+				if (t.paramCount == 0) {
+					t.PushDataStack(0);
+				} else {
+					t.paramCount--;
+				}
+			} COB_NEXT();
+			COB_OP(OP_GET_UNIT_VALUE): {
+				COB_IMPURE();
+				r1 = t.PopDataStack();
+				if ((r1 >= LUA0) && (r1 <= LUA9)) {
+					t.PushDataStack(t.luaArgs[r1 - LUA0]);
+				} else {
+					t.PushDataStack(t.cobInst->GetUnitVal(r1, 0, 0, 0, 0));
+				}
+			} COB_NEXT_CHECKED();
+
+
+			COB_OP(OP_JUMP_NOT_EQUAL): {
+				if (t.PopDataStack() == 0)
+					t.pc = ins->a;
+			} COB_NEXT();
+			COB_OP(OP_JUMP): {
+				t.pc = ins->a;
+			} COB_NEXT();
+
+
+			COB_OP(OP_POP_LOCAL_VAR): {
+				r2 = t.PopDataStack();
+				t.dataStack[t.LocalStackFrame() + ins->a] = r2;
+			} COB_NEXT();
+			COB_OP(OP_PUSH_LOCAL_VAR): {
+				r2 = t.dataStack[t.LocalStackFrame() + ins->a];
+				t.PushDataStack(r2);
+			} COB_NEXT();
+
+
+			COB_OP(OP_BITWISE_AND): {
+				r1 = t.PopDataStack();
+				r2 = t.PopDataStack();
+				t.PushDataStack(r1 & r2);
+			} COB_NEXT();
+			COB_OP(OP_BITWISE_OR): {
+				r1 = t.PopDataStack();
+				r2 = t.PopDataStack();
+				t.PushDataStack(r1 | r2);
+			} COB_NEXT();
+			COB_OP(OP_BITWISE_XOR): {
+				r1 = t.PopDataStack();
+				r2 = t.PopDataStack();
+				t.PushDataStack(r1 ^ r2);
+			} COB_NEXT();
+			COB_OP(OP_BITWISE_NOT): {
+				r1 = t.PopDataStack();
+				t.PushDataStack(~r1);
+			} COB_NEXT();
+
+			COB_OP(OP_EXPLODE): {
+				COB_IMPURE();
+				r2 = t.PopDataStack();
+				t.cobInst->Explode(ins->a, r2);
+			} COB_NEXT_CHECKED();
+
+			COB_OP(OP_PLAY_SOUND): {
+				COB_IMPURE();
+				r2 = t.PopDataStack();
+				t.cobInst->PlayUnitSound(ins->a, r2);
+			} COB_NEXT_CHECKED();
+
+			COB_OP(OP_PUSH_STATIC): {
+				t.PushDataStack(t.cobInst->staticVars[ins->a]);
+			} COB_NEXT();
+
+			COB_OP(OP_SET_NOT_EQUAL): {
+				r1 = t.PopDataStack();
+				r2 = t.PopDataStack();
+
+				t.PushDataStack(int(r1 != r2));
+			} COB_NEXT();
+			COB_OP(OP_SET_EQUAL): {
+				r1 = t.PopDataStack();
+				r2 = t.PopDataStack();
+
+				t.PushDataStack(int(r1 == r2));
+			} COB_NEXT();
+
+			COB_OP(OP_SET_LESS): {
+				r2 = t.PopDataStack();
+				r1 = t.PopDataStack();
+
+				t.PushDataStack(int(r1 < r2));
+			} COB_NEXT();
+			COB_OP(OP_SET_LESS_OR_EQUAL): {
+				r2 = t.PopDataStack();
+				r1 = t.PopDataStack();
+
+				t.PushDataStack(int(r1 <= r2));
+			} COB_NEXT();
+
+			COB_OP(OP_SET_GREATER): {
+				r2 = t.PopDataStack();
+				r1 = t.PopDataStack();
+
+				t.PushDataStack(int(r1 > r2));
+			} COB_NEXT();
+			COB_OP(OP_SET_GREATER_OR_EQUAL): {
+				r2 = t.PopDataStack();
+				r1 = t.PopDataStack();
+
+				t.PushDataStack(int(r1 >= r2));
+			} COB_NEXT();
+
+			COB_OP(OP_RAND): {
+				COB_IMPURE();
+				r2 = t.PopDataStack();
+				r1 = t.PopDataStack();
+				t.PushDataStack(t.RandInt(r1, r2));
+			} COB_NEXT();
+			COB_OP(OP_EMIT_SFX): {
+				COB_IMPURE();
+				r1 = t.PopDataStack();
+				t.cobInst->EmitSfx(r1, ins->a);
+			} COB_NEXT_CHECKED();
+			COB_OP(OP_MUL): {
+				r1 = t.PopDataStack();
+				r2 = t.PopDataStack();
+				t.PushDataStack(r1 * r2);
+			} COB_NEXT();
+
+
+			COB_OP(OP_SIGNAL): {
+				COB_IMPURE();
+				r1 = t.PopDataStack();
+				t.cobInst->Signal(r1);
+			} COB_NEXT_CHECKED();
+			COB_OP(OP_SET_SIGNAL_MASK): {
+				t.signalMask = t.PopDataStack();
+			} COB_NEXT();
+
+
+			COB_OP(OP_TURN): {
+				COB_IMPURE();
+				r2 = t.PopDataStack();
+				r1 = t.PopDataStack();
+
+				t.cobInst->Turn(ins->a, ins->b, r1, r2);
+			} COB_NEXT_CHECKED();
+			COB_OP(OP_GET): {
+				COB_IMPURE();
+				r5 = t.PopDataStack();
+				r4 = t.PopDataStack();
+				r3 = t.PopDataStack();
+				r2 = t.PopDataStack();
+				r1 = t.PopDataStack();
+				if ((r1 >= LUA0) && (r1 <= LUA9)) {
+					t.PushDataStack(t.luaArgs[r1 - LUA0]);
+				} else {
+					r6 = t.cobInst->GetUnitVal(r1, r2, r3, r4, r5);
+					t.PushDataStack(r6);
+				}
+			} COB_NEXT_CHECKED();
+			COB_OP(OP_ADD): {
+				r2 = t.PopDataStack();
+				r1 = t.PopDataStack();
+				t.PushDataStack(r1 + r2);
+			} COB_NEXT();
+			COB_OP(OP_SUB): {
+				r2 = t.PopDataStack();
+				r1 = t.PopDataStack();
+				t.PushDataStack(r1 - r2);
+			} COB_NEXT();
+
+			COB_OP(OP_DIV): {
+				COB_IMPURE_IF(t.dataStack.empty() || t.dataStack.back() == 0);
+
+				r2 = t.PopDataStack();
+				r1 = t.PopDataStack();
+
+				if (r2 != 0) {
+					r3 = r1 / r2;
+				} else {
+					r3 = 1000; // infinity!
+					t.ShowError("division by zero");
+				}
+				t.PushDataStack(r3);
+			} COB_NEXT();
+			COB_OP(OP_MOD): {
+				COB_IMPURE_IF(t.dataStack.empty() || t.dataStack.back() == 0);
+
+				r2 = t.PopDataStack();
+				r1 = t.PopDataStack();
+
+				if (r2 != 0) {
+					t.PushDataStack(r1 % r2);
+				} else {
+					t.PushDataStack(0);
+					t.ShowError("modulo division by zero");
+				}
+			} COB_NEXT();
+
+
+			COB_OP(OP_MOVE): {
+				COB_IMPURE();
+				r4 = t.PopDataStack();
+				r3 = t.PopDataStack();
+				t.cobInst->Move(ins->a, ins->b, r3, r4);
+			} COB_NEXT_CHECKED();
+			COB_OP(OP_MOVE_NOW): {
+				COB_IMPURE();
+				r3 = t.PopDataStack();
+				t.cobInst->MoveNow(ins->a, ins->b, r3);
+			} COB_NEXT_CHECKED();
+			COB_OP(OP_TURN_NOW): {
+				COB_IMPURE();
+				r3 = t.PopDataStack();
+				t.cobInst->TurnNow(ins->a, ins->b, r3);
+			} COB_NEXT_CHECKED();
+
+
+			COB_OP(OP_WAIT_TURN): {
+				COB_IMPURE();
+				if (t.NeedsWaitTurn(ins->a, ins->b)) {
+					t.state = T::WaitTurn;
+					t.waitPiece = ins->a;
+					t.waitAxis = ins->b;
+					return true;
+				}
+			} COB_NEXT_CHECKED();
+			COB_OP(OP_WAIT_MOVE): {
+				COB_IMPURE();
+				if (t.NeedsWaitMove(ins->a, ins->b)) {
+					t.state = T::WaitMove;
+					t.waitPiece = ins->a;
+					t.waitAxis = ins->b;
+					return true;
+				}
+			} COB_NEXT_CHECKED();
+
+
+			COB_OP(OP_SET): {
+				COB_IMPURE();
+				r2 = t.PopDataStack();
+				r1 = t.PopDataStack();
+
+				if ((r1 >= LUA0) && (r1 <= LUA9)) {
+					t.luaArgs[r1 - LUA0] = r2;
+				} else {
+					t.cobInst->SetUnitVal(r1, r2);
+				}
+			} COB_NEXT_CHECKED();
+
+
+			COB_OP(OP_ATTACH): {
+				COB_IMPURE();
+				r3 = t.PopDataStack();
+				r2 = t.PopDataStack();
+				r1 = t.PopDataStack();
+				t.cobInst->AttachUnit(r2, r1);
+			} COB_NEXT_CHECKED();
+			COB_OP(OP_DROP): {
+				COB_IMPURE();
+				r1 = t.PopDataStack();
+				t.cobInst->DropUnit(r1);
+			} COB_NEXT_CHECKED();
+
+			// like bitwise ops, but only on values 1 and 0
+			COB_OP(OP_LOGICAL_NOT): {
+				r1 = t.PopDataStack();
+				t.PushDataStack(int(r1 == 0));
+			} COB_NEXT();
+			COB_OP(OP_LOGICAL_AND): {
+				r1 = t.PopDataStack();
+				r2 = t.PopDataStack();
+				t.PushDataStack(int(r1 && r2));
+			} COB_NEXT();
+			COB_OP(OP_LOGICAL_OR): {
+				r1 = t.PopDataStack();
+				r2 = t.PopDataStack();
+				t.PushDataStack(int(r1 || r2));
+			} COB_NEXT();
+			COB_OP(OP_LOGICAL_XOR): {
+				r1 = t.PopDataStack();
+				r2 = t.PopDataStack();
+				t.PushDataStack(int((!!r1) ^ (!!r2)));
+			} COB_NEXT();
+
+
+			COB_OP(OP_HIDE): {
+				COB_IMPURE();
+				t.cobInst->SetVisibility(ins->a, false);
+			} COB_NEXT_CHECKED();
+
+			COB_OP(OP_SHOW): {
+				COB_IMPURE();
+				int i;
+				for (i = 0; i < MAX_WEAPONS_PER_UNIT; ++i)
+					if (t.LocalFunctionID() == t.cobFile->scriptIndex[COBFN_FirePrimary + COBFN_Weapon_Funcs * i])
+						break;
+
+				// if true, we are in a Fire-script and should show a special flare effect
+				if (i < MAX_WEAPONS_PER_UNIT) {
+					t.cobInst->ShowFlare(ins->a);
+				} else {
+					t.cobInst->SetVisibility(ins->a, true);
+				}
+			} COB_NEXT_CHECKED();
+
+			COB_OP(OP_INVALID): {
+				COB_IMPURE();
+				const char* name = t.cobFile->name.c_str();
+				const char* func = t.cobFile->scriptNames[t.LocalFunctionID()].c_str();
+
+				LOG_L(L_ERROR, "[COBThread::%s] unknown opcode %x (in %s:%s at %x)", __func__, ins->a, name, func, t.pc - ins->len);
+
+				t.state = T::Dead;
+				return false;
+			} COB_NEXT();
+
+		#ifndef COB_DIRECT_THREADED
+			default: {
+				assert(false);
+			} break;
+			}
+		}
+		#else
+		}
+		#endif
+
+	done:
+		#undef COB_FETCH
+		#undef COB_IMPURE_IF
+		#undef COB_IMPURE
+		#undef COB_OP
+		#undef COB_NEXT
+		#undef COB_NEXT_CHECKED
+
+		// can arrive here as dead, through CCobInstance::Signal()
+		return (t.state != T::Dead);
+	}
+}
+
+#endif // COB_INTERPRETER_H
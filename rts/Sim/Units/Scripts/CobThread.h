@@ -7,6 +7,7 @@
 #include <array>
 
 #include "CobInstance.h"
+#include "CobInterpreter.h"
 #include "Lua/LuaRules.h"
 
 class CCobFile;
@@ -79,6 +80,7 @@ public:
 	const std::string& GetName();
 
 	int GetID() const { return id; }
+	int GetPC() const { return pc; }
 	int GetStackVal(int pos) const { return dataStack[pos]; }
 	int GetWakeTime() const { return wakeTime; }
 	int GetRetCode() const { return retCode; }
@@ -105,7 +107,42 @@ protected:
 		int stackTop = -1;
 	};
 
-	void LuaCall();
+	template<bool Speculative, typename T> friend bool CobInterpreter::Run(T& t);
+
+public:
+	/**
+	 * What a speculative run of the thread can change, to undo it.
+	 * See CCobEngine::RunSpeculations.
+	 */
+	struct Speculation {
+		int threadID = -1;
+
+		int pc = 0;
+		int paramCount = 0;
+		int retCode = -1;
+		int signalMask = 0;
+
+		std::vector<CallInfo> callStack;
+		std::vector<int> dataStack;
+		std::vector<int> staticVars;
+	};
+
+	/**
+	 * Runs the thread up to its first instruction with effects outside of
+	 * it and its script instance's static vars, saving its state into s.
+	 */
+	void Speculate(Speculation& s);
+	void RevertSpeculation(const Speculation& s);
+
+protected:
+	void LuaCall(int scriptId, int numArgs);
+
+	// engine-side parts of the SLEEP, START, RAND and WAIT_* opcodes
+	void ScheduleWakeUp(int delay);
+	void StartChildThread(int functionId, int argCount);
+	int RandInt(int lo, int hi) const;
+	bool NeedsWaitTurn(int piece, int axis) const { return cobInst->NeedsWait(CCobInstance::ATurn, piece, axis); }
+	bool NeedsWaitMove(int piece, int axis) const { return cobInst->NeedsWait(CCobInstance::AMove, piece, axis); }
 
 	void PushCallStack(CallInfo v) { callStack.push_back(v); }
 	void PushDataStack(int v) { dataStack.push_back(v); }
@@ -57,6 +57,7 @@ void CLuaUnitScript::PostLoad()
 	hasSetSFXOccupy  = scriptIndex[LUAFN_SetSFXOccupy ] != LUA_NOREF;
 	hasRockUnit      = scriptIndex[LUAFN_RockUnit     ] != LUA_NOREF;
 	hasStartBuilding = scriptIndex[LUAFN_StartBuilding] != LUA_NOREF;
+	hasChangeHeading = scriptIndex[LUAFN_ChangeHeading] != LUA_NOREF;
 }
 
 
@@ -363,6 +364,7 @@ void CLuaUnitScript::UpdateCallIn(const std::string& fname, int ref)
 		case LUAFN_SetSFXOccupy:  hasSetSFXOccupy  = (ref != LUA_NOREF); break;
 		case LUAFN_RockUnit:      hasRockUnit      = (ref != LUA_NOREF); break;
 		case LUAFN_StartBuilding: hasStartBuilding = (ref != LUA_NOREF); break;
+		case LUAFN_ChangeHeading: hasChangeHeading = (ref != LUA_NOREF); break;
 	}
 
 	//LUA_TRACE(fname.c_str());
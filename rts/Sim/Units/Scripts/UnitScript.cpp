@@ -62,7 +62,8 @@ CR_REG_METADATA(CUnitScript, (
 	CR_IGNORED(pieces),
 	CR_IGNORED(hasSetSFXOccupy),
 	CR_IGNORED(hasRockUnit),
-	CR_IGNORED(hasStartBuilding)
+	CR_IGNORED(hasStartBuilding),
+	CR_IGNORED(hasChangeHeading)
 ))
 
 CR_BIND(CUnitScript::AnimInfo,)
@@ -84,6 +85,7 @@ CUnitScript::CUnitScript(CUnit* unit)
 	, hasSetSFXOccupy(false)
 	, hasRockUnit(false)
 	, hasStartBuilding(false)
+	, hasChangeHeading(false)
 { }
 
 
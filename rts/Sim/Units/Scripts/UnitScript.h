@@ -54,6 +54,7 @@ protected:
 	bool hasSetSFXOccupy;
 	bool hasRockUnit;
 	bool hasStartBuilding;
+	bool hasChangeHeading;
 
 	bool MoveToward(float& cur, float dest, float speed);
 	bool TurnToward(float& cur, float dest, float speed);
@@ -157,6 +158,7 @@ public:
 	bool HasSetSFXOccupy () const { return hasSetSFXOccupy; }
 	bool HasRockUnit     () const { return hasRockUnit; }
 	bool HasStartBuilding() const { return hasStartBuilding; }
+	bool HasChangeHeading() const { return hasChangeHeading; }
 
 	virtual bool HasBlockShot   (int weaponNum) const { return false; }
 	virtual bool HasTargetWeight(int weaponNum) const { return false; }
@@ -18,6 +18,7 @@
 #include "System/Misc/TracyDefs.h"
 
 CONFIG(bool, AnimationMT).defaultValue(true).safemodeValue(false).minimumValue(false).description("Enable multithreaded execution of animation ticks");
+CONFIG(bool, CobSpeculativeThreads).defaultValue(false).safemodeValue(false).minimumValue(false).description("Run the side-effect free start of unit script threads concurrently (results are identical to running them serially)");
 
 static CCobEngine gCobEngine;
 static CCobFileHandler gCobFileHandler;
@@ -44,7 +45,7 @@ void CUnitScriptEngine::InitStatic() {
 	cobFileHandler = &gCobFileHandler;
 	unitScriptEngine = &gUnitScriptEngine;
 
-	cobEngine->Init();
+	cobEngine->Init(configHandler->GetBool("CobSpeculativeThreads"));
 	cobFileHandler->Init();
 	unitScriptEngine->Init();
 }
@@ -84,6 +84,8 @@ float CUnit::expHealthScale = 0.0f;
 float CUnit::expReloadScale = 0.0f;
 float CUnit::expGrade       = 0.0f;
 
+bool CUnit::deferPhysicalStateEvents = false;
+
 
 CUnit::CUnit(): CSolidObject()
 {
@@ -896,7 +898,7 @@ void CUnit::SetLosStatus(int at, unsigned short newStatus)
 }
 
 
-unsigned short CUnit::CalcLosStatus(int at)
+unsigned short CUnit::CalcLosStatus(int at) const
 {
 	RECOIL_DETAILED_TRACY_ZONE;
 	const unsigned short currStatus = losStatus[at];
@@ -1801,12 +1803,23 @@ void CUnit::DependentDied(CObject* o)
 void CUnit::UpdatePhysicalState(float eps)
 {
 	RECOIL_DETAILED_TRACY_ZONE;
-	const bool inAir      = IsInAir();
-	const bool inWater    = IsInWater();
-	const bool underWater = IsUnderWater();
+	const unsigned int prevPhysicalState = physicalState;
 
 	CSolidObject::UpdatePhysicalState(eps);
 
+	if (deferPhysicalStateEvents)
+		return;
+
+	PhysicalStateEvents(prevPhysicalState);
+}
+
+void CUnit::PhysicalStateEvents(unsigned int prevPhysicalState)
+{
+	RECOIL_DETAILED_TRACY_ZONE;
+	const bool inAir      = ((prevPhysicalState & PSTATE_BIT_INAIR     ) != 0);
+	const bool inWater    = ((prevPhysicalState & PSTATE_BIT_INWATER   ) != 0);
+	const bool underWater = ((prevPhysicalState & PSTATE_BIT_UNDERWATER) != 0);
+
 	if (IsInAir() != inAir) {
 		if (IsInAir()) {
 			eventHandler.UnitEnteredAir(this);
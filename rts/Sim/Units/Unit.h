@@ -84,6 +84,10 @@ public:
 	virtual void Update();
 	virtual void SlowUpdate();
 
+	/// true if Update only touches this unit's own state and the heightmap
+	/// (no transport links, no build/reclaim/terraform side effects)
+	virtual bool CanUpdateConcurrently() const { return (transporter == nullptr && transportedUnits.empty()); }
+
 	const SolidObjectDef* GetDef() const { return ((const SolidObjectDef*) unitDef); }
 
 	virtual void DoDamage(const DamageArray& damages, const float3& impulse, CUnit* attacker, int weaponDefID, int projectileID);
@@ -146,6 +150,11 @@ public:
 	void CalculateTerrainType();
 	void UpdateTerrainType();
 	void UpdatePhysicalState(float eps);
+	/// raises the Unit{Entered,Left}{Air,Water,Underwater} events for the change since prevPhysicalState
+	void PhysicalStateEvents(unsigned int prevPhysicalState);
+
+	/// set while CUnitHandler runs Update on worker threads, it raises the events afterwards
+	static void SetDeferPhysicalStateEvents(bool b) { deferPhysicalStateEvents = b; }
 
 	float3 GetErrorVector(int allyteam) const;
 	float3 GetErrorPos(int allyteam, bool aiming = false) const { return (aiming? aimPos: midPos) + GetErrorVector(allyteam); }
@@ -187,7 +196,7 @@ public:
 	bool IsInLosForAllyTeam(int allyTeam) const { return ((losStatus[allyTeam] & LOS_INLOS) != 0); }
 
 	void SetLosStatus(int allyTeam, unsigned short newStatus);
-	unsigned short CalcLosStatus(int allyTeam);
+	unsigned short CalcLosStatus(int allyTeam) const;
 	void UpdateLosStatus(int allyTeam);
 
 	void UpdateWeapons();
@@ -571,6 +580,8 @@ private:
 	static float expHealthScale;
 	static float expReloadScale;
 	static float expGrade;
+
+	static bool deferPhysicalStateEvents;
 };
 
 #endif // UNIT_H
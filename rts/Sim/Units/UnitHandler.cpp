@@ -1,6 +1,8 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include <bit>
 #include <cassert>
+#include <cstdint>
 
 #include "UnitHandler.h"
 #include "Unit.h"
@@ -11,6 +13,7 @@
 #include "UnitTypes/Factory.h"
 
 #include "CommandAI/BuilderCAI.h"
+#include "Game/GameHelper.h"
 #include "Sim/Ecs/Registry.h"
 #include "Sim/Misc/GlobalSynced.h"
 #include "Sim/Misc/ModInfo.h"
@@ -26,6 +29,7 @@
 #include "System/SpringMath.h"
 #include "System/Threading/ThreadPool.h"
 #include "System/TimeProfiler.h"
+#include "System/Sync/SyncedPrimitiveBase.h"
 #include "System/creg/STL_Deque.h"
 #include "System/creg/STL_Set.h"
 #include "System/Threading/ThreadPool.h"
@@ -35,7 +39,10 @@
 
 #include "System/Config/ConfigHandler.h"
 CONFIG(bool, UpdateWeaponVectorsMT).defaultValue(true).safemodeValue(false).minimumValue(false).description("Enable multithreaded update of weapon vectors");
+CONFIG(bool, UpdateUnitsMT).defaultValue(false).safemodeValue(false).minimumValue(false).description("Enable multithreaded unit updates (results are identical to the single-threaded path)");
 CONFIG(bool, UpdateBoundingVolumeMT).defaultValue(true).safemodeValue(false).minimumValue(false).description("Enable multithreaded update of unit bounding volumes");
+CONFIG(bool, WeaponTargetCandidatesMT).defaultValue(true).safemodeValue(false).minimumValue(false).description("Enable multithreaded gathering of the enemy units shared by a unit's weapons when auto-targeting");
+CONFIG(bool, UpdateUnitLosStatesMT).defaultValue(true).safemodeValue(false).minimumValue(false).description("Enable multithreaded detection of unit LOS status changes (results are identical to the single-threaded path)");
 
 
 
@@ -48,6 +55,8 @@ CR_REG_METADATA(CUnitHandler, (
 	CR_MEMBER(activeUnits),
 	CR_MEMBER(unitsToBeRemoved),
 
+	CR_IGNORED(prevPhysicalStates),
+
 	CR_MEMBER(builderCAIs),
 
 	CR_MEMBER(activeSlowUpdateUnit),
@@ -344,9 +353,76 @@ void CUnitHandler::UpdateUnitMoveTypes()
 void CUnitHandler::UpdateUnitLosStates()
 {
 	ZoneScoped;
-	for (CUnit* unit: activeUnits) {
-		for (int at = 0; at < teamHandler.ActiveAllyTeams(); ++at) {
-			unit->UpdateLosStatus(at);
+	// bit i of losChangedUnits is set if activeUnits[i] changes status for
+	// any allyteam, the allyteams are then given by that unit's words in
+	// losChangedAllyTeams; almost all bits stay clear in a typical frame
+	static std::vector<std::uint64_t> losChangedUnits;
+	static std::vector<std::uint64_t> losChangedAllyTeams;
+
+	const size_t numUnits = activeUnits.size();
+	const size_t numUnitWords = (numUnits + 63) / 64;
+	const int numAllyTeams = teamHandler.ActiveAllyTeams();
+	const size_t numAllyTeamWords = (numAllyTeams + 63) / 64;
+
+	losChangedUnits.assign(numUnitWords, 0);
+	losChangedAllyTeams.assign(numUnits * numAllyTeamWords, 0);
+
+	// CalcLosStatus has no side-effects, so the changes are all determined
+	// against the state at the start of the pass (in one task per bitset
+	// word) and only the units that have any are visited below; a change
+	// caused by a LOS call-in fired during this pass is picked up in the
+	// next frame instead of the current one, identically with or without MT
+	//
+	// NOTE:
+	//   the scan still evaluates every unmasked (unit, allyteam) pair, since
+	//   nothing tracks which LOS-map squares or unit visibility flags changed
+	//   since the last frame; only the serial event pass is reduced to the
+	//   pairs that actually change
+	const auto FindLosChanges = [&](const size_t w) {
+		std::uint64_t unitBits = 0;
+
+		for (size_t i = w * 64, n = std::min(i + 64, numUnits); i < n; ++i) {
+			CUnit* unit = activeUnits[i];
+			std::uint64_t* allyTeamBits = &losChangedAllyTeams[i * numAllyTeamWords];
+
+			for (int at = 0; at < numAllyTeams; ++at) {
+				const unsigned short currStatus = unit->losStatus[at];
+
+				// no need to update, all changes are masked
+				if ((currStatus & LOS_ALL_MASK_BITS) == LOS_ALL_MASK_BITS)
+					continue;
+				if (unit->CalcLosStatus(at) == currStatus)
+					continue;
+
+				allyTeamBits[at >> 6] |= (std::uint64_t(1) << (at & 63));
+				unitBits |= (std::uint64_t(1) << (i & 63));
+			}
+		}
+
+		losChangedUnits[w] = unitBits;
+	};
+
+	if (configHandler->GetBool("UpdateUnitLosStatesMT")) {
+		for_mt(0, numUnitWords, [&](const int w) { FindLosChanges(w); });
+	} else {
+		for (size_t w = 0; w < numUnitWords; ++w) {
+			FindLosChanges(w);
+		}
+	}
+
+	// emit the events in the same (unit, allyteam) order as a full sweep;
+	// units added by call-ins are appended and not part of the bitsets
+	for (size_t w = 0; w < numUnitWords; ++w) {
+		for (std::uint64_t unitBits = losChangedUnits[w]; unitBits != 0; unitBits &= (unitBits - 1)) {
+			const size_t i = w * 64 + std::countr_zero(unitBits);
+
+			CUnit* unit = activeUnits[i];
+
+			for (size_t aw = 0; aw < numAllyTeamWords; ++aw) {
+				for (std::uint64_t allyTeamBits = losChangedAllyTeams[i * numAllyTeamWords + aw]; allyTeamBits != 0; allyTeamBits &= (allyTeamBits - 1)) {
+					unit->UpdateLosStatus(aw * 64 + std::countr_zero(allyTeamBits));
+				}
+			}
 		}
 	}
 }
@@ -373,6 +449,10 @@ void CUnitHandler::SlowUpdateUnits()
 
 	static std::vector<CUnit*> updateBoundingVolumeList;
 	updateBoundingVolumeList.clear();
+	{
+		ZoneScopedN("Sim::Unit::SlowUpdateTargets");
+		helper->GenerateWeaponTargetCandidates(activeUnits, idxBeg, idxEnd, configHandler->GetBool("WeaponTargetCandidatesMT"));
+	}
 	{
 		ZoneScopedN("Sim::Unit::SlowUpdateST");
 		for (size_t i = idxBeg; i < idxEnd; ++i) {
@@ -404,22 +484,107 @@ void CUnitHandler::SlowUpdateUnits()
 	}
 }
 
-void CUnitHandler::UpdateUnits()
+void CUnitHandler::UpdateUnit(CUnit* unit)
 {
-	SCOPED_TIMER("Sim::Unit::Update");
+	unit->SanityCheck();
+	unit->Update();
+	unit->moveType->UpdateCollisionMap();
+	// unsynced; done on-demand when drawing unit
+	// unit->UpdateLocalModel();
+	unit->SanityCheck();
+}
+
+void CUnitHandler::UpdateUnitBatch(const size_t idxBeg, const size_t idxEnd, const bool useThreads)
+{
+	// small batches are not worth waking the workers for
+	constexpr size_t MIN_BATCH_SIZE = 64;
+
+	if ((idxEnd - idxBeg) < MIN_BATCH_SIZE) {
+		for (size_t i = idxBeg; i < idxEnd; ++i) {
+			UpdateUnit(activeUnits[i]);
+		}
+
+		return;
+	}
+
+	prevPhysicalStates.resize(idxEnd - idxBeg);
 
-	size_t activeUnitCount = activeUnits.size();
-	for (size_t i = 0; i < activeUnitCount; ++i) {
+	for (size_t i = idxBeg; i < idxEnd; ++i) {
+		prevPhysicalStates[i - idxBeg] = activeUnits[i]->physicalState;
+	}
+
+	// every unit in [idxBeg, idxEnd) only writes its own state, so the
+	// order among them is irrelevant; the physical-state events and the
+	// QuadField moves are committed afterwards in activeUnits order
+	const auto UpdateBatchUnit = [this](const int i) {
 		CUnit* unit = activeUnits[i];
 
+		Sync::SetMTKey(unit->id);
+
 		unit->SanityCheck();
 		unit->Update();
+	};
+
+	CUnit::SetDeferPhysicalStateEvents(true);
+
+	#ifdef SYNCDEBUG
+	// the sync debugger needs all writes in sequence
+	for (size_t i = idxBeg; i < idxEnd; ++i) {
+		UpdateBatchUnit(i);
+	}
+	#else
+	{
+		Sync::ScopedMTSection mtSection;
+
+		if (useThreads) {
+			for_mt(idxBeg, idxEnd, UpdateBatchUnit);
+		} else {
+			for (size_t i = idxBeg; i < idxEnd; ++i) {
+				UpdateBatchUnit(i);
+			}
+		}
+	}
+	#endif
+
+	CUnit::SetDeferPhysicalStateEvents(false);
+
+	for (size_t i = idxBeg; i < idxEnd; ++i) {
+		CUnit* unit = activeUnits[i];
+
+		unit->PhysicalStateEvents(prevPhysicalStates[i - idxBeg]);
 		unit->moveType->UpdateCollisionMap();
-		// unsynced; done on-demand when drawing unit
-		// unit->UpdateLocalModel();
 		unit->SanityCheck();
+	}
+}
+
+void CUnitHandler::UpdateUnits()
+{
+	SCOPED_TIMER("Sim::Unit::Update");
+
+	const size_t activeUnitCount = activeUnits.size();
+	const bool useThreads = configHandler->GetBool("UpdateUnitsMT");
+
+	// units that can not be updated concurrently (builders, factories,
+	// transports and their cargo) act as barriers: they are updated in
+	// place, and only the runs of independent units between them are
+	// staged (and spread over the workers if enabled); batches are staged
+	// the same way regardless of UpdateUnitsMT, so all clients raise the
+	// same events in the same order and compute the same sync checksum
+	for (size_t idxBeg = 0; idxBeg < activeUnitCount; ) {
+		size_t idxEnd = idxBeg;
+
+		while (idxEnd < activeUnitCount && activeUnits[idxEnd]->CanUpdateConcurrently())
+			++idxEnd;
+
+		UpdateUnitBatch(idxBeg, idxEnd, useThreads);
+
+		if (idxEnd == activeUnitCount)
+			break;
+
+		UpdateUnit(activeUnits[idxEnd]);
 
-		assert(activeUnits[i] == unit);
+		assert(activeUnits.size() >= activeUnitCount);
+		idxBeg = idxEnd + 1;
 	}
 }
 
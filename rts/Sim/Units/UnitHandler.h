@@ -84,6 +84,8 @@ private:
 	void UpdateUnitPathing(const size_t idxBeg, const size_t idxEnd);
 	void UpdateUnitMoveTypes();
 	void UpdateUnitLosStates();
+	void UpdateUnit(CUnit* unit);
+	void UpdateUnitBatch(const size_t idxBeg, const size_t idxEnd, const bool useThreads);
 	void UpdateUnits();
 	void UpdateUnitWeapons();
 
@@ -100,6 +102,8 @@ private:
 	std::vector<CUnit*> activeUnits;                                     ///< used to get all active units
 	std::vector<CUnit*> unitsToBeRemoved;                                ///< units that will be removed at start of next update
 
+	std::vector<unsigned int> prevPhysicalStates;                        ///< of the units in the batch UpdateUnitBatch is running
+
 	spring::unordered_map<unsigned int, CBuilderCAI*> builderCAIs;
 
 
@@ -32,6 +32,7 @@ public:
 	CBuilder();
 
 	void Update();
+	bool CanUpdateConcurrently() const override { return false; }
 	void SlowUpdate();
 	void DependentDied(CObject* o);
 
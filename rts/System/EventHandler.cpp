@@ -631,6 +631,12 @@ void CEventHandler::CollectGarbage(bool forced)
 	ITERATE_EVENTCLIENTLIST(CollectGarbage, forced);
 }
 
+void CEventHandler::FlushCallInBatches()
+{
+	ZoneScoped;
+	ITERATE_EVENTCLIENTLIST_NA(FlushCallInBatches);
+}
+
 void CEventHandler::DbgTimingInfo(DbgTimingInfoType type, const spring_time start, const spring_time end)
 {
 	ITERATE_EVENTCLIENTLIST(DbgTimingInfo, type, start, end);
@@ -305,6 +305,7 @@ class CEventHandler
 		void GameProgress(int gameFrame);
 
 		void CollectGarbage(bool forced);
+		void FlushCallInBatches();
 		void DbgTimingInfo(DbgTimingInfoType type, const spring_time start, const spring_time end);
 		void Pong(uint8_t pingTag, const spring_time pktSendTime, const spring_time pktRecvTime);
 		void MetalMapChanged(const int x, const int z);
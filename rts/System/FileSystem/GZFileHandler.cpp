@@ -22,13 +22,15 @@
 
 //We must call Open from here since in the CFileHandler ctor
 //virtual functions aren't called.
-CGZFileHandler::CGZFileHandler(const char* fileName, const char* modes)
+CGZFileHandler::CGZFileHandler(const char* fileName, const char* modes, bool allowTruncated)
+	: allowTruncated(allowTruncated)
 {
 	Open(fileName, modes);
 }
 
 
-CGZFileHandler::CGZFileHandler(const std::string& fileName, const std::string& modes)
+CGZFileHandler::CGZFileHandler(const std::string& fileName, const std::string& modes, bool allowTruncated)
+	: allowTruncated(allowTruncated)
 {
 	Open(fileName, modes);
 }
@@ -47,6 +49,13 @@ bool CGZFileHandler::ReadToBuffer(const std::string& path)
 	while (true) {
 		int unzippedBytes = gzread(file, unzipBuffer, BUFFER_SIZE);
 		if (unzippedBytes < 0) {
+			int error = Z_OK;
+			gzerror(file, &error);
+
+			// truncated (e.g. still being written), keep what was complete
+			if (error == Z_BUF_ERROR && allowTruncated)
+				break;
+
 			fileBuffer.clear();
 			fileSize = -1;
 			gzclose(file);
@@ -86,7 +95,12 @@ bool CGZFileHandler::UncompressBuffer()
 		zstream.avail_out = BUFFER_SIZE;
 		zstream.next_out = unzipBuffer;
 		const int ret = inflate(&zstream, Z_NO_FLUSH);
-		if (ret != Z_OK) {
+		if (ret != Z_OK && ret != Z_STREAM_END) {
+			// truncated input, same as gzread
+			if (ret == Z_BUF_ERROR && zstream.avail_in == 0 && allowTruncated)
+				break;
+
+			inflateEnd(&zstream);
 			fileBuffer.clear();
 			fileSize = -1;
 			return false;
@@ -95,8 +109,13 @@ bool CGZFileHandler::UncompressBuffer()
 		const size_t unzippedBytes = BUFFER_SIZE - zstream.avail_out;
 		fileBuffer.insert(fileBuffer.end(), unzipBuffer, unzipBuffer + unzippedBytes);
 
-		if (ret == Z_STREAM_END)
-			break;
+		if (ret == Z_STREAM_END) {
+			if (zstream.avail_in == 0)
+				break;
+
+			// concatenated gzip members (e.g. demos) read as one stream
+			inflateReset(&zstream);
+		}
 	}
 
 	inflateEnd(&zstream);
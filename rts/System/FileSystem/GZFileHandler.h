@@ -14,8 +14,12 @@
 class CGZFileHandler : public CFileHandler
 {
 public:
-	CGZFileHandler(const char* fileName, const char* modes = SPRING_VFS_RAW_FIRST);
-	CGZFileHandler(const std::string& fileName, const std::string& modes = SPRING_VFS_RAW_FIRST);
+	/**
+	 * @param allowTruncated keep the complete part of a file whose compressed
+	 *   stream ends early (e.g. a demo still being recorded) instead of failing
+	 */
+	CGZFileHandler(const char* fileName, const char* modes = SPRING_VFS_RAW_FIRST, bool allowTruncated = false);
+	CGZFileHandler(const std::string& fileName, const std::string& modes = SPRING_VFS_RAW_FIRST, bool allowTruncated = false);
 
 private:
 	bool TryReadFromPWD(const std::string& fileName) override;
@@ -23,6 +27,8 @@ private:
 	bool TryReadFromVFS(const std::string& fileName, int section) override;
 	bool ReadToBuffer(const std::string& path);
 	bool UncompressBuffer();
+
+	bool allowTruncated = false;
 };
 
 #endif // _GZ_FILE_HANDLER_H
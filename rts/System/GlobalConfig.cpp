@@ -26,7 +26,8 @@ CONFIG(int, ReconnectTimeout)
 
 CONFIG(int, MaximumTransmissionUnit)
 	.defaultValue(1400)
-	.minimumValue(400);
+	.minimumValue(400)
+	.maximumValue(netcode::UDPConnection::MAX_MTU);
 
 CONFIG(int, LinkOutgoingBandwidth)
 	.defaultValue(64 * 1024)
@@ -1,5 +1,9 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <memory>
 #include <sstream>
 #include <zlib.h>
 
@@ -44,6 +48,7 @@
 #include "System/FileSystem/DataDirsAccess.h"
 #include "System/FileSystem/FileQueryFlags.h"
 #include "System/FileSystem/GZFileHandler.h"
+#include "System/Threading/SpringThreading.h"
 #include "System/Threading/ThreadPool.h"
 #include "System/creg/SerializeLuaState.h"
 #include "System/creg/Serializer.h"
@@ -52,11 +57,172 @@
 
 #define MAX_STRING_SIZE (1 << 19) // 512kB excluding null-term
 
+// streamed saves start with this id, followed by frames of
+// {uint64 size (LE), data}; one frame per serialized section
+static constexpr char SAVE_STREAM_FILE_ID[4] = {'S', 'S', 'F', 'S'};
+// bound on serialized data waiting for the compressor
+static constexpr size_t SAVE_STREAM_MAX_QUEUED_BYTES = 64 * 1024 * 1024;
+
+
+/// compresses save sections on a worker thread while later
+/// ones are being serialized, without ever concatenating them;
+/// writes to a temporary file that replaces the save only once
+/// it is complete
+class CSaveStreamWriter
+{
+public:
+	CSaveStreamWriter(gzFile f, const std::string& tmp, const std::string& path)
+		: file(f)
+		, tmpPath(tmp)
+		, savePath(path)
+	{}
+
+	void WriteFrame(std::string&& data) {
+		std::string size(sizeof(std::uint64_t), 0);
+
+		for (size_t i = 0; i < sizeof(std::uint64_t); i++) {
+			size[i] = static_cast<char>((std::uint64_t(data.size()) >> (i * 8)) & 0xFF);
+		}
+
+		Push(std::move(size));
+		Push(std::move(data));
+	}
+
+	void Push(std::string&& data) {
+		std::unique_lock<spring::mutex> lock(mutex);
+
+		// block the sim only if the compressor falls too far behind
+		cond.wait(lock, [&]() { return (queuedBytes < SAVE_STREAM_MAX_QUEUED_BYTES || chunks.empty()); });
+
+		queuedBytes += data.size();
+		chunks.emplace_back(std::move(data));
+		cond.notify_all();
+	}
+
+	/// @param commit false if serialization failed, the previous save is kept
+	void Close(bool commit) {
+		std::unique_lock<spring::mutex> lock(mutex);
+
+		closed = true;
+		committed = commit;
+		cond.notify_all();
+	}
+
+	void Run() {
+		while (true) {
+			std::string data;
+
+			{
+				std::unique_lock<spring::mutex> lock(mutex);
+				cond.wait(lock, [&]() { return (!chunks.empty() || closed); });
+
+				if (chunks.empty())
+					break;
+
+				data = std::move(chunks.front());
+				chunks.pop_front();
+			}
+
+			// gzwrite takes an unsigned length
+			for (size_t pos = 0; pos < data.size(); pos += (1 << 30)) {
+				failed |= (gzwrite(file, data.data() + pos, std::min(data.size() - pos, size_t(1 << 30))) <= 0);
+			}
+
+			{
+				std::unique_lock<spring::mutex> lock(mutex);
+				queuedBytes -= data.size();
+				cond.notify_all();
+			}
+		}
+
+		gzflush(file, Z_FINISH);
+		failed |= (gzclose(file) != Z_OK);
+
+		std::error_code err;
+
+		if (committed && !failed) {
+			std::filesystem::rename(tmpPath, savePath, err);
+
+			if (!err)
+				return;
+
+			LOG_L(L_ERROR, "[LSH::%s] could not move \"%s\" to \"%s\" (%s)", __func__, tmpPath.c_str(), savePath.c_str(), err.message().c_str());
+		} else if (failed) {
+			LOG_L(L_ERROR, "[LSH::%s] could not write \"%s\"", __func__, tmpPath.c_str());
+		}
+
+		std::filesystem::remove(tmpPath, err);
+	}
+
+private:
+	spring::mutex mutex;
+	spring::condition_variable cond;
+
+	std::deque<std::string> chunks;
+	size_t queuedBytes = 0;
+	bool closed = false;
+	bool committed = false;
+	bool failed = false;
+
+	gzFile file;
+
+	std::string tmpPath;
+	std::string savePath;
+};
+
+
+static bool ReadFrame(CFileHandler& file, std::string& data)
+{
+	unsigned char sizeBytes[sizeof(std::uint64_t)];
+
+	if (file.Read(sizeBytes, sizeof(sizeBytes)) != sizeof(sizeBytes))
+		return false;
+
+	std::uint64_t size = 0;
+
+	for (size_t i = 0; i < sizeof(std::uint64_t); i++) {
+		size |= (std::uint64_t(sizeBytes[i]) << (i * 8));
+	}
+
+	data.resize(size);
+
+	for (size_t pos = 0; pos < size; ) {
+		const int len = file.Read(data.data() + pos, std::min(size - pos, std::uint64_t(1 << 30)));
+
+		if (len <= 0)
+			return false;
+
+		pos += len;
+	}
+
+	return true;
+}
+
 
 CCregLoadSaveHandler::CCregLoadSaveHandler()
 {}
 
-CCregLoadSaveHandler::~CCregLoadSaveHandler() = default;
+CCregLoadSaveHandler::~CCregLoadSaveHandler() { CloseLoadFile(); }
+
+
+void CCregLoadSaveHandler::ReadSection()
+{
+	if (loadFile == nullptr)
+		return;
+
+	std::string data;
+
+	if (!ReadFrame(*loadFile, data))
+		throw content_error("[LSH::ReadSection] save-file is truncated");
+
+	iss.str(std::move(data));
+	iss.clear();
+}
+
+void CCregLoadSaveHandler::CloseLoadFile()
+{
+	loadFile.reset();
+}
 
 #ifdef USING_CREG
 class CGameStateCollector
@@ -259,70 +425,90 @@ void CCregLoadSaveHandler::SaveGame(const std::string& path)
 	//     But isn't serialized - leak on load.
 	selectedUnitsHandler.ClearSelected();
 
-	try {
-		std::stringstream oss;
+	// an existing save is only replaced once the new one is complete
+	const std::string savePath = dataDirsAccess.LocateFile(path, FileQueryFlags::WRITE);
+	const std::string tmpPath = savePath + ".tmp";
+
+	gzFile file = gzopen(tmpPath.c_str(), "wb5");
+
+	if (file == nullptr) {
+		LOG_L(L_ERROR, "[LSH::%s] could not open save-file", __func__);
+		return;
+	}
 
-		// write our own header. SavePackage() will add its own
-		WriteString(oss, SpringVersion::GetSync());
-		WriteString(oss, gameSetup->setupText);
-		WriteString(oss, modName);
-		WriteString(oss, mapName);
+	// each section is serialized into its own buffer and handed over to be
+	// compressed while the next one is built, the full save never exists in
+	// memory (creg packages seek back to patch their header so can not be
+	// written to the compressor directly)
+	const auto writer = std::make_shared<CSaveStreamWriter>(file, tmpPath, savePath);
 
+	// need to keep a reference to the future around or its destructor will block
+	std::future<void> writerJob = std::async(std::launch::async, [writer]() { writer->Run(); });
 
+	writer->Push(std::string(SAVE_STREAM_FILE_ID, sizeof(SAVE_STREAM_FILE_ID)));
+
+	bool serialized = false;
+
+	try {
 		{
+			std::stringstream oss;
+
+			// write our own header. SavePackage() will add its own
+			WriteString(oss, SpringVersion::GetSync());
+			WriteString(oss, gameSetup->setupText);
+			WriteString(oss, modName);
+			WriteString(oss, mapName);
+			writer->WriteFrame(std::move(oss).str());
+		}
+		{
+			std::stringstream oss;
 			Sim::SaveComponents(oss);
-
+			writer->WriteFrame(std::move(oss).str());
+		}
+		{
 			creg::COutputStreamSerializer os;
 
 			// save lua state first as lua unit scripts depend on it
-			const int luaStart = oss.tellp();
-			SaveLuaState(luaGaia, os, oss);
-			SaveLuaState(luaRules, os, oss);
-			PrintSize("Lua", ((int)oss.tellp()) - luaStart);
+			int luaSize = 0;
+
+			for (CSplitLuaHandle* handle: {static_cast<CSplitLuaHandle*>(luaGaia), static_cast<CSplitLuaHandle*>(luaRules)}) {
+				std::stringstream oss;
+				SaveLuaState(handle, os, oss);
+				luaSize += oss.tellp();
+				writer->WriteFrame(std::move(oss).str());
+			}
+
+			PrintSize("Lua", luaSize);
 
 			// save creg state
-			const int gameStart = oss.tellp();
+			std::stringstream oss;
 			CGameStateCollector gsc;
 			os.SavePackage(&oss, &gsc, gsc.GetClass());
-			PrintSize("Game", ((int)oss.tellp()) - gameStart);
-
-
+			PrintSize("Game", oss.tellp());
+			writer->WriteFrame(std::move(oss).str());
+		}
+		{
 			// save AI state
-			const int aiStart = oss.tellp();
+			int aiSize = 0;
 
 			for (const auto& ai: skirmishAIHandler.GetAllSkirmishAIs()) {
+				std::stringstream oss;
 				std::stringstream aiData;
 				eoh->Save(&aiData, ai.first);
 
-				std::uint64_t aiSize = aiData.tellp();
-				creg::WriteUInt(&oss, aiSize);
-				if (aiSize > 0)
+				std::uint64_t aiDataSize = aiData.tellp();
+				creg::WriteUInt(&oss, aiDataSize);
+				if (aiDataSize > 0)
 					oss << aiData.rdbuf();
-			}
-			PrintSize("AIs", ((int)oss.tellp()) - aiStart);
-		}
-
-		{
-			gzFile file = gzopen(dataDirsAccess.LocateFile(path, FileQueryFlags::WRITE).c_str(), "wb5");
 
-			if (file == nullptr) {
-				LOG_L(L_ERROR, "[LSH::%s] could not open save-file", __func__);
-				return;
+				aiSize += oss.tellp();
+				writer->WriteFrame(std::move(oss).str());
 			}
-
-			std::string data = oss.str();
-			std::function<void(gzFile, std::string&&)> func = [](gzFile file, std::string&& data) {
-				gzwrite(file, data.c_str(), data.size());
-				gzflush(file, Z_FINISH);
-				gzclose(file);
-			};
-
-			// gzFile is just a plain typedef (struct gzFile_s {}* gzFile), can be copied
-			// need to keep a reference to the future around or its destructor will block
-			ThreadPool::AddExtJob(std::move(std::async(std::launch::async, std::move(func), file, std::move(data))));
+			PrintSize("AIs", aiSize);
 		}
 
 		//FIXME add lua state
+		serialized = true;
 	} catch (const content_error& ex) {
 		LOG_L(L_ERROR, "[LSH::%s] content error \"%s\"", __func__, ex.what());
 	} catch (const std::exception& ex) {
@@ -334,6 +520,9 @@ void CCregLoadSaveHandler::SaveGame(const std::string& path)
 	} catch (...) {
 		LOG_L(L_ERROR, "[LSH::%s] unknown error", __func__);
 	}
+
+	writer->Close(serialized);
+	ThreadPool::AddExtJob(std::move(writerJob));
 #else //USING_CREG
 	LOG_L(L_ERROR, "[LSH::%s] creg is disabled", __func__);
 #endif //USING_CREG
@@ -342,16 +531,34 @@ void CCregLoadSaveHandler::SaveGame(const std::string& path)
 /// loads the data (map&mod-name,setup-script) needed by PreGame
 bool CCregLoadSaveHandler::LoadGameStartInfo(const std::string& path)
 {
-	CGZFileHandler saveFile(dataDirsAccess.LocateFile(FindSaveFile(path)), SPRING_VFS_RAW_FIRST);
+	const std::string saveFilePath = dataDirsAccess.LocateFile(FindSaveFile(path));
 
-	std::stringbuf* sbuf = iss.rdbuf();
 	std::string saveVersion;
 	std::string syncVersion = SpringVersion::GetSync();
 
-	char buf[4096];
-	int len;
-	while ((len = saveFile.Read(buf, sizeof(buf))) > 0)
-		sbuf->sputn(buf, len);
+	char fileID[sizeof(SAVE_STREAM_FILE_ID)] = {0};
+
+	CloseLoadFile();
+
+	// the file is inflated as a whole either way; sections of streamed saves
+	// are then handed to iss one at a time while loading
+	loadFile = std::make_unique<CGZFileHandler>(saveFilePath, SPRING_VFS_RAW_FIRST);
+
+	if (loadFile->Read(fileID, sizeof(fileID)) == sizeof(fileID) && memcmp(fileID, SAVE_STREAM_FILE_ID, sizeof(fileID)) == 0) {
+		ReadSection();
+	} else {
+		// legacy save, the whole file is one section
+		loadFile->Seek(0);
+
+		std::stringbuf* sbuf = iss.rdbuf();
+
+		char buf[4096];
+		int len;
+		while ((len = loadFile->Read(buf, sizeof(buf))) > 0)
+			sbuf->sputn(buf, len);
+
+		CloseLoadFile();
+	}
 
 	ReadString(iss, saveVersion);
 
@@ -376,18 +583,22 @@ void CCregLoadSaveHandler::LoadGame()
 #ifdef USING_CREG
 	ENTER_SYNCED_CODE();
 	{
+		ReadSection();
 		Sim::LoadComponents(iss);
 
 		creg::CInputStreamSerializer inputStream;
 
 		// load lua state first, as lua unit scripts depend on it
+		ReadSection();
 		LoadLuaState(luaGaia, inputStream, iss);
+		ReadSection();
 		LoadLuaState(luaRules, inputStream, iss);
 
 		// load creg state
 		void* pGSC = nullptr;
 		creg::Class* gsccls = nullptr;
 
+		ReadSection();
 		inputStream.LoadPackage(&iss, pGSC, gsccls);
 		assert(pGSC && gsccls == CGameStateCollector::StaticClass());
 
@@ -411,6 +622,7 @@ void CCregLoadSaveHandler::LoadAIData()
 	// load ai state
 	for (const auto& ai: skirmishAIHandler.GetAllSkirmishAIs()) {
 		std::uint64_t aiSize;
+		ReadSection();
 		creg::ReadUInt(&iss, &aiSize);
 
 		std::vector<char> buffer(aiSize);
@@ -423,6 +635,7 @@ void CCregLoadSaveHandler::LoadAIData()
 
 	// cleanup
 	iss.str("");
+	CloseLoadFile();
 
 	gs->paused = false;
 	if (gameServer != nullptr) {
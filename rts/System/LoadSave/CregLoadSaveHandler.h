@@ -3,10 +3,14 @@
 #ifndef CREG_LOAD_SAVE_HANDLER_H
 #define CREG_LOAD_SAVE_HANDLER_H
 
+#include <memory>
 #include <string>
 #include <sstream>
+
 #include "LoadSaveHandler.h"
 
+class CGZFileHandler;
+
 class CCregLoadSaveHandler : public ILoadSaveHandler
 {
 public:
@@ -18,8 +22,16 @@ public:
 	void LoadAIData() override;
 	void SaveGame(const std::string& path) override;
 
+protected:
+	/// replaces iss by the next section of a streamed save, no-op for legacy ones
+	void ReadSection();
+	void CloseLoadFile();
+
 protected:
 	std::stringstream iss;
+
+	/// inflated save, kept while a streamed save is being loaded
+	std::unique_ptr<CGZFileHandler> loadFile;
 };
 
 #endif // CREG_LOAD_SAVE_HANDLER_H
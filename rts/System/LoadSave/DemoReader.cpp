@@ -15,6 +15,7 @@ CONFIG(bool, DisableDemoVersionCheck).defaultValue(false).description("Allow to
 #include "System/Log/ILog.h"
 #include "System/Net/RawPacket.h"
 
+#include <algorithm>
 #include <array>
 #include <climits>
 #include <stdexcept>
@@ -49,7 +50,7 @@ static bool CheckDemoHeader(const DemoFileHeader& fileHeader)
 }
 
 
-CDemoReader::CDemoReader(const std::string& filename, float curTime): playbackDemo(new CGZFileHandler(filename, SPRING_VFS_PWD_ALL))
+CDemoReader::CDemoReader(const std::string& filename, float curTime): playbackDemo(new CGZFileHandler(filename, SPRING_VFS_PWD_ALL, true))
 {
 	if (FileSystem::GetExtension(filename) != "sdfz")
 		throw content_error("Unknown demo extension: " + FileSystem::GetExtension(filename));
@@ -80,6 +81,10 @@ CDemoReader::CDemoReader(const std::string& filename, float curTime): playbackDe
 		playbackDemo->Read(const_cast<char*>(setupScript.data()), setupScript.size());
 	}
 
+#ifdef TOOLS
+	streamStartPos = playbackDemo->GetPos();
+#endif
+
 	playbackDemo->Read((char*)&chunkHeader, sizeof(chunkHeader));
 	chunkHeader.swab();
 
@@ -99,6 +104,12 @@ CDemoReader::CDemoReader(const std::string& filename, float curTime): playbackDe
 		// (if this had still used CFileHandler that would have been easier ;-))
 		bytesRemaining = playbackDemoSize - curPos;
 	}
+
+#ifdef TOOLS
+	streamSize = bytesRemaining;
+
+	LoadKeyFrameIndex();
+#endif
 	playbackDemo->Seek(curPos);
 }
 
@@ -147,12 +158,94 @@ netcode::RawPacket* CDemoReader::GetData(const float readTime)
 	return nullptr;
 }
 
+#ifdef TOOLS
+int CDemoReader::SeekToFrame(int frameNum)
+{
+	// last indexed chunk at or before frameNum; if there is none, rewind to the start
+	const auto cmp = [](int n, const DemoKeyFrameIndexEntry& e) { return (n < e.frameNum); };
+	const auto iter = std::upper_bound(keyFrameIndex.begin(), keyFrameIndex.end(), frameNum, cmp);
+
+	if (iter == keyFrameIndex.begin()) {
+		SeekToStreamOffset(0);
+		return 0;
+	}
+
+	SeekToStreamOffset((iter - 1)->streamOffset);
+	return ((iter - 1)->frameNum);
+}
+
+bool CDemoReader::SeekToStreamOffset(std::uint32_t streamOffset)
+{
+	playbackDemo->Seek(streamStartPos + streamOffset);
+
+	if (playbackDemo->Read((char*)&chunkHeader, sizeof(chunkHeader)) < sizeof(chunkHeader)) {
+		bytesRemaining = 0;
+		return false;
+	}
+
+	chunkHeader.swab();
+
+	// same accounting as in the ctor
+	nextDemoReadTime = chunkHeader.modGameTime + demoTimeOffset;
+	bytesRemaining = streamSize - streamOffset;
+	return true;
+}
+
+std::uint32_t CDemoReader::GetStreamOffset() const
+{
+	return (playbackDemo->GetPos() - streamStartPos - sizeof(chunkHeader));
+}
+#endif
+
+
 bool CDemoReader::ReachedEnd()
 {
 	return (bytesRemaining <= 0 || playbackDemo->Eof() || (playbackDemo->GetPos() > playbackDemoSize));
 }
 
 
+#ifdef TOOLS
+void CDemoReader::LoadKeyFrameIndex()
+{
+	// index is not available if Spring crashed while writing the demo (or
+	// if it was recorded without one)
+	if (fileHeader.demoStreamSize == 0)
+		return;
+
+	DemoKeyFrameIndexFooter footer;
+
+	const int footerPos = playbackDemoSize - sizeof(footer);
+
+	if (footerPos < (streamStartPos + fileHeader.demoStreamSize))
+		return;
+
+	playbackDemo->Seek(footerPos);
+	playbackDemo->Read(reinterpret_cast<char*>(&footer), sizeof(footer));
+	footer.swab();
+
+	if (memcmp(footer.magic, DEMOFILE_KEYFRAME_INDEX_MAGIC, sizeof(footer.magic)) != 0)
+		return;
+	if (footer.numEntries > ((footerPos - streamStartPos - fileHeader.demoStreamSize) / sizeof(DemoKeyFrameIndexEntry)))
+		return;
+
+	keyFrameIndex.resize(footer.numEntries);
+
+	playbackDemo->Seek(footerPos - footer.numEntries * sizeof(DemoKeyFrameIndexEntry));
+	playbackDemo->Read(reinterpret_cast<char*>(keyFrameIndex.data()), footer.numEntries * sizeof(DemoKeyFrameIndexEntry));
+
+	for (DemoKeyFrameIndexEntry& entry: keyFrameIndex) {
+		entry.swab();
+	}
+
+	// drop anything not pointing into the stream, the rest must stay sorted for SeekToFrame
+	const auto pred = [&](const DemoKeyFrameIndexEntry& e) { return (e.streamOffset >= static_cast<std::uint32_t>(fileHeader.demoStreamSize)); };
+	keyFrameIndex.erase(std::remove_if(keyFrameIndex.begin(), keyFrameIndex.end(), pred), keyFrameIndex.end());
+
+	numFrames = footer.numFrames;
+}
+#endif
+
+
 void CDemoReader::LoadStats()
 {
 	// Stats are not available if Spring crashed while writing the demo.
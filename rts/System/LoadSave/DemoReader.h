@@ -39,6 +39,27 @@ public:
 	*/
 	bool ReachedEnd();
 
+#ifdef TOOLS
+	// the keyframe index is for tools only; the server (e.g. when skipping)
+	// has to send every packet in front of the target frame anyway
+
+	/**
+	@brief Reposition the demo stream using the keyframe index
+	@return number of frame packets in front of the new position, which is the last
+	        indexed one at or before frameNum (or the start of the stream without an index)
+	The next GetData call returns the chunk at the new position; this works in both
+	directions, but it is up to the caller to make sense of the skipped packets.
+	*/
+	int SeekToFrame(int frameNum);
+
+	bool HasKeyFrameIndex() const { return (numFrames >= 0); }
+	const std::vector<DemoKeyFrameIndexEntry>& GetKeyFrameIndex() const { return keyFrameIndex; }
+	/// total number of frame packets in the stream, -1 if unknown (no index)
+	int GetNumFrames() const { return numFrames; }
+	/// offset of the next chunk to be read, relative to the start of the demo stream
+	std::uint32_t GetStreamOffset() const;
+#endif
+
 	float GetModGameTime() const { return chunkHeader.modGameTime; }
 	float GetDemoTimeOffset() const { return demoTimeOffset; }
 	float GetNextDemoReadTime() const { return nextDemoReadTime; }
@@ -55,6 +76,12 @@ public:
 	/// Not needed for normal demo watching
 	void LoadStats();
 
+private:
+#ifdef TOOLS
+	void LoadKeyFrameIndex();
+	bool SeekToStreamOffset(std::uint32_t streamOffset);
+#endif
+
 private:
 	CFileHandler* playbackDemo;
 
@@ -62,6 +89,11 @@ private:
 	float nextDemoReadTime;
 	int bytesRemaining;
 	int playbackDemoSize;
+#ifdef TOOLS
+	int streamStartPos;
+	int streamSize;
+	int numFrames = -1;
+#endif
 
 	DemoStreamChunkHeader chunkHeader;
 
@@ -70,6 +102,9 @@ private:
 	std::vector<PlayerStatistics> playerStats; // one stat per player
 	std::vector< std::vector<TeamStatistics> > teamStats; // many stats per team
 	std::vector<unsigned char> winningAllyTeams;
+#ifdef TOOLS
+	std::vector<DemoKeyFrameIndexEntry> keyFrameIndex;
+#endif
 };
 
 #endif
@@ -1,14 +1,21 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
+#include <array>
 #include <cassert>
 #include <cerrno>
+#include <cstdio>
 #include <cstring>
+#include <deque>
+#include <future>
 #include <memory>
+#include <zlib.h>
 
 #include "DemoRecorder.h"
 #include "base64.h"
 #include "Game/GameVersion.h"
+#include "Net/Protocol/NetMessageTypes.h"
 #include "Sim/Misc/TeamStatistics.h"
+#include "System/Config/ConfigHandler.h"
 #include "System/TimeUtil.h"
 #include "System/StringUtil.h"
 #include "System/FileSystem/DataDirsAccess.h"
@@ -26,43 +33,213 @@
 #undef GetCurrentTime
 #endif
 
+CONFIG(int, DemoKeyFrameIndexInterval)
+	.defaultValue(0)
+	.minimumValue(0)
+	.description("Number of sim-frames between entries of the keyframe index appended to recorded demos, which lets readers seek within them. 0 disables the index, 900 (30 seconds) is a reasonable interval.");
+
+
+// stream data is handed to the writer thread in blocks of this size; each
+// becomes a separate gzip member so that everything up to the last written
+// block stays readable if the engine dies mid-game
+static constexpr size_t DEMO_STREAM_BLOCK_SIZE = 1024 * 1024;
+
+// gzip member header followed by the header of a single stored deflate block
+static constexpr size_t DEMO_HEADER_MEMBER_PREFIX_SIZE = 10 + 5;
+
+
+/// compresses the demo on a worker thread while the game runs, appending
+/// to the file block by block; the DemoFileHeader is kept uncompressed in
+/// a stored gzip member at the start so it can be patched in place
+class CDemoStreamWriter
+{
+public:
+	static CDemoStreamWriter* Open(const std::string& fileName) {
+		FILE* file = fopen(fileName.c_str(), "wb");
+
+		if (file == nullptr)
+			return nullptr;
+
+		CDemoStreamWriter* writer = new CDemoStreamWriter(file);
+
+		// the worker owns the writer once started, Close hands back its future
+		writer->worker = std::async(std::launch::async, [writer]() {
+			std::unique_ptr<CDemoStreamWriter> owner(writer);
+			owner->Run();
+		});
+
+		return writer;
+	}
+
+	void WriteHeader(const char* data, size_t size) {
+		Push(std::string(data, size), true);
+	}
+
+	void Write(const void* data, size_t size) {
+		block.append(reinterpret_cast<const char*>(data), size);
+
+		if (block.size() < DEMO_STREAM_BLOCK_SIZE)
+			return;
+
+		Push(std::move(block), false);
+
+		block.clear();
+		block.reserve(DEMO_STREAM_BLOCK_SIZE);
+	}
+
+	/// the writer deletes itself once the returned future is ready
+	std::future<void> Close() {
+		if (!block.empty())
+			Push(std::move(block), false);
+
+		std::future<void> job;
+
+		{
+			std::unique_lock<spring::mutex> lock(mutex);
+
+			job = std::move(worker);
+			closed = true;
+			cond.notify_all();
+		}
+
+		return job;
+	}
+
+private:
+	explicit CDemoStreamWriter(FILE* f): file(f) { block.reserve(DEMO_STREAM_BLOCK_SIZE); }
+
+	void Push(std::string&& data, bool isHeader) {
+		std::unique_lock<spring::mutex> lock(mutex);
+
+		jobs.emplace_back(std::move(data), isHeader);
+		cond.notify_all();
+	}
+
+	void Run() {
+		while (true) {
+			std::pair<std::string, bool> job;
+
+			{
+				std::unique_lock<spring::mutex> lock(mutex);
+				cond.wait(lock, [&]() { return (!jobs.empty() || closed); });
+
+				if (jobs.empty())
+					break;
+
+				job = std::move(jobs.front());
+				jobs.pop_front();
+			}
+
+			if (!(job.second? WriteHeaderMember(job.first): WriteBlockMember(job.first)) && !failed) {
+				LOG_L(L_ERROR, "[DemoStreamWriter::%s] error writing demo-file (errno %d)", __func__, errno);
+				failed = true;
+			}
+		}
+
+		fclose(file);
+	}
+
+	bool WriteHeaderMember(const std::string& data) {
+		const std::uint32_t crc = crc32(0, reinterpret_cast<const Bytef*>(data.data()), data.size());
+		const std::uint16_t len = data.size();
+
+		std::array<unsigned char, DEMO_HEADER_MEMBER_PREFIX_SIZE> prefix = {
+			0x1f, 0x8b, Z_DEFLATED, 0, // magic, method, flags
+			0, 0, 0, 0, 0, 0xff,       // mtime, xfl, os
+			0x01,                      // final stored block
+			std::uint8_t(len), std::uint8_t(len >> 8), std::uint8_t(~len), std::uint8_t(~len >> 8),
+		};
+		std::array<unsigned char, 8> suffix;
+
+		for (size_t i = 0; i < 4; i++) {
+			suffix[i    ] = std::uint8_t(crc >> (i * 8));
+			suffix[i + 4] = std::uint8_t(data.size() >> (i * 8));
+		}
+
+		// the header is always the same size, overwrite the previous one
+		bool ret = (fseek(file, 0, SEEK_SET) == 0);
+		ret = ret && (fwrite(prefix.data(), prefix.size(), 1, file) == 1);
+		ret = ret && (fwrite(data.data(), data.size(), 1, file) == 1);
+		ret = ret && (fwrite(suffix.data(), suffix.size(), 1, file) == 1);
+		ret = ret && (fseek(file, 0, SEEK_END) == 0);
+		return (ret && fflush(file) == 0);
+	}
+
+	bool WriteBlockMember(const std::string& data) {
+		z_stream zs;
+		memset(&zs, 0, sizeof(zs));
+
+		// +16 writes a gzip wrapper, concatenated members read back as one stream
+		if (deflateInit2(&zs, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+			return false;
+
+		outBuffer.resize(deflateBound(&zs, data.size()));
+
+		zs.next_in = reinterpret_cast<Bytef*>(const_cast<char*>(data.data()));
+		zs.avail_in = data.size();
+		zs.next_out = outBuffer.data();
+		zs.avail_out = outBuffer.size();
+
+		const bool ret = (deflate(&zs, Z_FINISH) == Z_STREAM_END);
+		const size_t outSize = zs.total_out;
+
+		deflateEnd(&zs);
+		return (ret && fwrite(outBuffer.data(), outSize, 1, file) == 1 && fflush(file) == 0);
+	}
+
+private:
+	spring::mutex mutex;
+	spring::condition_variable cond;
+
+	std::deque< std::pair<std::string, bool> > jobs;
+	std::future<void> worker;
+
+	std::string block;
+	std::vector<Bytef> outBuffer;
+
+	FILE* file;
+
+	bool closed = false;
+	bool failed = false;
+};
 
-// server and client memory-streams
-static std::string demoStreams[2];
-static spring::mutex demoMutex;
 
 
 CDemoRecorder::CDemoRecorder(const std::string& mapName, const std::string& modName, bool serverDemo): isServerDemo(serverDemo)
 {
-	std::lock_guard<spring::mutex> lock(demoMutex);
+	keyFrameInterval = configHandler->GetInt("DemoKeyFrameIndexInterval");
 
-	SetStream();
 	SetName(mapName, modName);
 	SetFileHeader();
-	WriteFileHeader(false);
 
-	file = gzopen(demoName.c_str(), "wb9");
+	if ((writer = CDemoStreamWriter::Open(demoName)) == nullptr) {
+		LOG_L(L_ERROR, "[DemoRecorder::%s] could not open demo-file \"%s\" (errno %d)", __func__, demoName.c_str(), errno);
+		return;
+	}
+
+	WriteFileHeader(false);
 }
 
 CDemoRecorder::~CDemoRecorder()
 {
-	if (file == nullptr)
+	if (writer == nullptr)
 		return;
 
 	WriteWinnerList();
 	WritePlayerStats();
 	WriteTeamStats();
+	WriteKeyFrameIndex();
 	WriteFileHeader(true);
-	WriteDemoFile();
-}
 
+	LOG("[DemoRecorder::%s] finishing %s-demo \"%s\"", __func__, (isServerDemo? "server": "client"), demoName.c_str());
 
-void CDemoRecorder::SetStream()
-{
-	demoStreams[isServerDemo].clear();
-	demoStreams[isServerDemo].reserve(8 * 1024 * 1024);
+	// only the last block is left to compress, do not wait for it
+	// NOTE: can not use ThreadPool for this directly here, workers are already gone
+	ThreadPool::AddExtJob(writer->Close());
+	writer = nullptr;
 }
 
+
 void CDemoRecorder::SetFileHeader()
 {
 	memset(&fileHeader, 0, sizeof(DemoFileHeader));
@@ -77,31 +254,13 @@ void CDemoRecorder::SetFileHeader()
 	fileHeader.winningAllyTeamsSize = 0;
 }
 
-void CDemoRecorder::WriteDemoFile()
+void CDemoRecorder::Write(const void* data, size_t size)
 {
-	// zlib FAQ claims the lib is thread-safe, "however any library routines that zlib uses and
-	// any application-provided memory allocation routines must also be thread-safe. zlib's gz*
-	// functions use stdio library routines, and most of zlib's functions use the library memory
-	// allocation routines by default" (so code below should be OK)
-	// gz* should usually be finished before ctor runs again when reloading, but take no chances
-	std::string& data = demoStreams[isServerDemo];
-	std::function<void(gzFile, std::string&)> func = [](gzFile file, std::string& data) {
-		std::lock_guard<spring::mutex> lock(demoMutex);
-
-		gzwrite(file, data.c_str(), data.size());
-		gzflush(file, Z_FINISH);
-		gzclose(file);
-	};
-
-	LOG("[DemoRecorder::%s] writing %s-demo \"%s\" (" _STPF_ " bytes)", __func__, (isServerDemo? "server": "client"), demoName.c_str(), data.size());
-
-	#ifndef _WIN32
-	// NOTE: can not use ThreadPool for this directly here, workers are already gone
-	// FIXME: does not currently (august 2017) compile on Windows mingw buildbots
-	ThreadPool::AddExtJob(spring::thread(std::move(func), file, std::ref(data)));
-	#else
-	ThreadPool::AddExtJob(std::move(std::async(std::launch::async, std::move(func), file, std::ref(data))));
-	#endif
+	// demo-file could not be opened, callers do not check IsValid
+	if (writer == nullptr)
+		return;
+
+	writer->Write(data, size);
 }
 
 void CDemoRecorder::WriteSetupText(const std::string& text)
@@ -120,7 +279,10 @@ void CDemoRecorder::WriteSetupText(const std::string& text)
 	}
 
 	fileHeader.scriptSize = length;
-	demoStreams[isServerDemo].append(text.c_str(), length);
+	Write(text.c_str(), length);
+
+	// keep the on-disk header usable should the game never end cleanly
+	WriteFileHeader(false);
 }
 
 void CDemoRecorder::SaveToDemo(const unsigned char* buf, const unsigned length, const float modGameTime)
@@ -130,8 +292,17 @@ void CDemoRecorder::SaveToDemo(const unsigned char* buf, const unsigned length,
 	chunkHeader.modGameTime = modGameTime;
 	chunkHeader.length = length;
 	chunkHeader.swab();
-	demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&chunkHeader), sizeof(chunkHeader));
-	demoStreams[isServerDemo].append(reinterpret_cast<const char*>(buf), length);
+
+	if (length > 0 && (buf[0] == NETMSG_NEWFRAME || buf[0] == NETMSG_KEYFRAME)) {
+		// index the chunk by the number of frames in front of it
+		if (keyFrameInterval > 0 && numFramePackets > 0 && (numFramePackets % keyFrameInterval) == 0)
+			keyFrameIndex.push_back({numFramePackets, modGameTime, static_cast<std::uint32_t>(fileHeader.demoStreamSize)});
+
+		numFramePackets++;
+	}
+
+	Write(&chunkHeader, sizeof(chunkHeader));
+	Write(buf, length);
 	fileHeader.demoStreamSize += (length + sizeof(chunkHeader));
 }
 
@@ -229,10 +400,13 @@ void CDemoRecorder::SetWinningAllyTeams(const std::vector<unsigned char>& winnin
 }
 
 /** @brief Write DemoFileHeader
-Write the DemoFileHeader at the start of the file and restores the original
-position in the file afterwards. */
-unsigned int CDemoRecorder::WriteFileHeader(bool updateStreamLength)
+Patches the DemoFileHeader at the start of the file; demoStreamSize stays 0
+until the demo is finished, which marks it as crashed (see demofile.h). */
+void CDemoRecorder::WriteFileHeader(bool updateStreamLength)
 {
+	if (writer == nullptr)
+		return;
+
 	DemoFileHeader tmpHeader;
 	memcpy(&tmpHeader, &fileHeader, sizeof(fileHeader));
 
@@ -242,28 +416,19 @@ unsigned int CDemoRecorder::WriteFileHeader(bool updateStreamLength)
 	// to little endian
 	tmpHeader.swab();
 
-	if (demoStreams[isServerDemo].empty()) {
-		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&tmpHeader), sizeof(tmpHeader));
-	} else {
-		assert(demoStreams[isServerDemo].size() >= sizeof(tmpHeader));
-		memcpy(&demoStreams[isServerDemo][0], reinterpret_cast<const char*>(&tmpHeader), sizeof(tmpHeader)); // no non-const .data() until C++17
-	}
-
-	return (demoStreams[isServerDemo].size());
+	writer->WriteHeader(reinterpret_cast<const char*>(&tmpHeader), sizeof(tmpHeader));
 }
 
 /** @brief Write the CPlayer::Statistics at the current position in the file. */
 void CDemoRecorder::WritePlayerStats()
 {
-	const size_t pos = demoStreams[isServerDemo].size();
-
 	for (PlayerStatistics& stats: playerStats) {
 		stats.swab();
-		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&stats), sizeof(PlayerStatistics));
+		Write(&stats, sizeof(PlayerStatistics));
 	}
 
 	fileHeader.numPlayers = playerStats.size();
-	fileHeader.playerStatSize = int(demoStreams[isServerDemo].size() - pos);
+	fileHeader.playerStatSize = int(playerStats.size() * sizeof(PlayerStatistics));
 
 	playerStats.clear();
 }
@@ -276,38 +441,59 @@ void CDemoRecorder::WriteWinnerList()
 	if (fileHeader.numTeams == 0)
 		return;
 
-	const size_t pos = demoStreams[isServerDemo].size();
-
 	// Write the array of winningAllyTeams.
 	for (size_t i = 0; i < winningAllyTeams.size(); i++) { // NOLINT{modernize-loop-convert}
-		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&winningAllyTeams[i]), sizeof(unsigned char));
+		Write(&winningAllyTeams[i], sizeof(unsigned char));
 	}
 
-	winningAllyTeams.clear();
+	fileHeader.winningAllyTeamsSize = int(winningAllyTeams.size() * sizeof(unsigned char));
 
-	fileHeader.winningAllyTeamsSize = int(demoStreams[isServerDemo].size() - pos);
+	winningAllyTeams.clear();
 }
 
 /** @brief Write the TeamStatistics at the current position in the file. */
 void CDemoRecorder::WriteTeamStats()
 {
-	const size_t pos = demoStreams[isServerDemo].size();
+	size_t size = 0;
 
 	// Write array of dwords indicating number of TeamStatistics per team.
 	for (std::vector<TeamStatistics>& history: teamStats) {
 		unsigned int c = swabDWord(history.size());
-		demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&c), sizeof(unsigned int));
+		Write(&c, sizeof(unsigned int));
+		size += sizeof(unsigned int);
 	}
 
 	// Write big array of TeamStatistics.
 	for (std::vector<TeamStatistics>& history: teamStats) {
 		for (TeamStatistics& stats: history) {
 			stats.swab();
-			demoStreams[isServerDemo].append(reinterpret_cast<const char*>(&stats), sizeof(TeamStatistics));
+			Write(&stats, sizeof(TeamStatistics));
+			size += sizeof(TeamStatistics);
 		}
 	}
 
-	fileHeader.teamStatSize = int(demoStreams[isServerDemo].size() - pos);
+	fileHeader.teamStatSize = int(size);
 
 	teamStats.clear();
 }
+
+/** @brief Write the keyframe index and its footer at the end of the file. */
+void CDemoRecorder::WriteKeyFrameIndex()
+{
+	if (keyFrameInterval <= 0)
+		return;
+
+	for (DemoKeyFrameIndexEntry& entry: keyFrameIndex) {
+		entry.swab();
+		Write(&entry, sizeof(DemoKeyFrameIndexEntry));
+	}
+
+	DemoKeyFrameIndexFooter footer;
+	footer.numEntries = keyFrameIndex.size();
+	footer.numFrames = numFramePackets;
+	memcpy(footer.magic, DEMOFILE_KEYFRAME_INDEX_MAGIC, sizeof(footer.magic));
+	footer.swab();
+	Write(&footer, sizeof(footer));
+
+	keyFrameIndex.clear();
+}
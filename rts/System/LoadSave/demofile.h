@@ -23,6 +23,9 @@
  */
 #define DEMOFILE_VERSION 5
 
+/** Magic of the optional keyframe index footer at the very end of a demofile. */
+#define DEMOFILE_KEYFRAME_INDEX_MAGIC "sdkfidx"
+
 #pragma pack(push, 1)
 
 /**
@@ -40,6 +43,9 @@
  *         CTeam::Statistics for each team.
  *       - Array of all CTeam::Statistics (total number of items is the
  *         sum of the elements in the array of dwords).
+ *     - Keyframe index (optional), consisting of:
+ *       - Array of numEntries DemoKeyFrameIndexEntry
+ *       - DemoKeyFrameIndexFooter, always the last bytes of the file.
  *
  * The header is designed to be extensible: it contains a version field and a
  * headerSize field to support this. The version field is a major version number
@@ -49,6 +55,9 @@
  *
  * If Spring did not cleanup properly (crashed), the demoStreamSize is 0 and it
  * can be assumed the demo stream continues until the end of the file.
+ *
+ * The file is gzip compressed as a series of concatenated gzip members, which
+ * readers must treat as a single stream (zlib's gzread and most tools do).
  */
 struct DemoFileHeader
 {
@@ -115,6 +124,45 @@ struct DemoStreamChunkHeader
 	}
 };
 
+/**
+ * @brief Spring demo keyframe index entry
+ *
+ * Marks the chunk of a NETMSG_NEWFRAME or NETMSG_KEYFRAME packet in the demo
+ * stream, so readers can reposition the stream without parsing every chunk
+ * in front of it. Readers that do not know about the index ignore it.
+ */
+struct DemoKeyFrameIndexEntry
+{
+	int frameNum;                 ///< Number of frame packets in the stream before this chunk.
+	float modGameTime;            ///< Gametime of the chunk, equal to its DemoStreamChunkHeader::modGameTime.
+	std::uint32_t streamOffset;   ///< Offset of the chunk header, relative to the start of the demo stream.
+
+	/// Change structure from host endian to little endian or vice versa.
+	void swab() {
+		swabDWordInPlace(frameNum);
+		swabFloatInPlace(modGameTime);
+		swabDWordInPlace(streamOffset);
+	}
+};
+
+/**
+ * @brief Spring demo keyframe index footer
+ *
+ * Follows the index entries; the index is only valid if magic matches.
+ */
+struct DemoKeyFrameIndexFooter
+{
+	std::uint32_t numEntries;     ///< Number of DemoKeyFrameIndexEntry in front of the footer.
+	int numFrames;                ///< Total number of frame packets in the demo stream.
+	char magic[8];                ///< DEMOFILE_KEYFRAME_INDEX_MAGIC
+
+	/// Change structure from host endian to little endian or vice versa.
+	void swab() {
+		swabDWordInPlace(numEntries);
+		swabDWordInPlace(numFrames);
+	}
+};
+
 #pragma pack(pop)
 
 #endif // DEMO_FILE_H
@@ -1,19 +1,107 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
 #include <string.h>
+#include <array>
+#include <new>
 #include <stdexcept>
 
 #include "RawPacket.h"
 
 #include "System/Log/ILog.h"
+#include "System/Threading/SpringThreading.h"
 
 namespace netcode
 {
 
+// anything larger than the last class goes straight to the heap
+static constexpr std::array<size_t, 8> POOL_SIZE_CLASSES = {32, 64, 128, 256, 512, 1024, 2048, 4096};
+// free blocks kept per class beyond which frees go back to the heap
+static constexpr size_t POOL_MAX_FREE_BYTES = 1024 * 1024;
+
+struct PoolFreeBlock {
+	PoolFreeBlock* next;
+};
+
+struct PoolSizeClass {
+	spring::spinlock lock;
+
+	PoolFreeBlock* freeList;
+	size_t numFree;
+};
+
+// trivially destructible, so packets can still be freed during static destruction
+static PoolSizeClass poolSizeClasses[POOL_SIZE_CLASSES.size()];
+
+
+static size_t GetSizeClass(size_t size)
+{
+	size_t idx = 0;
+
+	while (idx < POOL_SIZE_CLASSES.size() && POOL_SIZE_CLASSES[idx] < size)
+		idx++;
+
+	return idx;
+}
+
+void* RawPacket::AllocMem(size_t size)
+{
+	const size_t idx = GetSizeClass(size);
+
+	if (idx == POOL_SIZE_CLASSES.size())
+		return ::operator new(size);
+
+	PoolSizeClass& sc = poolSizeClasses[idx];
+
+	{
+		std::lock_guard<spring::spinlock> lock(sc.lock);
+
+		if (sc.freeList != nullptr) {
+			PoolFreeBlock* block = sc.freeList;
+
+			sc.freeList = block->next;
+			sc.numFree -= 1;
+			return block;
+		}
+	}
+
+	return ::operator new(POOL_SIZE_CLASSES[idx]);
+}
+
+void RawPacket::FreeMem(void* p, size_t size)
+{
+	if (p == nullptr)
+		return;
+
+	const size_t idx = GetSizeClass(size);
+
+	if (idx == POOL_SIZE_CLASSES.size()) {
+		::operator delete(p);
+		return;
+	}
+
+	PoolSizeClass& sc = poolSizeClasses[idx];
+
+	{
+		std::lock_guard<spring::spinlock> lock(sc.lock);
+
+		if ((sc.numFree * POOL_SIZE_CLASSES[idx]) < POOL_MAX_FREE_BYTES) {
+			PoolFreeBlock* block = static_cast<PoolFreeBlock*>(p);
+
+			block->next = sc.freeList;
+			sc.freeList = block;
+			sc.numFree += 1;
+			return;
+		}
+	}
+
+	::operator delete(p);
+}
+
+
 RawPacket::RawPacket(const uint8_t* const tdata, const uint32_t newLength): length(newLength)
 {
 	if (length > 0) {
-		data = new uint8_t[length];
+		data = static_cast<uint8_t*>(AllocMem(length));
 		memcpy(data, tdata, length);
 	} else {
 		LOG_L(L_ERROR, "[%s] tried to pack a zero-length packet", __func__);
@@ -6,6 +6,7 @@
 #include <cassert>
 #include <cstdint>
 #include <cstring>
+#include <memory>
 #include <utility>
 
 #include <string>
@@ -19,6 +20,9 @@ namespace netcode
 
 /**
  * @brief simple structure to hold some data
+ *
+ * Packets and their payloads are allocated from a size-class pool shared by
+ * all threads, since the netcode creates and drops them at a high rate.
  */
 class RawPacket
 {
@@ -40,7 +44,7 @@ public:
 		if (length == 0)
 			return;
 
-		data = new uint8_t[length];
+		data = static_cast<uint8_t*>(AllocMem(length));
 	}
 
 	RawPacket(const uint32_t length, uint8_t msgID): RawPacket(length) {
@@ -56,6 +60,8 @@ public:
 	RawPacket& operator = (const RawPacket&  p) = delete;
 	RawPacket& operator = (      RawPacket&& p) {
 		// assume no self-assignment
+		Delete();
+
 		data = p.data;
 		p.data = nullptr;
 
@@ -117,12 +123,20 @@ public:
 		if (length == 0)
 			return;
 
-		delete[] data;
+		FreeMem(data, length);
 		data = nullptr;
 
 		length = 0;
 	}
 
+
+	static void* operator new(size_t size) { return AllocMem(size); }
+	static void operator delete(void* p, size_t size) { FreeMem(p, size); }
+
+	/// pooled storage for packets, payloads and their shared_ptr control blocks
+	static void* AllocMem(size_t size);
+	static void FreeMem(void* p, size_t size);
+
 public:
 	uint8_t id = 0;
 	uint8_t* data = nullptr;
@@ -131,6 +145,27 @@ public:
 	uint32_t length = 0;
 };
 
+
+/// std allocator interface on top of RawPacket's pool
+template<typename T> struct RawPacketAllocator {
+	using value_type = T;
+
+	RawPacketAllocator() = default;
+	template<typename U> RawPacketAllocator(const RawPacketAllocator<U>&) {}
+
+	T* allocate(size_t n) { return static_cast<T*>(RawPacket::AllocMem(n * sizeof(T))); }
+	void deallocate(T* p, size_t n) { RawPacket::FreeMem(p, n * sizeof(T)); }
+
+	template<typename U> bool operator == (const RawPacketAllocator<U>&) const { return true; }
+	template<typename U> bool operator != (const RawPacketAllocator<U>&) const { return false; }
+};
+
+/// takes ownership of a packet, drawing the control block from the pool as well
+inline std::shared_ptr<const RawPacket> MakeSharedPacket(const RawPacket* p)
+{
+	return std::shared_ptr<const RawPacket>(p, std::default_delete<const RawPacket>(), RawPacketAllocator<RawPacket>());
+}
+
 } // namespace netcode
 
 #endif // RAW_PACKET_H
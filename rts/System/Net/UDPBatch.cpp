@@ -0,0 +1,200 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "UDPBatch.h"
+
+#include <cerrno>
+#include <cstring>
+#include <asio.hpp>
+
+#include "Socket.h"
+
+namespace netcode
+{
+
+UDPBatch::UDPBatch(std::shared_ptr<asio::ip::udp::socket> s): socket(std::move(s))
+{
+	sendData.resize(MAX_DATAGRAMS * MAX_DATAGRAM_SIZE, 0);
+	recvData.resize(MAX_DATAGRAMS * MAX_DATAGRAM_SIZE, 0);
+
+	sendSizes.fill(0);
+	recvSizes.fill(0);
+	sentBytesCounters.fill(nullptr);
+	sentDatagramsCounters.fill(nullptr);
+
+#ifdef __linux__
+	memset(msgs.data(), 0, sizeof(msgs));
+	memset(iovecs.data(), 0, sizeof(iovecs));
+	memset(recvNames.data(), 0, sizeof(recvNames));
+#endif
+}
+
+
+void UDPBatch::Send(
+	const std::vector<std::uint8_t>& data,
+	const asio::ip::udp::endpoint& to,
+	unsigned int* sentBytes,
+	unsigned int* sentDatagrams
+) {
+	if (data.size() > MAX_DATAGRAM_SIZE) {
+		// never larger than the MTU, but do not lose it if it is
+		asio::error_code err;
+		socket->send_to(asio::buffer(data), to, 0, err);
+		CheckErrorCode(err);
+
+		numSendCalls += 1;
+
+		// not counted as sent even if CheckErrorCode tolerates it
+		if (err)
+			return;
+
+		numSentDatagrams += 1;
+
+		if (sentBytes != nullptr)
+			*sentBytes += data.size();
+		if (sentDatagrams != nullptr)
+			*sentDatagrams += 1;
+
+		return;
+	}
+
+	if (numQueued == MAX_DATAGRAMS)
+		Flush();
+
+	std::memcpy(&sendData[numQueued * MAX_DATAGRAM_SIZE], data.data(), data.size());
+	sendSizes[numQueued] = data.size();
+	sendAddrs[numQueued] = to;
+	sentBytesCounters[numQueued] = sentBytes;
+	sentDatagramsCounters[numQueued] = sentDatagrams;
+
+	numQueued += 1;
+
+	if (deferDepth == 0)
+		Flush();
+}
+
+void UDPBatch::Flush()
+{
+	if (numQueued == 0)
+		return;
+
+#ifdef __linux__
+	for (size_t i = 0; i < numQueued; i++) {
+		iovecs[i].iov_base = &sendData[i * MAX_DATAGRAM_SIZE];
+		iovecs[i].iov_len = sendSizes[i];
+
+		msghdr& hdr = msgs[i].msg_hdr;
+		memset(&hdr, 0, sizeof(hdr));
+
+		hdr.msg_name = sendAddrs[i].data();
+		hdr.msg_namelen = sendAddrs[i].size();
+		hdr.msg_iov = &iovecs[i];
+		hdr.msg_iovlen = 1;
+	}
+
+	for (size_t numSent = 0; numSent < numQueued; ) {
+		const int ret = ::sendmmsg(socket->native_handle(), &msgs[numSent], numQueued - numSent, 0);
+
+		numSendCalls += 1;
+
+		if (ret <= 0) {
+			// the datagram at numSent failed; UDP is lossy anyway, skip it
+			asio::error_code err(errno, asio::error::get_system_category());
+			CheckErrorCode(err);
+
+			numSent += 1;
+			continue;
+		}
+
+		for (const size_t end = numSent + ret; numSent < end; numSent++) {
+			CountSent(numSent);
+		}
+	}
+#else
+	for (size_t i = 0; i < numQueued; i++) {
+		asio::error_code err;
+		socket->send_to(asio::buffer(&sendData[i * MAX_DATAGRAM_SIZE], sendSizes[i]), sendAddrs[i], 0, err);
+		CheckErrorCode(err);
+
+		numSendCalls += 1;
+
+		if (err)
+			continue;
+
+		CountSent(i);
+	}
+#endif
+
+	numQueued = 0;
+}
+
+void UDPBatch::CountSent(size_t i)
+{
+	numSentDatagrams += 1;
+
+	if (sentBytesCounters[i] != nullptr)
+		*sentBytesCounters[i] += sendSizes[i];
+	if (sentDatagramsCounters[i] != nullptr)
+		*sentDatagramsCounters[i] += 1;
+}
+
+
+size_t UDPBatch::Receive()
+{
+	size_t numReceived = 0;
+
+#ifdef __linux__
+	for (size_t i = 0; i < MAX_DATAGRAMS; i++) {
+		iovecs[i].iov_base = &recvData[i * MAX_DATAGRAM_SIZE];
+		iovecs[i].iov_len = MAX_DATAGRAM_SIZE;
+
+		msghdr& hdr = msgs[i].msg_hdr;
+		memset(&hdr, 0, sizeof(hdr));
+
+		hdr.msg_name = &recvNames[i];
+		hdr.msg_namelen = sizeof(recvNames[i]);
+		hdr.msg_iov = &iovecs[i];
+		hdr.msg_iovlen = 1;
+	}
+
+	const int ret = ::recvmmsg(socket->native_handle(), msgs.data(), MAX_DATAGRAMS, MSG_DONTWAIT, nullptr);
+
+	numRecvCalls += 1;
+
+	if (ret < 0) {
+		asio::error_code err(errno, asio::error::get_system_category());
+
+		if (err != asio::error::would_block)
+			CheckErrorCode(err);
+
+		return 0;
+	}
+
+	for (numReceived = 0; numReceived < size_t(ret); numReceived++) {
+		const msghdr& hdr = msgs[numReceived].msg_hdr;
+
+		// truncated datagrams can not be valid packets, let the caller skip them
+		recvSizes[numReceived] = ((hdr.msg_flags & MSG_TRUNC) == 0)? msgs[numReceived].msg_len: 0;
+
+		std::memcpy(recvAddrs[numReceived].data(), &recvNames[numReceived], hdr.msg_namelen);
+		recvAddrs[numReceived].resize(hdr.msg_namelen);
+	}
+#else
+	while (numReceived < MAX_DATAGRAMS && socket->available() > 0) {
+		asio::error_code err;
+		const asio::mutable_buffer buf = asio::buffer(&recvData[numReceived * MAX_DATAGRAM_SIZE], MAX_DATAGRAM_SIZE);
+
+		recvSizes[numReceived] = socket->receive_from(buf, recvAddrs[numReceived], 0, err);
+		numRecvCalls += 1;
+
+		if (CheckErrorCode(err))
+			break;
+
+		numReceived += 1;
+	}
+#endif
+
+	numRecvDatagrams += numReceived;
+	return numReceived;
+}
+
+}
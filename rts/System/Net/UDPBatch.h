@@ -0,0 +1,107 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef _UDP_BATCH_H
+#define _UDP_BATCH_H
+
+#include "System/Misc/NonCopyable.h"
+
+#include <array>
+#include <cinttypes>
+#include <memory>
+#include <vector>
+#include <asio/ip/udp.hpp>
+
+#ifdef __linux__
+#include <sys/socket.h>
+#endif
+
+namespace netcode
+{
+
+/**
+ * @brief Batched datagram I/O on one UDP socket
+ * Gathers outgoing datagrams (from any number of connections sharing the
+ * socket) between BeginSend and EndSend and drains incoming ones into
+ * preallocated buffers, using one sendmmsg/recvmmsg call per batch on Linux
+ * and one socket call per datagram elsewhere.
+ */
+class UDPBatch : spring::noncopyable
+{
+public:
+	static constexpr size_t MAX_DATAGRAMS = 64;
+	static constexpr size_t MAX_DATAGRAM_SIZE = 4096;
+
+	explicit UDPBatch(std::shared_ptr<asio::ip::udp::socket> socket);
+
+	/// until the matching EndSend, Send only queues datagrams (calls may nest)
+	void BeginSend() { deferDepth += 1; }
+	void EndSend() {
+		if ((deferDepth -= 1) == 0)
+			Flush();
+	}
+
+	/**
+	 * @brief send (or queue) a datagram
+	 * sentBytes and sentDatagrams (if given) are incremented once it has
+	 * actually been sent, so they have to outlive the next Flush.
+	 */
+	void Send(
+		const std::vector<std::uint8_t>& data,
+		const asio::ip::udp::endpoint& to,
+		unsigned int* sentBytes = nullptr,
+		unsigned int* sentDatagrams = nullptr
+	);
+	/// send all queued datagrams
+	void Flush();
+
+	/**
+	 * @brief receive pending datagrams
+	 * Reads up to MAX_DATAGRAMS without blocking; returns how many were read
+	 * or 0 if none were pending or an error occured (which is logged).
+	 * Their contents stay valid until the next call.
+	 */
+	size_t Receive();
+
+	const std::uint8_t* GetData(size_t i) const { return &recvData[i * MAX_DATAGRAM_SIZE]; }
+	size_t GetSize(size_t i) const { return recvSizes[i]; }
+	const asio::ip::udp::endpoint& GetSender(size_t i) const { return recvAddrs[i]; }
+
+	size_t GetNumSendCalls() const { return numSendCalls; }
+	size_t GetNumRecvCalls() const { return numRecvCalls; }
+	size_t GetNumSentDatagrams() const { return numSentDatagrams; }
+	size_t GetNumRecvDatagrams() const { return numRecvDatagrams; }
+
+private:
+	std::shared_ptr<asio::ip::udp::socket> socket;
+
+	std::vector<std::uint8_t> sendData;
+	std::vector<std::uint8_t> recvData;
+
+	std::array<size_t, MAX_DATAGRAMS> sendSizes;
+	std::array<size_t, MAX_DATAGRAMS> recvSizes;
+	std::array<asio::ip::udp::endpoint, MAX_DATAGRAMS> sendAddrs;
+	std::array<asio::ip::udp::endpoint, MAX_DATAGRAMS> recvAddrs;
+	std::array<unsigned int*, MAX_DATAGRAMS> sentBytesCounters;
+	std::array<unsigned int*, MAX_DATAGRAMS> sentDatagramsCounters;
+
+#ifdef __linux__
+	std::array<mmsghdr, MAX_DATAGRAMS> msgs;
+	std::array<iovec, MAX_DATAGRAMS> iovecs;
+	std::array<sockaddr_storage, MAX_DATAGRAMS> recvNames;
+#endif
+
+	size_t numQueued = 0;
+	size_t deferDepth = 0;
+
+	size_t numSendCalls = 0;
+	size_t numRecvCalls = 0;
+	size_t numSentDatagrams = 0;
+	size_t numRecvDatagrams = 0;
+
+private:
+	void CountSent(size_t i);
+};
+
+}
+
+#endif // _UDP_BATCH_H
@@ -1,8 +1,11 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
 #include "UDPConnection.h"
+#include "UDPBatch.h"
 
 #include <cinttypes>
+#include <cstring>
+#include <zlib.h>
 
 
 #include "Socket.h"
@@ -24,10 +27,12 @@ CONFIG(bool, UDPConnectionLogDebugMessages).defaultValue(false);
 namespace netcode {
 using namespace asio;
 
-static constexpr unsigned udpMaxPacketSize = 4096;
+static constexpr unsigned udpMaxPacketSize = UDPConnection::MAX_MTU;
 static constexpr int maxChunkSize = 254;
 static constexpr int chunksPerSec = 30;
 
+static_assert(UDPBatch::MAX_DATAGRAM_SIZE >= udpMaxPacketSize, "batch buffers must hold the largest datagram");
+
 
 
 #if NETWORK_TEST
@@ -67,12 +72,12 @@ inline void EMULATE_PACKET_CORRUPTION(std::uint8_t& crc) {}
 	for (auto di = delayed.begin(); di != delayed.end(); ) { \
 		spring_time curtime = spring_gettime(); \
 		if (curtime > di->first && (curtime - di->first) > spring_msecs(0)) { \
-			mySocket->send_to(buffer(di->second), addr, flags, err); \
+			myBatch->Send(di->second, addr, &dataSent, &sentPackets); \
 			di = delayed.erase(di); \
 		} else { ++di; } \
 	} \
 	if (cond) \
-		delayed[spring_gettime() + spring_msecs(PACKET_MIN_LATENCY + (PACKET_MAX_LATENCY - PACKET_MIN_LATENCY) * RANDOM_NUMBER())] = data; \
+		delayed[spring_gettime() + spring_msecs(PACKET_MIN_LATENCY + (PACKET_MAX_LATENCY - PACKET_MIN_LATENCY) * RANDOM_NUMBER())] = sendBuffer; \
 	if (false)
 #else
 #define EMULATE_LATENCY(cond) if(cond)
@@ -231,10 +236,11 @@ void Packet::Serialize(std::vector<std::uint8_t>& data)
 
 
 
-UDPConnection::UDPConnection(std::shared_ptr<ip::udp::socket> netSocket, const ip::udp::endpoint& myAddr)
+UDPConnection::UDPConnection(std::shared_ptr<ip::udp::socket> netSocket, const ip::udp::endpoint& myAddr, std::shared_ptr<UDPBatch> netBatch)
 	: addr(myAddr)
 	, sharedSocket(true)
 	, mySocket(netSocket)
+	, myBatch(netBatch)
 {
 	Init();
 }
@@ -249,6 +255,7 @@ UDPConnection::UDPConnection(int sourcePort, const std::string& address, const u
 	std::shared_ptr<ip::udp::socket> tempSocket(new ip::udp::socket(
 			netcode::netservice, ip::udp::endpoint(sourceAddr, sourcePort)));
 	mySocket = tempSocket;
+	myBatch = std::make_shared<UDPBatch>(mySocket);
 
 	Init();
 }
@@ -307,7 +314,7 @@ void UDPConnection::Init()
 	sentPackets = 0;
 	recvPackets = 0;
 	droppedChunks = 0;
-	mtu = globalConfig.mtu;
+	mtu = std::min(globalConfig.mtu, MAX_MTU);
 	reconnectTime = globalConfig.reconnectTimeout;
 
 	muted = true;
@@ -330,12 +337,13 @@ void UDPConnection::ReconnectTo(CConnection& conn) {
 }
 
 void UDPConnection::CopyConnection(UDPConnection &conn) {
-	conn.InitConnection(addr, mySocket);
+	conn.InitConnection(addr, mySocket, myBatch);
 }
 
-void UDPConnection::InitConnection(ip::udp::endpoint address, std::shared_ptr<ip::udp::socket> socket) {
+void UDPConnection::InitConnection(ip::udp::endpoint address, std::shared_ptr<ip::udp::socket> socket, std::shared_ptr<UDPBatch> batch) {
 	addr = address;
 	mySocket = socket;
+	myBatch = batch;
 }
 
 UDPConnection::~UDPConnection()
@@ -441,28 +449,18 @@ void UDPConnection::Update()
 		// duplicated code with UDPListener
 		netservice.poll();
 
-		size_t bytesAvailable = 0;
-
-		while ((bytesAvailable = mySocket->available()) > 0) {
-			recvBuffer.clear();
-			recvBuffer.resize(bytesAvailable, 0);
-
-			ip::udp::endpoint udpEndPoint;
-			ip::udp::socket::message_flags msgFlags = 0;
-			asio::error_code err;
-
-			const size_t bytesReceived = mySocket->receive_from(asio::buffer(recvBuffer), udpEndPoint, msgFlags, err);
-
-			if (CheckErrorCode(err))
-				break;
+		size_t numReceived = 0;
 
-			if (bytesReceived < Packet::headerSize)
-				continue;
+		while ((numReceived = myBatch->Receive()) > 0) {
+			for (size_t n = 0; n < numReceived; n++) {
+				if (myBatch->GetSize(n) < Packet::headerSize)
+					continue;
 
-			Packet data(&recvBuffer[0], bytesReceived);
+				Packet data(myBatch->GetData(n), myBatch->GetSize(n));
 
-			if (IsUsingAddress(udpEndPoint))
-				ProcessRawPacket(data);
+				if (IsUsingAddress(myBatch->GetSender(n)))
+					ProcessRawPacket(data);
+			}
 
 			// not likely, but make sure we do not get stuck here
 			if ((spring_gettime() - curTime) > spring_msecs(10)) {
@@ -644,36 +642,14 @@ void UDPConnection::ProcessRawPacket(Packet& incoming)
 
 			// this returns false for zero/invalid pktLength
 			if (ProtocolDef::GetInstance()->IsValidLength(pktLength, msgLength)) {
-				msgQueue.emplace_back(new RawPacket(bufp, pktLength));
-				std::shared_ptr<const RawPacket>& msgPacket = msgQueue.back();
-
-				#ifdef ENABLE_DEBUG_STATS
-				// server sends both of these, clients send only keyframe messages
-				// TODO: would be easy to feed this data into a Q3A-style lagometer
-				//
-				if (msgPacket->data[0] == NETMSG_NEWFRAME || msgPacket->data[0] == NETMSG_KEYFRAME) {
-					const spring_time dt = spring_gettime() - lastFramePacketRecvTime;
-
-					sumDeltaFramePacketRecvTime += dt.toMilliSecsf();
-					minDeltaFramePacketRecvTime = std::min(dt.toMilliSecsf(), minDeltaFramePacketRecvTime);
-					maxDeltaFramePacketRecvTime = std::max(dt.toMilliSecsf(), maxDeltaFramePacketRecvTime);
-
-					numReceivedFramePackets += 1;
-					numEnqueuedFramePackets += 1;
-					lastFramePacketRecvTime = spring_gettime();
-
-					if (logMessages) {
-						LOG_L(L_INFO,
-							"\t[%s] (received=%u enqueued=%u) packets (dt=%fms mindt=%fms maxdt=%fms sumdt=%fms)",
-							__func__, numReceivedFramePackets, numEnqueuedFramePackets, dt.toMilliSecsf(),
-							minDeltaFramePacketRecvTime, maxDeltaFramePacketRecvTime, sumDeltaFramePacketRecvTime
-						);
-					}
+				if (*bufp == NETMSG_PACKED) {
+					UnpackMessages(bufp, pktLength);
+					pos += pktLength;
+					continue;
 				}
-				#endif
 
+				EnqueueMessage(bufp, pktLength);
 				pos += pktLength;
-				numPings += (msgPacket->data[0] == NETMSG_PING); // incoming
 			} else {
 				if (pktLength >= 0) {
 					// partial packet in buffer
@@ -693,6 +669,76 @@ void UDPConnection::ProcessRawPacket(Packet& incoming)
 	UpdateWaitingPackets();
 }
 
+void UDPConnection::UnpackMessages(const unsigned char* buf, unsigned int bufLength)
+{
+	constexpr unsigned int headerSize = sizeof(uint8_t) + sizeof(uint16_t) + sizeof(uint16_t);
+
+	uint16_t rawSize = 0;
+
+	if (bufLength <= headerSize) {
+		LOG_L(L_ERROR, "\t[%s] discarding incoming packed message: LEN %u", __func__, bufLength);
+		return;
+	}
+
+	std::memcpy(&rawSize, buf + sizeof(uint8_t) + sizeof(uint16_t), sizeof(rawSize));
+
+	std::vector<unsigned char> rawData(rawSize);
+	uLongf inflSize = rawSize;
+
+	if (uncompress(rawData.data(), &inflSize, buf + headerSize, bufLength - headerSize) != Z_OK || inflSize != rawSize) {
+		LOG_L(L_ERROR, "\t[%s] discarding incoming packed message: LEN %u, RAW %u", __func__, bufLength, rawSize);
+		return;
+	}
+
+	for (unsigned int pos = 0; pos < rawSize; ) {
+		const unsigned char* msgp = &rawData[pos];
+		const unsigned int msgLength = rawSize - pos;
+
+		const int pktLength = ProtocolDef::GetInstance()->PacketLength(msgp, msgLength);
+
+		// packed messages are always complete and never nested
+		if (!ProtocolDef::GetInstance()->IsValidLength(pktLength, msgLength) || *msgp == NETMSG_PACKED) {
+			LOG_L(L_ERROR, "\t[%s] discarding rest of packed message: ID %d, LEN %d", __func__, (int)*msgp, pktLength);
+			return;
+		}
+
+		EnqueueMessage(msgp, pktLength);
+		pos += pktLength;
+	}
+}
+
+void UDPConnection::EnqueueMessage(const unsigned char* buf, unsigned int msgLength)
+{
+	msgQueue.emplace_back(MakeSharedPacket(new RawPacket(buf, msgLength)));
+
+	#ifdef ENABLE_DEBUG_STATS
+	// server sends both of these, clients send only keyframe messages
+	// TODO: would be easy to feed this data into a Q3A-style lagometer
+	//
+	if (*buf == NETMSG_NEWFRAME || *buf == NETMSG_KEYFRAME) {
+		const spring_time dt = spring_gettime() - lastFramePacketRecvTime;
+
+		sumDeltaFramePacketRecvTime += dt.toMilliSecsf();
+		minDeltaFramePacketRecvTime = std::min(dt.toMilliSecsf(), minDeltaFramePacketRecvTime);
+		maxDeltaFramePacketRecvTime = std::max(dt.toMilliSecsf(), maxDeltaFramePacketRecvTime);
+
+		numReceivedFramePackets += 1;
+		numEnqueuedFramePackets += 1;
+		lastFramePacketRecvTime = spring_gettime();
+
+		if (logMessages) {
+			LOG_L(L_INFO,
+				"\t[%s] (received=%u enqueued=%u) packets (dt=%fms mindt=%fms maxdt=%fms sumdt=%fms)",
+				__func__, numReceivedFramePackets, numEnqueuedFramePackets, dt.toMilliSecsf(),
+				minDeltaFramePacketRecvTime, maxDeltaFramePacketRecvTime, sumDeltaFramePacketRecvTime
+			);
+		}
+	}
+	#endif
+
+	numPings += (*buf == NETMSG_PING); // incoming
+}
+
 void UDPConnection::Flush(const bool forced)
 {
 	if (muted)
@@ -749,7 +795,7 @@ void UDPConnection::Flush(const bool forced)
 
 					if ((partialPacket = (numBytes != packet->length))) {
 						// partially transfered
-						packet.reset(new RawPacket(packet->data + numBytes, packet->length - numBytes));
+						packet = MakeSharedPacket(new RawPacket(packet->data + numBytes, packet->length - numBytes));
 					} else {
 						// full packet copied
 						outgoingData.pop_front();
@@ -1053,18 +1099,12 @@ void UDPConnection::SendPacket(Packet& pkt)
 	outgoing.DataSent(sendBuffer.size());
 	lastPacketSendTime = spring_gettime();
 
-	ip::udp::socket::message_flags flags = 0;
-	asio::error_code err;
-
+	// send errors are logged by the batch, as for any datagram it sends; it
+	// also counts the datagram into our stats once it has actually been sent
 	EMULATE_LATENCY( !EMULATE_PACKET_LOSS( LOSS_COUNTER ) ) {
-		mySocket->send_to(buffer(sendBuffer), addr, flags, err);
+		// queued while the listener updates its connections, sent right away otherwise
+		myBatch->Send(sendBuffer, addr, &dataSent, &sentPackets);
 	}
-
-	if (CheckErrorCode(err))
-		return;
-
-	dataSent += sendBuffer.size();
-	sentPackets += 1;
 }
 
 void UDPConnection::AckChunks(int lastAck)
@@ -26,6 +26,8 @@ namespace netcode {
 #define PACKET_MAX_LATENCY 1250               // in [milliseconds] maximum latency
 #define ENABLE_DEBUG_STATS
 
+class UDPBatch;
+
 class Chunk
 {
 public:
@@ -81,7 +83,7 @@ public:
 class UDPConnection : public CConnection
 {
 public:
-	UDPConnection(std::shared_ptr<asio::ip::udp::socket> netSocket, const asio::ip::udp::endpoint& myAddr);
+	UDPConnection(std::shared_ptr<asio::ip::udp::socket> netSocket, const asio::ip::udp::endpoint& myAddr, std::shared_ptr<UDPBatch> netBatch);
 	UDPConnection(int sourceport, const std::string& address, const unsigned port);
 	UDPConnection(CConnection& conn);
 	~UDPConnection();
@@ -91,6 +93,9 @@ public:
 		MAX_LOSS_FACTOR = 2
 	};
 
+	/// largest datagram sent, which is also what receivers have room for
+	static constexpr unsigned MAX_MTU = 4096;
+
 
 	// START overriding CConnection
 	void SendData(std::shared_ptr<const RawPacket> pkt) override;
@@ -136,7 +141,8 @@ public:
 
 private:
 	void InitConnection(asio::ip::udp::endpoint address,
-			std::shared_ptr<asio::ip::udp::socket> socket);
+			std::shared_ptr<asio::ip::udp::socket> socket,
+			std::shared_ptr<UDPBatch> batch);
 
 	void CopyConnection(UDPConnection& conn);
 
@@ -155,6 +161,11 @@ private:
 	void UpdateWaitingPackets();
 	void UpdateResendRequests();
 
+	/// queue the messages contained in a NETMSG_PACKED
+	void UnpackMessages(const unsigned char* buf, unsigned int bufLength);
+	/// queue one incoming message and count it into the stats
+	void EnqueueMessage(const unsigned char* buf, unsigned int msgLength);
+
 private:
 	spring_time lastChunkCreatedTime;
 	spring_time lastPacketSendTime;
@@ -203,7 +214,6 @@ private:
 	std::deque< std::shared_ptr<const RawPacket> > msgQueue;
 
 	std::vector<std::uint8_t> sendBuffer;
-	std::vector<std::uint8_t> recvBuffer;
 	std::vector<std::uint8_t> waitBuffer;
 
 	std::vector<int> droppedPackets;
@@ -221,6 +231,8 @@ private:
 
 	/// Our socket
 	std::shared_ptr<asio::ip::udp::socket> mySocket;
+	/// batched I/O on mySocket, shared with the listener if sharedSocket
+	std::shared_ptr<UDPBatch> myBatch;
 
 	RawPacket fragmentBuffer;
 
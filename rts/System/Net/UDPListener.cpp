@@ -14,6 +14,7 @@
 
 
 #include "ProtocolDef.h"
+#include "UDPBatch.h"
 #include "UDPConnection.h"
 #include "Socket.h"
 #include "System/Log/ILog.h"
@@ -36,6 +37,8 @@ UDPListener::UDPListener(int port, const std::string& ip): acceptNewConnections(
 	socket->non_blocking(true);
 	SetAcceptingConnections(true);
 
+	batch = std::make_shared<UDPBatch>(socket);
+
 	LOG("[%s] successfully bound socket on port %i", __func__, socket->local_endpoint().port());
 }
 
@@ -110,85 +113,87 @@ std::string UDPListener::TryBindSocket(int port, std::shared_ptr<asio::ip::udp::
 void UDPListener::Update() {
 	netservice.poll();
 
-	size_t bytesAvailable = 0;
+	size_t numReceived = 0;
 
-	while ((bytesAvailable = socket->available()) > 0) {
-		recvBuffer.clear();
-		recvBuffer.resize(bytesAvailable, 0);
+	while ((numReceived = batch->Receive()) > 0) {
+		for (size_t n = 0; n < numReceived; n++) {
+			const ip::udp::endpoint& udpEndPoint = batch->GetSender(n);
+			const size_t bytesReceived = batch->GetSize(n);
 
-		ip::udp::endpoint udpEndPoint;
-		asio::ip::udp::socket::message_flags msgFlags = 0;
-		asio::error_code err;
+			const auto ci = connMap.find(udpEndPoint);
 
-		const size_t bytesReceived = socket->receive_from(asio::buffer(recvBuffer), udpEndPoint, msgFlags, err);
+			// known connection but expired
+			if (ci != connMap.end() && ci->second.expired())
+				continue;
 
-		const auto ci = connMap.find(udpEndPoint);
+			if (bytesReceived < Packet::headerSize)
+				continue;
 
-		// known connection but expired
-		if (ci != connMap.end() && ci->second.expired())
-			continue;
+			Packet data(batch->GetData(n), bytesReceived);
 
-		if (CheckErrorCode(err))
-			break;
-
-		if (bytesReceived < Packet::headerSize)
-			continue;
-
-		Packet data(&recvBuffer[0], bytesReceived);
+			if (ci != connMap.end()) {
+				ci->second.lock()->ProcessRawPacket(data);
+				continue;
+			}
 
-		if (ci != connMap.end()) {
-			ci->second.lock()->ProcessRawPacket(data);
-			continue;
-		}
 
+			// unknown connection but still have the packet, maybe a new client wants to connect from sender's address
+			if (acceptNewConnections && data.lastContinuous == -1 && data.nakType == 0)	{
+				if (!data.chunks.empty() && (*data.chunks.begin())->chunkNumber == 0) {
+					std::shared_ptr<UDPConnection> incoming(new UDPConnection(socket, udpEndPoint, batch));
+					waiting.push(incoming);
+					connMap[udpEndPoint] = incoming;
+					incoming->ProcessRawPacket(data);
+				}
 
-		// unknown connection but still have the packet, maybe a new client wants to connect from sender's address
-		if (acceptNewConnections && data.lastContinuous == -1 && data.nakType == 0)	{
-			if (!data.chunks.empty() && (*data.chunks.begin())->chunkNumber == 0) {
-				std::shared_ptr<UDPConnection> incoming(new UDPConnection(socket, udpEndPoint));
-				waiting.push(incoming);
-				connMap[udpEndPoint] = incoming;
-				incoming->ProcessRawPacket(data);
+				continue;
 			}
 
-			continue;
-		}
-
 
-		const asio::ip::address& senderAddr = udpEndPoint.address();
-		const std::string& senderIP = senderAddr.to_string();
+			const asio::ip::address& senderAddr = udpEndPoint.address();
+			const std::string& senderIP = senderAddr.to_string();
 
-		if (dropMap.find(senderIP) == dropMap.end()) {
-			LOG_L(L_DEBUG, "[UDPListener::%s] dropping packet from unknown IP: [%s]:%i", __func__, senderIP.c_str(), udpEndPoint.port());
-			dropMap[senderIP] = 0;
-		} else {
-			dropMap[senderIP] += 1;
-		}
+			if (dropMap.find(senderIP) == dropMap.end()) {
+				LOG_L(L_DEBUG, "[UDPListener::%s] dropping packet from unknown IP: [%s]:%i", __func__, senderIP.c_str(), udpEndPoint.port());
+				dropMap[senderIP] = 0;
+			} else {
+				dropMap[senderIP] += 1;
+			}
 
-	#ifdef DEBUG
-		std::string conns;
-		for (auto it = connMap.cbegin(); it != connMap.cend(); ++it) {
-			conns += spring::format(" [%s]:%i;", it->first.address().to_string().c_str(),it->first.port());
+		#ifdef DEBUG
+			std::string conns;
+			for (auto it = connMap.cbegin(); it != connMap.cend(); ++it) {
+				conns += spring::format(" [%s]:%i;", it->first.address().to_string().c_str(),it->first.port());
+			}
+			LOG_L(L_DEBUG, "[UDPListener::%s] open connections: %s", __func__, conns.c_str());
+		#endif
 		}
-		LOG_L(L_DEBUG, "[UDPListener::%s] open connections: %s", __func__, conns.c_str());
-	#endif
 	}
 
+	// whatever the connections send goes out in as few calls as possible
+	batch->BeginSend();
+
 	for (auto i = connMap.cbegin(); i != connMap.cend(); ) {
 		if (i->second.expired()) {
 			LOG_L(L_DEBUG, "[UDPListener::%s] connection closed: [%s]:%i", __func__, i->first.address().to_string().c_str(), i->first.port());
 			i = connMap.erase(i);
 			continue;
 		}
-		i->second.lock()->Update();
+
+		// the batch counts sent datagrams into their connections' stats
+		updatedConns.push_back(i->second.lock());
+		updatedConns.back()->Update();
 		++i;
 	}
+
+	batch->EndSend();
+	updatedConns.clear();
 }
 
 
 std::shared_ptr<UDPConnection> UDPListener::SpawnConnection(const std::string& ip, const unsigned port)
 {
-	std::shared_ptr<UDPConnection> newConn(new UDPConnection(socket, ip::udp::endpoint(WrapIP(ip), port)));
+	std::shared_ptr<UDPConnection> newConn(new UDPConnection(socket, ip::udp::endpoint(WrapIP(ip), port), batch));
 	connMap[newConn->GetEndpoint()] = newConn;
 	return newConn;
 }
@@ -9,9 +9,11 @@
 #include <map>
 #include <queue>
 #include <string>
+#include <vector>
 
 namespace netcode
 {
+class UDPBatch;
 class UDPConnection;
 
 /**
@@ -84,12 +86,14 @@ private:
 
 	/// socket being listened on
 	std::shared_ptr<asio::ip::udp::socket> socket;
-
-	std::vector<std::uint8_t> recvBuffer;
+	/// batched I/O on socket, shared with all connections
+	std::shared_ptr<UDPBatch> batch;
 
 	/// all connections
 	std::map< asio::ip::udp::endpoint, std::weak_ptr<UDPConnection> > connMap;
 	std::map< std::string, size_t> dropMap;
+	/// kept alive until their queued datagrams are sent
+	std::vector< std::shared_ptr<UDPConnection> > updatedConns;
 
 	std::queue< std::shared_ptr<UDPConnection> > waiting;
 };
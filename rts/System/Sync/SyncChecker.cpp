@@ -9,8 +9,38 @@
 #include "System/Threading/ThreadPool.h"
 
 
+#include <array>
+
+
 unsigned CSyncChecker::g_checksum;
 int CSyncChecker::inSyncedCode;
+bool CSyncChecker::inMTSection;
+
+
+namespace {
+	struct alignas(64) MTAccumulator {
+		/// sum of the hashes of all finished keys
+		unsigned sum;
+		/// running hash of the current key
+		unsigned hash;
+		int key;
+		bool used;
+
+		void Reset() { sum = 0; hash = 0; key = -1; used = false; }
+		void Flush() {
+			if (!used)
+				return;
+
+			const unsigned keyHash[2] = {static_cast<unsigned>(key), hash};
+
+			sum += spring::LiteHash(keyHash, sizeof(keyHash), 0);
+			hash = 0;
+			used = false;
+		}
+	};
+
+	std::array<MTAccumulator, ThreadPool::MAX_THREADS> mtAccumulators;
+}
 
 
 void CSyncChecker::debugSyncCheckThreading()
@@ -18,4 +48,50 @@ void CSyncChecker::debugSyncCheckThreading()
     assert(ThreadPool::GetThreadNum() == 0);
 }
 
+
+void CSyncChecker::BeginMTSection()
+{
+	assert(ThreadPool::GetThreadNum() == 0);
+	assert(!inMTSection);
+
+	for (MTAccumulator& acc: mtAccumulators) {
+		acc.Reset();
+	}
+
+	inMTSection = true;
+}
+
+void CSyncChecker::EndMTSection()
+{
+	assert(ThreadPool::GetThreadNum() == 0);
+	assert(inMTSection);
+
+	unsigned sum = 0;
+
+	// addition commutes, so neither thread assignment nor order matter
+	for (MTAccumulator& acc: mtAccumulators) {
+		acc.Flush();
+		sum += acc.sum;
+	}
+
+	inMTSection = false;
+	g_checksum = spring::LiteHash(sum, g_checksum);
+}
+
+void CSyncChecker::SetMTKey(int key)
+{
+	MTAccumulator& acc = mtAccumulators[ThreadPool::GetThreadNum()];
+
+	acc.Flush();
+	acc.key = key;
+}
+
+void CSyncChecker::SyncMT(const void* p, unsigned size)
+{
+	MTAccumulator& acc = mtAccumulators[ThreadPool::GetThreadNum()];
+
+	acc.hash = spring::LiteHash(p, size, acc.hash);
+	acc.used = true;
+}
+
 #endif // SYNCDEBUG
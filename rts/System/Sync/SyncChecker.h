@@ -31,7 +31,28 @@ class CSyncChecker {
 		static unsigned GetChecksum() { return g_checksum; }
 		static void NewFrame() { g_checksum = 0xfade1eaf; }
 		static void debugSyncCheckThreading();
+
+		/**
+		 * Multithreaded synced sections.
+		 *
+		 * Between BeginMTSection and EndMTSection (on the main thread) Sync may
+		 * be called from any thread. Each thread hashes the writes of one key
+		 * (set with SetMTKey before each work item, e.g. to the unit ID) on its
+		 * own; the per-key hashes are summed up and folded into the checksum at
+		 * the end. The result does not depend on which thread ran which item or
+		 * in what order, as long as all writes for one key happen on one thread
+		 * in a deterministic order.
+		 */
+		static void BeginMTSection();
+		static void EndMTSection();
+		static void SetMTKey(int key);
+		static bool InMTSection() { return inMTSection; }
+
 		static void Sync(const void* p, unsigned size) {
+			if (inMTSection) {
+				SyncMT(p, size);
+				return;
+			}
 #ifdef DEBUG_SYNC_MT_CHECK
 			// Sync calls should not be occuring in multi-threaded sections
 			debugSyncCheckThreading();
@@ -42,6 +63,9 @@ class CSyncChecker {
 			//LOG("[Sync::Checker] chksum=%u\n", g_checksum);
 		}
 
+	private:
+		static void SyncMT(const void* p, unsigned size);
+
 	private:
 
 		/**
@@ -49,6 +73,11 @@ class CSyncChecker {
 		 */
 		static unsigned g_checksum;
 
+		/**
+		 * Whether Sync calls go to the per-thread accumulators
+		 */
+		static bool inMTSection;
+
 		/**
 		 * @brief in synced code
 		 *
@@ -61,6 +61,26 @@ namespace Sync {
 		Assert(&x, sizeof(T), msg);
 	}
 
+
+	/**
+	 * @brief Allows synced writes from worker threads while in scope.
+	 * See CSyncChecker::BeginMTSection; each work item has to call SetMTKey
+	 * before its first synced write. Not supported by the CSyncDebugger.
+	 */
+	struct ScopedMTSection {
+	#ifdef SYNCCHECK
+		ScopedMTSection() { CSyncChecker::BeginMTSection(); }
+		~ScopedMTSection() { CSyncChecker::EndMTSection(); }
+	#endif
+	};
+
+	/// @brief Identify the work item (e.g. unit ID) whose synced writes follow.
+	static inline void SetMTKey(int key) {
+	#ifdef SYNCCHECK
+		CSyncChecker::SetMTKey(key);
+	#endif
+	}
+
 }
 
 #if !defined(NDEBUG) && defined(SYNCCHECK)
@@ -1,6 +1,7 @@
 /* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
 
 #include <string>
+#include <vector>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -11,6 +12,7 @@
 #include "Game/GameData.h"
 #include "Game/GameVersion.h"
 #include "Net/GameServer.h"
+#include "Net/GameServerHost.h"
 #include "System/Exceptions.h"
 #include "System/GlobalConfig.h"
 #include "System/GlobalRNG.h"
@@ -53,7 +55,7 @@ extern "C"
 {
 #endif
 
-void ParseCmdLine(int argc, char* argv[], std::string& scriptName)
+void ParseCmdLine(int argc, char* argv[], std::vector<std::string>& scriptNames)
 {
 	#undef  LOG_SECTION_CURRENT
 	#define LOG_SECTION_CURRENT LOG_SECTION_DEFAULT
@@ -70,10 +72,12 @@ void ParseCmdLine(int argc, char* argv[], std::string& scriptName)
 		exit(0);
 	}
 
-	if (argc >= 2)
-		scriptName = argv[1];
+	// every further script is hosted as an independent game in this process
+	for (int i = 1; i < argc; i++) {
+		scriptNames.emplace_back(argv[i]);
+	}
 
-	if (scriptName.empty() && !FLAGS_list_config_vars) {
+	if (scriptNames.empty() && !FLAGS_list_config_vars) {
 		gflags::ShowUsageWithFlags(argv[0]);
 		exit(1);
 	}
@@ -105,142 +109,207 @@ void ParseCmdLine(int argc, char* argv[], std::string& scriptName)
 
 
 
-int main(int argc, char* argv[])
-{
-	Threading::SetMainThread();
-	try {
-		spring_clock::PushTickRate();
-		// initialize start time (can safely be done before SDL_Init
-		// since we are not using SDL_GetTicks as our clock anymore)
-		spring_time::setstarttime(spring_time::gettime(true));
+static bool LoadGameScript(
+	const std::string& scriptName,
+	CGlobalUnsyncedRNG& rng,
+	std::shared_ptr<ClientSetup>& dsClientSetup,
+	std::shared_ptr<GameData>& dsGameData,
+	std::shared_ptr<CGameSetup>& dsGameSetup
+) {
+	std::string scriptText;
 
-		CLogOutput::LogSystemInfo();
+	LOG("loading script from file: %s", scriptName.c_str());
 
-		std::string scriptName;
-		std::string scriptText;
-		std::string binaryName = argv[0];
+	// server will take ownership of these
+	dsClientSetup.reset(new ClientSetup());
+	dsGameData.reset(new GameData());
+	dsGameSetup.reset(new CGameSetup());
 
-		gflags::SetUsageMessage("Usage: " + binaryName + " [options] path_to_script.txt");
-		gflags::SetVersionString(SpringVersion::GetFull());
-		gflags::ParseCommandLineFlags(&argc, &argv, true);
-		ParseCmdLine(argc, argv, scriptName);
+	CFileHandler fh(scriptName);
 
-		globalConfig.Init();
-		FileSystemInitializer::InitializeLogOutput();
-		FileSystemInitializer::Initialize();
+	if (!fh.FileExists())
+		throw content_error("script does not exist in given location: " + scriptName);
 
-		// Initialize crash reporting
-		CrashHandler::Install();
+	if (!fh.LoadStringData(scriptText))
+		throw content_error("script cannot be read: " + scriptName);
 
-		LOG("report any errors to Mantis or the forums.");
-		LOG("loading script from file: %s", scriptName.c_str());
+	dsClientSetup->LoadFromStartScript(scriptText);
 
-		// server will take ownership of these
-		std::shared_ptr<ClientSetup> dsClientSetup(new ClientSetup());
-		std::shared_ptr<GameData> dsGameData(new GameData());
-		std::shared_ptr<CGameSetup> dsGameSetup(new CGameSetup());
+	if (!dsGameSetup->Init(scriptText)) {
+		// read the script provided by cmdline
+		LOG_L(L_ERROR, "failed to load script %s", scriptName.c_str());
+		return false;
+	}
 
-		CFileHandler fh(scriptName);
+	if (dsGameSetup->fixedRNGSeed == 0) {
+		dsGameData->SetRandomSeed(rng.NextInt());
+	} else {
+		dsGameData->SetRandomSeed(dsGameSetup->fixedRNGSeed);
+	}
 
-		if (!fh.FileExists())
-			throw content_error("script does not exist in given location: " + scriptName);
+	{
+		sha512::raw_digest dsMapChecksum;
+		sha512::raw_digest dsModChecksum;
+		sha512::hex_digest dsMapChecksumHex;
+		sha512::hex_digest dsModChecksumHex;
 
-		if (!fh.LoadStringData(scriptText))
-			throw content_error("script cannot be read: " + scriptName);
+		std::memcpy(dsMapChecksum.data(), &dsGameSetup->dsMapHash[0], sizeof(dsGameSetup->dsMapHash));
+		std::memcpy(dsModChecksum.data(), &dsGameSetup->dsModHash[0], sizeof(dsGameSetup->dsModHash));
+		sha512::dump_digest(dsMapChecksum, dsMapChecksumHex);
+		sha512::dump_digest(dsModChecksum, dsModChecksumHex);
 
-		dsClientSetup->LoadFromStartScript(scriptText);
+		LOG("[script-checksums]\n\tmap=%s\n\tmod=%s", dsMapChecksumHex.data(), dsModChecksumHex.data());
 
-		if (!dsGameSetup->Init(scriptText)) {
-			// read the script provided by cmdline
-			LOG_L(L_ERROR, "failed to load script %s", scriptName.c_str());
-			return 1;
-		}
+		// use script-provided hashes if any byte is non-zero; these
+		// are only used by some client-side (pregame) sanity checks
+		const auto hashPred = [](uint8_t byte) { return (byte != 0); };
 
-		// create the server, it will run in a separate thread
-		CGlobalUnsyncedRNG rng;
+		if (std::find_if(dsMapChecksum.begin(), dsMapChecksum.end(), hashPred) != dsMapChecksum.end()) {
+			dsGameData->SetMapChecksum(dsMapChecksum.data());
+			dsGameSetup->LoadStartPositions(false); // reduced mode
+		} else {
+			dsGameData->SetMapChecksum(&archiveScanner->GetArchiveCompleteChecksumBytes(dsGameSetup->mapName)[0]);
 
-		const uint32_t sleepTime = FLAGS_sleeptime;
-		const uint32_t randSeed = time(nullptr) % ((spring_gettime().toNanoSecsi() + 1) * 9007);
+			CFileHandler f("maps/" + dsGameSetup->mapName);
+			if (!f.FileExists())
+				vfsHandler->AddArchiveWithDeps(dsGameSetup->mapName, false);
 
-		rng.Seed(randSeed);
-		if (dsGameSetup->fixedRNGSeed == 0) {
-			dsGameData->SetRandomSeed(rng.NextInt());
+			dsGameSetup->LoadStartPositions(); // full mode
+		}
+
+		if (std::find_if(dsModChecksum.begin(), dsModChecksum.end(), hashPred) != dsModChecksum.end()) {
+			dsGameData->SetModChecksum(dsModChecksum.data());
 		} else {
-			dsGameData->SetRandomSeed(dsGameSetup->fixedRNGSeed);
+			const std::string& modArchive = archiveScanner->ArchiveFromName(dsGameSetup->modName);
+			const sha512::raw_digest& modCheckSum = archiveScanner->GetArchiveCompleteChecksumBytes(modArchive);
+
+			dsGameData->SetModChecksum(&modCheckSum[0]);
 		}
+	}
 
-		{
-			sha512::raw_digest dsMapChecksum;
-			sha512::raw_digest dsModChecksum;
-			sha512::hex_digest dsMapChecksumHex;
-			sha512::hex_digest dsModChecksumHex;
+	dsGameData->SetSetupText(dsGameSetup->setupText);
+	return true;
+}
 
-			std::memcpy(dsMapChecksum.data(), &dsGameSetup->dsMapHash[0], sizeof(dsGameSetup->dsMapHash));
-			std::memcpy(dsModChecksum.data(), &dsGameSetup->dsModHash[0], sizeof(dsGameSetup->dsModHash));
-			sha512::dump_digest(dsMapChecksum, dsMapChecksumHex);
-			sha512::dump_digest(dsModChecksum, dsModChecksumHex);
+static void RunGame(
+	const std::shared_ptr<ClientSetup>& dsClientSetup,
+	const std::shared_ptr<GameData>& dsGameData,
+	const std::shared_ptr<CGameSetup>& dsGameSetup
+) {
+	// the server runs in a separate thread
+	CGameServer server(dsClientSetup, dsGameData, dsGameSetup);
 
-			LOG("[script-checksums]\n\tmap=%s\n\tmod=%s", dsMapChecksumHex.data(), dsModChecksumHex.data());
+	const uint32_t sleepTime = FLAGS_sleeptime;
 
-			// use script-provided hashes if any byte is non-zero; these
-			// are only used by some client-side (pregame) sanity checks
-			const auto hashPred = [](uint8_t byte) { return (byte != 0); };
+	while (!server.HasGameID()) {
+		// wait until gameID has been generated or
+		// a timeout occurs (if no clients connect)
+		if (server.HasFinished())
+			break;
 
-			if (std::find_if(dsMapChecksum.begin(), dsMapChecksum.end(), hashPred) != dsMapChecksum.end()) {
-				dsGameData->SetMapChecksum(dsMapChecksum.data());
-				dsGameSetup->LoadStartPositions(false); // reduced mode
-			} else {
-				dsGameData->SetMapChecksum(&archiveScanner->GetArchiveCompleteChecksumBytes(dsGameSetup->mapName)[0]);
+		spring_sleep(spring_secs(sleepTime));
+	}
 
-				CFileHandler f("maps/" + dsGameSetup->mapName);
-				if (!f.FileExists())
-					vfsHandler->AddArchiveWithDeps(dsGameSetup->mapName, false);
+	while (!server.HasFinished()) {
+		static bool printData = (server.GetDemoRecorder() != nullptr);
 
-				dsGameSetup->LoadStartPositions(); // full mode
-			}
+		if (printData) {
+			printData = false;
 
-			if (std::find_if(dsModChecksum.begin(), dsModChecksum.end(), hashPred) != dsModChecksum.end()) {
-				dsGameData->SetModChecksum(dsModChecksum.data());
-			} else {
-				const std::string& modArchive = archiveScanner->ArchiveFromName(dsGameSetup->modName);
-				const sha512::raw_digest& modCheckSum = archiveScanner->GetArchiveCompleteChecksumBytes(modArchive);
+			const std::unique_ptr<CDemoRecorder>& demoRec = server.GetDemoRecorder();
+			const std::uint8_t* gameID = (demoRec->GetFileHeader()).gameID;
 
-				dsGameData->SetModChecksum(&modCheckSum[0]);
-			}
+			LOG("recording demo: %s", (demoRec->GetName()).c_str());
+			LOG("using mod: %s", (dsGameSetup->modName).c_str());
+			LOG("using map: %s", (dsGameSetup->mapName).c_str());
+			LOG("GameID: %02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x", gameID[0], gameID[1], gameID[2], gameID[3], gameID[4], gameID[5], gameID[6], gameID[7], gameID[8], gameID[9], gameID[10], gameID[11], gameID[12], gameID[13], gameID[14], gameID[15]);
 		}
 
-		LOG("starting server...");
+		spring_secs(sleepTime).sleep(true);
+	}
+}
 
-		{
-			dsGameData->SetSetupText(dsGameSetup->setupText);
-			CGameServer server(dsClientSetup, dsGameData, dsGameSetup);
+static void RunGames(const std::vector<std::string>& scriptNames, CGlobalUnsyncedRNG& rng)
+{
+	std::shared_ptr<ClientSetup> dsClientSetup;
+	std::shared_ptr<GameData> dsGameData;
+	std::shared_ptr<CGameSetup> dsGameSetup;
+
+	// all games share the listener (and port) of the first, and one thread
+	std::unique_ptr<CGameServerHost> host;
 
-			while (!server.HasGameID()) {
-				// wait until gameID has been generated or
-				// a timeout occurs (if no clients connect)
-				if (server.HasFinished())
-					break;
+	int hostPort = 0;
 
-				spring_sleep(spring_secs(sleepTime));
-			}
+	for (const std::string& scriptName: scriptNames) {
+		if (!LoadGameScript(scriptName, rng, dsClientSetup, dsGameData, dsGameSetup))
+			continue;
 
-			while (!server.HasFinished()) {
-				static bool printData = (server.GetDemoRecorder() != nullptr);
+		if (host == nullptr) {
+			host.reset(new CGameServerHost(hostPort = dsClientSetup->hostPort, dsClientSetup->hostIP));
+		} else if (dsClientSetup->hostPort != hostPort) {
+			LOG_L(L_WARNING, "HostPort %d of script %s ignored, all games are hosted on port %d", dsClientSetup->hostPort, scriptName.c_str(), hostPort);
+		}
 
-				if (printData) {
-					printData = false;
+		host->AddGame(dsClientSetup, dsGameData, dsGameSetup);
+	}
 
-					const std::unique_ptr<CDemoRecorder>& demoRec = server.GetDemoRecorder();
-					const std::uint8_t* gameID = (demoRec->GetFileHeader()).gameID;
+	if (host == nullptr)
+		return;
 
-					LOG("recording demo: %s", (demoRec->GetName()).c_str());
-					LOG("using mod: %s", (dsGameSetup->modName).c_str());
-					LOG("using map: %s", (dsGameSetup->mapName).c_str());
-					LOG("GameID: %02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x%02x", gameID[0], gameID[1], gameID[2], gameID[3], gameID[4], gameID[5], gameID[6], gameID[7], gameID[8], gameID[9], gameID[10], gameID[11], gameID[12], gameID[13], gameID[14], gameID[15]);
-				}
+	LOG("hosting %u games", unsigned(host->GetNumGames()));
 
-				spring_secs(sleepTime).sleep(true);
-			}
+	while (!host->HasFinished()) {
+		spring_secs(FLAGS_sleeptime).sleep(true);
+	}
+}
+
+
+int main(int argc, char* argv[])
+{
+	Threading::SetMainThread();
+	try {
+		spring_clock::PushTickRate();
+		// initialize start time (can safely be done before SDL_Init
+		// since we are not using SDL_GetTicks as our clock anymore)
+		spring_time::setstarttime(spring_time::gettime(true));
+
+		CLogOutput::LogSystemInfo();
+
+		std::vector<std::string> scriptNames;
+		std::string binaryName = argv[0];
+
+		gflags::SetUsageMessage("Usage: " + binaryName + " [options] path_to_script.txt [path_to_script2.txt ...]");
+		gflags::SetVersionString(SpringVersion::GetFull());
+		gflags::ParseCommandLineFlags(&argc, &argv, true);
+		ParseCmdLine(argc, argv, scriptNames);
+
+		globalConfig.Init();
+		FileSystemInitializer::InitializeLogOutput();
+		FileSystemInitializer::Initialize();
+
+		// Initialize crash reporting
+		CrashHandler::Install();
+
+		LOG("report any errors to Mantis or the forums.");
+		CGlobalUnsyncedRNG rng;
+
+		const uint32_t randSeed = time(nullptr) % ((spring_gettime().toNanoSecsi() + 1) * 9007);
+
+		rng.Seed(randSeed);
+
+		if (scriptNames.size() == 1) {
+			std::shared_ptr<ClientSetup> dsClientSetup;
+			std::shared_ptr<GameData> dsGameData;
+			std::shared_ptr<CGameSetup> dsGameSetup;
+
+			if (!LoadGameScript(scriptNames[0], rng, dsClientSetup, dsGameData, dsGameSetup))
+				return 1;
+
+			LOG("starting server...");
+			RunGame(dsClientSetup, dsGameData, dsGameSetup);
+		} else {
+			LOG("starting %u servers...", unsigned(scriptNames.size()));
+			RunGames(scriptNames, rng);
 		}
 
 		LOG("exiting");
@@ -0,0 +1,97 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Map/GroundSampling.h"
+#include "System/float3.h"
+
+#include <cstring>
+#include <random>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+MapDimensions mapDims;
+
+
+static bool SameBits(float a, float b)
+{
+	return (std::memcmp(&a, &b, sizeof(float)) == 0);
+}
+
+
+TEST_CASE("GroundSamplingBatch")
+{
+	static constexpr int MAP_X = 96;
+	static constexpr int MAP_Y = 64;
+	// not a multiple of any batch size, the tail takes the scalar path
+	static constexpr size_t NUM_POSITIONS = 100003;
+
+	mapDims.mapx = MAP_X;
+	mapDims.mapy = MAP_Y;
+	mapDims.Initialize();
+
+	float3::maxxpos = MAP_X * SQUARE_SIZE - 1;
+	float3::maxzpos = MAP_Y * SQUARE_SIZE - 1;
+
+	std::mt19937 rng(0x6709);
+	std::uniform_real_distribution<float> heightDist(-300.0f, 800.0f);
+	std::uniform_real_distribution<float> normalDist(-1.0f, 1.0f);
+
+	std::vector<float> cornerHeightMap(mapDims.mapxp1 * mapDims.mapyp1);
+	std::vector<float3> centerNormalMap(MAP_X * MAP_Y);
+
+	for (float& h: cornerHeightMap) {
+		h = heightDist(rng);
+	}
+	for (float3& n: centerNormalMap) {
+		n = float3(normalDist(rng), 1.0f, normalDist(rng)).Normalize();
+	}
+
+	// positions on and off the map, including exact square borders
+	std::uniform_real_distribution<float> xDist(-200.0f, MAP_X * SQUARE_SIZE + 200.0f);
+	std::uniform_real_distribution<float> zDist(-200.0f, MAP_Y * SQUARE_SIZE + 200.0f);
+	std::uniform_int_distribution<int> squareDist(0, std::max(MAP_X, MAP_Y));
+
+	std::vector<float> xs(NUM_POSITIONS);
+	std::vector<float> zs(NUM_POSITIONS);
+
+	for (size_t i = 0; i < NUM_POSITIONS; ++i) {
+		if ((i % 16) == 0) {
+			xs[i] = squareDist(rng) * SQUARE_SIZE;
+			zs[i] = squareDist(rng) * SQUARE_SIZE;
+		} else {
+			xs[i] = xDist(rng);
+			zs[i] = zDist(rng);
+		}
+	}
+
+	SECTION("heights") {
+		std::vector<float> heights(NUM_POSITIONS);
+
+		InterpolateCornerHeights(xs.data(), zs.data(), heights.data(), NUM_POSITIONS, cornerHeightMap.data());
+
+		size_t numDiffs = 0;
+
+		for (size_t i = 0; i < NUM_POSITIONS; ++i) {
+			numDiffs += !SameBits(heights[i], InterpolateCornerHeight(xs[i], zs[i], cornerHeightMap.data()));
+		}
+
+		CHECK(numDiffs == 0);
+	}
+
+	SECTION("normals") {
+		std::vector<float3> normals(NUM_POSITIONS);
+
+		SampleCenterNormals(xs.data(), zs.data(), normals.data(), NUM_POSITIONS, centerNormalMap.data());
+
+		size_t numDiffs = 0;
+
+		for (size_t i = 0; i < NUM_POSITIONS; ++i) {
+			const float3& n = SampleCenterNormal(xs[i], zs[i], centerNormalMap.data());
+
+			numDiffs += !(SameBits(normals[i].x, n.x) && SameBits(normals[i].y, n.y) && SameBits(normals[i].z, n.z));
+		}
+
+		CHECK(numDiffs == 0);
+	}
+}
@@ -0,0 +1,163 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Net/GameParticipant.h"
+#include "Net/Protocol/BaseNetProtocol.h"
+#include "System/Net/LoopbackConnection.h"
+#include "System/Net/RawPacket.h"
+
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+using netcode::RawPacket;
+
+static constexpr unsigned int PACKED_FRAMES = 4;
+
+
+// the loopback link hands back whatever the participant sent
+static std::vector<std::shared_ptr<const RawPacket>> GetSent(GameParticipant& p)
+{
+	std::vector<std::shared_ptr<const RawPacket>> sent;
+
+	while (p.clientLink->HasIncomingData()) {
+		sent.push_back(p.clientLink->GetData());
+	}
+
+	return sent;
+}
+
+static void ConnectSpectator(GameParticipant& p)
+{
+	p.Connected(std::make_shared<netcode::CLoopbackConnection>(), false);
+	p.spectator = true;
+	p.SetPackedFrames(PACKED_FRAMES);
+}
+
+static void SendFrames(GameParticipant& p, unsigned int numFrames)
+{
+	for (unsigned int i = 0; i < numFrames; i++) {
+		p.SendData(CBaseNetProtocol::Get().SendNewFrame());
+		p.SendData(CBaseNetProtocol::Get().SendPlayerInfo(0, 0.5f, 42));
+	}
+}
+
+
+TEST_CASE("GameParticipantPackedMessages")
+{
+	GameParticipant p;
+	ConnectSpectator(p);
+
+	SECTION("frames are gathered until enough are in") {
+		SendFrames(p, PACKED_FRAMES - 1);
+		p.FlushPackedMessages(false);
+
+		CHECK(GetSent(p).empty());
+
+		SendFrames(p, 1);
+		p.FlushPackedMessages(false);
+
+		const auto sent = GetSent(p);
+
+		REQUIRE(sent.size() == 1);
+		CHECK(sent[0]->data[0] == NETMSG_PACKED);
+	}
+
+	SECTION("pausing flushes whatever was gathered") {
+		SendFrames(p, 1);
+		p.FlushPackedMessages(false);
+
+		CHECK(GetSent(p).empty());
+
+		// what CGameServer::Update does for everyone while paused
+		p.SetPackedFrames(0);
+		p.FlushPackedMessages(false);
+
+		const auto sent = GetSent(p);
+
+		REQUIRE(sent.size() == 1);
+		CHECK(sent[0]->data[0] == NETMSG_PACKED);
+
+		// and nothing is held back until the game continues
+		SendFrames(p, 1);
+
+		const auto unpacked = GetSent(p);
+
+		REQUIRE(unpacked.size() == 2);
+		CHECK(unpacked[0]->data[0] == NETMSG_NEWFRAME);
+		CHECK(unpacked[1]->data[0] == NETMSG_PLAYERINFO);
+	}
+
+	SECTION("gathered messages go out before a quit") {
+		SendFrames(p, 1);
+		p.SendData(CBaseNetProtocol::Get().SendQuit("bye"));
+
+		const auto sent = GetSent(p);
+
+		REQUIRE(sent.size() == 2);
+		CHECK(sent[0]->data[0] == NETMSG_PACKED);
+		CHECK(sent[1]->data[0] == NETMSG_QUIT);
+	}
+
+	SECTION("gathered messages go out before a kill") {
+		std::shared_ptr<netcode::CConnection> link = p.clientLink;
+
+		SendFrames(p, 1);
+		p.Kill("kicked");
+
+		REQUIRE(link->HasIncomingData());
+		CHECK(link->GetData()->data[0] == NETMSG_PACKED);
+		REQUIRE(link->HasIncomingData());
+		CHECK(link->GetData()->data[0] == NETMSG_QUIT);
+		CHECK(!link->HasIncomingData());
+	}
+
+	SECTION("frame progress skips the queue") {
+		SendFrames(p, 1);
+		p.SendData(CBaseNetProtocol::Get().SendCurrentFrameProgress(42));
+
+		const auto sent = GetSent(p);
+
+		REQUIRE(sent.size() == 1);
+		CHECK(sent[0]->data[0] == NETMSG_GAME_FRAME_PROGRESS);
+	}
+}
+
+
+TEST_CASE("GameParticipantPackedMessageCache")
+{
+	GameParticipant a;
+	GameParticipant b;
+	GameParticipant c;
+
+	ConnectSpectator(a);
+	ConnectSpectator(b);
+	ConnectSpectator(c);
+
+	SendFrames(a, PACKED_FRAMES);
+	SendFrames(b, PACKED_FRAMES);
+	SendFrames(c, PACKED_FRAMES);
+
+	// c saw a different message
+	c.SendData(CBaseNetProtocol::Get().SendPlayerInfo(1, 0.5f, 42));
+
+	GameParticipant::PackedMessageCache cache;
+
+	a.FlushPackedMessages(false, &cache);
+	b.FlushPackedMessages(false, &cache);
+	c.FlushPackedMessages(false, &cache);
+
+	const auto sentA = GetSent(a);
+	const auto sentB = GetSent(b);
+	const auto sentC = GetSent(c);
+
+	REQUIRE(sentA.size() == 1);
+	REQUIRE(sentB.size() == 1);
+	REQUIRE(sentC.size() == 1);
+
+	// identical messages are compressed once and shared
+	CHECK(sentA[0] == sentB[0]);
+	CHECK(sentA[0] != sentC[0]);
+	CHECK(sentC[0]->data[0] == NETMSG_PACKED);
+	CHECK(cache.packet == sentC[0]);
+}
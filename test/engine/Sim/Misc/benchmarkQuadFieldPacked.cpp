@@ -0,0 +1,310 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Misc/QuadField.h"
+#include "Sim/Misc/QuadFieldPacked.h"
+#include "Sim/Misc/GlobalConstants.h"
+#include "System/float3.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "lib/catch.hpp"
+
+// compares the exact unit queries of CQuadField against live positions with
+// the ones against the per-quad packed copies (usePackedUnitQueries), using the
+// quads of the real CQuadField and its quad maintenance and per-quad query code
+// on stand-in units; run with the "[benchmark]" tag to get timings, e.g.
+// test_QuadFieldPacked "[benchmark]"
+
+namespace {
+	constexpr int MAP_SIZE = 8192;
+	constexpr int QUAD_SIZE = 128;
+	constexpr int NUM_QUERIES = 1024;
+
+	constexpr int NUM_ALLY_TEAMS = 4;
+
+	// stand-in for CUnit with the members the quad maintenance and
+	// CQuadField::GetQuadUnitsExact use; padded so neighbouring units
+	// do not share cache lines, like real units do not
+	struct MockUnit {
+		float3 pos;
+		float radius = 0.0f;
+		int allyteam = 0;
+		std::vector<int> quads;
+		std::array<int, ThreadPool::MAX_THREADS> mtTempNum = {};
+		std::array<uint8_t, 1024> payload = {};
+	};
+
+	// the parts of CQuadField::Quad that hold units
+	struct MockQuad {
+		std::vector<MockUnit*> units;
+		std::vector< std::vector<MockUnit*> > teamUnits = std::vector< std::vector<MockUnit*> >(NUM_ALLY_TEAMS);
+		QuadFieldPacked packedUnits;
+	};
+
+	struct MockQuery {
+		float3 pos;
+		float radius;
+		bool spherical;
+	};
+
+	struct MockField {
+		explicit MockField(size_t numUnits, unsigned int seed = 1234) {
+			float3::maxxpos = MAP_SIZE - 1.0f;
+			float3::maxzpos = MAP_SIZE - 1.0f;
+
+			quadField.Init(int2(MAP_SIZE / SQUARE_SIZE, MAP_SIZE / SQUARE_SIZE), QUAD_SIZE);
+
+			std::mt19937 rng(seed);
+			std::uniform_real_distribution<float> xzDist(0.0f, MAP_SIZE - 1.0f);
+			std::uniform_real_distribution<float>  yDist(0.0f, 200.0f);
+			std::uniform_real_distribution<float>  rDist(8.0f, 64.0f);
+			// collision- and explosion-sized queries, where most candidates
+			// in crowded quads are rejected
+			std::uniform_real_distribution<float> qrDist(8.0f, 96.0f);
+
+			quads.resize(quadField.GetNumQuadsX() * quadField.GetNumQuadsZ());
+			units.reserve(numUnits);
+
+			// cluster units in a few hot-spots, as in a real battle
+			for (size_t i = 0; i < numUnits; ++i) {
+				auto unit = std::make_unique<MockUnit>();
+
+				const float3 center = {MAP_SIZE * (0.25f + 0.5f * (i & 1)), 0.0f, MAP_SIZE * (0.25f + 0.5f * ((i >> 1) & 1))};
+				const float3 offset = {xzDist(rng) - MAP_SIZE * 0.5f, 0.0f, xzDist(rng) - MAP_SIZE * 0.5f};
+
+				unit->pos = center + offset * 0.25f;
+				unit->pos.y = yDist(rng);
+				unit->radius = rDist(rng);
+				unit->allyteam = i % NUM_ALLY_TEAMS;
+
+				MovedUnit(unit.get());
+				units.emplace_back(std::move(unit));
+			}
+
+			for (int i = 0; i < NUM_QUERIES; ++i) {
+				queries.push_back({units[rng() % units.size()]->pos, qrDist(rng), (i & 1) == 0});
+			}
+		}
+
+		~MockField() { quadField.Kill(); }
+
+		// CQuadField::MovedUnit and RemoveUnit, with packed copies maintained
+		void MovedUnit(MockUnit* unit) {
+			QuadFieldQuery qfQuery;
+			quadField.GetQuads(qfQuery, unit->pos, unit->radius);
+			CQuadField::MoveQuadsUnit(quads, unit, *qfQuery.quads, true);
+		}
+		void RemoveUnit(MockUnit* unit) {
+			CQuadField::RemoveQuadsUnit(quads, unit, true);
+		}
+
+		// CQuadField::GetUnitsExact(qfq, pos, radius, spherical)
+		void GetUnitsExact(std::vector<MockUnit*>& result, const MockQuery& q, bool packed) {
+			QuadFieldQuery qfQuery;
+			quadField.GetQuads(qfQuery, q.pos, q.radius);
+
+			++tempNum;
+
+			for (const int qi: *qfQuery.quads) {
+				const MockQuad& quad = quads[qi];
+				CQuadField::GetQuadUnitsExact(result, quad.units, packed? &quad.packedUnits: nullptr, hits, 0, tempNum, q.pos, q.radius, q.spherical);
+			}
+		}
+
+		// CQuadField::GetUnitsExact(qfq, mins, maxs)
+		void GetUnitsExact(std::vector<MockUnit*>& result, const float3& mins, const float3& maxs, bool packed) {
+			QuadFieldQuery qfQuery;
+			quadField.GetQuadsRectangle(qfQuery, mins, maxs);
+
+			++tempNum;
+
+			for (const int qi: *qfQuery.quads) {
+				const MockQuad& quad = quads[qi];
+				CQuadField::GetQuadUnitsExact(result, quad.units, packed? &quad.packedUnits: nullptr, hits, 0, tempNum, mins, maxs);
+			}
+		}
+
+		// every unit is in exactly the quads it touches, in each of them once
+		bool CheckQuads() const {
+			std::vector<int> counts(units.size() * quads.size(), 0);
+
+			for (size_t qi = 0; qi < quads.size(); ++qi) {
+				if (quads[qi].packedUnits.Size() != quads[qi].units.size())
+					return false;
+
+				size_t numTeamUnits = 0;
+
+				for (const auto& teamUnits: quads[qi].teamUnits) {
+					numTeamUnits += teamUnits.size();
+				}
+
+				if (numTeamUnits != quads[qi].units.size())
+					return false;
+			}
+
+			for (const auto& unit: units) {
+				for (const int qi: unit->quads) {
+					const std::vector<MockUnit*>& qu = quads[qi].units;
+
+					if (std::count(qu.begin(), qu.end(), unit.get()) != 1)
+						return false;
+				}
+			}
+
+			return true;
+		}
+
+		std::vector<std::unique_ptr<MockUnit>> units;
+		std::vector<MockQuad> quads;
+		std::vector<MockQuery> queries;
+		std::vector<uint32_t> hits;
+
+		int tempNum = 0;
+	};
+}
+
+
+TEST_CASE("QuadFieldPacked")
+{
+	for (const size_t numUnits: {1000, 5000, 20000}) {
+		MockField field(numUnits);
+
+		std::vector<MockUnit*> expected;
+		std::vector<MockUnit*> actual;
+
+		for (const MockQuery& q: field.queries) {
+			expected.clear();
+			actual.clear();
+
+			field.GetUnitsExact(expected, q, false);
+			field.GetUnitsExact(actual, q, true);
+
+			// same units in the same order
+			CHECK(expected == actual);
+
+			const float3 mins = q.pos - float3(q.radius, 0.0f, q.radius);
+			const float3 maxs = q.pos + float3(q.radius, 0.0f, q.radius);
+
+			expected.clear();
+			actual.clear();
+
+			field.GetUnitsExact(expected, mins, maxs, false);
+			field.GetUnitsExact(actual, mins, maxs, true);
+
+			CHECK(expected == actual);
+		}
+	}
+}
+
+TEST_CASE("QuadFieldPackedStale")
+{
+	// packed copies are only refreshed by CQuadField::MovedUnit; until then
+	// queries see a unit where it was, not where it is
+	MockField field(1000);
+	MockUnit* unit = field.units.front().get();
+
+	const float3 oldPos = unit->pos;
+	const MockQuery q = {oldPos, 1.0f, true};
+
+	std::vector<MockUnit*> live;
+	std::vector<MockUnit*> packed;
+
+	unit->pos.x += (unit->radius + q.radius) * 2.0f;
+
+	field.GetUnitsExact(live, q, false);
+	field.GetUnitsExact(packed, q, true);
+
+	CHECK(std::find(live.begin(), live.end(), unit) == live.end());
+	CHECK(std::find(packed.begin(), packed.end(), unit) != packed.end());
+
+	field.MovedUnit(unit);
+
+	live.clear();
+	packed.clear();
+
+	field.GetUnitsExact(live, q, false);
+	field.GetUnitsExact(packed, q, true);
+
+	CHECK(live == packed);
+}
+
+TEST_CASE("QuadFieldPackedMoves")
+{
+	// units moving within and across quads, leaving and coming back, keep
+	// the packed copies in line with the unit lists
+	MockField field(5000);
+
+	std::mt19937 rng(5678);
+	std::uniform_real_distribution<float> stepDist(-QUAD_SIZE * 0.75f, QUAD_SIZE * 0.75f);
+
+	std::vector<MockUnit*> removed;
+	std::vector<MockUnit*> expected;
+	std::vector<MockUnit*> actual;
+
+	for (int step = 0; step < 8; ++step) {
+		for (const auto& unit: field.units) {
+			if (std::find(removed.begin(), removed.end(), unit.get()) != removed.end())
+				continue;
+
+			unit->pos.x = std::clamp(unit->pos.x + stepDist(rng), 0.0f, MAP_SIZE - 1.0f);
+			unit->pos.z = std::clamp(unit->pos.z + stepDist(rng), 0.0f, MAP_SIZE - 1.0f);
+
+			field.MovedUnit(unit.get());
+		}
+
+		// take some units out of the field and put others back in
+		for (MockUnit* unit: removed) {
+			field.MovedUnit(unit);
+		}
+
+		removed.clear();
+
+		for (size_t i = step; i < field.units.size(); i += 7) {
+			field.RemoveUnit(field.units[i].get());
+			removed.push_back(field.units[i].get());
+		}
+
+		REQUIRE(field.CheckQuads());
+
+		for (const MockQuery& q: field.queries) {
+			expected.clear();
+			actual.clear();
+
+			field.GetUnitsExact(expected, q, false);
+			field.GetUnitsExact(actual, q, true);
+
+			CHECK(expected == actual);
+		}
+	}
+}
+
+TEST_CASE("QuadFieldPackedBenchmark", "[.][benchmark]")
+{
+	for (const size_t numUnits: {1000, 5000, 20000}) {
+		MockField field(numUnits);
+		std::vector<MockUnit*> result;
+
+		BENCHMARK("GetUnitsExact/" + std::to_string(numUnits)) {
+			for (const MockQuery& q: field.queries) {
+				result.clear();
+				field.GetUnitsExact(result, q, false);
+			}
+			return result.size();
+		};
+
+		BENCHMARK("GetUnitsExactPacked/" + std::to_string(numUnits)) {
+			for (const MockQuery& q: field.queries) {
+				result.clear();
+				field.GetUnitsExact(result, q, true);
+			}
+			return result.size();
+		};
+	}
+}
@@ -0,0 +1,149 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Misc/LosInstance.h"
+#include "Sim/Misc/LosMap.h"
+#include "Map/ReadMap.h"
+#include "System/Rectangle.h"
+#include "System/type2.h"
+
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+// referenced by CLosMap, only used when it sends ReadMap events
+class CGlobalUnsynced;
+CGlobalUnsynced* gu = nullptr;
+CReadMap* readMap = nullptr;
+MapDimensions mapDims;
+
+void CReadMap::UpdateLOS(const SRectangle& rect) {}
+
+
+static bool SameSquares(const SLosInstance& a, const SLosInstance& b)
+{
+	if (a.squares.size() != b.squares.size())
+		return false;
+
+	for (size_t i = 0; i < a.squares.size(); ++i) {
+		if (a.squares[i].start != b.squares[i].start || a.squares[i].length != b.squares[i].length)
+			return false;
+	}
+
+	return true;
+}
+
+
+TEST_CASE("LosMapIncrementalRaycast")
+{
+	// full-resolution heightmap and a LOS map at mip-level 1
+	static constexpr int MIP_LEVEL = 1;
+	static constexpr int MAP_X = 256;
+	static constexpr int MAP_Y = 192;
+	static constexpr int LOS_X = MAP_X >> MIP_LEVEL;
+	static constexpr int LOS_Y = MAP_Y >> MIP_LEVEL;
+
+	static constexpr int TEST_INSTANCES = 400;
+	static constexpr int TEST_TERRAFORMS = 8;
+
+	mapDims.mapx = MAP_X;
+	mapDims.mapy = MAP_Y;
+	mapDims.Initialize();
+
+	std::mt19937 rng(0x1057);
+	std::uniform_real_distribution<float> heightDist(-20.0f, 120.0f);
+
+	std::vector<float> ctrHeightMap(MAP_X * MAP_Y);
+	std::vector<float> mipHeightMap(LOS_X * LOS_Y);
+
+	// coarse noise so that rays get both occluded and free
+	for (int y = 0; y < LOS_Y; ++y) {
+		for (int x = 0; x < LOS_X; ++x) {
+			mipHeightMap[y * LOS_X + x] = heightDist(rng) * (((x / 5) + (y / 3)) % 3) * 0.5f;
+		}
+	}
+	for (int y = 0; y < MAP_Y; ++y) {
+		for (int x = 0; x < MAP_X; ++x) {
+			ctrHeightMap[y * MAP_X + x] = mipHeightMap[(y >> MIP_LEVEL) * LOS_X + (x >> MIP_LEVEL)];
+		}
+	}
+
+	CLosMap losMap;
+	losMap.Init(int2(LOS_X, LOS_Y), int2(MAP_X, MAP_Y), ctrHeightMap.data(), mipHeightMap.data(), false);
+
+	const auto Terraform = [&](const SRectangle& rect, float dh) {
+		for (int y = rect.y1; y < rect.y2; ++y) {
+			for (int x = rect.x1; x < rect.x2; ++x) {
+				mipHeightMap[y * LOS_X + x] += dh;
+
+				for (int fy = (y << MIP_LEVEL); fy < ((y + 1) << MIP_LEVEL); ++fy) {
+					for (int fx = (x << MIP_LEVEL); fx < ((x + 1) << MIP_LEVEL); ++fx) {
+						ctrHeightMap[fy * MAP_X + fx] += dh;
+					}
+				}
+			}
+		}
+	};
+
+	int numIncremental = 0;
+	int numFallbacks = 0;
+
+	for (int n = 0; n < TEST_INSTANCES; ++n) {
+		// (re)place the instance like a moved unit, near the border every now and then
+		const int radius = std::uniform_int_distribution<int>(2, 40)(rng);
+		const int2 basePos = {
+			std::uniform_int_distribution<int>(0, LOS_X - 1)(rng),
+			std::uniform_int_distribution<int>(0, LOS_Y - 1)(rng),
+		};
+		const float baseHeight = std::max(0.0f, mipHeightMap[basePos.y * LOS_X + basePos.x]) + std::uniform_real_distribution<float>(10.0f, 80.0f)(rng);
+
+		SLosInstance incremental(n);
+		incremental.allyteam = -1;
+		incremental.radius = radius;
+		incremental.basePos = basePos;
+		incremental.baseHeight = baseHeight;
+
+		losMap.PrepareRaycast(&incremental);
+
+		for (int t = 0; t < TEST_TERRAFORMS; ++t) {
+			const int w = std::uniform_int_distribution<int>(1, 6)(rng);
+			const int h = std::uniform_int_distribution<int>(1, 6)(rng);
+			const int x = std::clamp(basePos.x + std::uniform_int_distribution<int>(-radius, radius)(rng), 0, LOS_X - w);
+			const int y = std::clamp(basePos.y + std::uniform_int_distribution<int>(-radius, radius)(rng), 0, LOS_Y - h);
+
+			const SRectangle rect(x, y, x + w, y + h);
+
+			Terraform(rect, std::uniform_real_distribution<float>(-60.0f, 60.0f)(rng));
+
+			// same handling as ILosType::Update
+			incremental.damagedRects.push_back(rect);
+
+			if (!losMap.UpdateRaycast(&incremental)) {
+				incremental.squares.clear();
+				losMap.PrepareRaycast(&incremental);
+				numFallbacks++;
+			} else {
+				numIncremental++;
+			}
+
+			incremental.damagedRects.clear();
+
+			SLosInstance full(n);
+			full.allyteam = -1;
+			full.radius = radius;
+			full.basePos = basePos;
+			full.baseHeight = baseHeight;
+
+			losMap.PrepareRaycast(&full);
+
+			CAPTURE(n, t, radius, basePos.x, basePos.y, rect.x1, rect.y1, rect.x2, rect.y2);
+			REQUIRE(SameSquares(incremental, full));
+		}
+	}
+
+	// both paths have to be taken for the comparison to mean anything
+	CHECK(numIncremental > (TEST_INSTANCES * TEST_TERRAFORMS) / 2);
+	CHECK(numFallbacks > 0);
+}
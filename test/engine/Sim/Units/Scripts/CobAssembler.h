@@ -0,0 +1,52 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#ifndef TEST_COB_ASSEMBLER_H
+#define TEST_COB_ASSEMBLER_H
+
+#include "Sim/Units/Scripts/CobFile.h"
+#include "Sim/Units/Scripts/CobInterpreter.h"
+#include "Sim/Units/Scripts/CobOpcodes.h"
+
+#include <algorithm>
+#include <string>
+
+// assembles scripts into a CCobFile laid out like CCobFile's ctor does
+struct CobAssembler {
+	void Begin(const std::string& name) {
+		file.scriptNames.push_back(name);
+		file.scriptOffsets.push_back(Here());
+	}
+
+	CobAssembler& Op(int opcode) { file.code.push_back(opcode); return *this; }
+	CobAssembler& Op(int opcode, int a) { file.code.insert(file.code.end(), {opcode, a}); return *this; }
+	CobAssembler& Op(int opcode, int a, int b) { file.code.insert(file.code.end(), {opcode, a, b}); return *this; }
+
+	int Here() const { return static_cast<int>(file.code.size()); }
+	int Func(const std::string& name) const { return static_cast<int>(std::find(file.scriptNames.begin(), file.scriptNames.end(), name) - file.scriptNames.begin()); }
+
+	// points the jump at <at> to the current offset
+	void Patch(int at) { file.code[at + 1] = Here(); }
+
+	CCobFile& Finish(int numStaticVars) {
+		for (size_t i = 0, n = file.scriptOffsets.size(); i < n; i++) {
+			const int next = (i + 1 < n)? file.scriptOffsets[i + 1]: Here();
+			file.scriptLengths.push_back(next - file.scriptOffsets[i]);
+		}
+
+		file.code.resize(file.code.size() + 4, 0);
+		file.numStaticVars = numStaticVars;
+		file.name = "test.cob";
+		file.scriptIndex.fill(-1);
+
+		const int fire = Func("FirePrimary");
+		if (fire < static_cast<int>(file.scriptNames.size()))
+			file.scriptIndex[COBFN_FirePrimary] = fire;
+
+		CobInterpreter::Decode(file, file.instrs);
+		return file;
+	}
+
+	CCobFile file;
+};
+
+#endif // TEST_COB_ASSEMBLER_H
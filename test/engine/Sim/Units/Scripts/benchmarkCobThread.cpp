@@ -0,0 +1,833 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Units/Scripts/CobFile.h"
+#include "Sim/Units/Scripts/CobInterpreter.h"
+#include "Sim/Units/Scripts/CobOpcodes.h"
+#include "CobAssembler.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#define CATCH_CONFIG_ENABLE_BENCHMARKING
+#include "lib/catch.hpp"
+
+// compares the pre-decoded, direct-threaded COB interpreter (CobInterpreter::Run)
+// with the switch interpreter it replaced, which re-read every operand from the
+// raw code; run with the "[benchmark]" tag to get timings, e.g.
+// test_CobThread "[benchmark]"
+
+namespace {
+	// MAX_LUA_COB_ARGS, see Lua/LuaRules.h
+	constexpr int NUM_LUA_COB_ARGS = 10;
+
+	struct MockCobThread;
+
+	// stand-in for CCobInstance, records every call made into it
+	struct MockCobInstance {
+		explicit MockCobInstance(int numStaticVars): staticVars(numStaticVars, 0) {}
+
+		void Record(int a, int b = 0, int c = 0, int d = 0, int e = 0) { trace.insert(trace.end(), {a, b, c, d, e}); }
+
+		void Move(int p, int a, int pos, int speed) { Record(1, p, a, pos, speed); }
+		void Turn(int p, int a, int dest, int speed) { Record(2, p, a, dest, speed); }
+		void Spin(int p, int a, int speed, int accel) { Record(3, p, a, speed, accel); }
+		void StopSpin(int p, int a, int decel) { Record(4, p, a, decel); }
+		void MoveNow(int p, int a, int pos) { Record(5, p, a, pos); }
+		void TurnNow(int p, int a, int dest) { Record(6, p, a, dest); }
+		void SetVisibility(int p, bool visible) { Record(7, p, visible); }
+		void ShowFlare(int p) { Record(8, p); }
+		void EmitSfx(int type, int p) { Record(9, type, p); }
+		void Explode(int p, int flags) { Record(10, p, flags); }
+		void PlayUnitSound(int snd, int attr) { Record(11, snd, attr); }
+		void AttachUnit(int p, int u) { Record(12, p, u); }
+		void DropUnit(int u) { Record(13, u); }
+		void SetUnitVal(int val, int param) { Record(14, val, param); }
+		void Signal(int signal);
+
+		int GetUnitVal(int val, int p1, int p2, int p3, int p4) {
+			Record(15, val, p1, p2, p3);
+			return (val * 3 + p1 - p2 + p3 * p4);
+		}
+
+		std::vector<int> staticVars;
+		std::vector<int> trace;
+
+		MockCobThread* thread = nullptr;
+	};
+
+	// mirrors the parts of CCobThread the interpreter uses
+	struct MockCobThread {
+		enum State {Init, Sleep, Run, Dead, WaitTurn, WaitMove};
+
+		struct CallInfo {
+			int functionId = -1;
+			int returnAddr = -1;
+			int stackTop = -1;
+		};
+
+		MockCobThread(MockCobInstance* inst, const CCobFile* file): cobInst(inst), cobFile(file) { inst->thread = this; }
+
+		void Start(int functionId, int sigMask) {
+			state = Run;
+			pc = cobFile->scriptOffsets[functionId];
+			signalMask = sigMask;
+
+			CallInfo& ci = PushCallStackRef();
+			ci.functionId = functionId;
+			ci.returnAddr = -1;
+			ci.stackTop = 0;
+		}
+
+		void LuaCall(int scriptId, int numArgs) {
+			const int size = static_cast<int>(dataStack.size());
+			const int argCount = std::min(numArgs, NUM_LUA_COB_ARGS);
+			const int start = std::max(0, size - numArgs);
+			const int end = std::min(size, start + argCount);
+
+			for (int a = 0, i = start; i < end; i++) {
+				luaArgs[a++] = dataStack[i];
+			}
+
+			if (numArgs >= size) {
+				dataStack.clear();
+			} else {
+				dataStack.resize(size - numArgs);
+			}
+
+			cobInst->Record(20, scriptId, numArgs, luaArgs[0], luaArgs[1]);
+			luaArgs[0] = 1;
+			retCode = luaArgs[0];
+		}
+
+		void ScheduleWakeUp(int delay) {
+			cobInst->Record(21, delay);
+			state = Sleep;
+		}
+		void StartChildThread(int functionId, int argCount) {
+			cobInst->Record(22, functionId, argCount);
+
+			for (int i = 0; i < argCount; i++) {
+				cobInst->Record(23, PopDataStack());
+			}
+		}
+		int RandInt(int lo, int hi) {
+			rngState = rngState * 1103515245u + 12345u;
+			return (static_cast<int>((rngState >> 16) % static_cast<unsigned int>(hi - lo + 1)) + lo);
+		}
+		bool NeedsWaitTurn(int piece, int axis) const { return (((piece + axis) & 1) != 0); }
+		bool NeedsWaitMove(int piece, int axis) const { return (((piece + axis) & 1) == 0); }
+
+		void ShowError(const char* msg) { cobInst->Record(24, int(msg[0])); }
+
+		void PushDataStack(int v) { dataStack.push_back(v); }
+		CallInfo& PushCallStackRef() { return callStack.emplace_back(); }
+
+		int LocalFunctionID() const { return callStack.back().functionId; }
+		int LocalReturnAddr() const { return callStack.back().returnAddr; }
+		int LocalStackFrame() const { return callStack.back().stackTop; }
+
+		int PopDataStack() {
+			if (dataStack.empty())
+				return 0;
+
+			const int ret = dataStack.back();
+			dataStack.pop_back();
+			return ret;
+		}
+
+		MockCobInstance* cobInst = nullptr;
+		const CCobFile* cobFile = nullptr;
+
+		int pc = 0;
+		int paramCount = 0;
+		int retCode = -1;
+		int signalMask = 0;
+
+		int waitAxis = -1;
+		int waitPiece = -1;
+
+		int luaArgs[NUM_LUA_COB_ARGS] = {0};
+
+		std::vector<CallInfo> callStack;
+		std::vector<int> dataStack;
+
+		State state = Init;
+
+		unsigned int rngState = 1;
+	};
+
+	void MockCobInstance::Signal(int signal) {
+		Record(16, signal);
+
+		if ((signal & thread->signalMask) != 0)
+			thread->state = MockCobThread::Dead;
+	}
+
+
+	// the interpreter loop of CCobThread::Tick before scripts were decoded,
+	// working on the raw (self-modifying) code
+	bool TickSwitch(MockCobThread& t, std::vector<int>& code)
+	{
+		#define GET_LONG_PC() (code.at(t.pc++))
+
+		int r1, r2, r3, r4, r5, r6;
+
+		while (t.state == MockCobThread::Run) {
+			const int opcode = GET_LONG_PC();
+
+			switch (opcode) {
+				case PUSH_CONSTANT: {
+					r1 = GET_LONG_PC();
+					t.PushDataStack(r1);
+				} break;
+				case SLEEP: {
+					t.ScheduleWakeUp(t.PopDataStack());
+					return true;
+				} break;
+				case SPIN: {
+					r1 = GET_LONG_PC();
+					r2 = GET_LONG_PC();
+					r3 = t.PopDataStack();
+					r4 = t.PopDataStack();
+					t.cobInst->Spin(r1, r2, r3, r4);
+				} break;
+				case STOP_SPIN: {
+					r1 = GET_LONG_PC();
+					r2 = GET_LONG_PC();
+					r3 = t.PopDataStack();
+					t.cobInst->StopSpin(r1, r2, r3);
+				} break;
+				case RETURN: {
+					t.retCode = t.PopDataStack();
+
+					if (t.LocalReturnAddr() == -1) {
+						t.state = MockCobThread::Dead;
+						return false;
+					}
+
+					t.pc = t.LocalReturnAddr();
+					if (t.dataStack.size() > t.LocalStackFrame())
+						t.dataStack.resize(t.LocalStackFrame());
+
+					t.callStack.pop_back();
+				} break;
+
+				case SHADE:
+				case DONT_SHADE:
+				case CACHE:
+				case DONT_CACHE: {
+					r1 = GET_LONG_PC();
+				} break;
+
+				case CALL: {
+					r1 = GET_LONG_PC();
+					t.pc--;
+
+					if (t.cobFile->scriptNames[r1].find("lua_") == 0) {
+						code[t.pc - 1] = LUA_CALL;
+						r1 = GET_LONG_PC();
+						r2 = GET_LONG_PC();
+						t.LuaCall(r1, r2);
+						break;
+					}
+
+					code[t.pc - 1] = REAL_CALL;
+				} [[fallthrough]];
+				case REAL_CALL: {
+					r1 = GET_LONG_PC();
+					r2 = GET_LONG_PC();
+
+					if (t.cobFile->scriptLengths[r1] == 0)
+						break;
+
+					MockCobThread::CallInfo& ci = t.PushCallStackRef();
+					ci.functionId = r1;
+					ci.returnAddr = t.pc;
+					ci.stackTop = t.dataStack.size() - r2;
+
+					t.paramCount = r2;
+					t.pc = t.cobFile->scriptOffsets[r1];
+				} break;
+				case LUA_CALL: {
+					r1 = GET_LONG_PC();
+					r2 = GET_LONG_PC();
+					t.LuaCall(r1, r2);
+				} break;
+
+				case POP_STATIC: {
+					r1 = GET_LONG_PC();
+					r2 = t.PopDataStack();
+
+					if (static_cast<size_t>(r1) < t.cobInst->staticVars.size())
+						t.cobInst->staticVars[r1] = r2;
+				} break;
+				case POP_STACK: {
+					t.PopDataStack();
+				} break;
+
+				case START: {
+					r1 = GET_LONG_PC();
+					r2 = GET_LONG_PC();
+
+					if (t.cobFile->scriptLengths[r1] == 0)
+						break;
+
+					t.StartChildThread(r1, r2);
+				} break;
+
+				case CREATE_LOCAL_VAR: {
+					if (t.paramCount == 0) {
+						t.PushDataStack(0);
+					} else {
+						t.paramCount--;
+					}
+				} break;
+				case GET_UNIT_VALUE: {
+					r1 = t.PopDataStack();
+					if ((r1 >= LUA0) && (r1 <= LUA9)) {
+						t.PushDataStack(t.luaArgs[r1 - LUA0]);
+						break;
+					}
+					t.PushDataStack(t.cobInst->GetUnitVal(r1, 0, 0, 0, 0));
+				} break;
+
+				case JUMP_NOT_EQUAL: {
+					r1 = GET_LONG_PC();
+					r2 = t.PopDataStack();
+
+					if (r2 == 0)
+						t.pc = r1;
+				} break;
+				case JUMP: {
+					r1 = GET_LONG_PC();
+					t.pc = r1;
+				} break;
+
+				case POP_LOCAL_VAR: {
+					r1 = GET_LONG_PC();
+					r2 = t.PopDataStack();
+					t.dataStack[t.LocalStackFrame() + r1] = r2;
+				} break;
+				case PUSH_LOCAL_VAR: {
+					r1 = GET_LONG_PC();
+					r2 = t.dataStack[t.LocalStackFrame() + r1];
+					t.PushDataStack(r2);
+				} break;
+
+				case BITWISE_AND: { r1 = t.PopDataStack(); r2 = t.PopDataStack(); t.PushDataStack(r1 & r2); } break;
+				case BITWISE_OR : { r1 = t.PopDataStack(); r2 = t.PopDataStack(); t.PushDataStack(r1 | r2); } break;
+				case BITWISE_XOR: { r1 = t.PopDataStack(); r2 = t.PopDataStack(); t.PushDataStack(r1 ^ r2); } break;
+				case BITWISE_NOT: { r1 = t.PopDataStack(); t.PushDataStack(~r1); } break;
+
+				case EXPLODE: {
+					r1 = GET_LONG_PC();
+					r2 = t.PopDataStack();
+					t.cobInst->Explode(r1, r2);
+				} break;
+				case PLAY_SOUND: {
+					r1 = GET_LONG_PC();
+					r2 = t.PopDataStack();
+					t.cobInst->PlayUnitSound(r1, r2);
+				} break;
+
+				case PUSH_STATIC: {
+					r1 = GET_LONG_PC();
+
+					if (static_cast<size_t>(r1) < t.cobInst->staticVars.size())
+						t.PushDataStack(t.cobInst->staticVars[r1]);
+				} break;
+
+				case SET_NOT_EQUAL       : { r1 = t.PopDataStack(); r2 = t.PopDataStack(); t.PushDataStack(int(r1 != r2)); } break;
+				case SET_EQUAL           : { r1 = t.PopDataStack(); r2 = t.PopDataStack(); t.PushDataStack(int(r1 == r2)); } break;
+				case SET_LESS            : { r2 = t.PopDataStack(); r1 = t.PopDataStack(); t.PushDataStack(int(r1 <  r2)); } break;
+				case SET_LESS_OR_EQUAL   : { r2 = t.PopDataStack(); r1 = t.PopDataStack(); t.PushDataStack(int(r1 <= r2)); } break;
+				case SET_GREATER         : { r2 = t.PopDataStack(); r1 = t.PopDataStack(); t.PushDataStack(int(r1 >  r2)); } break;
+				case SET_GREATER_OR_EQUAL: { r2 = t.PopDataStack(); r1 = t.PopDataStack(); t.PushDataStack(int(r1 >= r2)); } break;
+
+				case RAND: {
+					r2 = t.PopDataStack();
+					r1 = t.PopDataStack();
+					t.PushDataStack(t.RandInt(r1, r2));
+				} break;
+				case EMIT_SFX: {
+					r1 = t.PopDataStack();
+					r2 = GET_LONG_PC();
+					t.cobInst->EmitSfx(r1, r2);
+				} break;
+				case MUL: { r1 = t.PopDataStack(); r2 = t.PopDataStack(); t.PushDataStack(r1 * r2); } break;
+
+				case SIGNAL: {
+					r1 = t.PopDataStack();
+					t.cobInst->Signal(r1);
+				} break;
+				case SET_SIGNAL_MASK: {
+					t.signalMask = t.PopDataStack();
+				} break;
+
+				case TURN: {
+					r2 = t.PopDataStack();
+					r1 = t.PopDataStack();
+					r3 = GET_LONG_PC();
+					r4 = GET_LONG_PC();
+					t.cobInst->Turn(r3, r4, r1, r2);
+				} break;
+				case GET: {
+					r5 = t.PopDataStack();
+					r4 = t.PopDataStack();
+					r3 = t.PopDataStack();
+					r2 = t.PopDataStack();
+					r1 = t.PopDataStack();
+					if ((r1 >= LUA0) && (r1 <= LUA9)) {
+						t.PushDataStack(t.luaArgs[r1 - LUA0]);
+						break;
+					}
+					r6 = t.cobInst->GetUnitVal(r1, r2, r3, r4, r5);
+					t.PushDataStack(r6);
+				} break;
+				case ADD: { r2 = t.PopDataStack(); r1 = t.PopDataStack(); t.PushDataStack(r1 + r2); } break;
+				case SUB: { r2 = t.PopDataStack(); r1 = t.PopDataStack(); t.PushDataStack(r1 - r2); } break;
+
+				case DIV: {
+					r2 = t.PopDataStack();
+					r1 = t.PopDataStack();
+
+					if (r2 != 0) {
+						r3 = r1 / r2;
+					} else {
+						r3 = 1000;
+						t.ShowError("division by zero");
+					}
+					t.PushDataStack(r3);
+				} break;
+				case MOD: {
+					r2 = t.PopDataStack();
+					r1 = t.PopDataStack();
+
+					if (r2 != 0) {
+						t.PushDataStack(r1 % r2);
+					} else {
+						t.PushDataStack(0);
+						t.ShowError("modulo division by zero");
+					}
+				} break;
+
+				case MOVE: {
+					r1 = GET_LONG_PC();
+					r2 = GET_LONG_PC();
+					r4 = t.PopDataStack();
+					r3 = t.PopDataStack();
+					t.cobInst->Move(r1, r2, r3, r4);
+				} break;
+				case MOVE_NOW: {
+					r1 = GET_LONG_PC();
+					r2 = GET_LONG_PC();
+					r3 = t.PopDataStack();
+					t.cobInst->MoveNow(r1, r2, r3);
+				} break;
+				case TURN_NOW: {
+					r1 = GET_LONG_PC();
+					r2 = GET_LONG_PC();
+					r3 = t.PopDataStack();
+					t.cobInst->TurnNow(r1, r2, r3);
+				} break;
+
+				case WAIT_TURN: {
+					r1 = GET_LONG_PC();
+					r2 = GET_LONG_PC();
+
+					if (t.NeedsWaitTurn(r1, r2)) {
+						t.state = MockCobThread::WaitTurn;
+						t.waitPiece = r1;
+						t.waitAxis = r2;
+						return true;
+					}
+				} break;
+				case WAIT_MOVE: {
+					r1 = GET_LONG_PC();
+					r2 = GET_LONG_PC();
+
+					if (t.NeedsWaitMove(r1, r2)) {
+						t.state = MockCobThread::WaitMove;
+						t.waitPiece = r1;
+						t.waitAxis = r2;
+						return true;
+					}
+				} break;
+
+				case SET: {
+					r2 = t.PopDataStack();
+					r1 = t.PopDataStack();
+
+					if ((r1 >= LUA0) && (r1 <= LUA9)) {
+						t.luaArgs[r1 - LUA0] = r2;
+						break;
+					}
+
+					t.cobInst->SetUnitVal(r1, r2);
+				} break;
+
+				case ATTACH: {
+					r3 = t.PopDataStack();
+					r2 = t.PopDataStack();
+					r1 = t.PopDataStack();
+					t.cobInst->AttachUnit(r2, r1);
+				} break;
+				case DROP: {
+					t.cobInst->DropUnit(t.PopDataStack());
+				} break;
+
+				case LOGICAL_NOT: { r1 = t.PopDataStack(); t.PushDataStack(int(r1 == 0)); } break;
+				case LOGICAL_AND: { r1 = t.PopDataStack(); r2 = t.PopDataStack(); t.PushDataStack(int(r1 && r2)); } break;
+				case LOGICAL_OR : { r1 = t.PopDataStack(); r2 = t.PopDataStack(); t.PushDataStack(int(r1 || r2)); } break;
+				case LOGICAL_XOR: { r1 = t.PopDataStack(); r2 = t.PopDataStack(); t.PushDataStack(int((!!r1) ^ (!!r2))); } break;
+
+				case HIDE: {
+					r1 = GET_LONG_PC();
+					t.cobInst->SetVisibility(r1, false);
+				} break;
+				case SHOW: {
+					r1 = GET_LONG_PC();
+
+					int i;
+					for (i = 0; i < MAX_WEAPONS_PER_UNIT; ++i)
+						if (t.LocalFunctionID() == t.cobFile->scriptIndex[COBFN_FirePrimary + COBFN_Weapon_Funcs * i])
+							break;
+
+					if (i < MAX_WEAPONS_PER_UNIT) {
+						t.cobInst->ShowFlare(r1);
+					} else {
+						t.cobInst->SetVisibility(r1, true);
+					}
+				} break;
+
+				default: {
+					t.state = MockCobThread::Dead;
+					return false;
+				} break;
+			}
+		}
+
+		#undef GET_LONG_PC
+
+		return (t.state != MockCobThread::Dead);
+	}
+
+
+	// for i in [0, iters): acc = (acc + i * 3) ^ 7; static0 += i
+	void EmitLoop(CobAssembler& as, int iters) {
+		as.Op(CREATE_LOCAL_VAR).Op(CREATE_LOCAL_VAR);
+
+		const int top = as.Here();
+		as.Op(PUSH_LOCAL_VAR, 0).Op(PUSH_CONSTANT, iters).Op(SET_LESS);
+		const int exit = as.Here();
+		as.Op(JUMP_NOT_EQUAL, 0);
+
+		as.Op(PUSH_LOCAL_VAR, 1).Op(PUSH_LOCAL_VAR, 0).Op(PUSH_CONSTANT, 3).Op(MUL).Op(ADD).Op(PUSH_CONSTANT, 7).Op(BITWISE_XOR).Op(POP_LOCAL_VAR, 1);
+		as.Op(PUSH_STATIC, 0).Op(PUSH_LOCAL_VAR, 0).Op(ADD).Op(POP_STATIC, 0);
+		as.Op(PUSH_LOCAL_VAR, 0).Op(PUSH_CONSTANT, 1).Op(ADD).Op(POP_LOCAL_VAR, 0);
+		as.Op(JUMP, top);
+
+		as.Patch(exit);
+		as.Op(PUSH_LOCAL_VAR, 1).Op(RETURN);
+	}
+
+	CCobFile& AssembleTestFile(CobAssembler& as, int loopIters) {
+		// function ids are fixed by declaration order
+		const int callee = 1;
+		const int empty = 2;
+		const int luaFoo = 3;
+		const int fire = 6;
+
+		as.Begin("Loop");
+		EmitLoop(as, loopIters);
+
+		// (a, b) -> (a - b) / 0 + a % b
+		as.Begin("Callee");
+		as.Op(CREATE_LOCAL_VAR).Op(CREATE_LOCAL_VAR);
+		as.Op(PUSH_LOCAL_VAR, 0).Op(PUSH_LOCAL_VAR, 1).Op(SUB).Op(PUSH_CONSTANT, 0).Op(DIV);
+		as.Op(PUSH_LOCAL_VAR, 0).Op(PUSH_LOCAL_VAR, 1).Op(MOD).Op(ADD).Op(RETURN);
+
+		as.Begin("Empty");
+		as.Begin("lua_Foo");
+
+		// CALL's are rewritten by the switch interpreter on first execution, run them thrice
+		as.Begin("Calls");
+		as.Op(CREATE_LOCAL_VAR).Op(CREATE_LOCAL_VAR);
+		{
+			const int top = as.Here();
+			as.Op(PUSH_LOCAL_VAR, 0).Op(PUSH_CONSTANT, 3).Op(SET_LESS);
+			const int exit = as.Here();
+			as.Op(JUMP_NOT_EQUAL, 0);
+
+			// accumulate into local 1
+			as.Op(PUSH_LOCAL_VAR, 1);
+			as.Op(PUSH_CONSTANT, 10).Op(PUSH_LOCAL_VAR, 0).Op(CALL, callee, 2);
+			as.Op(CALL, empty, 0).Op(START, empty, 0);
+			as.Op(PUSH_CONSTANT, 1).Op(PUSH_CONSTANT, 2).Op(CALL, luaFoo, 2);
+			as.Op(PUSH_CONSTANT, LUA0).Op(GET_UNIT_VALUE).Op(ADD);
+			as.Op(PUSH_CONSTANT, 5).Op(START, callee, 1);
+			as.Op(PUSH_CONSTANT, 1).Op(PUSH_CONSTANT, 6).Op(RAND).Op(ADD);
+			as.Op(PUSH_CONSTANT, LUA1).Op(PUSH_CONSTANT, 42).Op(SET);
+			as.Op(PUSH_CONSTANT, LUA1).Op(PUSH_CONSTANT, 0).Op(PUSH_CONSTANT, 0).Op(PUSH_CONSTANT, 0).Op(PUSH_CONSTANT, 0).Op(GET).Op(ADD);
+			as.Op(PUSH_CONSTANT, 7).Op(PUSH_CONSTANT, 1).Op(PUSH_CONSTANT, 2).Op(PUSH_CONSTANT, 3).Op(PUSH_CONSTANT, 4).Op(GET).Op(ADD);
+			as.Op(PUSH_CONSTANT, 9).Op(GET_UNIT_VALUE).Op(ADD);
+			as.Op(POP_LOCAL_VAR, 1).Op(PUSH_LOCAL_VAR, 1).Op(POP_STATIC, 1);
+			as.Op(PUSH_LOCAL_VAR, 0).Op(PUSH_CONSTANT, 1).Op(ADD).Op(POP_LOCAL_VAR, 0);
+			as.Op(JUMP, top);
+
+			as.Patch(exit);
+		}
+		as.Op(PUSH_LOCAL_VAR, 1).Op(RETURN);
+
+		as.Begin("Anim");
+		as.Op(PUSH_CONSTANT, 100).Op(PUSH_CONSTANT, 20).Op(MOVE, 1, 0);
+		as.Op(PUSH_CONSTANT, 300).Op(PUSH_CONSTANT, 40).Op(TURN, 2, 1);
+		as.Op(PUSH_CONSTANT, 5).Op(PUSH_CONSTANT, 6).Op(SPIN, 3, 2);
+		as.Op(PUSH_CONSTANT, 7).Op(STOP_SPIN, 3, 2);
+		as.Op(PUSH_CONSTANT, 8).Op(MOVE_NOW, 1, 1);
+		as.Op(PUSH_CONSTANT, 9).Op(TURN_NOW, 2, 2);
+		as.Op(SHADE, 1).Op(DONT_SHADE, 1).Op(CACHE, 1).Op(DONT_CACHE, 1);
+		as.Op(PUSH_CONSTANT, 1024).Op(EMIT_SFX, 4);
+		as.Op(PUSH_CONSTANT, 3).Op(EXPLODE, 4).Op(PUSH_CONSTANT, 2).Op(PLAY_SOUND, 1);
+		as.Op(WAIT_TURN, 1, 0).Op(WAIT_MOVE, 1, 1).Op(WAIT_TURN, 1, 1);
+		as.Op(SHOW, 3).Op(HIDE, 2).Op(CALL, fire, 0);
+		as.Op(PUSH_CONSTANT, 33).Op(SLEEP);
+		as.Op(PUSH_CONSTANT, 11).Op(PUSH_CONSTANT, 12).Op(PUSH_CONSTANT, 13).Op(ATTACH).Op(PUSH_CONSTANT, 14).Op(DROP);
+		as.Op(PUSH_CONSTANT, 20).Op(PUSH_CONSTANT, 21).Op(SET);
+		as.Op(PUSH_STATIC, 99).Op(PUSH_CONSTANT, 1).Op(POP_STATIC, 99);
+		as.Op(PUSH_CONSTANT, 5).Op(PUSH_CONSTANT, 0).Op(LOGICAL_AND).Op(PUSH_CONSTANT, 5).Op(LOGICAL_OR).Op(PUSH_CONSTANT, 1).Op(LOGICAL_XOR).Op(LOGICAL_NOT);
+		as.Op(PUSH_CONSTANT, 5).Op(PUSH_CONSTANT, 5).Op(SET_LESS_OR_EQUAL).Op(PUSH_CONSTANT, 2).Op(SET_GREATER).Op(PUSH_CONSTANT, 1).Op(SET_GREATER_OR_EQUAL);
+		as.Op(PUSH_CONSTANT, 4).Op(SET_EQUAL).Op(PUSH_CONSTANT, 0).Op(SET_NOT_EQUAL).Op(BITWISE_NOT).Op(PUSH_CONSTANT, 6).Op(BITWISE_AND).Op(PUSH_CONSTANT, 1).Op(BITWISE_OR);
+		as.Op(PUSH_CONSTANT, 3).Op(PUSH_CONSTANT, 0).Op(MOD).Op(POP_STACK);
+		as.Op(PUSH_CONSTANT, 2).Op(SET_SIGNAL_MASK).Op(PUSH_CONSTANT, 1).Op(SIGNAL);
+		// kills the thread, nothing after this runs
+		as.Op(PUSH_CONSTANT, 2).Op(SIGNAL).Op(PUSH_CONSTANT, 77).Op(DROP).Op(RETURN);
+
+		as.Begin("FirePrimary");
+		as.Op(SHOW, 5).Op(PUSH_CONSTANT, 1).Op(RETURN);
+
+		as.Begin("Unknown");
+		as.Op(PUSH_CONSTANT, 1).Op(0x12345678).Op(PUSH_CONSTANT, 2).Op(RETURN);
+
+		as.Begin("BadJump");
+		as.Op(PUSH_CONSTANT, 1).Op(JUMP, 1 << 20);
+
+		// jumps into the operand of the PUSH_CONSTANT, which holds a valid opcode
+		as.Begin("OperandJump");
+		{
+			const int push = as.Here();
+			as.Op(PUSH_CONSTANT, RETURN).Op(PUSH_CONSTANT, 8).Op(JUMP, push + 1);
+		}
+
+		return (as.Finish(2));
+	}
+
+
+	struct RunResult {
+		std::vector<int> trace;
+		std::vector<int> staticVars;
+		std::vector<int> dataStack;
+
+		int retCode = 0;
+		int pc = 0;
+		int state = 0;
+		int ticks = 0;
+		bool threw = false;
+
+		bool operator == (const RunResult& r) const {
+			return
+				trace == r.trace && staticVars == r.staticVars && dataStack == r.dataStack &&
+				retCode == r.retCode && pc == r.pc && state == r.state && ticks == r.ticks && threw == r.threw;
+		}
+	};
+
+	// ticks the script until it dies, waking it right away when it blocks
+	template<typename TickFunc>
+	RunResult RunScript(const CCobFile& file, int functionId, TickFunc&& tick) {
+		MockCobInstance inst(file.numStaticVars);
+		MockCobThread thread(&inst, &file);
+
+		RunResult res;
+
+		thread.Start(functionId, 0);
+
+		try {
+			for (res.ticks = 0; res.ticks < 16; res.ticks++) {
+				if (thread.state == MockCobThread::Dead)
+					break;
+
+				thread.state = MockCobThread::Run;
+
+				if (!tick(thread))
+					break;
+			}
+		} catch (const std::out_of_range&) {
+			res.threw = true;
+		}
+
+		res.trace = std::move(inst.trace);
+		res.staticVars = std::move(inst.staticVars);
+		res.dataStack = std::move(thread.dataStack);
+		res.retCode = thread.retCode;
+		// where a bad access leaves pc differs between the interpreters
+		res.pc = res.threw? -1: thread.pc;
+		res.state = thread.state;
+		return res;
+	}
+
+	RunResult RunDecoded(const CCobFile& file, int functionId) {
+		return (RunScript(file, functionId, [](MockCobThread& t) { return CobInterpreter::Run(t); }));
+	}
+
+	// runs ahead up to the first instruction with outside effects before each tick, like CCobEngine
+	RunResult RunSpeculated(const CCobFile& file, int functionId) {
+		return (RunScript(file, functionId, [](MockCobThread& t) { CobInterpreter::Run<true>(t); return CobInterpreter::Run(t); }));
+	}
+
+	RunResult RunSwitch(const CCobFile& file, int functionId, std::vector<int>& code) {
+		return (RunScript(file, functionId, [&](MockCobThread& t) { return TickSwitch(t, code); }));
+	}
+}
+
+
+TEST_CASE("CobInterpreterMatchesSwitch")
+{
+	CobAssembler as;
+	const CCobFile& file = AssembleTestFile(as, 100);
+
+	// the switch interpreter rewrites CALL's in place
+	std::vector<int> code = file.code;
+
+	for (size_t fn = 0; fn < file.scriptNames.size(); fn++) {
+		if (file.scriptLengths[fn] == 0)
+			continue;
+
+		CAPTURE(file.scriptNames[fn]);
+
+		const RunResult decoded = RunDecoded(file, fn);
+		const RunResult switched = RunSwitch(file, fn, code);
+
+		CHECK(decoded == switched);
+		CHECK(!decoded.trace.empty() == (file.scriptNames[fn] == "Callee" || file.scriptNames[fn] == "Calls" || file.scriptNames[fn] == "Anim" || file.scriptNames[fn] == "FirePrimary"));
+	}
+
+	CHECK(RunDecoded(file, as.Func("Loop")).retCode != 0);
+	CHECK(RunDecoded(file, as.Func("Anim")).state == MockCobThread::Dead);
+	CHECK(RunDecoded(file, as.Func("Unknown")).state == MockCobThread::Dead);
+	CHECK(RunDecoded(file, as.Func("BadJump")).threw);
+	CHECK(RunDecoded(file, as.Func("OperandJump")).retCode == 8);
+
+	// decoding is repeatable and does not touch the raw code
+	std::vector<CobInterpreter::Instr> instrs;
+	CobInterpreter::Decode(file, instrs);
+
+	CHECK(instrs.size() == file.code.size() + 1);
+	CHECK(std::find(file.code.begin(), file.code.end(), REAL_CALL) == file.code.end());
+}
+
+
+TEST_CASE("CobInterpreterSpeculation")
+{
+	CobAssembler as;
+	const CCobFile& file = AssembleTestFile(as, 100);
+
+	for (size_t fn = 0; fn < file.scriptNames.size(); fn++) {
+		if (file.scriptLengths[fn] == 0)
+			continue;
+
+		CAPTURE(file.scriptNames[fn]);
+		CHECK(RunSpeculated(file, fn) == RunDecoded(file, fn));
+	}
+
+	// the whole loop runs speculatively, up to the final RETURN
+	MockCobInstance inst(file.numStaticVars);
+	MockCobThread thread(&inst, &file);
+
+	thread.Start(as.Func("Loop"), 0);
+	CobInterpreter::Run<true>(thread);
+
+	CHECK(thread.state == MockCobThread::Run);
+	CHECK(file.code[thread.pc] == RETURN);
+	CHECK(inst.staticVars[0] == (99 * 100) / 2);
+	CHECK(inst.trace.empty());
+
+	// nothing runs ahead of a call into the instance
+	MockCobInstance animInst(file.numStaticVars);
+	MockCobThread animThread(&animInst, &file);
+
+	animThread.Start(as.Func("Anim"), 0);
+	CobInterpreter::Run<true>(animThread);
+
+	CHECK(animThread.pc == file.scriptOffsets[as.Func("Anim")] + 4);
+	CHECK(animInst.trace.empty());
+}
+
+
+TEST_CASE("CobInterpreterCountSpeculative")
+{
+	CobAssembler as;
+	const CCobFile& file = AssembleTestFile(as, 100);
+
+	// what CCobEngine checks before running a thread ahead matches what the
+	// interpreter does; both stop at the first impure op
+	for (size_t fn = 0; fn < file.scriptNames.size(); fn++) {
+		if (file.scriptLengths[fn] == 0)
+			continue;
+
+		CAPTURE(file.scriptNames[fn]);
+
+		MockCobInstance inst(file.numStaticVars);
+		MockCobThread thread(&inst, &file);
+
+		thread.Start(fn, 0);
+
+		const int count = CobInterpreter::CountSpeculative(file, thread.pc, 1000);
+
+		CobInterpreter::Run<true>(thread);
+
+		// DIV, MOD and RETURN only stop the interpreter depending on the stack
+		if (count == 0) {
+			const int op = file.instrs[file.scriptOffsets[fn]].op;
+			CHECK((thread.pc == file.scriptOffsets[fn] || op == CobInterpreter::OP_DIV || op == CobInterpreter::OP_MOD || op == CobInterpreter::OP_RETURN));
+		} else {
+			CHECK(thread.pc != file.scriptOffsets[fn]);
+		}
+	}
+
+	CHECK(CobInterpreter::CountSpeculative(file, file.scriptOffsets[as.Func("Loop")], 1000) == 6);
+	CHECK(CobInterpreter::CountSpeculative(file, file.scriptOffsets[as.Func("Loop")], 4) == 4);
+	CHECK(CobInterpreter::CountSpeculative(file, file.scriptOffsets[as.Func("Anim")], 1000) == 2);
+}
+
+
+TEST_CASE("CobInterpreterBenchmark", "[.][benchmark]")
+{
+	CobAssembler as;
+	const CCobFile& file = AssembleTestFile(as, 1000);
+
+	std::vector<int> code = file.code;
+
+	const int loop = as.Func("Loop");
+	const int calls = as.Func("Calls");
+
+	REQUIRE(RunDecoded(file, loop) == RunSwitch(file, loop, code));
+
+	BENCHMARK("Switch::Loop") {
+		return RunSwitch(file, loop, code).retCode;
+	};
+	BENCHMARK("Decoded::Loop") {
+		return RunDecoded(file, loop).retCode;
+	};
+
+	BENCHMARK("Switch::Calls") {
+		return RunSwitch(file, calls, code).retCode;
+	};
+	BENCHMARK("Decoded::Calls") {
+		return RunDecoded(file, calls).retCode;
+	};
+}
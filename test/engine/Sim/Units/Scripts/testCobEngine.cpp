@@ -0,0 +1,277 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "Sim/Units/Scripts/CobEngine.h"
+#include "Sim/Units/Scripts/CobFile.h"
+#include "Sim/Units/Scripts/CobFileHandler.h"
+#include "Sim/Units/Scripts/CobInstance.h"
+#include "Sim/Units/Scripts/CobOpcodes.h"
+#include "Sim/Misc/GlobalSynced.h"
+#include "Sim/Weapons/WeaponDefHandler.h"
+#include "Lua/LuaRules.h"
+#include "System/Misc/SpringTime.h"
+#include "System/Platform/Threading.h"
+#include "System/Sound/ISoundChannels.h"
+#include "System/Threading/ThreadPool.h"
+#include "CobAssembler.h"
+
+#include <algorithm>
+#include <deque>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+// runs unit script threads through the real CCobEngine with and without
+// CobSpeculativeThreads; everything the scripts call into the unit goes
+// through the CUnitScript definitions below instead of UnitScript.cpp
+
+namespace {
+	// more than CCobEngine needs to bother running threads ahead
+	constexpr int NUM_SPINNERS = 80;
+
+	// calls into units made while threads run ahead this tick wait for their turn
+	int numSpeculatedCalls = 0;
+
+	struct TestCobInstance: public CCobInstance {
+		explicit TestCobInstance(CCobFile& file) {
+			cobFile = &file;
+			staticVars.resize(file.numStaticVars, 0);
+		}
+
+		std::vector<int> trace;
+
+		// EMIT_SFX on piece 3 calls callFunction of callTarget, on piece 7 signals signalTarget
+		TestCobInstance* callTarget = nullptr;
+		TestCobInstance* signalTarget = nullptr;
+		int callFunction = -1;
+	};
+}
+
+
+CCobEngine* cobEngine = nullptr;
+CCobFileHandler* cobFileHandler = nullptr;
+CWeaponDefHandler* weaponDefHandler = nullptr;
+CLuaRules* luaRules = nullptr;
+CGlobalSyncedRNG gsRNG;
+
+namespace Channels {
+	IAudioChannel* UnitReply = nullptr;
+}
+
+int CCobFile::GetFunctionId(const std::string& name) { return -1; }
+CCobFile* CCobFileHandler::GetCobFile(const std::string& name) { return nullptr; }
+const WeaponDef* CWeaponDefHandler::GetWeaponDefByID(int id) const { return nullptr; }
+void CLuaRules::Cob2Lua(const LuaHashString& funcName, const CUnit* unit, int& argsCount, int args[MAX_LUA_COB_ARGS]) {}
+
+CUnitScript::CUnitScript(CUnit* unit)
+	: unit(unit)
+	, busy(false)
+	, hasSetSFXOccupy(false)
+	, hasRockUnit(false)
+	, hasStartBuilding(false)
+	, hasChangeHeading(false)
+{ }
+
+CUnitScript::~CUnitScript() {}
+
+bool CUnitScript::EmitSfx(int sfxType, int sfxPiece)
+{
+	TestCobInstance* inst = static_cast<TestCobInstance*>(this);
+
+	inst->trace.insert(inst->trace.end(), {sfxPiece, sfxType});
+	numSpeculatedCalls += cobEngine->HasSpeculations();
+
+	if (sfxPiece == 3)
+		inst->callTarget->RawCall(inst->callFunction);
+	if (sfxPiece == 7)
+		inst->signalTarget->Signal(sfxType);
+
+	return true;
+}
+
+void CUnitScript::Spin(int piece, int axis, float speed, float accel) {}
+void CUnitScript::StopSpin(int piece, int axis, float decel) {}
+void CUnitScript::Turn(int piece, int axis, float speed, float destination) {}
+void CUnitScript::Move(int piece, int axis, float speed, float destination) {}
+void CUnitScript::MoveNow(int piece, int axis, float destination) {}
+void CUnitScript::TurnNow(int piece, int axis, float destination) {}
+bool CUnitScript::NeedsWait(AnimType type, int piece, int axis) { return false; }
+void CUnitScript::SetVisibility(int piece, bool visible) {}
+void CUnitScript::AttachUnit(int piece, int unit) {}
+void CUnitScript::DropUnit(int unit) {}
+void CUnitScript::Explode(int piece, int flags) {}
+void CUnitScript::ShowFlare(int piece) {}
+int CUnitScript::GetUnitVal(int val, int p1, int p2, int p3, int p4) { return 0; }
+void CUnitScript::SetUnitVal(int val, int param) {}
+
+
+namespace {
+	// static0 = static0 * 3 + 1, thrice, then show it and sleep
+	void AssembleSpin(CobAssembler& as) {
+		const int top = as.Here();
+
+		for (int i = 0; i < 3; i++) {
+			as.Op(PUSH_STATIC, 0).Op(PUSH_CONSTANT, 3).Op(MUL).Op(PUSH_CONSTANT, 1).Op(ADD).Op(POP_STATIC, 0);
+		}
+
+		as.Op(PUSH_STATIC, 0).Op(EMIT_SFX, 1);
+		as.Op(PUSH_CONSTANT, 10).Op(SLEEP).Op(JUMP, top);
+	}
+
+	CCobFile& AssembleTestFile(CobAssembler& as) {
+		as.Begin("Spin");
+		AssembleSpin(as);
+
+		// same, but can be signalled
+		as.Begin("MaskedSpin");
+		as.Op(PUSH_CONSTANT, 2).Op(SET_SIGNAL_MASK);
+		AssembleSpin(as);
+
+		// makes the unit kill the threads of its signalTarget with mask 2, then
+		// call callFunction of its callTarget, which removes the killed threads;
+		// wakes up in the same tick as MaskedSpin, and before it
+		as.Begin("Signaller");
+		as.Op(PUSH_CONSTANT, 25).Op(SLEEP);
+		{
+			const int top = as.Here();
+
+			as.Op(PUSH_CONSTANT, 2).Op(EMIT_SFX, 7);
+			as.Op(PUSH_CONSTANT, 5).Op(EMIT_SFX, 3);
+			as.Op(PUSH_CONSTANT, 10).Op(SLEEP).Op(JUMP, top);
+		}
+
+		// makes the unit call callFunction of its callTarget
+		as.Begin("Caller");
+		{
+			const int top = as.Here();
+
+			as.Op(PUSH_CONSTANT, 5).Op(EMIT_SFX, 3);
+			as.Op(PUSH_CONSTANT, 10).Op(SLEEP).Op(JUMP, top);
+		}
+
+		as.Begin("Bump");
+		as.Op(PUSH_STATIC, 0).Op(EMIT_SFX, 4);
+		as.Op(PUSH_STATIC, 0).Op(PUSH_CONSTANT, 100).Op(ADD).Op(POP_STATIC, 0);
+		as.Op(PUSH_CONSTANT, 0).Op(RETURN);
+
+		// sleeps for a negative time thrice out of four, shows static0 each time
+		as.Begin("Rewind");
+		{
+			const int top = as.Here();
+
+			as.Op(PUSH_STATIC, 1).Op(EMIT_SFX, 5).Op(PUSH_STATIC, 0).Op(EMIT_SFX, 6);
+			as.Op(PUSH_STATIC, 1).Op(PUSH_CONSTANT, 1).Op(ADD).Op(POP_STATIC, 1);
+			as.Op(PUSH_STATIC, 1).Op(PUSH_CONSTANT, 4).Op(MOD);
+
+			const int rest = as.Here();
+
+			as.Op(JUMP_NOT_EQUAL, 0);
+			as.Op(PUSH_CONSTANT, -5).Op(SLEEP).Op(JUMP, top);
+			as.Patch(rest);
+			as.Op(PUSH_CONSTANT, 10).Op(SLEEP).Op(JUMP, top);
+		}
+
+		return (as.Finish(2));
+	}
+
+	struct EngineResult {
+		std::vector<std::vector<int>> traces;
+		std::vector<std::vector<int>> staticVars;
+		std::vector<int> threadIDs;
+
+		int numSpeculatedCalls = 0;
+	};
+
+	// ticks threads whose instances get signalled, called into or rewound
+	// before the turn of a thread that was run ahead, next to one which is
+	// left alone and enough others to make running ahead worth it
+	EngineResult RunEngine(const CobAssembler& as, CCobFile& file, bool speculate, int numTicks) {
+		CCobEngine engine;
+		EngineResult res;
+
+		cobEngine = &engine;
+		cobEngine->Init(speculate);
+
+		numSpeculatedCalls = 0;
+
+		{
+			std::deque<TestCobInstance> insts;
+
+			for (int i = 0; i < 6 + NUM_SPINNERS; i++) {
+				insts.emplace_back(file);
+			}
+
+			insts[3].callTarget = &insts[2];
+			insts[3].callFunction = as.Func("Bump");
+			insts[5].callTarget = &insts[5];
+			insts[5].callFunction = as.Func("Bump");
+			insts[5].signalTarget = &insts[1];
+
+			// threads that tick first in each phase are started first
+			insts[5].RawCall(as.Func("Signaller"));
+			insts[1].RawCall(as.Func("MaskedSpin"));
+			insts[3].RawCall(as.Func("Caller"));
+			insts[2].RawCall(as.Func("Spin"));
+			insts[4].RawCall(as.Func("Rewind"));
+			insts[4].RawCall(as.Func("Spin"));
+
+			for (size_t i = 6; i < insts.size(); i++) {
+				insts[i].RawCall(as.Func("Spin"));
+			}
+
+			insts[0].RawCall(as.Func("Spin"));
+
+			for (int i = 0; i < numTicks; i++) {
+				cobEngine->Tick(5);
+			}
+
+			for (const auto& p: cobEngine->GetThreadInstances()) {
+				res.threadIDs.push_back(p.first);
+			}
+
+			for (TestCobInstance& inst: insts) {
+				res.traces.push_back(std::move(inst.trace));
+				res.staticVars.push_back(inst.staticVars);
+			}
+		}
+
+		std::sort(res.threadIDs.begin(), res.threadIDs.end());
+		res.numSpeculatedCalls = numSpeculatedCalls;
+
+		cobEngine->Kill();
+		cobEngine = nullptr;
+		return res;
+	}
+}
+
+
+TEST_CASE("CobEngineSpeculation")
+{
+	// what InitSpringTime does, which is only there with UNIT_TEST
+	spring_clock::PushTickRate(true);
+	spring_time::setstarttime(spring_time::gettime(true));
+
+	Threading::DetectCores();
+	ThreadPool::SetThreadCount(ThreadPool::GetMaxThreads());
+
+	CobAssembler as;
+	CCobFile& file = AssembleTestFile(as);
+
+	const EngineResult serial = RunEngine(as, file, false, 40);
+	const EngineResult speculated = RunEngine(as, file, true, 40);
+
+	// nothing waits for its turn unless enabled, and then something does
+	CHECK(serial.numSpeculatedCalls == 0);
+	CHECK(speculated.numSpeculatedCalls > 0);
+
+	CHECK(speculated.traces == serial.traces);
+	CHECK(speculated.staticVars == serial.staticVars);
+	CHECK(speculated.threadIDs == serial.threadIDs);
+
+	// the signalled thread is gone, Bump ran and Rewind was rewound
+	CHECK(serial.threadIDs.size() == 6 + NUM_SPINNERS);
+	CHECK(serial.staticVars[2][0] >= 100);
+	CHECK(serial.staticVars[4][1] > 4);
+
+	ThreadPool::SetThreadCount(0);
+}
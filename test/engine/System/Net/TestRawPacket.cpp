@@ -0,0 +1,160 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/Net/RawPacket.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <thread>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+using namespace netcode;
+
+// counts heap allocations made by the current thread while enabled
+static thread_local bool countHeapAllocs = false;
+static thread_local size_t numHeapAllocs = 0;
+static thread_local size_t numHeapFrees = 0;
+
+void* operator new(size_t size)
+{
+	numHeapAllocs += countHeapAllocs;
+
+	if (void* p = std::malloc(size == 0 ? 1 : size))
+		return p;
+
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept
+{
+	numHeapFrees += (countHeapAllocs && p != nullptr);
+	std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept { operator delete(p); }
+
+
+struct HeapCounter {
+	HeapCounter() { numHeapAllocs = 0; numHeapFrees = 0; countHeapAllocs = true; }
+	~HeapCounter() { countHeapAllocs = false; }
+
+	size_t Allocs() const { return numHeapAllocs; }
+	size_t Frees() const { return numHeapFrees; }
+};
+
+
+TEST_CASE("RawPacketPoolSizeClasses")
+{
+	SECTION("blocks are reused within their size class") {
+		void* a = RawPacket::AllocMem(40);
+		RawPacket::FreeMem(a, 40);
+
+		// 40 and 64 bytes share the 64-byte class
+		void* b = RawPacket::AllocMem(64);
+		CHECK(b == a);
+
+		// 65 bytes does not
+		void* c = RawPacket::AllocMem(65);
+		CHECK(c != a);
+
+		RawPacket::FreeMem(c, 65);
+		RawPacket::FreeMem(b, 64);
+	}
+
+	SECTION("sizes beyond the largest class bypass the pool") {
+		HeapCounter counter;
+
+		void* p = RawPacket::AllocMem(4097);
+		RawPacket::FreeMem(p, 4097);
+
+		CHECK(counter.Allocs() == 1);
+		CHECK(counter.Frees() == 1);
+	}
+
+	SECTION("each class keeps a bounded number of free blocks") {
+		// 1MB worth of 32-byte blocks, plus some to overflow the free-list
+		static constexpr size_t NUM_BLOCKS = (1024 * 1024) / 32 + 1000;
+
+		std::vector<void*> blocks(NUM_BLOCKS);
+
+		for (void*& p: blocks)
+			p = RawPacket::AllocMem(32);
+
+		HeapCounter counter;
+
+		for (void* p: blocks)
+			RawPacket::FreeMem(p, 32);
+
+		// allocating them drained the free-list, so exactly the overflow is freed
+		CHECK(counter.Frees() == 1000);
+	}
+}
+
+
+TEST_CASE("RawPacketPoolReuse")
+{
+	// small enough for every size class to keep all of them on its free-list
+	static constexpr size_t NUM_PACKETS = 1000;
+
+	// warm the pool up with every size used below
+	{
+		std::vector<std::shared_ptr<const RawPacket>> packets;
+
+		for (size_t i = 0; i < NUM_PACKETS; i++)
+			packets.push_back(MakeSharedPacket(new RawPacket(1 + (i % 1500))));
+	}
+
+	SECTION("packets, payloads and control blocks come from the pool") {
+		std::vector<std::shared_ptr<const RawPacket>> packets;
+		packets.reserve(NUM_PACKETS);
+
+		HeapCounter counter;
+
+		for (size_t i = 0; i < NUM_PACKETS; i++)
+			packets.push_back(MakeSharedPacket(new RawPacket(1 + (i % 1500))));
+
+		packets.clear();
+
+		CHECK(counter.Allocs() == 0);
+		CHECK(counter.Frees() == 0);
+	}
+
+	SECTION("the payload goes back to the pool with the last reference") {
+		std::shared_ptr<const RawPacket> p = MakeSharedPacket(new RawPacket(200, 1));
+		std::shared_ptr<const RawPacket> q = p;
+
+		const void* payload = q->data;
+
+		p.reset();
+
+		// still owned by q
+		void* block = RawPacket::AllocMem(200);
+		CHECK(block != payload);
+		RawPacket::FreeMem(block, 200);
+
+		q.reset();
+
+		block = RawPacket::AllocMem(200);
+		CHECK(block == payload);
+		RawPacket::FreeMem(block, 200);
+	}
+
+	SECTION("packets can be freed on another thread") {
+		std::vector<std::shared_ptr<const RawPacket>> packets;
+
+		for (size_t i = 0; i < NUM_PACKETS; i++)
+			packets.push_back(MakeSharedPacket(new RawPacket(100)));
+
+		std::thread([&]() { packets.clear(); }).join();
+
+		HeapCounter counter;
+
+		for (size_t i = 0; i < NUM_PACKETS; i++)
+			packets.push_back(MakeSharedPacket(new RawPacket(100)));
+
+		CHECK(counter.Allocs() == 0);
+	}
+}
@@ -0,0 +1,177 @@
+/* This file is part of the Spring engine (GPL v2 or later), see LICENSE.html */
+
+#include "System/Net/UDPBatch.h"
+#include "System/Net/Socket.h"
+#include "System/Log/ILog.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <asio.hpp>
+
+#define CATCH_CONFIG_MAIN
+#include "lib/catch.hpp"
+
+using namespace netcode;
+
+static constexpr size_t NUM_DATAGRAMS = 20000;
+static constexpr size_t DATAGRAM_SIZE = 512;
+static constexpr size_t NUM_PINGS = 1000;
+static constexpr std::chrono::seconds RECV_TIMEOUT(5);
+
+
+static std::shared_ptr<asio::ip::udp::socket> OpenLoopbackSocket()
+{
+	std::shared_ptr<asio::ip::udp::socket> sock(new asio::ip::udp::socket(netservice));
+
+	sock->open(asio::ip::udp::v4());
+	sock->bind(asio::ip::udp::endpoint(asio::ip::address_v4::loopback(), 0));
+	sock->non_blocking(true);
+	return sock;
+}
+
+static size_t DrainBatch(UDPBatch& batch, std::vector<bool>& seen)
+{
+	size_t numReceived = 0;
+	size_t n = 0;
+
+	while ((n = batch.Receive()) > 0) {
+		for (size_t i = 0; i < n; i++) {
+			std::uint32_t seq = 0;
+
+			REQUIRE(batch.GetSize(i) == DATAGRAM_SIZE);
+			memcpy(&seq, batch.GetData(i), sizeof(seq));
+			REQUIRE(seq < seen.size());
+			CHECK(batch.GetData(i)[DATAGRAM_SIZE - 1] == std::uint8_t(seq));
+
+			seen[seq] = true;
+		}
+
+		numReceived += n;
+	}
+
+	return numReceived;
+}
+
+
+TEST_CASE("UDPBatch")
+{
+	std::shared_ptr<asio::ip::udp::socket> sendSocket = OpenLoopbackSocket();
+	std::shared_ptr<asio::ip::udp::socket> recvSocket = OpenLoopbackSocket();
+
+	UDPBatch sender(sendSocket);
+	UDPBatch receiver(recvSocket);
+
+	const asio::ip::udp::endpoint recvAddr = recvSocket->local_endpoint();
+	const asio::ip::udp::endpoint sendAddr = sendSocket->local_endpoint();
+
+	SECTION("Throughput") {
+		std::vector<std::uint8_t> data(DATAGRAM_SIZE, 0);
+		std::vector<bool> seen(NUM_DATAGRAMS, false);
+
+		size_t numReceived = 0;
+
+		const auto t0 = std::chrono::steady_clock::now();
+
+		for (size_t seq = 0; seq < NUM_DATAGRAMS; ) {
+			// one "server tick" worth of datagrams, then let the receiver catch up
+			sender.BeginSend();
+
+			for (size_t i = 0; i < UDPBatch::MAX_DATAGRAMS && seq < NUM_DATAGRAMS; i++, seq++) {
+				const std::uint32_t seq32 = seq;
+
+				memcpy(data.data(), &seq32, sizeof(seq32));
+				data[DATAGRAM_SIZE - 1] = std::uint8_t(seq);
+				sender.Send(data, recvAddr);
+			}
+
+			sender.EndSend();
+
+			numReceived += DrainBatch(receiver, seen);
+		}
+
+		numReceived += DrainBatch(receiver, seen);
+
+		const auto t1 = std::chrono::steady_clock::now();
+		const double secs = std::chrono::duration<double>(t1 - t0).count();
+
+		LOG("[UDPBatch] %u datagrams of %u bytes: %.0f datagrams/s sent, %u received; %u send and %u receive calls",
+			unsigned(NUM_DATAGRAMS), unsigned(DATAGRAM_SIZE), NUM_DATAGRAMS / secs, unsigned(numReceived),
+			unsigned(sender.GetNumSendCalls()), unsigned(receiver.GetNumRecvCalls()));
+
+		CHECK(sender.GetNumSentDatagrams() == NUM_DATAGRAMS);
+		// loopback does not drop as long as the receiver keeps up
+		CHECK(numReceived == NUM_DATAGRAMS);
+		CHECK(std::find(seen.begin(), seen.end(), false) == seen.end());
+
+	#ifdef __linux__
+		CHECK(sender.GetNumSendCalls() <= (NUM_DATAGRAMS / UDPBatch::MAX_DATAGRAMS + 1));
+	#endif
+	}
+
+	SECTION("Latency") {
+		std::vector<std::uint8_t> ping(DATAGRAM_SIZE, 0);
+		std::vector<bool> seen(1, false);
+
+		double maxLatency = 0.0;
+		double sumLatency = 0.0;
+
+		for (size_t n = 0; n < NUM_PINGS; n++) {
+			const auto t0 = std::chrono::steady_clock::now();
+
+			// not inside BeginSend/EndSend, goes out right away
+			sender.Send(ping, recvAddr);
+
+			size_t numReceived = 0;
+
+			// a lost datagram must fail the test rather than hang it
+			while ((numReceived = receiver.Receive()) == 0 && (std::chrono::steady_clock::now() - t0) < RECV_TIMEOUT);
+
+			REQUIRE(numReceived == 1);
+			REQUIRE(receiver.GetSize(0) == DATAGRAM_SIZE);
+			CHECK(receiver.GetSender(0) == sendAddr);
+
+			const double latency = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+
+			maxLatency = std::max(maxLatency, latency);
+			sumLatency += latency;
+		}
+
+		LOG("[UDPBatch] %u unbatched datagrams: %.1fus average, %.1fus max latency", unsigned(NUM_PINGS), sumLatency / NUM_PINGS, maxLatency);
+
+		CHECK(DrainBatch(receiver, seen) == 0);
+	}
+
+	SECTION("SentCounters") {
+		std::vector<std::uint8_t> data(DATAGRAM_SIZE, 0);
+		std::vector<bool> seen(1, false);
+
+		// not reachable through an IPv4 socket, sending to it fails
+		const asio::ip::udp::endpoint badAddr(asio::ip::address_v6::loopback(), recvAddr.port());
+
+		unsigned int sentBytes = 0;
+		unsigned int sentDatagrams = 0;
+
+		sender.BeginSend();
+		sender.Send(data, recvAddr, &sentBytes, &sentDatagrams);
+		sender.Send(data, badAddr, &sentBytes, &sentDatagrams);
+		sender.Send(data, recvAddr, &sentBytes, &sentDatagrams);
+		sender.Send(data, recvAddr);
+
+		// nothing is counted before the datagrams are actually sent
+		CHECK(sentBytes == 0);
+		CHECK(sentDatagrams == 0);
+
+		sender.EndSend();
+
+		CHECK(sentBytes == 2 * DATAGRAM_SIZE);
+		CHECK(sentDatagrams == 2);
+		CHECK(sender.GetNumSentDatagrams() == 3);
+
+		const auto t0 = std::chrono::steady_clock::now();
+
+		for (size_t numReceived = 0; numReceived < 3 && (std::chrono::steady_clock::now() - t0) < RECV_TIMEOUT; ) {
+			numReceived += DrainBatch(receiver, seen);
+		}
+	}
+}
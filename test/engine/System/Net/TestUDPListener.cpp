@@ -1,6 +1,14 @@
 
 #include "System/Net/UDPListener.h"
+#include "System/Net/UDPConnection.h"
+#include "System/Net/RawPacket.h"
 #include "System/Log/ILog.h"
+#include "System/Misc/SpringTime.h"
+#include "Net/ConnectionAttempt.h"
+#include "Net/Protocol/BaseNetProtocol.h"
+
+#include <chrono>
+#include <thread>
 
 
 #define CATCH_CONFIG_MAIN
@@ -89,3 +97,116 @@ TEST_CASE("TryBindSocket")
 	t.TestPort(-1, false);
 }
 
+// connections time their chunks; the tick rate can only be set once per process
+static void InitClock()
+{
+	static bool clockInited = false;
+
+	if (clockInited)
+		return;
+
+	spring_clock::PushTickRate();
+	spring_time::setstarttime(spring_time::gettime(true));
+	clockInited = true;
+}
+
+TEST_CASE("PackedMessages")
+{
+	InitClock();
+
+	netcode::UDPListener sender(11112, "127.0.0.1");
+	netcode::UDPListener receiver(11113, "127.0.0.1");
+
+	std::shared_ptr<netcode::UDPConnection> conn = sender.SpawnConnection("127.0.0.1", 11113);
+	conn->Unmute();
+
+	// what a spectator gets in 16 frames: one keyframe, 15 newframes and some chatter
+	std::vector<CBaseNetProtocol::PacketType> msgs;
+	std::vector<uint8_t> msgData;
+
+	msgs.push_back(CBaseNetProtocol::Get().SendKeyFrame(16));
+
+	for (int i = 0; i < 15; i++) {
+		msgs.push_back(CBaseNetProtocol::Get().SendNewFrame());
+		msgs.push_back(CBaseNetProtocol::Get().SendPlayerInfo(i, 0.5f, 42));
+	}
+
+	for (const CBaseNetProtocol::PacketType& msg: msgs) {
+		msgData.insert(msgData.end(), msg->data, msg->data + msg->length);
+	}
+
+	CBaseNetProtocol::PacketType packed = CBaseNetProtocol::Get().SendPackedMessages(msgData);
+
+	REQUIRE(packed != nullptr);
+	CHECK(packed->data[0] == NETMSG_PACKED);
+	CHECK(packed->length < msgData.size());
+
+	conn->SendData(packed);
+	conn->Flush(true);
+
+	for (int i = 0; i < 100 && !receiver.HasIncomingConnections(); i++) {
+		sender.Update();
+		receiver.Update();
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	REQUIRE(receiver.HasIncomingConnections());
+
+	// the receiving connection hands out the original messages
+	std::shared_ptr<netcode::UDPConnection> incoming = receiver.AcceptConnection();
+
+	for (const CBaseNetProtocol::PacketType& msg: msgs) {
+		CBaseNetProtocol::PacketType recv = incoming->GetData();
+
+		REQUIRE(recv != nullptr);
+		REQUIRE(recv->length == msg->length);
+		CHECK(std::memcmp(recv->data, msg->data, msg->length) == 0);
+	}
+
+	CHECK(incoming->GetData() == nullptr);
+}
+
+
+TEST_CASE("ConnectionAttemptRouting")
+{
+	InitClock();
+
+	netcode::UDPListener client(11114, "127.0.0.1");
+	netcode::UDPListener host(11115, "127.0.0.1");
+
+	std::shared_ptr<netcode::UDPConnection> conn = client.SpawnConnection("127.0.0.1", 11115);
+	conn->Unmute();
+	conn->SendData(CBaseNetProtocol::Get().SendAttemptConnect("player", "secret", "version", "platform", 1, true));
+	conn->Flush(true);
+
+	for (int i = 0; i < 100 && !host.HasIncomingConnections(); i++) {
+		client.Update();
+		host.Update();
+		std::this_thread::sleep_for(std::chrono::milliseconds(10));
+	}
+
+	REQUIRE(host.HasIncomingConnections());
+
+	// CGameServerHost picks the game by looking at the attempt...
+	ConnectionAttempt routed;
+
+	REQUIRE(PeekConnectionAttempt(host, routed));
+	CHECK(routed.name == "player");
+	CHECK(routed.passwd == "secret");
+
+	// ...which CGameServer::HandleConnectionAttempt then reads from the accepted connection
+	std::shared_ptr<netcode::UDPConnection> incoming = host.AcceptConnection();
+	std::shared_ptr<const netcode::RawPacket> packet = incoming->GetData();
+
+	REQUIRE(packet != nullptr);
+
+	ConnectionAttempt accepted;
+	UnpackConnectionAttempt(packet, accepted);
+
+	CHECK(accepted.name == routed.name);
+	CHECK(accepted.passwd == routed.passwd);
+	CHECK(accepted.version == "version");
+	CHECK(accepted.platform == "platform");
+	CHECK(accepted.reconnect == 1);
+	CHECK(accepted.netloss == 1);
+}
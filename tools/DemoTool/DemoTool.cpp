@@ -5,10 +5,14 @@
 #include <iostream>
 #include <gflags/gflags.h>
 #include <iomanip> //hex
+#include <cstring>
+#include <filesystem>
+#include <zlib.h>
 
 #include "StringSerializer.h"
 
 #include "Net/Protocol/BaseNetProtocol.h"
+#include "System/FileSystem/GZFileHandler.h"
 #include "System/LoadSave/DemoReader.h"
 #include "System/Net/RawPacket.h"
 #include "Sim/Units/CommandAI/Command.h"
@@ -32,10 +36,14 @@ no console output (you still could use this.exe > z.tzt though).
 	DEFINE_bool  (teamstats,    false, "Print teamstats");
 	DEFINE_int32 (team,         -1,    "Select team");
 	DEFINE_string(teamsstatcsv, "",    "Write teamstats in a csv file");
+	DEFINE_int32 (fromframe,    0,     "Start dumping at the last indexed keyframe before this frame");
+	DEFINE_int32 (keyframes,    0,     "Append a keyframe index with an entry every N frames");
+	DEFINE_string(outfile,      "",    "Where to write the demo for --keyframes (default: overwrite demofile)");
 
 
 void TrafficDump(CDemoReader& reader, bool trafficStats);
 void WriteTeamstatHistory(CDemoReader& reader, unsigned team, const std::string& file);
+bool WriteKeyFrameIndex(CDemoReader& reader, const std::string& inFile, const std::string& outFile, int interval);
 
 int main (int argc, char* argv[])
 {
@@ -54,6 +62,12 @@ int main (int argc, char* argv[])
 
 	CDemoReader reader(filename, 0.0f);
 	reader.LoadStats();
+	if (FLAGS_keyframes > 0)
+	{
+		if (!WriteKeyFrameIndex(reader, filename, FLAGS_outfile.empty()? filename: FLAGS_outfile, FLAGS_keyframes))
+			exit(1);
+		return 0;
+	}
 	if (FLAGS_dump)
 	{
 		TrafficDump(reader, true);
@@ -197,6 +211,8 @@ void TrafficDump(CDemoReader& reader, bool trafficStats)
 	std::vector<unsigned> trafficCounter(NETMSG_LAST, 0);
 	int frame = -1;
 	int cmdId = 0;
+	if (FLAGS_fromframe > 0)
+		frame = reader.SeekToFrame(FLAGS_fromframe) - 1;
 	while (!reader.ReachedEnd())
 	{
 		netcode::RawPacket* packet;
@@ -504,3 +520,81 @@ void WriteTeamstatHistory(CDemoReader& reader, unsigned team, const std::string&
 		exit(1);
 	}
 };
+
+
+bool WriteKeyFrameIndex(CDemoReader& reader, const std::string& inFile, const std::string& outFile, int interval)
+{
+	const DemoFileHeader& header = reader.GetFileHeader();
+
+	if (header.demoStreamSize == 0) {
+		std::cout << "Demo is incomplete, can not index it" << std::endl;
+		return false;
+	}
+
+	std::vector<DemoKeyFrameIndexEntry> index;
+	int numFrames = 0;
+
+	// same rules as CDemoRecorder::SaveToDemo, from the chunks of the recorded stream
+	reader.SeekToFrame(0);
+	while (!reader.ReachedEnd())
+	{
+		const std::uint32_t streamOffset = reader.GetStreamOffset();
+		const float modGameTime = reader.GetModGameTime();
+		netcode::RawPacket* packet = reader.GetData(3.402823466e+38f);
+		if (packet == NULL)
+			continue;
+		if (packet->length > 0 && (packet->data[0] == NETMSG_NEWFRAME || packet->data[0] == NETMSG_KEYFRAME)) {
+			if (numFrames > 0 && (numFrames % interval) == 0)
+				index.push_back({numFrames, modGameTime, streamOffset});
+			++numFrames;
+		}
+		delete packet;
+	}
+
+	// copy everything up to the end of the stats, dropping any previous index
+	CGZFileHandler inDemo(inFile, SPRING_VFS_PWD_ALL);
+	const int dataSize = header.headerSize + header.scriptSize + header.demoStreamSize +
+		header.winningAllyTeamsSize + header.playerStatSize + header.teamStatSize;
+
+	if (inDemo.FileSize() < dataSize) {
+		std::cout << "Demo is truncated, can not index it" << std::endl;
+		return false;
+	}
+
+	std::string data(dataSize, 0);
+	inDemo.Read(&data[0], dataSize);
+
+	for (DemoKeyFrameIndexEntry& entry: index) {
+		entry.swab();
+		data.append(reinterpret_cast<const char*>(&entry), sizeof(entry));
+	}
+
+	DemoKeyFrameIndexFooter footer;
+	footer.numEntries = index.size();
+	footer.numFrames = numFrames;
+	memcpy(footer.magic, DEMOFILE_KEYFRAME_INDEX_MAGIC, sizeof(footer.magic));
+	footer.swab();
+	data.append(reinterpret_cast<const char*>(&footer), sizeof(footer));
+
+	// outFile defaults to the input, never truncate it before the new demo is complete
+	const std::string tmpFile = outFile + ".tmp";
+
+	gzFile file = gzopen(tmpFile.c_str(), "wb9");
+	bool written = (file != nullptr && gzwrite(file, data.c_str(), data.size()) == (int)data.size());
+
+	if (file != nullptr)
+		written &= (gzclose(file) == Z_OK);
+
+	std::error_code err;
+	if (written)
+		std::filesystem::rename(tmpFile, outFile, err);
+
+	if (!written || err) {
+		std::cout << "Could not write " << outFile << std::endl;
+		std::filesystem::remove(tmpFile, err);
+		return false;
+	}
+
+	std::cout << "Wrote " << index.size() << " keyframes for " << numFrames << " frames to " << outFile << std::endl;
+	return true;
+}